@@ -1,21 +1,201 @@
 #pragma once
 
+#include "briskdef.hpp"
 #include "utility.hpp"
+#include "functional.hpp"
+#include "memory_resource.hpp"
+#include "simd.hpp"
+#ifdef BRISK_HEAP_PROFILE
+#include "heap_profiler.hpp"
+#endif
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace brisk
 {
+	namespace detail
+	{
+		template <class Iterator>
+		using iter_element_t = std::remove_reference_t<std::iter_reference_t<Iterator>>;
+
+		// Copies between contiguous ranges of the same trivially copyable
+		// type can be done as one memmove.
+		template <class Iterator, class OutIterator>
+		constexpr bool isMemmovable()
+		{
+			if constexpr (std::contiguous_iterator<Iterator> && std::contiguous_iterator<OutIterator>) {
+				using Source = iter_element_t<Iterator>;
+				using Dest = iter_element_t<OutIterator>;
+				return std::is_same_v<std::remove_const_t<Source>, Dest> && !std::is_volatile_v<Dest>
+					&& std::is_trivially_copyable_v<Dest> && std::is_trivially_copy_assignable_v<Dest> && std::is_trivially_move_assignable_v<Dest>;
+			} else {
+				return false;
+			}
+		}
+
+		// Contiguous ranges of a trivially copyable type filled with a value
+		// of that type. They're memset when it's a single byte or all zeros.
+		template <class Iterator, class T>
+		constexpr bool isMemsettable()
+		{
+			if constexpr (std::contiguous_iterator<Iterator>) {
+				using Dest = iter_element_t<Iterator>;
+				return !std::is_const_v<Dest> && !std::is_volatile_v<Dest> && std::is_trivially_copyable_v<Dest>
+					&& std::is_trivially_copy_assignable_v<Dest>
+					&& (std::is_same_v<std::remove_cvref_t<T>, Dest> || (std::is_arithmetic_v<Dest> && std::is_arithmetic_v<std::remove_cvref_t<T>>));
+			} else {
+				return false;
+			}
+		}
+
+		// Fills n elements at dest with memset if value allows it.
+		template <class Type>
+		bool memsetFill(Type* dest, brisk::size_t n, const Type& value) noexcept
+		{
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+			if constexpr (sizeof(Type) == 1) {
+				std::memset(dest, bytes[0], n);
+				return true;
+			} else {
+				for (brisk::size_t i = 0; i < sizeof(Type); ++i) {
+					if (bytes[i] != 0) {
+						return false;
+					}
+				}
+
+				std::memset(dest, 0, n * sizeof(Type));
+				return true;
+			}
+		}
+
+		struct simd_fill
+		{
+			template <class Abi, class Type>
+			static void run(Type* dest, brisk::size_t n, Type value) noexcept
+			{
+				using V = basic_simd<Type, Abi>;
+				constexpr brisk::size_t lanes = V::size();
+				const V v(value);
+				brisk::size_t i = 0;
+				// stores that straddle cache lines cost two
+				for (; i < n && reinterpret_cast<std::uintptr_t>(dest + i) % (lanes * sizeof(Type)) != 0; ++i) {
+					dest[i] = value;
+				}
+				for (; i + 4 * lanes <= n; i += 4 * lanes) {
+					v.store(dest + i);
+					v.store(dest + i + lanes);
+					v.store(dest + i + 2 * lanes);
+					v.store(dest + i + 3 * lanes);
+				}
+				for (; i + lanes <= n; i += lanes) {
+					v.store(dest + i);
+				}
+				for (; i < n; ++i) {
+					dest[i] = value;
+				}
+			}
+		};
+
+		// Contiguous elements that simd has lanes for.
+		template <class Iterator>
+		constexpr bool isSimdRange()
+		{
+			if constexpr (std::contiguous_iterator<Iterator>) {
+				return isSimdElement<std::remove_cv_t<iter_element_t<Iterator>>> && !std::is_volatile_v<iter_element_t<Iterator>>;
+			} else {
+				return false;
+			}
+		}
+
+		// ... added up with plus into a total of their own type.
+		template <class Iterator, class T, class BinaryOp>
+		constexpr bool isSimdSum()
+		{
+			if constexpr (isSimdRange<Iterator>()) {
+				using Type = std::remove_cv_t<iter_element_t<Iterator>>;
+				return std::is_same_v<Type, T> && (std::is_same_v<BinaryOp, std::plus<>> || std::is_same_v<BinaryOp, std::plus<Type>>);
+			} else {
+				return false;
+			}
+		}
+
+		// Four accumulators, so each add doesn't wait on the one before.
+		struct simd_sum
+		{
+			template <class Abi, class Type>
+			static Type run(const Type* p, brisk::size_t n) noexcept
+			{
+				using V = basic_simd<Type, Abi>;
+				constexpr brisk::size_t lanes = V::size();
+				V sum0, sum1, sum2, sum3;
+				brisk::size_t i = 0;
+				for (; i + 4 * lanes <= n; i += 4 * lanes) {
+					sum0 += V::load(p + i);
+					sum1 += V::load(p + i + lanes);
+					sum2 += V::load(p + i + 2 * lanes);
+					sum3 += V::load(p + i + 3 * lanes);
+				}
+				for (; i + lanes <= n; i += lanes) {
+					sum0 += V::load(p + i);
+				}
+
+				Type sum = brisk::reduce_add((sum0 + sum1) + (sum2 + sum3));
+				for (; i < n; ++i) {
+					sum = wrapAdd(sum, p[i]);
+				}
+
+				return sum;
+			}
+		};
+	}
+
 	template <class Iterator, class T>
-	constexpr void fill(Iterator first, Iterator last, const T&& value)
+	constexpr void fill(Iterator first, Iterator last, const T& value)
 	{
+		if constexpr (detail::isMemsettable<Iterator, T>()) {
+			if (!std::is_constant_evaluated() && first != last) {
+				const detail::iter_element_t<Iterator> element = value;
+				if (detail::memsetFill(std::to_address(first), static_cast<brisk::size_t>(last - first), element))
+					return;
+
+				if constexpr (detail::isSimdElement<detail::iter_element_t<Iterator>>) {
+					brisk::simd_dispatch<detail::simd_fill>(std::to_address(first), static_cast<brisk::size_t>(last - first), element);
+					return;
+				}
+			}
+		}
+
 		for (; first != last; ++first)
-			*first = brisk::move(value);
+			*first = value;
 	}
 
 	template <class Iterator, class Size, class T>
-	constexpr Iterator fill_n(Iterator first, Size count, const T&& value)
+	constexpr Iterator fill_n(Iterator first, Size count, const T& value)
 	{
+		if constexpr (detail::isMemsettable<Iterator, T>()) {
+			if (count <= 0)
+				return first;
+
+			brisk::fill(first, first + count, value);
+			return first + count;
+		}
+
 		for (Size i = 0; i < count; i++)
-			*first++ = brisk::move(value);
+			*first++ = value;
 		
 		return first;
 	}
@@ -38,15 +218,332 @@ namespace brisk
 		return f;
 	}
 
+	// Contiguous integers summed into a total of their own type go through
+	// simd_dispatch: they wrap around, so any order gives the same answer.
+	// Floating-point sums are left in order; reduce is the one free to
+	// vectorize those.
 	template <class Iterator, class T>
 	T accumulate(Iterator first, Iterator last, T init)
+	{
+		if constexpr (detail::isSimdSum<Iterator, T, std::plus<>>() && std::is_integral_v<T>) {
+			return detail::wrapAdd(init, brisk::simd_dispatch<detail::simd_sum>(std::to_address(first), static_cast<brisk::size_t>(last - first)));
+		} else {
+			for (; first != last; ++first)
+				init = brisk::move(init) + *first;
+
+			return init;
+		}
+	}
+
+	template <class Iterator, class T, class BinaryOp>
+	T accumulate(Iterator first, Iterator last, T init, BinaryOp op)
 	{
 		for (; first != last; ++first)
-			init = brisk::move(init) + *first;
-		
+			init = op(brisk::move(init), *first);
+
 		return init;
 	}
 
+	template <class Iterator, class Size, class Function>
+	Iterator for_each_n(Iterator first, Size count, Function f)
+	{
+		for (Size i = 0; i < count; i++, ++first)
+			f(*first);
+
+		return first;
+	}
+
+	template <class Iterator, class OutIterator, class UnaryOp>
+	OutIterator transform(Iterator first, Iterator last, OutIterator d_first, UnaryOp op)
+	{
+		for (; first != last; ++first, ++d_first)
+			*d_first = op(*first);
+
+		return d_first;
+	}
+
+	template <class Iterator, class Iterator2, class OutIterator, class BinaryOp>
+	OutIterator transform(Iterator first1, Iterator last1, Iterator2 first2, OutIterator d_first, BinaryOp op)
+	{
+		for (; first1 != last1; ++first1, ++first2, ++d_first)
+			*d_first = op(*first1, *first2);
+
+		return d_first;
+	}
+
+	// Like accumulate, except that the parallel overloads in execution.hpp
+	// may group the operations differently, so op should be associative and
+	// commutative.
+	template <class Iterator, class T, class BinaryOp>
+	T reduce(Iterator first, Iterator last, T init, BinaryOp op)
+	{
+		if constexpr (detail::isSimdSum<Iterator, T, BinaryOp>()) {
+			return detail::wrapAdd(init, brisk::simd_dispatch<detail::simd_sum>(std::to_address(first), static_cast<brisk::size_t>(last - first)));
+		} else {
+			for (; first != last; ++first)
+				init = op(brisk::move(init), *first);
+
+			return init;
+		}
+	}
+
+	template <class Iterator, class T>
+	T reduce(Iterator first, Iterator last, T init)
+	{
+		return brisk::reduce(first, last, brisk::move(init), std::plus<>());
+	}
+
+	template <class Iterator>
+	typename std::iterator_traits<Iterator>::value_type reduce(Iterator first, Iterator last)
+	{
+		return brisk::reduce(first, last, typename std::iterator_traits<Iterator>::value_type(), std::plus<>());
+	}
+
+	template <class Iterator, class T, class ReduceOp, class TransformOp>
+	T transform_reduce(Iterator first, Iterator last, T init, ReduceOp reduce, TransformOp transform)
+	{
+		for (; first != last; ++first)
+			init = reduce(brisk::move(init), transform(*first));
+
+		return init;
+	}
+
+	template <class Iterator, class Iterator2, class T, class ReduceOp, class TransformOp>
+	T transform_reduce(Iterator first1, Iterator last1, Iterator2 first2, T init, ReduceOp reduce, TransformOp transform)
+	{
+		for (; first1 != last1; ++first1, ++first2)
+			init = reduce(brisk::move(init), transform(*first1, *first2));
+
+		return init;
+	}
+
+	template <class Iterator, class Iterator2, class T>
+	T transform_reduce(Iterator first1, Iterator last1, Iterator2 first2, T init)
+	{
+		return brisk::transform_reduce(first1, last1, first2, brisk::move(init), std::plus<>(), std::multiplies<>());
+	}
+
+	namespace detail
+	{
+		// Contiguous 32-bit integers summed with plus, which the SIMD scan
+		// kernel handles.
+		template <class Iterator, class OutIterator, class T, class BinaryOp>
+		constexpr bool isSimdScan()
+		{
+			if constexpr (std::contiguous_iterator<Iterator> && std::contiguous_iterator<OutIterator>) {
+				using Type = std::remove_cv_t<iter_element_t<Iterator>>;
+				return std::is_same_v<Type, iter_element_t<OutIterator>> && std::is_same_v<Type, T>
+					&& std::is_integral_v<Type> && !std::is_same_v<Type, bool> && sizeof(Type) == 4
+					&& (std::is_same_v<BinaryOp, std::plus<>> || std::is_same_v<BinaryOp, std::plus<Type>>);
+			} else {
+				return false;
+			}
+		}
+
+		template <bool Exclusive, class Type>
+		Type scalarScan(const Type* in, Type* out, brisk::size_t n, Type total) noexcept
+		{
+			for (brisk::size_t i = 0; i < n; ++i) {
+				Type x = in[i];
+				out[i] = Exclusive ? total : static_cast<Type>(total + x);
+				total = static_cast<Type>(total + x);
+			}
+
+			return total;
+		}
+
+		// Prefix sums a vector at a time: two shifted adds give every lane
+		// the sum of the lanes up to it, and the running total is added to
+		// all of them and then broadcast from the last lane. Exclusive takes
+		// each lane's own element back off. Returns the running total.
+		template <bool Exclusive, bool Stream, class Type>
+		Type vectorScan(const Type* in, Type* out, brisk::size_t n, Type total) noexcept
+		{
+			brisk::size_t i = 0;
+#if defined(__AVX2__)
+			const __m256i lowTop = _mm256_set1_epi32(3);
+			const __m256i top = _mm256_set1_epi32(7);
+			__m256i sum = _mm256_set1_epi32(static_cast<int>(total));
+			for (; i + 8 <= n; i += 8) {
+				__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+				__m256i p = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+				p = _mm256_add_epi32(p, _mm256_slli_si256(p, 8));
+				// the shifts stay within 128-bit halves; carry the low one over
+				p = _mm256_add_epi32(p, _mm256_blend_epi32(_mm256_setzero_si256(), _mm256_permutevar8x32_epi32(p, lowTop), 0xf0));
+				p = _mm256_add_epi32(p, sum);
+				if constexpr (Stream) {
+					_mm256_stream_si256(reinterpret_cast<__m256i*>(out + i), Exclusive ? _mm256_sub_epi32(p, x) : p);
+				} else {
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), Exclusive ? _mm256_sub_epi32(p, x) : p);
+				}
+				sum = _mm256_permutevar8x32_epi32(p, top);
+			}
+			total = static_cast<Type>(_mm256_cvtsi256_si32(sum));
+#elif defined(__SSE2__)
+			__m128i sum = _mm_set1_epi32(static_cast<int>(total));
+			for (; i + 4 <= n; i += 4) {
+				__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+				__m128i p = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+				p = _mm_add_epi32(p, _mm_slli_si128(p, 8));
+				p = _mm_add_epi32(p, sum);
+				if constexpr (Stream) {
+					_mm_stream_si128(reinterpret_cast<__m128i*>(out + i), Exclusive ? _mm_sub_epi32(p, x) : p);
+				} else {
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), Exclusive ? _mm_sub_epi32(p, x) : p);
+				}
+				sum = _mm_shuffle_epi32(p, 0xff);
+			}
+			total = static_cast<Type>(_mm_cvtsi128_si32(sum));
+#endif
+			return scalarScan<Exclusive>(in + i, out + i, n - i, total);
+		}
+
+		// Outputs this large are written around the cache, which saves
+		// reading in every line just to overwrite it.
+		constexpr brisk::size_t streamScanBytes = brisk::size_t(8) << 20;
+
+		template <bool Exclusive, class Type>
+		Type simdScan(const Type* in, Type* out, brisk::size_t n, Type total) noexcept
+		{
+#if defined(__SSE2__)
+			if (n * sizeof(Type) >= streamScanBytes && in != out) {
+#if defined(__AVX2__)
+				constexpr std::uintptr_t alignment = 32;
+#else
+				constexpr std::uintptr_t alignment = 16;
+#endif
+				// streaming stores have to be aligned
+				brisk::size_t head = static_cast<brisk::size_t>((alignment - reinterpret_cast<std::uintptr_t>(out) % alignment) % alignment) / sizeof(Type);
+				total = scalarScan<Exclusive>(in, out, head, total);
+				total = vectorScan<Exclusive, true>(in + head, out + head, n - head, total);
+				_mm_sfence();
+				return total;
+			}
+#endif
+			return vectorScan<Exclusive, false>(in, out, n, total);
+		}
+	}
+
+	// Prefix sums, d_first[i] being init op first[0] op ... op first[i].
+	// d_first may be first. Contiguous 32-bit integers added up with
+	// std::plus go through an SSE2 kernel, or AVX2 when compiled for it.
+	template <class Iterator, class OutIterator, class BinaryOp, class T>
+	OutIterator inclusive_scan(Iterator first, Iterator last, OutIterator d_first, BinaryOp op, T init)
+	{
+		if constexpr (detail::isSimdScan<Iterator, OutIterator, T, BinaryOp>()) {
+			brisk::size_t n = static_cast<brisk::size_t>(last - first);
+			detail::simdScan<false>(std::to_address(first), std::to_address(d_first), n, init);
+			return d_first + n;
+		} else {
+			for (; first != last; ++first, ++d_first) {
+				init = op(brisk::move(init), *first);
+				*d_first = init;
+			}
+
+			return d_first;
+		}
+	}
+
+	template <class Iterator, class OutIterator, class BinaryOp>
+	OutIterator inclusive_scan(Iterator first, Iterator last, OutIterator d_first, BinaryOp op)
+	{
+		if (first == last) {
+			return d_first;
+		}
+
+		typename std::iterator_traits<Iterator>::value_type init = *first;
+		*d_first = init;
+		return brisk::inclusive_scan(++first, last, ++d_first, op, brisk::move(init));
+	}
+
+	template <class Iterator, class OutIterator>
+	OutIterator inclusive_scan(Iterator first, Iterator last, OutIterator d_first)
+	{
+		return brisk::inclusive_scan(first, last, d_first, std::plus<>());
+	}
+
+	// d_first[i] is init op first[0] op ... op first[i - 1], so d_first[0]
+	// is init. Offsets from sizes.
+	template <class Iterator, class OutIterator, class T, class BinaryOp>
+	OutIterator exclusive_scan(Iterator first, Iterator last, OutIterator d_first, T init, BinaryOp op)
+	{
+		if constexpr (detail::isSimdScan<Iterator, OutIterator, T, BinaryOp>()) {
+			brisk::size_t n = static_cast<brisk::size_t>(last - first);
+			detail::simdScan<true>(std::to_address(first), std::to_address(d_first), n, init);
+			return d_first + n;
+		} else {
+			for (; first != last; ++first, ++d_first) {
+				T next = op(init, *first);
+				*d_first = brisk::move(init);
+				init = brisk::move(next);
+			}
+
+			return d_first;
+		}
+	}
+
+	template <class Iterator, class OutIterator, class T>
+	OutIterator exclusive_scan(Iterator first, Iterator last, OutIterator d_first, T init)
+	{
+		return brisk::exclusive_scan(first, last, d_first, brisk::move(init), std::plus<>());
+	}
+
+	template <class Iterator, class OutIterator, class BinaryOp, class UnaryOp, class T>
+	OutIterator transform_inclusive_scan(Iterator first, Iterator last, OutIterator d_first, BinaryOp op, UnaryOp transform, T init)
+	{
+		for (; first != last; ++first, ++d_first) {
+			init = op(brisk::move(init), transform(*first));
+			*d_first = init;
+		}
+
+		return d_first;
+	}
+
+	template <class Iterator, class OutIterator, class BinaryOp, class UnaryOp>
+	OutIterator transform_inclusive_scan(Iterator first, Iterator last, OutIterator d_first, BinaryOp op, UnaryOp transform)
+	{
+		if (first == last) {
+			return d_first;
+		}
+
+		auto init = transform(*first);
+		*d_first = init;
+		return brisk::transform_inclusive_scan(++first, last, ++d_first, op, transform, brisk::move(init));
+	}
+
+	template <class Iterator, class OutIterator, class T, class BinaryOp, class UnaryOp>
+	OutIterator transform_exclusive_scan(Iterator first, Iterator last, OutIterator d_first, T init, BinaryOp op, UnaryOp transform)
+	{
+		for (; first != last; ++first, ++d_first) {
+			T next = op(init, transform(*first));
+			*d_first = brisk::move(init);
+			init = brisk::move(next);
+		}
+
+		return d_first;
+	}
+
+	template <class Iterator, class Predicate>
+	typename std::iterator_traits<Iterator>::difference_type count_if(Iterator first, Iterator last, Predicate pred)
+	{
+		typename std::iterator_traits<Iterator>::difference_type count = 0;
+		for (; first != last; ++first)
+			if (pred(*first))
+				++count;
+
+		return count;
+	}
+
+	template <class Iterator, class Predicate>
+	Iterator find_if(Iterator first, Iterator last, Predicate pred)
+	{
+		for (; first != last; ++first)
+			if (pred(*first))
+				return first;
+
+		return last;
+	}
+
 	template <class T>
 	constexpr void swap(T& a, T& b) noexcept
 	{
@@ -55,15 +552,118 @@ namespace brisk
 		b = brisk::move(temp);
 	}
 
+	// copy, copy_n, copy_backward, move and move_backward are one memmove
+	// for contiguous ranges of trivially copyable types, so the ranges may
+	// overlap the way the element loops would allow.
 	template <class Iterator, class DestIterator>
-	Iterator copy(Iterator first, Iterator last, DestIterator d_first)
+	constexpr DestIterator copy(Iterator first, Iterator last, DestIterator d_first)
 	{
-		while (first != last)
-			*first++ = *d_first++;
+		if constexpr (detail::isMemmovable<Iterator, DestIterator>()) {
+			if (!std::is_constant_evaluated()) {
+				brisk::size_t n = static_cast<brisk::size_t>(last - first);
+				if (n != 0)
+					std::memmove(std::to_address(d_first), std::to_address(first), n * sizeof(detail::iter_element_t<DestIterator>));
+
+				return d_first + n;
+			}
+		}
+
+		for (; first != last; ++first, ++d_first)
+			*d_first = *first;
 		
 		return d_first;
 	}
 
+	template <class Iterator, class Size, class DestIterator>
+	constexpr DestIterator copy_n(Iterator first, Size count, DestIterator d_first)
+	{
+		if constexpr (detail::isMemmovable<Iterator, DestIterator>()) {
+			return (count > 0) ? brisk::copy(first, first + count, d_first) : d_first;
+		}
+
+		for (Size i = 0; i < count; i++, ++first, ++d_first)
+			*d_first = *first;
+
+		return d_first;
+	}
+
+	template <class Iterator, class DestIterator>
+	constexpr DestIterator copy_backward(Iterator first, Iterator last, DestIterator d_last)
+	{
+		if constexpr (detail::isMemmovable<Iterator, DestIterator>()) {
+			if (!std::is_constant_evaluated()) {
+				brisk::size_t n = static_cast<brisk::size_t>(last - first);
+				if (n != 0)
+					std::memmove(std::to_address(d_last) - n, std::to_address(first), n * sizeof(detail::iter_element_t<DestIterator>));
+
+				return d_last - n;
+			}
+		}
+
+		while (first != last)
+			*--d_last = *--last;
+
+		return d_last;
+	}
+
+	template <class Iterator, class DestIterator>
+	constexpr DestIterator move(Iterator first, Iterator last, DestIterator d_first)
+	{
+		if constexpr (detail::isMemmovable<Iterator, DestIterator>()) {
+			return brisk::copy(first, last, d_first);
+		}
+
+		for (; first != last; ++first, ++d_first)
+			*d_first = brisk::move(*first);
+
+		return d_first;
+	}
+
+	template <class Iterator, class DestIterator>
+	constexpr DestIterator move_backward(Iterator first, Iterator last, DestIterator d_last)
+	{
+		if constexpr (detail::isMemmovable<Iterator, DestIterator>()) {
+			return brisk::copy_backward(first, last, d_last);
+		}
+
+		while (first != last)
+			*--d_last = brisk::move(*--last);
+
+		return d_last;
+	}
+
+	// Swaps two ranges that don't overlap. Trivially copyable contiguous
+	// ranges go through a small stack buffer a block at a time.
+	template <class Iterator, class Iterator2>
+	constexpr Iterator2 swap_ranges(Iterator first1, Iterator last1, Iterator2 first2)
+	{
+		if constexpr (detail::isMemmovable<Iterator, Iterator2>() && !std::is_const_v<detail::iter_element_t<Iterator>>) {
+			if (!std::is_constant_evaluated()) {
+				using Type = detail::iter_element_t<Iterator>;
+				constexpr brisk::size_t blockBytes = 256;
+				constexpr brisk::size_t block = (sizeof(Type) < blockBytes) ? blockBytes / sizeof(Type) : 1;
+				alignas(Type) unsigned char buffer[block * sizeof(Type)];
+
+				Type* a = std::to_address(first1);
+				Type* b = std::to_address(first2);
+				brisk::size_t n = static_cast<brisk::size_t>(last1 - first1);
+				for (brisk::size_t done = 0; done < n; done += block) {
+					brisk::size_t bytes = ((n - done < block) ? n - done : block) * sizeof(Type);
+					std::memcpy(buffer, a + done, bytes);
+					std::memcpy(a + done, b + done, bytes);
+					std::memcpy(b + done, buffer, bytes);
+				}
+
+				return first2 + n;
+			}
+		}
+
+		for (; first1 != last1; ++first1, ++first2)
+			brisk::swap(*first1, *first2);
+
+		return first2;
+	}
+
 	template <class T>
 	constexpr const T& min(const T& x, const T& y) noexcept
 	{
@@ -76,6 +676,1449 @@ namespace brisk
 		return (x > y) ? x : y;
 	}
 
+	namespace detail
+	{
+		// The index of the first least, or with Greatest the first greatest,
+		// of n > 0 integers. Each block of a few KB is reduced lane-wise, and
+		// only one that beats the best so far is searched again, from L1,
+		// for where.
+		template <bool Greatest>
+		struct simd_extreme
+		{
+			template <class Abi, class Type>
+			static brisk::size_t run(const Type* p, brisk::size_t n) noexcept
+			{
+				if constexpr (std::is_same_v<Abi, simd_abi::sse2> && sizeof(Type) == 8) {
+					// SSE2 builds 64-bit compares out of 32-bit ones; cmov is faster
+					return run<simd_abi::scalar>(p, n);
+				}
+
+				using V = basic_simd<Type, Abi>;
+				constexpr brisk::size_t lanes = V::size();
+				constexpr brisk::size_t block = 4096 / sizeof(Type);
+				brisk::size_t best = 0;
+				Type bestValue = p[0];
+				for (brisk::size_t start = 0; start < n; start += block) {
+					const brisk::size_t end = (n - start < block) ? n : start + block;
+					V e0(p[start]), e1(p[start]), e2(p[start]), e3(p[start]);
+					brisk::size_t i = start;
+					for (; i + 4 * lanes <= end; i += 4 * lanes) {
+						e0 = Greatest ? brisk::max(e0, V::load(p + i)) : brisk::min(e0, V::load(p + i));
+						e1 = Greatest ? brisk::max(e1, V::load(p + i + lanes)) : brisk::min(e1, V::load(p + i + lanes));
+						e2 = Greatest ? brisk::max(e2, V::load(p + i + 2 * lanes)) : brisk::min(e2, V::load(p + i + 2 * lanes));
+						e3 = Greatest ? brisk::max(e3, V::load(p + i + 3 * lanes)) : brisk::min(e3, V::load(p + i + 3 * lanes));
+					}
+					for (; i + lanes <= end; i += lanes) {
+						e0 = Greatest ? brisk::max(e0, V::load(p + i)) : brisk::min(e0, V::load(p + i));
+					}
+
+					Type value = Greatest ? brisk::reduce_max(brisk::max(brisk::max(e0, e1), brisk::max(e2, e3)))
+						: brisk::reduce_min(brisk::min(brisk::min(e0, e1), brisk::min(e2, e3)));
+					for (; i < end; ++i) {
+						value = Greatest ? brisk::max(value, p[i]) : brisk::min(value, p[i]);
+					}
+
+					if (Greatest ? bestValue < value : value < bestValue) {
+						bestValue = value;
+						best = find<Abi>(p, start, end, value);
+					}
+				}
+
+				return best;
+			}
+
+			template <class Abi, class Type>
+			static brisk::size_t find(const Type* p, brisk::size_t start, brisk::size_t end, Type value) noexcept
+			{
+				using V = basic_simd<Type, Abi>;
+				const V target(value);
+				brisk::size_t i = start;
+				for (; i + V::size() <= end; i += V::size()) {
+					const std::uint64_t bits = (V::load(p + i) == target).to_bits();
+					if (bits != 0) {
+						return i + static_cast<brisk::size_t>(std::countr_zero(bits));
+					}
+				}
+				for (; i < end && p[i] != value; ++i) {
+
+				}
+
+				return i;
+			}
+		};
+	}
+
+	template <class Iterator, class Compare>
+	Iterator min_element(Iterator first, Iterator last, Compare comp)
+	{
+		if (first == last)
+			return last;
+
+		Iterator best = first;
+		for (++first; first != last; ++first) {
+			if (comp(*first, *best))
+				best = first;
+		}
+
+		return best;
+	}
+
+	// Contiguous integers are searched with simd_dispatch. Floats aren't:
+	// a NaN has no place in the order the lanes would need.
+	template <class Iterator>
+	Iterator min_element(Iterator first, Iterator last)
+	{
+		if constexpr (detail::isSimdRange<Iterator>() && std::is_integral_v<detail::iter_element_t<Iterator>>) {
+			if (first == last)
+				return last;
+
+			return first + static_cast<std::iter_difference_t<Iterator>>(
+				brisk::simd_dispatch<detail::simd_extreme<false>>(std::to_address(first), static_cast<brisk::size_t>(last - first)));
+		} else {
+			return brisk::min_element(first, last, brisk::less<>());
+		}
+	}
+
+	// The first of the greatest, as std::max_element.
+	template <class Iterator, class Compare>
+	Iterator max_element(Iterator first, Iterator last, Compare comp)
+	{
+		if (first == last)
+			return last;
+
+		Iterator best = first;
+		for (++first; first != last; ++first) {
+			if (comp(*best, *first))
+				best = first;
+		}
+
+		return best;
+	}
+
+	template <class Iterator>
+	Iterator max_element(Iterator first, Iterator last)
+	{
+		if constexpr (detail::isSimdRange<Iterator>() && std::is_integral_v<detail::iter_element_t<Iterator>>) {
+			if (first == last)
+				return last;
+
+			return first + static_cast<std::iter_difference_t<Iterator>>(
+				brisk::simd_dispatch<detail::simd_extreme<true>>(std::to_address(first), static_cast<brisk::size_t>(last - first)));
+		} else {
+			return brisk::max_element(first, last, brisk::less<>());
+		}
+	}
+
+	namespace detail
+	{
+		struct simd_equal
+		{
+			template <class Abi, class Type>
+			static bool run(const Type* a, const Type* b, brisk::size_t n) noexcept
+			{
+				using V = basic_simd<Type, Abi>;
+				constexpr brisk::size_t lanes = V::size();
+				brisk::size_t i = 0;
+				for (; i + 4 * lanes <= n; i += 4 * lanes) {
+					const auto same = (V::load(a + i) == V::load(b + i)) & (V::load(a + i + lanes) == V::load(b + i + lanes))
+						& (V::load(a + i + 2 * lanes) == V::load(b + i + 2 * lanes)) & (V::load(a + i + 3 * lanes) == V::load(b + i + 3 * lanes));
+					if (!brisk::all_of(same)) {
+						return false;
+					}
+				}
+				for (; i + lanes <= n; i += lanes) {
+					if (!brisk::all_of(V::load(a + i) == V::load(b + i))) {
+						return false;
+					}
+				}
+				for (; i < n; ++i) {
+					if (!(a[i] == b[i])) {
+						return false;
+					}
+				}
+
+				return true;
+			}
+		};
+
+		// Whether a[i] == b[i] for all i < n. Integers, bools and pointers are
+		// equal exactly when their bytes are, so they're one memcmp. Floats
+		// aren't (0.0 == -0.0, NaN != NaN) and are compared in simd lanes;
+		// anything else uses its own ==.
+		template <class Type>
+		bool equalElements(const Type* a, const Type* b, brisk::size_t n)
+		{
+			if constexpr (std::is_integral_v<Type> || std::is_pointer_v<Type>) {
+				return n == 0 || std::memcmp(a, b, n * sizeof(Type)) == 0;
+			} else if constexpr (isSimdElement<Type>) {
+				return brisk::simd_dispatch<simd_equal>(a, b, n);
+			} else {
+				for (brisk::size_t i = 0; i < n; ++i) {
+					if (a[i] != b[i]) {
+						return false;
+					}
+				}
+
+				return true;
+			}
+		}
+	}
+
+	namespace detail
+	{
+		// Scratch space for the sorts that need it, from the default resource.
+		// Slots start out raw; constructed(n) records that the first n hold
+		// live objects, so only those are destroyed.
+		template <class Type>
+		class sort_buffer
+		{
+		public:
+			explicit sort_buffer(brisk::size_t size)
+				: m_data(nullptr), m_size(size), m_constructed(0)
+			{
+				BRISK_HEAP_SAMPLE(size * sizeof(Type));
+				m_data = static_cast<Type*>(brisk::get_default_resource()->allocate(size * sizeof(Type), alignof(Type)));
+			}
+
+			sort_buffer(const sort_buffer&) = delete;
+			sort_buffer& operator=(const sort_buffer&) = delete;
+
+			~sort_buffer()
+			{
+				for (brisk::size_t i = 0; i < m_constructed; ++i) {
+					m_data[i].~Type();
+				}
+
+				brisk::get_default_resource()->deallocate(m_data, m_size * sizeof(Type), alignof(Type));
+			}
+
+			Type* data() const noexcept
+			{
+				return m_data;
+			}
+
+			brisk::size_t constructed() const noexcept
+			{
+				return m_constructed;
+			}
+
+			void constructed(brisk::size_t count) noexcept
+			{
+				if (count > m_constructed) {
+					m_constructed = count;
+				}
+			}
+
+		private:
+			Type* m_data;
+			brisk::size_t m_size;
+			brisk::size_t m_constructed;
+		};
+
+		template <class Iterator>
+		using iter_value_t = typename std::iterator_traits<Iterator>::value_type;
+
+		template <class Iterator>
+		using iter_difference_t = typename std::iterator_traits<Iterator>::difference_type;
+
+		template <class Iterator>
+		constexpr void iterSwap(Iterator a, Iterator b)
+		{
+			iter_value_t<Iterator> temp = brisk::move(*a);
+			*a = brisk::move(*b);
+			*b = brisk::move(temp);
+		}
+
+		// The plain less-than and greater-than comparators, the only ones
+		// whose order is known without calling them. They get the branchless
+		// partition and the radix sort dispatch.
+		template <class Compare, class Type>
+		constexpr bool isLess = std::is_same_v<Compare, brisk::less<>> || std::is_same_v<Compare, brisk::less<Type>>
+			|| std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<Type>>;
+
+		template <class Compare, class Type>
+		constexpr bool isGreater = std::is_same_v<Compare, brisk::greater<>> || std::is_same_v<Compare, brisk::greater<Type>>
+			|| std::is_same_v<Compare, std::greater<>> || std::is_same_v<Compare, std::greater<Type>>;
+
+		// Keys radix_sort can order by their bits: integers, and IEEE floats
+		// and doubles.
+		template <class Key>
+		constexpr bool isRadixKey = (std::is_integral_v<Key> && !std::is_same_v<Key, bool>)
+			|| (std::is_floating_point_v<Key> && std::numeric_limits<Key>::is_iec559 && (sizeof(Key) == 4 || sizeof(Key) == 8));
+
+		template <brisk::size_t Bytes> struct radix_unsigned;
+		template <> struct radix_unsigned<1> { using type = std::uint8_t; };
+		template <> struct radix_unsigned<2> { using type = std::uint16_t; };
+		template <> struct radix_unsigned<4> { using type = std::uint32_t; };
+		template <> struct radix_unsigned<8> { using type = std::uint64_t; };
+
+		// Maps a key to an unsigned integer with the same order: signed
+		// integers get their sign bit flipped, negative floats all their bits
+		// and positive floats just the sign bit.
+		template <class Key>
+		constexpr auto radixBits(Key key) noexcept
+		{
+			using Bits = typename radix_unsigned<sizeof(Key)>::type;
+			constexpr Bits sign = Bits(1) << (sizeof(Key) * 8 - 1);
+			if constexpr (std::is_floating_point_v<Key>) {
+				Bits bits = std::bit_cast<Bits>(key);
+				return (bits & sign) ? Bits(~bits) : Bits(bits | sign);
+			} else if constexpr (std::is_signed_v<Key>) {
+				return Bits(Bits(key) ^ sign);
+			} else {
+				return Bits(key);
+			}
+		}
+
+		// LSD radix sort a byte at a time, so it's stable. All the histograms
+		// come from one read pass, and a pass whose byte is the same in every
+		// key is skipped. Elements move between the range and the buffer,
+		// and back again if they finish in the buffer.
+		template <class Iterator, class Projection>
+		void radixSort(Iterator first, Iterator last, Projection& key, bool descending)
+		{
+			using Type = iter_value_t<Iterator>;
+			using Key = std::decay_t<std::invoke_result_t<Projection&, Type&>>;
+			using Bits = decltype(radixBits(Key()));
+			constexpr brisk::size_t passes = sizeof(Bits);
+			static_assert(isRadixKey<Key>, "[brisk::radix_sort]: key must be an integer, float or double");
+			static_assert(std::is_nothrow_move_constructible_v<Type> && std::is_nothrow_move_assignable_v<Type>,
+				"[brisk::radix_sort]: elements must be nothrow movable");
+
+			const brisk::size_t n = static_cast<brisk::size_t>(last - first);
+			if (n < 2) {
+				return;
+			}
+
+			const Bits flip = descending ? Bits(~Bits(0)) : Bits(0);
+			brisk::size_t counts[passes][256] = {};
+			for (Iterator it = first; it != last; ++it) {
+				Bits bits = radixBits(key(*it)) ^ flip;
+				for (brisk::size_t pass = 0; pass < passes; ++pass) {
+					++counts[pass][(bits >> (pass * 8)) & 0xff];
+				}
+			}
+
+			sort_buffer<Type> buffer(n);
+			Type* scratch = buffer.data();
+			bool inScratch = false;
+			for (brisk::size_t pass = 0; pass < passes; ++pass) {
+				brisk::size_t* count = counts[pass];
+				const unsigned shift = static_cast<unsigned>(pass * 8);
+				if (count[(radixBits(key(inScratch ? scratch[0] : *first)) ^ flip) >> shift & 0xff] == n) {
+					continue;
+				}
+
+				brisk::size_t offset = 0;
+				for (brisk::size_t b = 0; b < 256; ++b) {
+					brisk::size_t c = count[b];
+					count[b] = offset;
+					offset += c;
+				}
+
+				if (inScratch) {
+					for (brisk::size_t i = 0; i < n; ++i) {
+						first[count[(radixBits(key(scratch[i])) ^ flip) >> shift & 0xff]++] = brisk::move(scratch[i]);
+					}
+				} else if (buffer.constructed() == n) {
+					for (Iterator it = first; it != last; ++it) {
+						scratch[count[(radixBits(key(*it)) ^ flip) >> shift & 0xff]++] = brisk::move(*it);
+					}
+				} else {
+					for (Iterator it = first; it != last; ++it) {
+						::new (static_cast<void*>(scratch + count[(radixBits(key(*it)) ^ flip) >> shift & 0xff]++)) Type(brisk::move(*it));
+					}
+					buffer.constructed(n);
+				}
+
+				inScratch = !inScratch;
+			}
+
+			if (inScratch) {
+				for (brisk::size_t i = 0; i < n; ++i) {
+					first[i] = brisk::move(scratch[i]);
+				}
+			}
+		}
+
+		struct identity
+		{
+			template <class Type>
+			constexpr Type&& operator()(Type&& value) const noexcept
+			{
+				return brisk::forward<Type>(value);
+			}
+		};
+
+		// Below these sizes pdqsort beats a pass per key byte on random
+		// input. Measured with sort_benchmark.
+		template <class Type>
+		constexpr brisk::size_t radixThreshold = (sizeof(Type) <= 2) ? 256 : (sizeof(Type) <= 4) ? 4096 : 16384;
+
+		template <class Iterator, class Compare>
+		constexpr bool radixDispatch = std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>
+			&& isRadixKey<iter_value_t<Iterator>>
+			&& (isLess<Compare, iter_value_t<Iterator>> || isGreater<Compare, iter_value_t<Iterator>>);
+
+		// Finishes a non-empty range that is already in order, or strictly
+		// in reverse, and says whether it did. On anything else it stops
+		// looking within a few elements.
+		template <class Iterator, class Compare>
+		bool sortPresorted(Iterator first, Iterator last, Compare& comp)
+		{
+			Iterator next = first + 1;
+			while (next != last && !comp(*next, *(next - 1))) {
+				++next;
+			}
+
+			if (next == last) {
+				return true;
+			}
+
+			if (next == first + 1) {
+				while (next != last && comp(*next, *(next - 1))) {
+					++next;
+				}
+
+				if (next == last) {
+					for (Iterator l = first, r = last - 1; l < r; ++l, --r) {
+						iterSwap(l, r);
+					}
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		// Sorts [first, last) by radix if that's the faster choice and the
+		// scratch memory is there; returns false to leave it to the caller.
+		// Radix sort does every pass even on presorted input, so that is
+		// checked for first.
+		template <class Iterator, class Compare>
+		bool tryRadixSort(Iterator first, Iterator last, Compare& comp)
+		{
+			if constexpr (radixDispatch<Iterator, Compare>) {
+				if (static_cast<brisk::size_t>(last - first) >= radixThreshold<iter_value_t<Iterator>>) {
+					if (sortPresorted(first, last, comp)) {
+						return true;
+					}
+
+					try {
+						identity key;
+						radixSort(first, last, key, isGreater<Compare, iter_value_t<Iterator>>);
+						return true;
+					} catch (const std::bad_alloc&) {
+						return false;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		// pdqsort: Orson Peters' pattern-defeating quicksort. Introsort with
+		// a median-of-3 (ninther past 128 elements) pivot, a left partition
+		// that puts runs of equal elements in place, insertion sort on nearly
+		// sorted partitions, pivot shuffles after unbalanced partitions and
+		// heapsort once there have been log2(n) of those.
+		constexpr brisk::ptrdiff_t insertionSortThreshold = 24;
+		constexpr brisk::ptrdiff_t nintherThreshold = 128;
+		constexpr brisk::size_t partialInsertionSortLimit = 8;
+		constexpr brisk::size_t partitionBlockSize = 64;
+
+		template <class Iterator, class Compare>
+		void insertionSort(Iterator first, Iterator last, Compare& comp)
+		{
+			if (first == last) {
+				return;
+			}
+
+			for (Iterator cur = first + 1; cur != last; ++cur) {
+				Iterator sift = cur;
+				Iterator sift1 = cur - 1;
+				if (comp(*sift, *sift1)) {
+					iter_value_t<Iterator> temp = brisk::move(*sift);
+					do {
+						*sift-- = brisk::move(*sift1);
+					} while (sift != first && comp(temp, *--sift1));
+
+					*sift = brisk::move(temp);
+				}
+			}
+		}
+
+		// Only for ranges with an element at first - 1 that is no greater
+		// than any of them, which stops the shifting.
+		template <class Iterator, class Compare>
+		void unguardedInsertionSort(Iterator first, Iterator last, Compare& comp)
+		{
+			if (first == last) {
+				return;
+			}
+
+			for (Iterator cur = first + 1; cur != last; ++cur) {
+				Iterator sift = cur;
+				Iterator sift1 = cur - 1;
+				if (comp(*sift, *sift1)) {
+					iter_value_t<Iterator> temp = brisk::move(*sift);
+					do {
+						*sift-- = brisk::move(*sift1);
+					} while (comp(temp, *--sift1));
+
+					*sift = brisk::move(temp);
+				}
+			}
+		}
+
+		// Insertion sort that gives up once it has moved more than a few
+		// elements; returns whether the range got sorted.
+		template <class Iterator, class Compare>
+		bool partialInsertionSort(Iterator first, Iterator last, Compare& comp)
+		{
+			if (first == last) {
+				return true;
+			}
+
+			brisk::size_t moved = 0;
+			for (Iterator cur = first + 1; cur != last; ++cur) {
+				Iterator sift = cur;
+				Iterator sift1 = cur - 1;
+				if (comp(*sift, *sift1)) {
+					iter_value_t<Iterator> temp = brisk::move(*sift);
+					do {
+						*sift-- = brisk::move(*sift1);
+					} while (sift != first && comp(temp, *--sift1));
+
+					*sift = brisk::move(temp);
+					moved += static_cast<brisk::size_t>(cur - sift);
+				}
+
+				if (moved > partialInsertionSortLimit) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		template <class Iterator, class Compare>
+		void sort2(Iterator a, Iterator b, Compare& comp)
+		{
+			if (comp(*b, *a)) {
+				iterSwap(a, b);
+			}
+		}
+
+		template <class Iterator, class Compare>
+		void sort3(Iterator a, Iterator b, Iterator c, Compare& comp)
+		{
+			sort2(a, b, comp);
+			sort2(b, c, comp);
+			sort2(a, b, comp);
+		}
+
+		template <class Iterator, class Compare>
+		void siftDown(Iterator first, iter_difference_t<Iterator> size, iter_difference_t<Iterator> hole, Compare& comp)
+		{
+			iter_value_t<Iterator> value = brisk::move(first[hole]);
+			for (iter_difference_t<Iterator> child = 2 * hole + 1; child < size; child = 2 * hole + 1) {
+				if (child + 1 < size && comp(first[child], first[child + 1])) {
+					++child;
+				}
+
+				if (!comp(value, first[child])) {
+					break;
+				}
+
+				first[hole] = brisk::move(first[child]);
+				hole = child;
+			}
+
+			first[hole] = brisk::move(value);
+		}
+
+		template <class Iterator, class Compare>
+		void siftUp(Iterator first, iter_difference_t<Iterator> hole, Compare& comp)
+		{
+			iter_value_t<Iterator> value = brisk::move(first[hole]);
+			while (hole > 0) {
+				iter_difference_t<Iterator> parent = (hole - 1) / 2;
+				if (!comp(first[parent], value)) {
+					break;
+				}
+
+				first[hole] = brisk::move(first[parent]);
+				hole = parent;
+			}
+
+			first[hole] = brisk::move(value);
+		}
+
+		template <class Iterator, class Compare>
+		void makeHeap(Iterator first, iter_difference_t<Iterator> size, Compare& comp)
+		{
+			for (iter_difference_t<Iterator> i = size / 2; i > 0; --i) {
+				siftDown(first, size, i - 1, comp);
+			}
+		}
+
+		template <class Iterator, class Compare>
+		void sortHeap(Iterator first, iter_difference_t<Iterator> size, Compare& comp)
+		{
+			for (iter_difference_t<Iterator> end = size - 1; end > 0; --end) {
+				iterSwap(first, first + end);
+				siftDown(first, end, iter_difference_t<Iterator>(0), comp);
+			}
+		}
+
+		template <class Iterator, class Compare>
+		void heapSort(Iterator first, Iterator last, Compare& comp)
+		{
+			makeHeap(first, last - first, comp);
+			sortHeap(first, last - first, comp);
+		}
+
+		template <class Iterator>
+		void swapOffsets(Iterator first, Iterator last, const unsigned char* offsetsL, const unsigned char* offsetsR, brisk::size_t count, bool useSwaps)
+		{
+			if (useSwaps) {
+				// the same number on both sides: a cyclic shift could move an
+				// element onto itself, so swap pairs instead
+				for (brisk::size_t i = 0; i < count; ++i) {
+					iterSwap(first + offsetsL[i], last - offsetsR[i]);
+				}
+			} else if (count > 0) {
+				Iterator l = first + offsetsL[0];
+				Iterator r = last - offsetsR[0];
+				iter_value_t<Iterator> temp = brisk::move(*l);
+				*l = brisk::move(*r);
+				for (brisk::size_t i = 1; i < count; ++i) {
+					l = first + offsetsL[i];
+					*r = brisk::move(*l);
+					r = last - offsetsR[i];
+					*l = brisk::move(*r);
+				}
+
+				*r = brisk::move(temp);
+			}
+		}
+
+		// Partitions around *first into [< pivot][pivot][>= pivot] and returns
+		// the pivot's position; alreadyPartitioned says whether nothing had
+		// to move. The
+		// branchless version records which elements are on the wrong side a
+		// block at a time, with the comparison result added to a counter
+		// rather than branched on, and then swaps them in bulk.
+		template <class Iterator, class Compare>
+		Iterator partitionRightBranchless(Iterator begin, Iterator end, Compare& comp, bool& alreadyPartitioned)
+		{
+			iter_value_t<Iterator> pivot = brisk::move(*begin);
+			Iterator first = begin;
+			Iterator last = end;
+
+			// the median-of-3 guarantees something >= pivot on the right, and
+			// something < pivot on the left unless this is the first element
+			while (comp(*++first, pivot));
+			if (first - 1 == begin) {
+				while (first < last && !comp(*--last, pivot));
+			} else {
+				while (!comp(*--last, pivot));
+			}
+
+			alreadyPartitioned = first >= last;
+			if (!alreadyPartitioned) {
+				iterSwap(first, last);
+				++first;
+
+				alignas(64) unsigned char offsetsL[partitionBlockSize];
+				alignas(64) unsigned char offsetsR[partitionBlockSize];
+				Iterator baseL = first;
+				Iterator baseR = last;
+				brisk::size_t numL = 0, numR = 0, startL = 0, startR = 0;
+				while (first < last) {
+					// fill whichever offset buffers are empty, splitting what's
+					// left between them when both are
+					brisk::size_t unknown = static_cast<brisk::size_t>(last - first);
+					brisk::size_t splitL = (numL == 0) ? ((numR == 0) ? unknown / 2 : unknown) : 0;
+					brisk::size_t splitR = (numR == 0) ? (unknown - splitL) : 0;
+
+					if (splitL >= partitionBlockSize) {
+						for (brisk::size_t i = 0; i < partitionBlockSize;) {
+							offsetsL[numL] = static_cast<unsigned char>(i++); numL += !comp(*first, pivot); ++first;
+							offsetsL[numL] = static_cast<unsigned char>(i++); numL += !comp(*first, pivot); ++first;
+							offsetsL[numL] = static_cast<unsigned char>(i++); numL += !comp(*first, pivot); ++first;
+							offsetsL[numL] = static_cast<unsigned char>(i++); numL += !comp(*first, pivot); ++first;
+						}
+					} else {
+						for (brisk::size_t i = 0; i < splitL;) {
+							offsetsL[numL] = static_cast<unsigned char>(i++); numL += !comp(*first, pivot); ++first;
+						}
+					}
+
+					if (splitR >= partitionBlockSize) {
+						for (brisk::size_t i = 0; i < partitionBlockSize;) {
+							offsetsR[numR] = static_cast<unsigned char>(++i); numR += comp(*--last, pivot);
+							offsetsR[numR] = static_cast<unsigned char>(++i); numR += comp(*--last, pivot);
+							offsetsR[numR] = static_cast<unsigned char>(++i); numR += comp(*--last, pivot);
+							offsetsR[numR] = static_cast<unsigned char>(++i); numR += comp(*--last, pivot);
+						}
+					} else {
+						for (brisk::size_t i = 0; i < splitR;) {
+							offsetsR[numR] = static_cast<unsigned char>(++i); numR += comp(*--last, pivot);
+						}
+					}
+
+					brisk::size_t count = (numL < numR) ? numL : numR;
+					swapOffsets(baseL, baseR, offsetsL + startL, offsetsR + startR, count, numL == numR);
+					numL -= count;
+					numR -= count;
+					startL += count;
+					startR += count;
+					if (numL == 0) {
+						startL = 0;
+						baseL = first;
+					}
+
+					if (numR == 0) {
+						startR = 0;
+						baseR = last;
+					}
+				}
+
+				// one buffer may still hold misplaced elements; move them to
+				// the boundary
+				if (numL != 0) {
+					while (numL--) {
+						iterSwap(baseL + offsetsL[startL + numL], --last);
+					}
+					first = last;
+				}
+
+				if (numR != 0) {
+					while (numR--) {
+						iterSwap(baseR - offsetsR[startR + numR], first);
+						++first;
+					}
+					last = first;
+				}
+			}
+
+			Iterator pivotPos = first - 1;
+			*begin = brisk::move(*pivotPos);
+			*pivotPos = brisk::move(pivot);
+			return pivotPos;
+		}
+
+		template <class Iterator, class Compare>
+		Iterator partitionRight(Iterator begin, Iterator end, Compare& comp, bool& alreadyPartitioned)
+		{
+			iter_value_t<Iterator> pivot = brisk::move(*begin);
+			Iterator first = begin;
+			Iterator last = end;
+
+			while (comp(*++first, pivot));
+			if (first - 1 == begin) {
+				while (first < last && !comp(*--last, pivot));
+			} else {
+				while (!comp(*--last, pivot));
+			}
+
+			alreadyPartitioned = first >= last;
+			while (first < last) {
+				iterSwap(first, last);
+				while (comp(*++first, pivot));
+				while (!comp(*--last, pivot));
+			}
+
+			Iterator pivotPos = first - 1;
+			*begin = brisk::move(*pivotPos);
+			*pivotPos = brisk::move(pivot);
+			return pivotPos;
+		}
+
+		// Partitions into [<= pivot][> pivot]. Used when the pivot equals
+		// the element before the range, so everything equal to it is done.
+		template <class Iterator, class Compare>
+		Iterator partitionLeft(Iterator begin, Iterator end, Compare& comp)
+		{
+			iter_value_t<Iterator> pivot = brisk::move(*begin);
+			Iterator first = begin;
+			Iterator last = end;
+
+			while (comp(pivot, *--last));
+			if (last + 1 == end) {
+				while (first < last && !comp(pivot, *++first));
+			} else {
+				while (!comp(pivot, *++first));
+			}
+
+			while (first < last) {
+				iterSwap(first, last);
+				while (comp(pivot, *--last));
+				while (!comp(pivot, *++first));
+			}
+
+			Iterator pivotPos = last;
+			*begin = brisk::move(*pivotPos);
+			*pivotPos = brisk::move(pivot);
+			return pivotPos;
+		}
+
+		template <bool Branchless, class Iterator, class Compare>
+		void pdqsortLoop(Iterator begin, Iterator end, Compare& comp, int badAllowed, bool leftmost = true)
+		{
+			using difference_type = iter_difference_t<Iterator>;
+
+			// recurse into the left partition and loop on the right one
+			for (;;) {
+				difference_type size = end - begin;
+				if (size < insertionSortThreshold) {
+					if (leftmost) {
+						insertionSort(begin, end, comp);
+					} else {
+						unguardedInsertionSort(begin, end, comp);
+					}
+					return;
+				}
+
+				// pivot goes to *begin
+				difference_type half = size / 2;
+				if (size > nintherThreshold) {
+					sort3(begin, begin + half, end - 1, comp);
+					sort3(begin + 1, begin + (half - 1), end - 2, comp);
+					sort3(begin + 2, begin + (half + 1), end - 3, comp);
+					sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+					iterSwap(begin, begin + half);
+				} else {
+					sort3(begin + half, begin, end - 1, comp);
+				}
+
+				// the element before this range is a pivot from further up, and
+				// no greater than anything here; if it equals this pivot, take
+				// all the copies out at once
+				if (!leftmost && !comp(*(begin - 1), *begin)) {
+					begin = partitionLeft(begin, end, comp) + 1;
+					continue;
+				}
+
+				bool alreadyPartitioned = false;
+				Iterator pivotPos = Branchless ? partitionRightBranchless(begin, end, comp, alreadyPartitioned) : partitionRight(begin, end, comp, alreadyPartitioned);
+
+				difference_type sizeL = pivotPos - begin;
+				difference_type sizeR = end - (pivotPos + 1);
+				bool highlyUnbalanced = sizeL < size / 8 || sizeR < size / 8;
+				if (highlyUnbalanced) {
+					if (--badAllowed == 0) {
+						heapSort(begin, end, comp);
+						return;
+					}
+
+					// shuffle a few elements to break up whatever pattern caused it
+					if (sizeL >= insertionSortThreshold) {
+						iterSwap(begin, begin + sizeL / 4);
+						iterSwap(pivotPos - 1, pivotPos - sizeL / 4);
+						if (sizeL > nintherThreshold) {
+							iterSwap(begin + 1, begin + (sizeL / 4 + 1));
+							iterSwap(begin + 2, begin + (sizeL / 4 + 2));
+							iterSwap(pivotPos - 2, pivotPos - (sizeL / 4 + 1));
+							iterSwap(pivotPos - 3, pivotPos - (sizeL / 4 + 2));
+						}
+					}
+
+					if (sizeR >= insertionSortThreshold) {
+						iterSwap(pivotPos + 1, pivotPos + (1 + sizeR / 4));
+						iterSwap(end - 1, end - sizeR / 4);
+						if (sizeR > nintherThreshold) {
+							iterSwap(pivotPos + 2, pivotPos + (2 + sizeR / 4));
+							iterSwap(pivotPos + 3, pivotPos + (3 + sizeR / 4));
+							iterSwap(end - 2, end - (1 + sizeR / 4));
+							iterSwap(end - 3, end - (2 + sizeR / 4));
+						}
+					}
+				} else if (alreadyPartitioned && partialInsertionSort(begin, pivotPos, comp) && partialInsertionSort(pivotPos + 1, end, comp)) {
+					// nothing moved, so the range was probably nearly sorted
+					return;
+				}
+
+				pdqsortLoop<Branchless>(begin, pivotPos, comp, badAllowed, leftmost);
+				begin = pivotPos + 1;
+				leftmost = false;
+			}
+		}
+
+		template <class Iterator, class Compare>
+		void pdqsort(Iterator first, Iterator last, Compare& comp)
+		{
+			if (last - first < 2) {
+				return;
+			}
+
+			int badAllowed = std::bit_width(static_cast<brisk::size_t>(last - first));
+			if constexpr (isLess<Compare, iter_value_t<Iterator>> || isGreater<Compare, iter_value_t<Iterator>>) {
+				pdqsortLoop<std::is_arithmetic_v<iter_value_t<Iterator>>>(first, last, comp, badAllowed);
+			} else {
+				pdqsortLoop<false>(first, last, comp, badAllowed);
+			}
+		}
+
+		constexpr brisk::ptrdiff_t mergeRunLength = 32;
+
+		// Merges [first, middle) and [middle, last) with the left half moved
+		// out to buffer; ties go to the left, which keeps it stable.
+		template <class Iterator, class Compare>
+		void mergeRuns(Iterator first, Iterator middle, Iterator last, sort_buffer<iter_value_t<Iterator>>& buffer, Compare& comp)
+		{
+			if (!comp(*middle, *(middle - 1))) {
+				return;
+			}
+
+			using Type = iter_value_t<Iterator>;
+			Type* left = buffer.data();
+			brisk::size_t sizeL = static_cast<brisk::size_t>(middle - first);
+			brisk::size_t live = buffer.constructed();
+			Iterator it = first;
+			for (brisk::size_t i = 0; i < sizeL; ++i, ++it) {
+				if (i < live) {
+					left[i] = brisk::move(*it);
+				} else {
+					::new (static_cast<void*>(left + i)) Type(brisk::move(*it));
+					buffer.constructed(i + 1);
+				}
+			}
+
+			Type* leftEnd = left + sizeL;
+			Iterator out = first;
+			Iterator right = middle;
+			while (left != leftEnd && right != last) {
+				if (comp(*right, *left)) {
+					*out = brisk::move(*right);
+					++right;
+				} else {
+					*out = brisk::move(*left);
+					++left;
+				}
+				++out;
+			}
+
+			for (; left != leftEnd; ++left, ++out) {
+				*out = brisk::move(*left);
+			}
+		}
+
+		template <class Iterator, class Compare>
+		void mergeSort(Iterator first, Iterator last, sort_buffer<iter_value_t<Iterator>>& buffer, Compare& comp)
+		{
+			if (last - first <= mergeRunLength) {
+				insertionSort(first, last, comp);
+				return;
+			}
+
+			Iterator middle = first + (last - first) / 2;
+			mergeSort(first, middle, buffer, comp);
+			mergeSort(middle, last, buffer, comp);
+			mergeRuns(first, middle, last, buffer, comp);
+		}
+	}
+
+	// Sorts [first, last) so that comp(*(i + 1), *i) is false throughout.
+	// Not stable. Integer and floating point ranges sorted by less or
+	// greater go to radix_sort once they're big enough for it to be faster,
+	// everything else to pdqsort, which is O(n log n) in the worst case.
+	template <class Iterator, class Compare = brisk::less<>>
+	void sort(Iterator first, Iterator last, Compare comp = Compare())
+	{
+		if (detail::tryRadixSort(first, last, comp)) {
+			return;
+		}
+
+		detail::pdqsort(first, last, comp);
+	}
+
+	// Merge sort: equal elements keep their order. Uses a buffer of half the
+	// range, and radix_sort for integer ranges sorted by less or greater.
+	template <class Iterator, class Compare = brisk::less<>>
+	void stable_sort(Iterator first, Iterator last, Compare comp = Compare())
+	{
+		if (last - first < 2) {
+			return;
+		}
+
+		// radix sort is stable too, but orders -0.0 before 0.0 where a
+		// comparison sort would leave them as they were
+		if constexpr (std::is_integral_v<detail::iter_value_t<Iterator>>) {
+			if (detail::tryRadixSort(first, last, comp)) {
+				return;
+			}
+		}
+
+		// a merge sort can't tell it has nothing to do, and does the most
+		// moving on reversed input
+		if (detail::sortPresorted(first, last, comp)) {
+			return;
+		}
+
+		detail::sort_buffer<detail::iter_value_t<Iterator>> buffer(static_cast<brisk::size_t>(last - first + 1) / 2);
+		detail::mergeSort(first, last, buffer, comp);
+	}
+
+	// Stable LSD radix sort of integers, floats or doubles into ascending
+	// order. The version taking key sorts any element type by the integer
+	// or floating point key(element) returns. Needs a scratch copy of the
+	// range, and takes a pass per byte of the key.
+	template <class Iterator>
+	void radix_sort(Iterator first, Iterator last)
+	{
+		detail::identity key;
+		detail::radixSort(first, last, key, false);
+	}
+
+	template <class Iterator, class Projection>
+	void radix_sort(Iterator first, Iterator last, Projection key)
+	{
+		detail::radixSort(first, last, key, false);
+	}
+
+	namespace detail
+	{
+		// Up to this many buckets the counts are spread over four tables,
+		// which still fit in L1/L2. Up to histogramStackBins the tables are
+		// 8KB on the stack, past that they come from the default resource,
+		// so a call on a pool worker's stack stays small either way.
+		constexpr brisk::size_t histogramSplitBins = 4096;
+		constexpr brisk::size_t histogramStackBins = 256;
+
+		// The four-table count, with table t at tables + t * bins.
+		template <class Iterator, class CountIterator, class Key>
+		CountIterator splitHistogram(Iterator first, Iterator last, CountIterator counts, brisk::size_t bins, Key& key, brisk::size_t* tables)
+		{
+			using Count = iter_value_t<CountIterator>;
+			brisk::size_t* t0 = tables;
+			brisk::size_t* t1 = tables + bins;
+			brisk::size_t* t2 = tables + 2 * bins;
+			brisk::size_t* t3 = tables + 3 * bins;
+			brisk::fill(tables, tables + 4 * bins, brisk::size_t(0));
+
+			Iterator it = first;
+			if constexpr (std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>) {
+				for (; last - it >= 4; it += 4) {
+					brisk::size_t k0 = static_cast<brisk::size_t>(key(it[0]));
+					brisk::size_t k1 = static_cast<brisk::size_t>(key(it[1]));
+					brisk::size_t k2 = static_cast<brisk::size_t>(key(it[2]));
+					brisk::size_t k3 = static_cast<brisk::size_t>(key(it[3]));
+					t0[k0 < bins ? k0 : 0] += (k0 < bins);
+					t1[k1 < bins ? k1 : 0] += (k1 < bins);
+					t2[k2 < bins ? k2 : 0] += (k2 < bins);
+					t3[k3 < bins ? k3 : 0] += (k3 < bins);
+				}
+			}
+			for (; it != last; ++it) {
+				brisk::size_t k = static_cast<brisk::size_t>(key(*it));
+				t0[k < bins ? k : 0] += (k < bins);
+			}
+
+			for (brisk::size_t b = 0; b < bins; ++b) {
+				counts[b] = static_cast<Count>(t0[b] + t1[b] + t2[b] + t3[b]);
+			}
+
+			return counts + bins;
+		}
+	}
+
+	// Counts the elements in each of bins buckets by key(element), the
+	// element itself by default, into counts[0, bins). Keys outside
+	// [0, bins) aren't counted. With few buckets consecutive elements land
+	// in four tables in turn, so a run of one key doesn't wait on its own
+	// increments.
+	template <class Iterator, class CountIterator, class Key = detail::identity>
+	CountIterator histogram(Iterator first, Iterator last, CountIterator counts, brisk::size_t bins, Key key = Key())
+	{
+		using Count = detail::iter_value_t<CountIterator>;
+		if (bins > detail::histogramSplitBins) {
+			brisk::fill(counts, counts + bins, Count(0));
+			for (; first != last; ++first) {
+				brisk::size_t k = static_cast<brisk::size_t>(key(*first));
+				if (k < bins) {
+					++counts[k];
+				}
+			}
+
+			return counts + bins;
+		}
+
+		if (bins > detail::histogramStackBins) {
+			detail::sort_buffer<brisk::size_t> tables(4 * bins);
+			return detail::splitHistogram(first, last, counts, bins, key, tables.data());
+		}
+
+		brisk::size_t tables[4 * detail::histogramStackBins];
+		return detail::splitHistogram(first, last, counts, bins, key, tables);
+	}
+
+	// Where each bucket starts once the range is grouped by key, into
+	// offsets[0, bins], with offsets[bins] the number counted: a histogram
+	// and an exclusive scan, the first pass of a counting sort or a radix
+	// partition.
+	template <class Iterator, class OffsetIterator, class Key = detail::identity>
+	OffsetIterator bucket_offsets(Iterator first, Iterator last, OffsetIterator offsets, brisk::size_t bins, Key key = Key())
+	{
+		using Count = detail::iter_value_t<OffsetIterator>;
+		brisk::histogram(first, last, offsets, bins, key);
+		offsets[bins] = Count(0);
+		return brisk::exclusive_scan(offsets, offsets + (bins + 1), offsets, Count(0));
+	}
+
+	template <class Iterator, class Compare = brisk::less<>>
+	bool is_sorted(Iterator first, Iterator last, Compare comp = Compare())
+	{
+		if (first == last) {
+			return true;
+		}
+
+		Iterator next = first;
+		for (++next; next != last; ++first, ++next) {
+			if (comp(*next, *first)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	namespace detail
+	{
+		// Leaves the middle - first smallest elements in [first, middle) as a
+		// heap, its largest at first. Most of the rest are turned away by a
+		// single comparison with that largest.
+		template <class Iterator, class Compare>
+		void heapSelect(Iterator first, Iterator middle, Iterator last, Compare& comp)
+		{
+			iter_difference_t<Iterator> size = middle - first;
+			makeHeap(first, size, comp);
+			for (Iterator it = middle; it != last; ++it) {
+				if (comp(*it, *first)) {
+					iterSwap(it, first);
+					siftDown(first, size, iter_difference_t<Iterator>(0), comp);
+				}
+			}
+		}
+
+		// Floyd and Rivest's SELECT. On a large range it first selects
+		// within a small sample around where the kth element should fall,
+		// so the pivot it then partitions on is very nearly the answer and
+		// most ranges take one partitioning pass with about n + k
+		// comparisons. Small ranges are insertion sorted, and a range that
+		// keeps coming back after depth passes is finished with a heap, so
+		// the worst case stays O(n log n).
+		template <class Iterator, class Compare>
+		void floydRivestSelect(Iterator first, iter_difference_t<Iterator> left, iter_difference_t<Iterator> right, iter_difference_t<Iterator> k, Compare& comp, int depth)
+		{
+			using difference_type = iter_difference_t<Iterator>;
+			while (right > left) {
+				if (right - left < 24) {
+					insertionSort(first + left, first + right + 1, comp);
+					return;
+				}
+
+				if (depth-- == 0) {
+					heapSelect(first + left, first + k + 1, first + right + 1, comp);
+					iterSwap(first + left, first + k);
+					return;
+				}
+
+				if (right - left > 600) {
+					double n = static_cast<double>(right - left + 1);
+					double i = static_cast<double>(k - left + 1);
+					double z = std::log(n);
+					double s = 0.5 * std::exp(2.0 * z / 3.0);
+					double sd = 0.5 * std::sqrt(z * s * (n - s) / n) * ((i < n / 2) ? -1.0 : 1.0);
+					difference_type sampleLeft = static_cast<difference_type>(static_cast<double>(k) - i * s / n + sd);
+					difference_type sampleRight = static_cast<difference_type>(static_cast<double>(k) + (n - i) * s / n + sd);
+					floydRivestSelect(first, (sampleLeft > left) ? sampleLeft : left, (sampleRight < right) ? sampleRight : right, k, comp, depth);
+				}
+
+				// partition [left, right] around t, with copies of t or
+				// something on the right side of it at both ends as sentinels
+				iter_value_t<Iterator> t = first[k];
+				difference_type i = left;
+				difference_type j = right;
+				iterSwap(first + left, first + k);
+				if (comp(t, first[right])) {
+					iterSwap(first + right, first + left);
+				}
+
+				while (i < j) {
+					iterSwap(first + i, first + j);
+					++i;
+					--j;
+					while (comp(first[i], t)) {
+						++i;
+					}
+					while (comp(t, first[j])) {
+						--j;
+					}
+				}
+
+				if (!comp(first[left], t) && !comp(t, first[left])) {
+					iterSwap(first + left, first + j);
+				} else {
+					++j;
+					iterSwap(first + j, first + right);
+				}
+
+				if (j <= k) {
+					left = j + 1;
+				}
+				if (k <= j) {
+					right = j - 1;
+				}
+			}
+		}
+	}
+
+	// Puts the element that belongs at nth in sorted order there, with
+	// nothing after it ordered before it and nothing before it ordered
+	// after it. Expected linear time. The element type must be copyable,
+	// since the pivot is held aside while partitioning.
+	template <class Iterator, class Compare = brisk::less<>>
+	void nth_element(Iterator first, Iterator nth, Iterator last, Compare comp = Compare())
+	{
+		if (nth == last || last - first < 2) {
+			return;
+		}
+
+		int depth = 2 * std::bit_width(static_cast<std::make_unsigned_t<detail::iter_difference_t<Iterator>>>(last - first)) + 8;
+		detail::floydRivestSelect(first, detail::iter_difference_t<Iterator>(0), (last - first) - 1, nth - first, comp, depth);
+	}
+
+	// Sorts the middle - first smallest elements into [first, middle); the
+	// rest are left in [middle, last) in no particular order. Up to 1024 of
+	// them go through a heap; past that it's cheaper to select and sort.
+	template <class Iterator, class Compare = brisk::less<>>
+	void partial_sort(Iterator first, Iterator middle, Iterator last, Compare comp = Compare())
+	{
+		detail::iter_difference_t<Iterator> size = middle - first;
+		if (size <= 0) {
+			return;
+		}
+
+		if (size > 1024) {
+			brisk::nth_element(first, middle - 1, last, comp);
+			brisk::sort(first, middle - 1, comp);
+			return;
+		}
+
+		detail::heapSelect(first, middle, last, comp);
+		detail::sortHeap(first, size, comp);
+	}
+
+	// The smallest d_last - d_first elements of [first, last), sorted, copied
+	// into the output range. Returns the end of what was written.
+	template <class Iterator, class DestIterator, class Compare = brisk::less<>>
+	DestIterator partial_sort_copy(Iterator first, Iterator last, DestIterator d_first, DestIterator d_last, Compare comp = Compare())
+	{
+		DestIterator d_end = d_first;
+		for (; first != last && d_end != d_last; ++first, ++d_end)
+			*d_end = *first;
+
+		detail::iter_difference_t<DestIterator> size = d_end - d_first;
+		if (size == 0) {
+			return d_end;
+		}
+
+		detail::makeHeap(d_first, size, comp);
+		for (; first != last; ++first) {
+			if (comp(*first, *d_first)) {
+				*d_first = *first;
+				detail::siftDown(d_first, size, detail::iter_difference_t<DestIterator>(0), comp);
+			}
+		}
+
+		detail::sortHeap(d_first, size, comp);
+		return d_end;
+	}
+
+	namespace detail
+	{
+		template <class Iterator>
+		inline void prefetchAt(Iterator it) noexcept
+		{
+			if constexpr (std::contiguous_iterator<Iterator>) {
+				BRISK_PREFETCH(std::to_address(it));
+			}
+		}
+
+		// Binary search without a data-dependent branch. Every step halves
+		// the range whatever the comparison says, and the comparison only
+		// decides how far to move, so the loop runs a fixed number of times
+		// and there's nothing to mispredict. Both places the next probe could
+		// land are prefetched while this one is being compared, which hides
+		// most of a miss on large arrays. goRight(x) says the answer lies
+		// past x.
+		template <class Iterator, class GoRight>
+		Iterator branchlessSearch(Iterator first, iter_difference_t<Iterator> length, GoRight& goRight)
+		{
+			if (length == 0)
+				return first;
+
+			while (length > 1) {
+				iter_difference_t<Iterator> half = length / 2;
+				iter_difference_t<Iterator> rest = length - half;
+				prefetchAt(first + rest / 2);
+				prefetchAt(first + half + rest / 2);
+				first += static_cast<iter_difference_t<Iterator>>(goRight(first[half])) * half;
+				length = rest;
+			}
+
+			return first + static_cast<iter_difference_t<Iterator>>(goRight(*first));
+		}
+
+		// The same search for iterators that can only step forward.
+		template <class Iterator, class GoRight>
+		Iterator forwardSearch(Iterator first, Iterator last, GoRight& goRight)
+		{
+			iter_difference_t<Iterator> length = std::distance(first, last);
+			while (length > 0) {
+				iter_difference_t<Iterator> half = length / 2;
+				Iterator middle = first;
+				std::advance(middle, half);
+				if (goRight(*middle)) {
+					first = ++middle;
+					length -= half + 1;
+				} else {
+					length = half;
+				}
+			}
+
+			return first;
+		}
+
+		template <class Iterator, class GoRight>
+		Iterator boundSearch(Iterator first, Iterator last, GoRight goRight)
+		{
+			if constexpr (std::random_access_iterator<Iterator>)
+				return branchlessSearch(first, last - first, goRight);
+			else
+				return forwardSearch(first, last, goRight);
+		}
+	}
+
+	// The first element in a sorted range that isn't less than value.
+	template <class Iterator, class T, class Compare = brisk::less<>>
+	Iterator lower_bound(Iterator first, Iterator last, const T& value, Compare comp = Compare())
+	{
+		return detail::boundSearch(first, last, [&comp, &value](const auto& element) -> bool { return comp(element, value); });
+	}
+
+	// The first element in a sorted range that's greater than value.
+	template <class Iterator, class T, class Compare = brisk::less<>>
+	Iterator upper_bound(Iterator first, Iterator last, const T& value, Compare comp = Compare())
+	{
+		return detail::boundSearch(first, last, [&comp, &value](const auto& element) -> bool { return !comp(value, element); });
+	}
+
+	template <class Iterator, class T, class Compare = brisk::less<>>
+	bool binary_search(Iterator first, Iterator last, const T& value, Compare comp = Compare())
+	{
+		first = brisk::lower_bound(first, last, value, comp);
+		return first != last && !comp(value, *first);
+	}
+
+	template <class Iterator, class T, class Compare = brisk::less<>>
+	std::pair<Iterator, Iterator> equal_range(Iterator first, Iterator last, const T& value, Compare comp = Compare())
+	{
+		first = brisk::lower_bound(first, last, value, comp);
+		return std::pair<Iterator, Iterator>(first, brisk::upper_bound(first, last, value, comp));
+	}
+
+	// Merges two sorted ranges into d_first. Stable: of equal elements, the
+	// ones from the first range come first.
+	template <class Iterator1, class Iterator2, class OutIterator, class Compare = brisk::less<>>
+	OutIterator merge(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutIterator d_first, Compare comp = Compare())
+	{
+		for (; first1 != last1 && first2 != last2; ++d_first) {
+			if (comp(*first2, *first1)) {
+				*d_first = *first2;
+				++first2;
+			} else {
+				*d_first = *first1;
+				++first1;
+			}
+		}
+
+		d_first = brisk::copy(first1, last1, d_first);
+		return brisk::copy(first2, last2, d_first);
+	}
+
+	namespace detail
+	{
+		template <class Iterator>
+		void reverseRange(Iterator first, Iterator last)
+		{
+			for (; first < last; ++first)
+				iterSwap(first, --last);
+		}
+
+		// The merge for when there's no memory for a buffer: split the
+		// longer run in half, find where its middle goes in the other,
+		// rotate the two middle pieces past each other and recurse on both
+		// sides. O(n log n) moves rather than O(n).
+		template <class Iterator, class Compare>
+		void mergeWithoutBuffer(Iterator first, Iterator middle, Iterator last, Compare& comp)
+		{
+			iter_difference_t<Iterator> sizeL = middle - first;
+			iter_difference_t<Iterator> sizeR = last - middle;
+			if (sizeL == 0 || sizeR == 0) {
+				return;
+			}
+
+			if (sizeL + sizeR == 2) {
+				if (comp(*middle, *first)) {
+					iterSwap(first, middle);
+				}
+				return;
+			}
+
+			Iterator cutL;
+			Iterator cutR;
+			if (sizeL > sizeR) {
+				cutL = first + sizeL / 2;
+				cutR = brisk::lower_bound(middle, last, *cutL, comp);
+			} else {
+				cutR = middle + sizeR / 2;
+				cutL = brisk::upper_bound(first, middle, *cutR, comp);
+			}
+
+			reverseRange(cutL, middle);
+			reverseRange(middle, cutR);
+			reverseRange(cutL, cutR);
+			Iterator newMiddle = cutL + (cutR - middle);
+			mergeWithoutBuffer(first, cutL, newMiddle, comp);
+			mergeWithoutBuffer(newMiddle, cutR, last, comp);
+		}
+	}
+
+	// Merges the sorted runs [first, middle) and [middle, last) in place,
+	// stably. Borrows a buffer the size of the first run, and gets by
+	// without one, more slowly, if that can't be had.
+	template <class Iterator, class Compare = brisk::less<>>
+	void inplace_merge(Iterator first, Iterator middle, Iterator last, Compare comp = Compare())
+	{
+		if (first == middle || middle == last) {
+			return;
+		}
+
+		std::optional<detail::sort_buffer<detail::iter_value_t<Iterator>>> buffer;
+		try {
+			buffer.emplace(static_cast<brisk::size_t>(middle - first));
+		} catch (const std::bad_alloc&) {
+			detail::mergeWithoutBuffer(first, middle, last, comp);
+			return;
+		}
+
+		detail::mergeRuns(first, middle, last, *buffer, comp);
+	}
+
 	template <class Container>
 	auto begin(Container& c) -> decltype(c.begin())
 	{
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "briskdef.hpp"
+#include "algorithm.hpp"
 
 #include <iterator>
 #include <initializer_list>
@@ -102,22 +103,12 @@ namespace brisk
 
 		void fill(const value_type& value)
 		{
-			for (size_type i = 0; i < Size; ++i) {
-				m_array[i] = value;
-			}
+			brisk::fill(m_array, m_array + Size, value);
 		}
 
 		void swap(array<Type, Size>& other)
 		{
-			value_type buffer[Size];
-			for (size_type i = 0; i < Size; i++) {
-				buffer[i] = other[i];
-			}
-
-			for (int i = 0; i < Size; i++) {
-				other[i] = m_array[i];
-				m_array[i] = buffer[i];
-			}
+			brisk::swap_ranges(m_array, m_array + Size, other.m_array);
 		}
 
 		iterator begin() noexcept
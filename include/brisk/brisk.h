@@ -10,4 +10,27 @@
 #include "algorithm.hpp"
 #include "functional.hpp"
 #include "iterator.hpp"
-#include "briskdef.hpp"
\ No newline at end of file
+#include "briskdef.hpp"
+#include "memory_resource.hpp"
+#include "thread_caching_resource.hpp"
+#include "pool_allocator.hpp"
+#include "object_pool.hpp"
+#include "reclaim.hpp"
+#include "heap_profiler.hpp"
+#include "logfile.hpp"
+#include "loghistory.hpp"
+#include "logmetrics.hpp"
+#include "compress.hpp"
+#include "eventlog.hpp"
+#include "format.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+#include "execution.hpp"
+#include "ranges.hpp"
+#include "merge.hpp"
+#include "top_k.hpp"
+#include "eytzinger.hpp"
+#include "external_sort.hpp"
+#include "hash_table.hpp"
+#include "hash_algorithm.hpp"
+#include "hyperloglog.hpp"
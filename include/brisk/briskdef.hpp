@@ -8,6 +8,22 @@
 	#endif
 #endif
 
+// Allocation hook for heap_profiler.hpp. Defining BRISK_HEAP_PROFILE
+// makes vector, string and the smart pointer factories report their
+// allocations; otherwise it compiles to nothing.
+#ifdef BRISK_HEAP_PROFILE
+	#define BRISK_HEAP_SAMPLE(bytes) ::brisk::detail::heapSample(bytes)
+#else
+	#define BRISK_HEAP_SAMPLE(bytes) ((void)0)
+#endif
+
+// Read prefetch hint for the searches; a no-op where there's no builtin.
+#if defined(__GNUC__) || defined(__clang__)
+	#define BRISK_PREFETCH(address) __builtin_prefetch(address)
+#else
+	#define BRISK_PREFETCH(address) ((void)(address))
+#endif
+
 namespace brisk
 {
 	using size_t = decltype(sizeof(int));
@@ -0,0 +1,542 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "vector.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace brisk
+{
+	// A small LZ77 block compressor in the spirit of LZ4. Each sequence is a
+	// token byte (literal length in the high nibble, match length - 4 in the
+	// low nibble), extra length bytes when a nibble overflows, the literals
+	// and a 16-bit little endian match offset. The last sequence of a block
+	// only carries literals.
+	namespace lz
+	{
+		constexpr brisk::size_t minMatch = 4;
+		constexpr brisk::size_t lastLiterals = 5;
+		constexpr brisk::size_t maxOffset = 65535;
+		constexpr unsigned hashBits = 14;
+
+		constexpr brisk::size_t compress_bound(brisk::size_t n) noexcept
+		{
+			return n + (n / 255) + 16;
+		}
+
+		inline std::uint32_t read32(const unsigned char* p) noexcept
+		{
+			std::uint32_t v;
+			memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		inline std::uint32_t hash(std::uint32_t v) noexcept
+		{
+			return (v * 2654435761u) >> (32 - hashBits);
+		}
+
+		inline unsigned char* writeLength(unsigned char* op, brisk::size_t length) noexcept
+		{
+			for (; length >= 255; length -= 255) {
+				*op++ = 255;
+			}
+			*op++ = static_cast<unsigned char>(length);
+			return op;
+		}
+
+		inline unsigned char* writeSequence(unsigned char* op, const unsigned char* literals, brisk::size_t literalLength,
+			brisk::size_t offset, brisk::size_t matchLength) noexcept
+		{
+			unsigned char* token = op++;
+			brisk::size_t matchCode = (matchLength == 0) ? 0 : matchLength - minMatch;
+
+			*token = static_cast<unsigned char>(((literalLength < 15) ? literalLength : 15) << 4);
+			if (literalLength >= 15) {
+				op = writeLength(op, literalLength - 15);
+			}
+
+			memcpy(op, literals, literalLength);
+			op += literalLength;
+
+			if (matchLength != 0)
+			{
+				*op++ = static_cast<unsigned char>(offset & 0xff);
+				*op++ = static_cast<unsigned char>(offset >> 8);
+				*token |= static_cast<unsigned char>((matchCode < 15) ? matchCode : 15);
+				if (matchCode >= 15) {
+					op = writeLength(op, matchCode - 15);
+				}
+			}
+
+			return op;
+		}
+
+		// Returns the compressed size, or 0 if capacity < compress_bound(n).
+		inline brisk::size_t compress(const char* source, brisk::size_t n, char* dest, brisk::size_t capacity) noexcept
+		{
+			if (capacity < compress_bound(n)) {
+				return 0;
+			}
+
+			const unsigned char* src = reinterpret_cast<const unsigned char*>(source);
+			const unsigned char* ip = src;
+			const unsigned char* anchor = src;
+			const unsigned char* end = src + n;
+			unsigned char* op = reinterpret_cast<unsigned char*>(dest);
+
+			if (n > minMatch + lastLiterals)
+			{
+				const unsigned char* matchLimit = end - lastLiterals;
+				std::uint32_t table[1u << hashBits];
+				memset(table, 0, sizeof(table));
+
+				while (ip + minMatch <= matchLimit)
+				{
+					std::uint32_t sequence = read32(ip);
+					std::uint32_t h = hash(sequence);
+					const unsigned char* ref = src + table[h];
+					table[h] = static_cast<std::uint32_t>(ip - src);
+
+					if (ref >= ip || brisk::size_t(ip - ref) > maxOffset || read32(ref) != sequence) {
+						// skip faster through data that doesn't compress
+						ip += 1 + ((ip - anchor) >> 6);
+						continue;
+					}
+
+					while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+						--ip;
+						--ref;
+					}
+
+					brisk::size_t length = minMatch;
+					while (ip + length < matchLimit && ip[length] == ref[length]) {
+						++length;
+					}
+
+					op = writeSequence(op, anchor, brisk::size_t(ip - anchor), brisk::size_t(ip - ref), length);
+					ip += length;
+					anchor = ip;
+
+					if (ip + minMatch <= matchLimit) {
+						table[hash(read32(ip - 2))] = static_cast<std::uint32_t>(ip - 2 - src);
+					}
+				}
+			}
+
+			op = writeSequence(op, anchor, brisk::size_t(end - anchor), 0, 0);
+			return brisk::size_t(op - reinterpret_cast<unsigned char*>(dest));
+		}
+
+		// Returns the decompressed size, or size_t(-1) if the block is corrupt
+		// or would not fit in capacity.
+		inline brisk::size_t decompress(const char* source, brisk::size_t n, char* dest, brisk::size_t capacity) noexcept
+		{
+			const brisk::size_t corrupt = static_cast<brisk::size_t>(-1);
+			const unsigned char* ip = reinterpret_cast<const unsigned char*>(source);
+			const unsigned char* end = ip + n;
+			unsigned char* out = reinterpret_cast<unsigned char*>(dest);
+			unsigned char* op = out;
+			unsigned char* outEnd = out + capacity;
+
+			while (ip < end)
+			{
+				unsigned token = *ip++;
+
+				brisk::size_t literalLength = token >> 4;
+				if (literalLength == 15) {
+					unsigned char b;
+					do {
+						if (ip >= end) {
+							return corrupt;
+						}
+						b = *ip++;
+						literalLength += b;
+					} while (b == 255);
+				}
+
+				if (literalLength > brisk::size_t(end - ip) || literalLength > brisk::size_t(outEnd - op)) {
+					return corrupt;
+				}
+
+				memcpy(op, ip, literalLength);
+				ip += literalLength;
+				op += literalLength;
+
+				if (ip == end) {
+					break;
+				}
+
+				if (end - ip < 2) {
+					return corrupt;
+				}
+
+				brisk::size_t offset = brisk::size_t(ip[0]) | (brisk::size_t(ip[1]) << 8);
+				ip += 2;
+
+				brisk::size_t matchLength = token & 15;
+				if (matchLength == 15) {
+					unsigned char b;
+					do {
+						if (ip >= end) {
+							return corrupt;
+						}
+						b = *ip++;
+						matchLength += b;
+					} while (b == 255);
+				}
+				matchLength += minMatch;
+
+				if (offset == 0 || offset > brisk::size_t(op - out) || matchLength > brisk::size_t(outEnd - op)) {
+					return corrupt;
+				}
+
+				const unsigned char* ref = op - offset;
+				if (offset >= matchLength) {
+					memcpy(op, ref, matchLength);
+					op += matchLength;
+				} else {
+					// overlapping match, e.g. a run of one repeated byte
+					for (brisk::size_t i = 0; i < matchLength; ++i) {
+						*op++ = ref[i];
+					}
+				}
+			}
+
+			return brisk::size_t(op - out);
+		}
+	}
+
+	// On-disk framing for compressed logs:
+	//
+	//   "BRLZ" version:u32 blockSize:u32
+	//   { rawSize:u32 storedSize:u32 bytes[storedSize] } ...
+	//   offset:u64 ... count:u64 "BRLX"
+	//
+	// A block whose storedSize equals its rawSize is stored uncompressed. The
+	// trailing index holds the file offset of every block so a reader can seek
+	// straight to any of them. Files that were cut short before the index was
+	// written are still readable by walking the block headers. All integers
+	// are written in host byte order (little endian on every platform brisk
+	// targets).
+	namespace lzframe
+	{
+		constexpr char magic[4] = { 'B', 'R', 'L', 'Z' };
+		constexpr char indexMagic[4] = { 'B', 'R', 'L', 'X' };
+		constexpr std::uint32_t version = 1;
+		constexpr brisk::size_t headerSize = 12;
+		constexpr brisk::size_t blockHeaderSize = 8;
+		constexpr brisk::size_t defaultBlockSize = brisk::size_t(64) << 10;
+	}
+
+	class compressed_writer
+	{
+	public:
+		compressed_writer()
+			: m_file(nullptr), m_block(nullptr), m_scratch(nullptr), m_blockSize(0), m_fill(0), m_offset(0), m_failed(false)
+		{
+
+		}
+
+		compressed_writer(const compressed_writer&) = delete;
+		compressed_writer& operator=(const compressed_writer&) = delete;
+
+		~compressed_writer()
+		{
+			close();
+		}
+
+		bool open(const char* path, brisk::size_t blockSize = lzframe::defaultBlockSize)
+		{
+			close();
+			m_file = std::fopen(path, "wb");
+			if (m_file == nullptr) {
+				return false;
+			}
+
+			m_blockSize = (blockSize == 0) ? lzframe::defaultBlockSize : blockSize;
+			m_block = new char[m_blockSize];
+			m_scratch = new char[lz::compress_bound(m_blockSize)];
+			m_fill = 0;
+			m_failed = false;
+			m_index.clear();
+
+			std::uint32_t header[2] = { lzframe::version, static_cast<std::uint32_t>(m_blockSize) };
+			m_failed = std::fwrite(lzframe::magic, 1, 4, m_file) != 4 || std::fwrite(header, 1, 8, m_file) != 8;
+			m_offset = lzframe::headerSize;
+			return !m_failed;
+		}
+
+		bool write(const char* data, brisk::size_t n)
+		{
+			if (m_file == nullptr) {
+				return false;
+			}
+
+			while (n > 0)
+			{
+				brisk::size_t chunk = m_blockSize - m_fill;
+				chunk = (n < chunk) ? n : chunk;
+				memcpy(m_block + m_fill, data, chunk);
+				m_fill += chunk;
+				data += chunk;
+				n -= chunk;
+
+				if (m_fill == m_blockSize) {
+					flushBlock();
+				}
+			}
+
+			return !m_failed;
+		}
+
+		// Writes any partial block and the block index, then closes the file.
+		bool close()
+		{
+			if (m_file == nullptr) {
+				return false;
+			}
+
+			flushBlock();
+			for (brisk::size_t i = 0; i < m_index.size(); ++i) {
+				m_failed = (std::fwrite(&m_index[i], 1, 8, m_file) != 8) || m_failed;
+			}
+
+			std::uint64_t count = m_index.size();
+			m_failed = (std::fwrite(&count, 1, 8, m_file) != 8) || m_failed;
+			m_failed = (std::fwrite(lzframe::indexMagic, 1, 4, m_file) != 4) || m_failed;
+			m_failed = (std::fclose(m_file) != 0) || m_failed;
+			m_file = nullptr;
+
+			delete[] m_block;
+			delete[] m_scratch;
+			m_block = m_scratch = nullptr;
+			return !m_failed;
+		}
+
+		bool is_open() const noexcept
+		{
+			return m_file != nullptr;
+		}
+
+		// Bytes written to disk so far, headers included.
+		std::uint64_t compressed_size() const noexcept
+		{
+			return m_offset;
+		}
+
+	private:
+		void flushBlock()
+		{
+			if (m_fill == 0) {
+				return;
+			}
+
+			brisk::size_t stored = lz::compress(m_block, m_fill, m_scratch, lz::compress_bound(m_blockSize));
+			const char* payload = m_scratch;
+			if (stored == 0 || stored >= m_fill) {
+				stored = m_fill;
+				payload = m_block;
+			}
+
+			std::uint32_t header[2] = { static_cast<std::uint32_t>(m_fill), static_cast<std::uint32_t>(stored) };
+			m_failed = (std::fwrite(header, 1, 8, m_file) != 8) || m_failed;
+			m_failed = (std::fwrite(payload, 1, stored, m_file) != stored) || m_failed;
+
+			m_index.push_back(m_offset);
+			m_offset += lzframe::blockHeaderSize + stored;
+			m_fill = 0;
+		}
+
+		std::FILE* m_file;
+		char* m_block;
+		char* m_scratch;
+		brisk::size_t m_blockSize;
+		brisk::size_t m_fill;
+		std::uint64_t m_offset;
+		brisk::vector<std::uint64_t> m_index;
+		bool m_failed;
+	};
+
+	class compressed_reader
+	{
+	public:
+		compressed_reader()
+			: m_file(nullptr), m_scratch(nullptr), m_blockSize(0)
+		{
+
+		}
+
+		compressed_reader(const compressed_reader&) = delete;
+		compressed_reader& operator=(const compressed_reader&) = delete;
+
+		~compressed_reader()
+		{
+			close();
+		}
+
+		bool open(const char* path)
+		{
+			close();
+			m_file = std::fopen(path, "rb");
+			if (m_file == nullptr) {
+				return false;
+			}
+
+			char magic[4];
+			std::uint32_t header[2];
+			if (std::fread(magic, 1, 4, m_file) != 4 || memcmp(magic, lzframe::magic, 4) != 0 ||
+				std::fread(header, 1, 8, m_file) != 8 || header[0] != lzframe::version || header[1] == 0) {
+				close();
+				return false;
+			}
+
+			m_blockSize = header[1];
+			m_scratch = new char[m_blockSize];
+			if (!readIndex()) {
+				scanBlocks();
+			}
+
+			return true;
+		}
+
+		void close()
+		{
+			if (m_file != nullptr) {
+				std::fclose(m_file);
+				m_file = nullptr;
+			}
+
+			delete[] m_scratch;
+			m_scratch = nullptr;
+			m_index.clear();
+		}
+
+		brisk::size_t blocks() const noexcept
+		{
+			return m_index.size();
+		}
+
+		// Largest uncompressed size of any block.
+		brisk::size_t block_size() const noexcept
+		{
+			return m_blockSize;
+		}
+
+		// Decompresses block i into out. Returns the number of bytes produced,
+		// or size_t(-1) on error.
+		brisk::size_t read_block(brisk::size_t i, char* out, brisk::size_t capacity)
+		{
+			const brisk::size_t error = static_cast<brisk::size_t>(-1);
+			if (m_file == nullptr || i >= m_index.size()) {
+				return error;
+			}
+
+			std::uint32_t header[2];
+			if (std::fseek(m_file, static_cast<long>(m_index[i]), SEEK_SET) != 0 || std::fread(header, 1, 8, m_file) != 8 ||
+				header[0] > capacity || header[1] > m_blockSize) {
+				return error;
+			}
+
+			if (header[0] == header[1]) {
+				return (std::fread(out, 1, header[0], m_file) == header[0]) ? header[0] : error;
+			}
+
+			if (std::fread(m_scratch, 1, header[1], m_file) != header[1]) {
+				return error;
+			}
+
+			brisk::size_t produced = lz::decompress(m_scratch, header[1], out, capacity);
+			return (produced == header[0]) ? produced : error;
+		}
+
+	private:
+		bool readIndex()
+		{
+			char magic[4];
+			std::uint64_t count;
+			if (std::fseek(m_file, -12, SEEK_END) != 0) {
+				return false;
+			}
+
+			long footer = std::ftell(m_file);
+			if (std::fread(&count, 1, 8, m_file) != 8 || std::fread(magic, 1, 4, m_file) != 4 || memcmp(magic, lzframe::indexMagic, 4) != 0 ||
+				footer < 0 || count > std::uint64_t(footer) / 8) {
+				return false;
+			}
+
+			if (std::fseek(m_file, footer - static_cast<long>(count * 8), SEEK_SET) != 0) {
+				return false;
+			}
+
+			m_index.reserve(count);
+			for (std::uint64_t i = 0; i < count; ++i)
+			{
+				std::uint64_t offset;
+				if (std::fread(&offset, 1, 8, m_file) != 8) {
+					m_index.clear();
+					return false;
+				}
+				m_index.push_back(offset);
+			}
+
+			return true;
+		}
+
+		void scanBlocks()
+		{
+			m_index.clear();
+			std::uint64_t offset = lzframe::headerSize;
+			std::uint32_t header[2];
+			while (std::fseek(m_file, static_cast<long>(offset), SEEK_SET) == 0 && std::fread(header, 1, 8, m_file) == 8)
+			{
+				if (header[0] == 0 || header[0] > m_blockSize || header[1] > m_blockSize || std::fseek(m_file, header[1], SEEK_CUR) != 0) {
+					break;
+				}
+
+				// a block cut short by a crash is not indexed
+				long next = std::ftell(m_file);
+				std::fseek(m_file, 0, SEEK_END);
+				if (next < 0 || next > std::ftell(m_file)) {
+					break;
+				}
+
+				m_index.push_back(offset);
+				offset += lzframe::blockHeaderSize + header[1];
+			}
+		}
+
+		std::FILE* m_file;
+		char* m_scratch;
+		brisk::size_t m_blockSize;
+		brisk::vector<std::uint64_t> m_index;
+	};
+
+	// Compresses the file at source into a framed file at dest.
+	inline bool compress_file(const char* source, const char* dest, brisk::size_t blockSize = lzframe::defaultBlockSize)
+	{
+		std::FILE* in = std::fopen(source, "rb");
+		if (in == nullptr) {
+			return false;
+		}
+
+		compressed_writer writer;
+		if (!writer.open(dest, blockSize)) {
+			std::fclose(in);
+			return false;
+		}
+
+		char buffer[1 << 16];
+		brisk::size_t n;
+		bool ok = true;
+		while ((n = std::fread(buffer, 1, sizeof(buffer), in)) > 0) {
+			ok = writer.write(buffer, n) && ok;
+		}
+
+		ok = !std::ferror(in) && ok;
+		std::fclose(in);
+		return writer.close() && ok;
+	}
+}
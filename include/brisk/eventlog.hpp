@@ -0,0 +1,748 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "string.hpp"
+#include "utility.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BRISK_HAS_EVENT_READER 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace brisk
+{
+	// Binary structured log format:
+	//
+	//   "BREV" version:u32
+	//   { length:u32 kind:u8 payload[length - 1] } ...
+	//
+	// kind 1 is a dictionary entry (id:u16 name[]) that maps an id to an event
+	// or key name the first time that name is used. kind 2 is an event
+	// (nameId:u16 fieldCount:u8 { keyId:u16 type:u8 value } ...). Integers
+	// and doubles are 8 bytes, bools 1 byte, strings are length:u32 bytes[].
+	// Everything is in host byte order.
+	namespace eventlog
+	{
+		constexpr char magic[4] = { 'B', 'R', 'E', 'V' };
+		constexpr std::uint32_t version = 1;
+		constexpr brisk::size_t headerSize = 8;
+		// ids are 2 bytes, so a file holds at most this many distinct names
+		constexpr brisk::size_t maxNames = 65536;
+
+		enum record_kind : std::uint8_t
+		{
+			dictionary = 1,
+			event = 2
+		};
+
+		enum field_type : std::uint8_t
+		{
+			int64 = 0,
+			uint64 = 1,
+			float64 = 2,
+			string = 3,
+			boolean = 4
+		};
+
+		template <class T>
+		inline void put(char*& out, const T& value) noexcept
+		{
+			memcpy(out, &value, sizeof(T));
+			out += sizeof(T);
+		}
+
+		template <class T>
+		inline T get(const char* in) noexcept
+		{
+			T value;
+			memcpy(&value, in, sizeof(T));
+			return value;
+		}
+	}
+
+	// Appends structured events to a file. Event and key names are interned
+	// into a per-file dictionary, so a record only carries 2-byte ids. Past
+	// 65536 distinct names, or with a name too long for the write buffer,
+	// an event that needs a new one isn't written and event() returns false.
+	class event_writer
+	{
+	public:
+		event_writer()
+			: m_file(nullptr), m_buffer(new char[bufferSize]), m_fill(0), m_failed(false)
+		{
+			memset(m_cache, 0, sizeof(m_cache));
+		}
+
+		event_writer(const event_writer&) = delete;
+		event_writer& operator=(const event_writer&) = delete;
+
+		~event_writer()
+		{
+			close();
+			delete[] m_buffer;
+		}
+
+		bool open(const char* path)
+		{
+			close();
+			m_file = std::fopen(path, "wb");
+			if (m_file == nullptr) {
+				return false;
+			}
+
+			m_names.clear();
+			memset(m_cache, 0, sizeof(m_cache));
+			m_failed = false;
+			m_fill = 0;
+
+			char* out = m_buffer;
+			memcpy(out, eventlog::magic, 4);
+			out += 4;
+			eventlog::put<std::uint32_t>(out, eventlog::version);
+			m_fill = eventlog::headerSize;
+			return true;
+		}
+
+		bool close()
+		{
+			if (m_file == nullptr) {
+				return false;
+			}
+
+			bool ok = flush();
+			ok = (std::fclose(m_file) == 0) && ok;
+			m_file = nullptr;
+			return ok;
+		}
+
+		bool is_open() const noexcept
+		{
+			return m_file != nullptr;
+		}
+
+		// event("req", "latency_us", 120, "path", "/api") writes one record
+		// with the fields given as alternating keys and values.
+		template <class... Args>
+		bool event(const char* name, const Args&... fields)
+		{
+			static_assert(sizeof...(Args) % 2 == 0, "brisk::event_writer::event expects key, value pairs");
+			static_assert(sizeof...(Args) / 2 < 256, "brisk::event_writer::event supports at most 255 fields");
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_file == nullptr) {
+				return false;
+			}
+
+			// interning can emit dictionary records, so every name is resolved
+			// before the event's own bytes are reserved
+			std::uint16_t ids[sizeof...(Args) / 2 + 1];
+			if (!intern(name, ids[0]) || !internKeys(ids + 1, fields...)) {
+				return false;
+			}
+
+			brisk::size_t length = 1 + 2 + 1 + payloadSize(fields...);
+			char* out = reserve(4 + length);
+			if (out == nullptr) {
+				return false;
+			}
+
+			eventlog::put<std::uint32_t>(out, static_cast<std::uint32_t>(length));
+			eventlog::put<std::uint8_t>(out, eventlog::event);
+			eventlog::put<std::uint16_t>(out, ids[0]);
+			eventlog::put<std::uint8_t>(out, static_cast<std::uint8_t>(sizeof...(Args) / 2));
+			encode(out, ids + 1, fields...);
+			return !m_failed;
+		}
+
+		bool flush()
+		{
+			if (m_file == nullptr) {
+				return false;
+			}
+
+			if (m_fill != 0) {
+				m_failed = (std::fwrite(m_buffer, 1, m_fill, m_file) != m_fill) || m_failed;
+				m_fill = 0;
+			}
+
+			m_failed = (std::fflush(m_file) != 0) || m_failed;
+			return !m_failed;
+		}
+
+	private:
+		static constexpr brisk::size_t bufferSize = brisk::size_t(1) << 20;
+		static constexpr brisk::size_t cacheSize = 256;
+
+		struct cache_entry
+		{
+			const char* name;
+			const char* text;
+			std::uint16_t id;
+		};
+
+		// Makes room for n contiguous bytes in the write buffer.
+		char* reserve(brisk::size_t n)
+		{
+			if (m_fill + n > bufferSize)
+			{
+				m_failed = (std::fwrite(m_buffer, 1, m_fill, m_file) != m_fill) || m_failed;
+				m_fill = 0;
+
+				if (n > bufferSize) {
+					return nullptr;
+				}
+			}
+
+			char* out = m_buffer + m_fill;
+			m_fill += n;
+			return out;
+		}
+
+		// Names are nearly always string literals, so a direct-mapped cache on
+		// the pointer avoids hashing the text for every field. The same
+		// pointer can be a reused buffer holding another name, so a hit is
+		// confirmed against the interned text. False once the dictionary is
+		// full or if the name's record doesn't fit in the buffer.
+		bool intern(const char* name, std::uint16_t& id)
+		{
+			cache_entry& cached = m_cache[(reinterpret_cast<std::uintptr_t>(name) >> 3) % cacheSize];
+			if (cached.name == name && strcmp(cached.text, name) == 0) {
+				id = cached.id;
+				return true;
+			}
+
+			std::string key(name);
+			std::unordered_map<std::string, std::uint16_t>::iterator it = m_names.find(key);
+			if (it != m_names.end()) {
+				id = it->second;
+			} else {
+				if (m_names.size() == eventlog::maxNames) {
+					return false;
+				}
+
+				// the id only counts as taken once its dictionary record is
+				// written, or later events would carry an id nothing defines
+				char* out = reserve(4 + 1 + 2 + key.size());
+				if (out == nullptr) {
+					return false;
+				}
+
+				id = static_cast<std::uint16_t>(m_names.size());
+				eventlog::put<std::uint32_t>(out, static_cast<std::uint32_t>(1 + 2 + key.size()));
+				eventlog::put<std::uint8_t>(out, eventlog::dictionary);
+				eventlog::put<std::uint16_t>(out, id);
+				memcpy(out, key.data(), key.size());
+				it = m_names.emplace(brisk::move(key), id).first;
+			}
+
+			cached.name = name;
+			cached.text = it->first.c_str();
+			cached.id = id;
+			return true;
+		}
+
+		template <class T>
+		static std::string_view asString(const T& value)
+		{
+			if constexpr (std::is_same_v<T, brisk::string>) {
+				return std::string_view(value.c_str());
+			} else {
+				return std::string_view(value);
+			}
+		}
+
+		template <class T>
+		static constexpr bool isString()
+		{
+			using U = std::decay_t<T>;
+			return std::is_same_v<U, const char*> || std::is_same_v<U, char*> || std::is_same_v<U, std::string> ||
+				std::is_same_v<U, std::string_view> || std::is_same_v<U, brisk::string>;
+		}
+
+		template <class T>
+		static brisk::size_t valueSize(const T& value)
+		{
+			if constexpr (isString<T>()) {
+				return 4 + asString(value).size();
+			} else if constexpr (std::is_same_v<T, bool>) {
+				return 1;
+			} else {
+				static_assert(std::is_arithmetic_v<T>, "brisk::event_writer::event values must be arithmetic or strings");
+				return 8;
+			}
+		}
+
+		static brisk::size_t payloadSize()
+		{
+			return 0;
+		}
+
+		template <class Key, class Value, class... Rest>
+		static brisk::size_t payloadSize(const Key&, const Value& value, const Rest&... rest)
+		{
+			return 2 + 1 + valueSize(value) + payloadSize(rest...);
+		}
+
+		bool internKeys(std::uint16_t*)
+		{
+			return true;
+		}
+
+		template <class Value, class... Rest>
+		bool internKeys(std::uint16_t* ids, const char* key, const Value&, const Rest&... rest)
+		{
+			return intern(key, *ids) && internKeys(ids + 1, rest...);
+		}
+
+		void encode(char*&, const std::uint16_t*)
+		{
+
+		}
+
+		template <class Value, class... Rest>
+		void encode(char*& out, const std::uint16_t* ids, const char*, const Value& value, const Rest&... rest)
+		{
+			eventlog::put<std::uint16_t>(out, *ids);
+
+			if constexpr (isString<Value>()) {
+				std::string_view text = asString(value);
+				eventlog::put<std::uint8_t>(out, eventlog::string);
+				eventlog::put<std::uint32_t>(out, static_cast<std::uint32_t>(text.size()));
+				memcpy(out, text.data(), text.size());
+				out += text.size();
+			} else if constexpr (std::is_same_v<Value, bool>) {
+				eventlog::put<std::uint8_t>(out, eventlog::boolean);
+				eventlog::put<std::uint8_t>(out, value ? 1 : 0);
+			} else if constexpr (std::is_floating_point_v<Value>) {
+				eventlog::put<std::uint8_t>(out, eventlog::float64);
+				eventlog::put<double>(out, static_cast<double>(value));
+			} else if constexpr (std::is_signed_v<Value>) {
+				eventlog::put<std::uint8_t>(out, eventlog::int64);
+				eventlog::put<std::int64_t>(out, static_cast<std::int64_t>(value));
+			} else {
+				eventlog::put<std::uint8_t>(out, eventlog::uint64);
+				eventlog::put<std::uint64_t>(out, static_cast<std::uint64_t>(value));
+			}
+
+			encode(out, ids + 1, rest...);
+		}
+
+		std::FILE* m_file;
+		char* m_buffer;
+		brisk::size_t m_fill;
+		bool m_failed;
+		std::mutex m_mutex;
+		std::unordered_map<std::string, std::uint16_t> m_names;
+		cache_entry m_cache[cacheSize];
+	};
+
+#ifdef BRISK_HAS_EVENT_READER
+	class event_reader;
+
+	class event_field
+	{
+	public:
+		event_field() noexcept
+			: m_reader(nullptr), m_data(nullptr)
+		{
+
+		}
+
+		event_field(const event_reader* reader, const char* data) noexcept
+			: m_reader(reader), m_data(data)
+		{
+
+		}
+
+		std::uint16_t key_id() const noexcept
+		{
+			return eventlog::get<std::uint16_t>(m_data);
+		}
+
+		std::string_view key() const noexcept;
+
+		eventlog::field_type type() const noexcept
+		{
+			return static_cast<eventlog::field_type>(m_data[2]);
+		}
+
+		bool is_string() const noexcept
+		{
+			return type() == eventlog::string;
+		}
+
+		// Numeric fields of any type converted to double; 0 for strings.
+		double as_double() const noexcept
+		{
+			switch (type())
+			{
+				case eventlog::int64: return static_cast<double>(eventlog::get<std::int64_t>(m_data + 3));
+				case eventlog::uint64: return static_cast<double>(eventlog::get<std::uint64_t>(m_data + 3));
+				case eventlog::float64: return eventlog::get<double>(m_data + 3);
+				case eventlog::boolean: return m_data[3] ? 1.0 : 0.0;
+				default: return 0.0;
+			}
+		}
+
+		std::int64_t as_int() const noexcept
+		{
+			switch (type())
+			{
+				case eventlog::int64: return eventlog::get<std::int64_t>(m_data + 3);
+				case eventlog::uint64: return static_cast<std::int64_t>(eventlog::get<std::uint64_t>(m_data + 3));
+				case eventlog::float64: return static_cast<std::int64_t>(eventlog::get<double>(m_data + 3));
+				case eventlog::boolean: return m_data[3] ? 1 : 0;
+				default: return 0;
+			}
+		}
+
+		// Points into the mapped file; valid while the reader stays open.
+		std::string_view as_string() const noexcept
+		{
+			if (type() != eventlog::string) {
+				return std::string_view();
+			}
+
+			return std::string_view(m_data + 7, eventlog::get<std::uint32_t>(m_data + 3));
+		}
+
+		// Encoded size of a field starting at data, or 0 if it runs past end.
+		static brisk::size_t encodedSize(const char* data, const char* end) noexcept
+		{
+			if (end - data < 3) {
+				return 0;
+			}
+
+			brisk::size_t size;
+			switch (static_cast<eventlog::field_type>(data[2]))
+			{
+				case eventlog::boolean: size = 4; break;
+				case eventlog::string:
+					if (end - data < 7) {
+						return 0;
+					}
+					size = 7 + eventlog::get<std::uint32_t>(data + 3);
+					break;
+				default: size = 11; break;
+			}
+
+			return (size <= brisk::size_t(end - data)) ? size : 0;
+		}
+
+	private:
+		const event_reader* m_reader;
+		const char* m_data;
+	};
+
+	class event_record
+	{
+	public:
+		class iterator
+		{
+		public:
+			iterator(const event_reader* reader, const char* pos, const char* end) noexcept
+				: m_reader(reader), m_pos(pos), m_end(end)
+			{
+				m_size = event_field::encodedSize(m_pos, m_end);
+				if (m_size == 0) {
+					m_pos = m_end;
+				}
+			}
+
+			event_field operator*() const noexcept
+			{
+				return event_field(m_reader, m_pos);
+			}
+
+			iterator& operator++() noexcept
+			{
+				m_pos += m_size;
+				m_size = event_field::encodedSize(m_pos, m_end);
+				if (m_size == 0) {
+					m_pos = m_end;
+				}
+				return *this;
+			}
+
+			bool operator==(const iterator& other) const noexcept
+			{
+				return m_pos == other.m_pos;
+			}
+
+			bool operator!=(const iterator& other) const noexcept
+			{
+				return m_pos != other.m_pos;
+			}
+
+		private:
+			const event_reader* m_reader;
+			const char* m_pos;
+			const char* m_end;
+			brisk::size_t m_size;
+		};
+
+		// payload points just past the record's kind byte
+		event_record(const event_reader* reader, const char* payload, brisk::size_t length) noexcept
+			: m_reader(reader), m_payload(payload), m_end(payload + length)
+		{
+
+		}
+
+		std::uint16_t name_id() const noexcept
+		{
+			return eventlog::get<std::uint16_t>(m_payload);
+		}
+
+		std::string_view name() const noexcept;
+
+		brisk::size_t size() const noexcept
+		{
+			return static_cast<unsigned char>(m_payload[2]);
+		}
+
+		iterator begin() const noexcept
+		{
+			return iterator(m_reader, m_payload + 3, m_end);
+		}
+
+		iterator end() const noexcept
+		{
+			return iterator(m_reader, m_end, m_end);
+		}
+
+		// Looks a field up by key id, the fast path for filters that run over
+		// every record.
+		bool find(std::uint16_t keyId, event_field& field) const noexcept
+		{
+			for (iterator it = begin(); it != end(); ++it)
+			{
+				if ((*it).key_id() == keyId) {
+					field = *it;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		const event_reader* m_reader;
+		const char* m_payload;
+		const char* m_end;
+	};
+
+	// Memory-maps a structured log and walks its records in place. Dictionary
+	// records are consumed while iterating, so names and key ids resolve as
+	// soon as the events that use them are reached.
+	class event_reader
+	{
+	public:
+		static constexpr int unknown = -1;
+
+		class iterator
+		{
+		public:
+			iterator(event_reader* reader, const char* pos) noexcept
+				: m_reader(reader), m_pos(pos)
+			{
+				skipDictionary();
+			}
+
+			event_record operator*() const noexcept
+			{
+				return event_record(m_reader, m_pos + 5, eventlog::get<std::uint32_t>(m_pos) - 1);
+			}
+
+			iterator& operator++() noexcept
+			{
+				m_pos += 4 + eventlog::get<std::uint32_t>(m_pos);
+				skipDictionary();
+				return *this;
+			}
+
+			bool operator==(const iterator& other) const noexcept
+			{
+				return m_pos == other.m_pos;
+			}
+
+			bool operator!=(const iterator& other) const noexcept
+			{
+				return m_pos != other.m_pos;
+			}
+
+		private:
+			void skipDictionary() noexcept
+			{
+				const char* end = m_reader->m_end;
+				while (m_pos != end)
+				{
+					std::uint32_t length = 0;
+					std::uint8_t kind = 0;
+					if (end - m_pos >= 5) {
+						length = eventlog::get<std::uint32_t>(m_pos);
+						kind = static_cast<std::uint8_t>(m_pos[4]);
+					}
+
+					// an event holds at least its kind, name id and field
+					// count, a dictionary record its kind and id
+					std::uint32_t minimum = (kind == eventlog::event) ? 4 : 3;
+					if (length < minimum || length > brisk::size_t(end - m_pos - 4)) {
+						// a record cut short by a crash ends the log
+						m_pos = end;
+						return;
+					}
+
+					if (kind == eventlog::event) {
+						return;
+					}
+
+					if (kind == eventlog::dictionary) {
+						m_reader->define(eventlog::get<std::uint16_t>(m_pos + 5), std::string_view(m_pos + 7, length - 3));
+					}
+
+					m_pos += 4 + length;
+				}
+			}
+
+			event_reader* m_reader;
+			const char* m_pos;
+		};
+
+		event_reader()
+			: m_map(nullptr), m_mapSize(0), m_begin(nullptr), m_end(nullptr), m_names(new std::string_view[eventlog::maxNames]), m_generation(0)
+		{
+
+		}
+
+		event_reader(const event_reader&) = delete;
+		event_reader& operator=(const event_reader&) = delete;
+
+		~event_reader()
+		{
+			close();
+			delete[] m_names;
+		}
+
+		bool open(const char* path)
+		{
+			close();
+			int fd = ::open(path, O_RDONLY);
+			if (fd < 0) {
+				return false;
+			}
+
+			struct stat info;
+			if (::fstat(fd, &info) != 0 || brisk::size_t(info.st_size) < eventlog::headerSize) {
+				::close(fd);
+				return false;
+			}
+
+			void* mapping = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (mapping == MAP_FAILED) {
+				return false;
+			}
+
+			::madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+			m_map = static_cast<const char*>(mapping);
+			m_mapSize = info.st_size;
+			if (memcmp(m_map, eventlog::magic, 4) != 0 || eventlog::get<std::uint32_t>(m_map + 4) != eventlog::version) {
+				close();
+				return false;
+			}
+
+			m_begin = m_map + eventlog::headerSize;
+			m_end = m_map + m_mapSize;
+			return true;
+		}
+
+		void close()
+		{
+			if (m_map != nullptr) {
+				::munmap(const_cast<char*>(m_map), m_mapSize);
+				// the names point into the mapping
+				for (brisk::size_t i = 0; i < eventlog::maxNames; ++i) {
+					m_names[i] = std::string_view();
+				}
+			}
+
+			m_map = m_begin = m_end = nullptr;
+			m_mapSize = 0;
+			m_ids.clear();
+		}
+
+		iterator begin() noexcept
+		{
+			return iterator(this, m_begin);
+		}
+
+		iterator end() noexcept
+		{
+			return iterator(this, m_end);
+		}
+
+		std::string_view name(std::uint16_t id) const noexcept
+		{
+			return m_names[id];
+		}
+
+		// Id of a name seen so far, or unknown. Callers that cache ids can
+		// compare generation() to tell when new names have appeared.
+		int id(std::string_view name) const
+		{
+			std::unordered_map<std::string_view, std::uint16_t>::const_iterator it = m_ids.find(name);
+			return (it == m_ids.end()) ? unknown : it->second;
+		}
+
+		brisk::size_t generation() const noexcept
+		{
+			return m_generation;
+		}
+
+		brisk::size_t bytes() const noexcept
+		{
+			return m_mapSize;
+		}
+
+	private:
+		void define(std::uint16_t id, std::string_view name)
+		{
+			if (m_names[id] != name) {
+				m_names[id] = name;
+				m_ids[name] = id;
+				++m_generation;
+			}
+		}
+
+		const char* m_map;
+		brisk::size_t m_mapSize;
+		const char* m_begin;
+		const char* m_end;
+		std::string_view* m_names;
+		std::unordered_map<std::string_view, std::uint16_t> m_ids;
+		brisk::size_t m_generation;
+	};
+
+	inline std::string_view event_field::key() const noexcept
+	{
+		return m_reader->name(key_id());
+	}
+
+	inline std::string_view event_record::name() const noexcept
+	{
+		return m_reader->name(name_id());
+	}
+#endif
+}
@@ -0,0 +1,745 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+#include "algorithm.hpp"
+#include "memory.hpp"
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+
+// Asks the compiler to vectorize the next loop without proving that its
+// iterations are independent, which the unsequenced policies promise.
+#if defined(__clang__)
+#define BRISK_PRAGMA_IVDEP _Pragma("clang loop vectorize(enable) interleave(enable)")
+#elif defined(__GNUC__)
+#define BRISK_PRAGMA_IVDEP _Pragma("GCC ivdep")
+#else
+#define BRISK_PRAGMA_IVDEP
+#endif
+
+namespace brisk
+{
+	namespace execution
+	{
+		struct sequenced_policy {};
+		struct unsequenced_policy {};
+
+		// Work is cut into chunks of at least grain() elements (0 lets the
+		// algorithm pick) and run on pool(), default_thread_pool() unless
+		// on() names another. Unsequenced also lets each chunk's loop be
+		// vectorized, so the element functions mustn't take locks.
+		template <bool Unsequenced>
+		class basic_parallel_policy
+		{
+		public:
+			constexpr basic_parallel_policy() noexcept = default;
+
+			constexpr basic_parallel_policy on(thread_pool& pool) const noexcept
+			{
+				basic_parallel_policy policy = *this;
+				policy.m_pool = &pool;
+				return policy;
+			}
+
+			constexpr basic_parallel_policy with_grain(brisk::size_t grain) const noexcept
+			{
+				basic_parallel_policy policy = *this;
+				policy.m_grain = grain;
+				return policy;
+			}
+
+			thread_pool& pool() const
+			{
+				return (m_pool != nullptr) ? *m_pool : default_thread_pool();
+			}
+
+			constexpr brisk::size_t grain() const noexcept
+			{
+				return m_grain;
+			}
+
+		private:
+			thread_pool* m_pool = nullptr;
+			brisk::size_t m_grain = 0;
+		};
+
+		using parallel_policy = basic_parallel_policy<false>;
+		using parallel_unsequenced_policy = basic_parallel_policy<true>;
+
+		inline constexpr sequenced_policy seq{};
+		inline constexpr unsequenced_policy unseq{};
+		inline constexpr parallel_policy par{};
+		inline constexpr parallel_unsequenced_policy par_unseq{};
+	}
+
+	template <class Type> struct is_execution_policy : std::false_type {};
+	template <> struct is_execution_policy<execution::sequenced_policy> : std::true_type {};
+	template <> struct is_execution_policy<execution::unsequenced_policy> : std::true_type {};
+	template <bool Unsequenced> struct is_execution_policy<execution::basic_parallel_policy<Unsequenced>> : std::true_type {};
+
+	template <class Type>
+	inline constexpr bool is_execution_policy_v = is_execution_policy<std::remove_cvref_t<Type>>::value;
+
+	namespace detail
+	{
+		template <class Policy>
+		constexpr bool policyIsParallel = !std::is_same_v<std::remove_cvref_t<Policy>, execution::sequenced_policy>
+			&& !std::is_same_v<std::remove_cvref_t<Policy>, execution::unsequenced_policy>;
+
+		template <class Policy>
+		constexpr bool policyIsUnsequenced = std::is_same_v<std::remove_cvref_t<Policy>, execution::unsequenced_policy>
+			|| std::is_same_v<std::remove_cvref_t<Policy>, execution::parallel_unsequenced_policy>;
+
+		template <class Iterator>
+		constexpr bool isRandomAccess = std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>;
+
+		// Below this many elements per chunk, handing a chunk to another
+		// thread costs more than a cheap element function saves.
+		constexpr brisk::size_t defaultGrain = 16384;
+
+		// Chunks per thread, so a thread that falls behind doesn't hold up
+		// the others.
+		constexpr brisk::size_t chunksPerThread = 4;
+
+		struct chunk_plan
+		{
+			brisk::size_t count;
+			brisk::size_t size;
+
+			brisk::size_t begin(brisk::size_t chunk) const noexcept
+			{
+				return chunk * size;
+			}
+
+			brisk::size_t end(brisk::size_t chunk, brisk::size_t n) const noexcept
+			{
+				return (chunk + 1 == count) ? n : (chunk + 1) * size;
+			}
+		};
+
+		template <class Policy>
+		chunk_plan planChunks(const Policy& policy, brisk::size_t n)
+		{
+			if constexpr (policyIsParallel<Policy>) {
+				brisk::size_t grain = (policy.grain() != 0) ? policy.grain() : defaultGrain;
+				brisk::size_t threads = policy.pool().size();
+				brisk::size_t size = (n + threads * chunksPerThread - 1) / (threads * chunksPerThread);
+				if (size < grain) {
+					size = grain;
+				}
+
+				if (threads > 1 && n > size) {
+					return chunk_plan{(n + size - 1) / size, size};
+				}
+			}
+
+			return chunk_plan{1, n};
+		}
+
+		// Calls body(chunk, begin, end) for every chunk of [0, n), on the
+		// policy's pool when there's more than one.
+		template <class Policy, class Body>
+		void runChunks(const Policy& policy, const chunk_plan& plan, brisk::size_t n, Body&& body)
+		{
+			if (plan.count == 1) {
+				body(brisk::size_t(0), brisk::size_t(0), n);
+				return;
+			}
+
+			if constexpr (policyIsParallel<Policy>) {
+				policy.pool().bulk(plan.count, [&body, &plan, n](brisk::size_t chunk) {
+					body(chunk, plan.begin(chunk), plan.end(chunk, n));
+				});
+			}
+		}
+
+		// f(i) for i in [begin, end), as a loop the compiler may vectorize
+		// when the policy allows it.
+		template <class Policy, class Function>
+		inline void chunkLoop(brisk::size_t begin, brisk::size_t end, Function& f)
+		{
+			if constexpr (policyIsUnsequenced<Policy>) {
+				BRISK_PRAGMA_IVDEP
+				for (brisk::size_t i = begin; i < end; ++i) {
+					f(i);
+				}
+			} else {
+				for (brisk::size_t i = begin; i < end; ++i) {
+					f(i);
+				}
+			}
+		}
+
+		template <class Policy, class Function>
+		void parallelFor(const Policy& policy, brisk::size_t n, Function f)
+		{
+			chunk_plan plan = planChunks(policy, n);
+			runChunks(policy, plan, n, [&f](brisk::size_t, brisk::size_t begin, brisk::size_t end) {
+				chunkLoop<Policy>(begin, end, f);
+			});
+		}
+
+		// Each chunk folds its own elements, then the partial results are
+		// folded into init in chunk order, so for a given pool the grouping
+		// is always the same.
+		template <class Policy, class T, class ReduceOp, class Element>
+		T parallelReduce(const Policy& policy, brisk::size_t n, T init, ReduceOp& reduce, Element element)
+		{
+			chunk_plan plan = planChunks(policy, n);
+			if (plan.count == 1) {
+				for (brisk::size_t i = 0; i < n; ++i) {
+					init = reduce(brisk::move(init), element(i));
+				}
+				return init;
+			}
+
+			brisk::unique_ptr<std::optional<T>[]> partials = brisk::make_unique<std::optional<T>[]>(plan.count);
+			runChunks(policy, plan, n, [&partials, &reduce, &element](brisk::size_t chunk, brisk::size_t begin, brisk::size_t end) {
+				T partial = element(begin);
+				for (brisk::size_t i = begin + 1; i < end; ++i) {
+					partial = reduce(brisk::move(partial), element(i));
+				}
+				partials[chunk].emplace(brisk::move(partial));
+			});
+
+			for (brisk::size_t chunk = 0; chunk < plan.count; ++chunk) {
+				init = reduce(brisk::move(init), brisk::move(*partials[chunk]));
+			}
+
+			return init;
+		}
+	}
+
+	// Overloads of the algorithm.hpp algorithms that take an execution
+	// policy first. The parallel policies split random-access ranges into
+	// chunks and run them on a thread_pool, so element functions are called
+	// from several threads at once and must be safe for that. An exception
+	// from one is rethrown to the caller after the other chunks stop.
+	template <class Policy, class Iterator, class Function>
+		requires is_execution_policy_v<Policy>
+	void for_each(Policy&& policy, Iterator first, Iterator last, Function f)
+	{
+		static_assert(detail::isRandomAccess<Iterator>, "[brisk::for_each]: execution policies need random-access iterators");
+		detail::parallelFor(policy, static_cast<brisk::size_t>(last - first), [first, &f](brisk::size_t i) { f(first[i]); });
+	}
+
+	template <class Policy, class Iterator, class Size, class Function>
+		requires is_execution_policy_v<Policy>
+	Iterator for_each_n(Policy&& policy, Iterator first, Size count, Function f)
+	{
+		static_assert(detail::isRandomAccess<Iterator>, "[brisk::for_each_n]: execution policies need random-access iterators");
+		if (count <= 0) {
+			return first;
+		}
+
+		detail::parallelFor(policy, static_cast<brisk::size_t>(count), [first, &f](brisk::size_t i) { f(first[i]); });
+		return first + count;
+	}
+
+	template <class Policy, class Iterator, class OutIterator, class UnaryOp>
+		requires is_execution_policy_v<Policy>
+	OutIterator transform(Policy&& policy, Iterator first, Iterator last, OutIterator d_first, UnaryOp op)
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<OutIterator>, "[brisk::transform]: execution policies need random-access iterators");
+		brisk::size_t n = static_cast<brisk::size_t>(last - first);
+		detail::parallelFor(policy, n, [first, d_first, &op](brisk::size_t i) { d_first[i] = op(first[i]); });
+		return d_first + n;
+	}
+
+	template <class Policy, class Iterator, class Iterator2, class OutIterator, class BinaryOp>
+		requires is_execution_policy_v<Policy>
+	OutIterator transform(Policy&& policy, Iterator first1, Iterator last1, Iterator2 first2, OutIterator d_first, BinaryOp op)
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<Iterator2> && detail::isRandomAccess<OutIterator>,
+			"[brisk::transform]: execution policies need random-access iterators");
+		brisk::size_t n = static_cast<brisk::size_t>(last1 - first1);
+		detail::parallelFor(policy, n, [first1, first2, d_first, &op](brisk::size_t i) { d_first[i] = op(first1[i], first2[i]); });
+		return d_first + n;
+	}
+
+	template <class Policy, class Iterator, class T, class BinaryOp>
+		requires is_execution_policy_v<Policy>
+	T reduce(Policy&& policy, Iterator first, Iterator last, T init, BinaryOp op)
+	{
+		static_assert(detail::isRandomAccess<Iterator>, "[brisk::reduce]: execution policies need random-access iterators");
+		return detail::parallelReduce(policy, static_cast<brisk::size_t>(last - first), brisk::move(init), op,
+			[first](brisk::size_t i) -> decltype(auto) { return first[i]; });
+	}
+
+	template <class Policy, class Iterator, class T>
+		requires is_execution_policy_v<Policy>
+	T reduce(Policy&& policy, Iterator first, Iterator last, T init)
+	{
+		return brisk::reduce(policy, first, last, brisk::move(init), std::plus<>());
+	}
+
+	template <class Policy, class Iterator>
+		requires is_execution_policy_v<Policy>
+	typename std::iterator_traits<Iterator>::value_type reduce(Policy&& policy, Iterator first, Iterator last)
+	{
+		return brisk::reduce(policy, first, last, typename std::iterator_traits<Iterator>::value_type(), std::plus<>());
+	}
+
+	// accumulate with a policy is reduce: the parallel versions regroup the
+	// additions, so op has to be associative and commutative.
+	template <class Policy, class Iterator, class T, class BinaryOp>
+		requires is_execution_policy_v<Policy>
+	T accumulate(Policy&& policy, Iterator first, Iterator last, T init, BinaryOp op)
+	{
+		return brisk::reduce(policy, first, last, brisk::move(init), op);
+	}
+
+	template <class Policy, class Iterator, class T>
+		requires is_execution_policy_v<Policy>
+	T accumulate(Policy&& policy, Iterator first, Iterator last, T init)
+	{
+		return brisk::reduce(policy, first, last, brisk::move(init), std::plus<>());
+	}
+
+	template <class Policy, class Iterator, class T, class ReduceOp, class TransformOp>
+		requires is_execution_policy_v<Policy>
+	T transform_reduce(Policy&& policy, Iterator first, Iterator last, T init, ReduceOp reduce, TransformOp transform)
+	{
+		static_assert(detail::isRandomAccess<Iterator>, "[brisk::transform_reduce]: execution policies need random-access iterators");
+		return detail::parallelReduce(policy, static_cast<brisk::size_t>(last - first), brisk::move(init), reduce,
+			[first, &transform](brisk::size_t i) { return transform(first[i]); });
+	}
+
+	template <class Policy, class Iterator, class Iterator2, class T, class ReduceOp, class TransformOp>
+		requires is_execution_policy_v<Policy>
+	T transform_reduce(Policy&& policy, Iterator first1, Iterator last1, Iterator2 first2, T init, ReduceOp reduce, TransformOp transform)
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<Iterator2>, "[brisk::transform_reduce]: execution policies need random-access iterators");
+		return detail::parallelReduce(policy, static_cast<brisk::size_t>(last1 - first1), brisk::move(init), reduce,
+			[first1, first2, &transform](brisk::size_t i) { return transform(first1[i], first2[i]); });
+	}
+
+	template <class Policy, class Iterator, class Iterator2, class T>
+		requires is_execution_policy_v<Policy>
+	T transform_reduce(Policy&& policy, Iterator first1, Iterator last1, Iterator2 first2, T init)
+	{
+		return brisk::transform_reduce(policy, first1, last1, first2, brisk::move(init), std::plus<>(), std::multiplies<>());
+	}
+
+	template <class Policy, class Iterator, class T>
+		requires is_execution_policy_v<Policy>
+	void fill(Policy&& policy, Iterator first, Iterator last, const T& value)
+	{
+		static_assert(detail::isRandomAccess<Iterator>, "[brisk::fill]: execution policies need random-access iterators");
+		// whole chunks at a time, so each one can still be a memset
+		brisk::size_t n = static_cast<brisk::size_t>(last - first);
+		detail::runChunks(policy, detail::planChunks(policy, n), n, [first, &value](brisk::size_t, brisk::size_t begin, brisk::size_t end) {
+			brisk::fill(first + begin, first + end, value);
+		});
+	}
+
+	template <class Policy, class Iterator, class OutIterator>
+		requires is_execution_policy_v<Policy>
+	OutIterator copy(Policy&& policy, Iterator first, Iterator last, OutIterator d_first)
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<OutIterator>, "[brisk::copy]: execution policies need random-access iterators");
+		brisk::size_t n = static_cast<brisk::size_t>(last - first);
+		detail::runChunks(policy, detail::planChunks(policy, n), n, [first, d_first](brisk::size_t, brisk::size_t begin, brisk::size_t end) {
+			brisk::copy(first + begin, first + end, d_first + begin);
+		});
+		return d_first + n;
+	}
+
+	template <class Policy, class Iterator, class Predicate>
+		requires is_execution_policy_v<Policy>
+	typename std::iterator_traits<Iterator>::difference_type count_if(Policy&& policy, Iterator first, Iterator last, Predicate pred)
+	{
+		static_assert(detail::isRandomAccess<Iterator>, "[brisk::count_if]: execution policies need random-access iterators");
+		std::plus<> add;
+		return detail::parallelReduce(policy, static_cast<brisk::size_t>(last - first), typename std::iterator_traits<Iterator>::difference_type(0), add,
+			[first, &pred](brisk::size_t i) { return static_cast<typename std::iterator_traits<Iterator>::difference_type>(pred(first[i]) ? 1 : 0); });
+	}
+
+	// Chunks are handed out in order, and each one gives up once a match
+	// has turned up in an earlier chunk, so the first match wins without
+	// every chunk being searched.
+	template <class Policy, class Iterator, class Predicate>
+		requires is_execution_policy_v<Policy>
+	Iterator find_if(Policy&& policy, Iterator first, Iterator last, Predicate pred)
+	{
+		static_assert(detail::isRandomAccess<Iterator>, "[brisk::find_if]: execution policies need random-access iterators");
+		brisk::size_t n = static_cast<brisk::size_t>(last - first);
+		detail::chunk_plan plan = detail::planChunks(policy, n);
+		std::atomic<brisk::size_t> found(n);
+		detail::runChunks(policy, plan, n, [first, &pred, &found](brisk::size_t, brisk::size_t begin, brisk::size_t end) {
+			for (brisk::size_t i = begin; i < end; ++i) {
+				if (((i - begin) & 1023) == 0 && found.load(std::memory_order_relaxed) < begin) {
+					return;
+				}
+
+				if (pred(first[i])) {
+					brisk::size_t best = found.load(std::memory_order_relaxed);
+					while (i < best && !found.compare_exchange_weak(best, i, std::memory_order_relaxed));
+					return;
+				}
+			}
+		});
+
+		return first + found.load(std::memory_order_relaxed);
+	}
+
+	namespace detail
+	{
+		// How many elements of the first range come before output position
+		// diagonal in a stable merge: the merge path crosses that
+		// diagonal there. Binary search, so a chunk of the output can be
+		// merged without merging anything before it.
+		template <class Iterator1, class Iterator2, class Compare>
+		brisk::size_t mergePathSplit(Iterator1 first1, brisk::size_t size1, Iterator2 first2, brisk::size_t size2, brisk::size_t diagonal, Compare& comp)
+		{
+			brisk::size_t low = (diagonal > size2) ? diagonal - size2 : 0;
+			brisk::size_t high = (diagonal < size1) ? diagonal : size1;
+			while (low < high) {
+				brisk::size_t middle = low + (high - low) / 2;
+				if (comp(first2[diagonal - middle - 1], first1[middle])) {
+					high = middle;
+				} else {
+					low = middle + 1;
+				}
+			}
+
+			return low;
+		}
+	}
+
+	// Merge path: each chunk of the output finds where it starts in both
+	// inputs by binary search, then merges its share independently, so the
+	// work splits evenly however the values are spread. Stable.
+	//
+	// Every split is found before any chunk merges: the inputs may be move
+	// iterators, and one chunk's merge would otherwise empty values another
+	// chunk's search is still comparing.
+	template <class Policy, class Iterator1, class Iterator2, class OutIterator, class Compare = brisk::less<>>
+		requires is_execution_policy_v<Policy>
+	OutIterator merge(Policy&& policy, Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutIterator d_first, Compare comp = Compare())
+	{
+		static_assert(detail::isRandomAccess<Iterator1> && detail::isRandomAccess<Iterator2> && detail::isRandomAccess<OutIterator>, "[brisk::merge]: execution policies need random-access iterators");
+		brisk::size_t size1 = static_cast<brisk::size_t>(last1 - first1);
+		brisk::size_t size2 = static_cast<brisk::size_t>(last2 - first2);
+		brisk::size_t n = size1 + size2;
+		const detail::chunk_plan plan = detail::planChunks(policy, n);
+		if (plan.count == 1) {
+			return brisk::merge(first1, last1, first2, last2, d_first, comp);
+		}
+
+		// splits[chunk] is where the chunk starts in the first input; the
+		// last entry closes the final chunk
+		brisk::vector<brisk::size_t> splits(plan.count + 1);
+		for (brisk::size_t chunk = 0; chunk < plan.count; ++chunk) {
+			splits.push_back(0);
+		}
+		splits.push_back(size1);
+
+		detail::runChunks(policy, plan, n, [&](brisk::size_t chunk, brisk::size_t begin, brisk::size_t) {
+			splits[chunk] = detail::mergePathSplit(first1, size1, first2, size2, begin, comp);
+		});
+		detail::runChunks(policy, plan, n, [&](brisk::size_t chunk, brisk::size_t begin, brisk::size_t end) {
+			brisk::size_t begin1 = splits[chunk];
+			brisk::size_t end1 = splits[chunk + 1];
+			brisk::merge(first1 + begin1, first1 + end1, first2 + (begin - begin1), first2 + (end - end1), d_first + begin, comp);
+		});
+
+		return d_first + n;
+	}
+
+	namespace detail
+	{
+		// Moves rather than copies, except where the two are the same.
+		template <class Pointer>
+		auto moving(Pointer p)
+		{
+			if constexpr (std::is_trivially_copyable_v<std::remove_reference_t<decltype(*p)>>)
+				return p;
+			else
+				return std::make_move_iterator(p);
+		}
+
+		// One round of pairwise merges of the sorted runs in source that
+		// bounds delimits, into dest. A run left without a partner is moved
+		// across as it is.
+		template <class Policy, class Source, class Dest, class Compare>
+		void mergeRound(const Policy& policy, Source source, Dest dest, brisk::vector<brisk::size_t>& bounds, Compare& comp)
+		{
+			brisk::vector<brisk::size_t> next;
+			for (brisk::size_t run = 0; run + 1 < bounds.size(); run += 2) {
+				brisk::size_t begin = bounds[run];
+				brisk::size_t middle = bounds[run + 1];
+				if (run + 2 < bounds.size()) {
+					brisk::size_t end = bounds[run + 2];
+					brisk::merge(policy, moving(source + begin), moving(source + middle), moving(source + middle), moving(source + end), dest + begin, comp);
+				} else {
+					brisk::copy(policy, moving(source + begin), moving(source + middle), dest + begin);
+				}
+
+				next.push_back(begin);
+			}
+
+			next.push_back(bounds[bounds.size() - 1]);
+			bounds = brisk::move(next);
+		}
+	}
+
+	// Stable sorts a chunk per task, then merges the sorted runs pairwise
+	// with the parallel merge, a round at a time, through a buffer the size
+	// of the range.
+	template <class Policy, class Iterator, class Compare = brisk::less<>>
+		requires is_execution_policy_v<Policy>
+	void stable_sort(Policy&& policy, Iterator first, Iterator last, Compare comp = Compare())
+	{
+		static_assert(detail::isRandomAccess<Iterator>, "[brisk::stable_sort]: execution policies need random-access iterators");
+		using Type = detail::iter_value_t<Iterator>;
+		brisk::size_t n = static_cast<brisk::size_t>(last - first);
+		detail::chunk_plan plan = detail::planChunks(policy, n);
+		if (plan.count == 1) {
+			brisk::stable_sort(first, last, comp);
+			return;
+		}
+
+		detail::runChunks(policy, plan, n, [first, &comp](brisk::size_t, brisk::size_t begin, brisk::size_t end) {
+			brisk::stable_sort(first + begin, first + end, comp);
+		});
+
+		detail::sort_buffer<Type> buffer(n);
+		Type* scratch = buffer.data();
+		if constexpr (std::is_trivially_copyable_v<Type>) {
+			brisk::copy(policy, first, last, scratch);
+			buffer.constructed(n);
+		} else {
+			brisk::size_t i = 0;
+			try {
+				for (; i < n; ++i) {
+					::new (static_cast<void*>(scratch + i)) Type(brisk::move(first[i]));
+				}
+			} catch (...) {
+				buffer.constructed(i);
+				throw;
+			}
+			buffer.constructed(n);
+		}
+
+		brisk::vector<brisk::size_t> bounds;
+		for (brisk::size_t chunk = 0; chunk < plan.count; ++chunk) {
+			bounds.push_back(plan.begin(chunk));
+		}
+		bounds.push_back(n);
+
+		// runs go back and forth between the buffer and the range
+		bool inBuffer = true;
+		while (bounds.size() > 2) {
+			if (inBuffer) {
+				detail::mergeRound(policy, scratch, first, bounds, comp);
+			} else {
+				detail::mergeRound(policy, first, scratch, bounds, comp);
+			}
+			inBuffer = !inBuffer;
+		}
+
+		if (inBuffer) {
+			brisk::copy(policy, detail::moving(scratch), detail::moving(scratch + n), first);
+		}
+	}
+
+	namespace detail
+	{
+		template <bool Exclusive, class Iterator, class OutIterator, class T, class BinaryOp, class UnaryOp>
+		void scanChunk(Iterator first, Iterator last, OutIterator d_first, T init, BinaryOp& op, UnaryOp& transform)
+		{
+			if constexpr (std::is_same_v<UnaryOp, identity>) {
+				if constexpr (Exclusive) {
+					brisk::exclusive_scan(first, last, d_first, brisk::move(init), op);
+				} else {
+					brisk::inclusive_scan(first, last, d_first, op, brisk::move(init));
+				}
+			} else {
+				if constexpr (Exclusive) {
+					brisk::transform_exclusive_scan(first, last, d_first, brisk::move(init), op, transform);
+				} else {
+					brisk::transform_inclusive_scan(first, last, d_first, op, transform, brisk::move(init));
+				}
+			}
+		}
+
+		// Two passes over the chunks: each is reduced to its total, the
+		// totals are scanned on this thread into the value each chunk
+		// starts from, and then each chunk is scanned from it. That reads
+		// the input twice but keeps every chunk independent. An inclusive
+		// scan without init leaves the first chunk with none.
+		template <bool Exclusive, class T, class Policy, class Iterator, class OutIterator, class BinaryOp, class UnaryOp>
+		OutIterator scanChunks(const Policy& policy, Iterator first, Iterator last, OutIterator d_first, std::optional<T> init, BinaryOp& op, UnaryOp& transform)
+		{
+			const brisk::size_t n = static_cast<brisk::size_t>(last - first);
+			if (n == 0) {
+				return d_first;
+			}
+
+			const chunk_plan plan = planChunks(policy, n);
+			brisk::vector<std::optional<T>> starts(plan.count);
+			for (brisk::size_t chunk = 0; chunk < plan.count; ++chunk) {
+				starts.push_back(std::optional<T>());
+			}
+
+			if (plan.count > 1) {
+				// the last chunk's total isn't needed
+				brisk::vector<std::optional<T>> totals(starts);
+				runChunks(policy, plan, n, [first, &totals, &op, &transform, &plan](brisk::size_t chunk, brisk::size_t begin, brisk::size_t end) {
+					if (chunk + 1 < plan.count) {
+						T total = transform(first[begin]);
+						totals[chunk].emplace(brisk::transform_reduce(first + (begin + 1), first + end, brisk::move(total), op, transform));
+					}
+				});
+
+				std::optional<T> running = brisk::move(init);
+				for (brisk::size_t chunk = 0; chunk < plan.count; ++chunk) {
+					starts[chunk] = running;
+					if (chunk + 1 < plan.count) {
+						running.emplace(running ? op(brisk::move(*running), brisk::move(*totals[chunk])) : brisk::move(*totals[chunk]));
+					}
+				}
+			} else {
+				starts[0] = brisk::move(init);
+			}
+
+			runChunks(policy, plan, n, [first, d_first, &starts, &op, &transform](brisk::size_t chunk, brisk::size_t begin, brisk::size_t end) {
+				if (starts[chunk]) {
+					scanChunk<Exclusive>(first + begin, first + end, d_first + begin, brisk::move(*starts[chunk]), op, transform);
+				} else {
+					T start = transform(first[begin]);
+					d_first[begin] = start;
+					scanChunk<Exclusive>(first + (begin + 1), first + end, d_first + (begin + 1), brisk::move(start), op, transform);
+				}
+			});
+
+			return d_first + n;
+		}
+
+		template <class Iterator, class UnaryOp>
+		using scan_value_t = std::decay_t<std::invoke_result_t<UnaryOp&, std::iter_reference_t<Iterator>>>;
+	}
+
+	// The scans split into chunks as below, so op has to be associative.
+	template <class Policy, class Iterator, class OutIterator, class BinaryOp, class T>
+		requires is_execution_policy_v<Policy>
+	OutIterator inclusive_scan(Policy&& policy, Iterator first, Iterator last, OutIterator d_first, BinaryOp op, T init)
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<OutIterator>, "[brisk::inclusive_scan]: execution policies need random-access iterators");
+		detail::identity transform;
+		return detail::scanChunks<false, T>(policy, first, last, d_first, std::optional<T>(brisk::move(init)), op, transform);
+	}
+
+	template <class Policy, class Iterator, class OutIterator, class BinaryOp>
+		requires is_execution_policy_v<Policy>
+	OutIterator inclusive_scan(Policy&& policy, Iterator first, Iterator last, OutIterator d_first, BinaryOp op)
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<OutIterator>, "[brisk::inclusive_scan]: execution policies need random-access iterators");
+		using T = detail::iter_value_t<Iterator>;
+		detail::identity transform;
+		return detail::scanChunks<false, T>(policy, first, last, d_first, std::optional<T>(), op, transform);
+	}
+
+	template <class Policy, class Iterator, class OutIterator>
+		requires is_execution_policy_v<Policy>
+	OutIterator inclusive_scan(Policy&& policy, Iterator first, Iterator last, OutIterator d_first)
+	{
+		return brisk::inclusive_scan(policy, first, last, d_first, std::plus<>());
+	}
+
+	template <class Policy, class Iterator, class OutIterator, class T, class BinaryOp>
+		requires is_execution_policy_v<Policy>
+	OutIterator exclusive_scan(Policy&& policy, Iterator first, Iterator last, OutIterator d_first, T init, BinaryOp op)
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<OutIterator>, "[brisk::exclusive_scan]: execution policies need random-access iterators");
+		detail::identity transform;
+		return detail::scanChunks<true, T>(policy, first, last, d_first, std::optional<T>(brisk::move(init)), op, transform);
+	}
+
+	template <class Policy, class Iterator, class OutIterator, class T>
+		requires is_execution_policy_v<Policy>
+	OutIterator exclusive_scan(Policy&& policy, Iterator first, Iterator last, OutIterator d_first, T init)
+	{
+		return brisk::exclusive_scan(policy, first, last, d_first, brisk::move(init), std::plus<>());
+	}
+
+	template <class Policy, class Iterator, class OutIterator, class BinaryOp, class UnaryOp, class T>
+		requires is_execution_policy_v<Policy>
+	OutIterator transform_inclusive_scan(Policy&& policy, Iterator first, Iterator last, OutIterator d_first, BinaryOp op, UnaryOp transform, T init)
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<OutIterator>, "[brisk::transform_inclusive_scan]: execution policies need random-access iterators");
+		return detail::scanChunks<false, T>(policy, first, last, d_first, std::optional<T>(brisk::move(init)), op, transform);
+	}
+
+	template <class Policy, class Iterator, class OutIterator, class BinaryOp, class UnaryOp>
+		requires is_execution_policy_v<Policy>
+	OutIterator transform_inclusive_scan(Policy&& policy, Iterator first, Iterator last, OutIterator d_first, BinaryOp op, UnaryOp transform)
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<OutIterator>, "[brisk::transform_inclusive_scan]: execution policies need random-access iterators");
+		using T = detail::scan_value_t<Iterator, UnaryOp>;
+		return detail::scanChunks<false, T>(policy, first, last, d_first, std::optional<T>(), op, transform);
+	}
+
+	template <class Policy, class Iterator, class OutIterator, class T, class BinaryOp, class UnaryOp>
+		requires is_execution_policy_v<Policy>
+	OutIterator transform_exclusive_scan(Policy&& policy, Iterator first, Iterator last, OutIterator d_first, T init, BinaryOp op, UnaryOp transform)
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<OutIterator>, "[brisk::transform_exclusive_scan]: execution policies need random-access iterators");
+		return detail::scanChunks<true, T>(policy, first, last, d_first, std::optional<T>(brisk::move(init)), op, transform);
+	}
+
+	// Each chunk counts into a table of its own, and the tables are summed
+	// bucket by bucket. There are never more tables than it takes to match
+	// the input in size, so a histogram with many buckets uses fewer chunks.
+	template <class Policy, class Iterator, class CountIterator, class Key = detail::identity>
+		requires is_execution_policy_v<Policy>
+	CountIterator histogram(Policy&& policy, Iterator first, Iterator last, CountIterator counts, brisk::size_t bins, Key key = Key())
+	{
+		static_assert(detail::isRandomAccess<Iterator> && detail::isRandomAccess<CountIterator>, "[brisk::histogram]: execution policies need random-access iterators");
+		using Count = detail::iter_value_t<CountIterator>;
+		const brisk::size_t n = static_cast<brisk::size_t>(last - first);
+		detail::chunk_plan plan = detail::planChunks(policy, n);
+		brisk::size_t chunks = plan.count;
+		while (chunks > 1 && chunks * bins > n) {
+			chunks /= 2;
+		}
+		if (chunks <= 1) {
+			return brisk::histogram(first, last, counts, bins, key);
+		}
+
+		plan = detail::chunk_plan{chunks, (n + chunks - 1) / chunks};
+		detail::sort_buffer<brisk::size_t> tables(chunks * bins);
+		brisk::size_t* table = tables.data();
+		detail::runChunks(policy, plan, n, [first, table, bins, &key](brisk::size_t chunk, brisk::size_t begin, brisk::size_t end) {
+			brisk::histogram(first + begin, first + end, table + chunk * bins, bins, key);
+		});
+
+		detail::runChunks(policy, detail::planChunks(policy, bins), bins, [counts, table, bins, chunks](brisk::size_t, brisk::size_t begin, brisk::size_t end) {
+			for (brisk::size_t b = begin; b < end; ++b) {
+				brisk::size_t sum = 0;
+				for (brisk::size_t chunk = 0; chunk < chunks; ++chunk) {
+					sum += table[chunk * bins + b];
+				}
+				counts[b] = static_cast<Count>(sum);
+			}
+		});
+
+		return counts + bins;
+	}
+
+	template <class Policy, class Iterator, class OffsetIterator, class Key = detail::identity>
+		requires is_execution_policy_v<Policy>
+	OffsetIterator bucket_offsets(Policy&& policy, Iterator first, Iterator last, OffsetIterator offsets, brisk::size_t bins, Key key = Key())
+	{
+		using Count = detail::iter_value_t<OffsetIterator>;
+		brisk::histogram(policy, first, last, offsets, bins, key);
+		offsets[bins] = Count(0);
+		return brisk::exclusive_scan(policy, offsets, offsets + (bins + 1), offsets, Count(0));
+	}
+}
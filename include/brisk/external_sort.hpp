@@ -0,0 +1,362 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+#include "functional.hpp"
+#include "algorithm.hpp"
+#include "execution.hpp"
+#include "merge.hpp"
+#include "vector.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+namespace brisk
+{
+	struct external_sort_options
+	{
+		// Memory for sorting runs, which the merge then reuses for its
+		// buffers.
+		brisk::size_t memory_bytes = brisk::size_t(256) << 20;
+		// Read buffer per run while merging. Fewer, larger buffers read
+		// more sequentially but merge fewer runs per pass.
+		brisk::size_t buffer_bytes = brisk::size_t(1) << 20;
+		// Where runs are written; empty means the system's temp directory.
+		std::filesystem::path temp_directory;
+	};
+
+	namespace detail
+	{
+		class sort_file
+		{
+		public:
+			sort_file() noexcept
+				: m_file(nullptr)
+			{
+
+			}
+
+			sort_file(const std::filesystem::path& path, const char* mode)
+				: m_file(std::fopen(path.string().c_str(), mode))
+			{
+				if (m_file == nullptr) {
+					throw std::runtime_error("[brisk::external_sort][Exception]: could not open " + path.string());
+				}
+			}
+
+			sort_file(const sort_file&) = delete;
+			sort_file& operator=(const sort_file&) = delete;
+
+			sort_file(sort_file&& other) noexcept
+				: m_file(other.m_file)
+			{
+				other.m_file = nullptr;
+			}
+
+			sort_file& operator=(sort_file&& other) noexcept
+			{
+				if (this != &other) {
+					close();
+					m_file = other.m_file;
+					other.m_file = nullptr;
+				}
+
+				return *this;
+			}
+
+			~sort_file()
+			{
+				close();
+			}
+
+			template <class T>
+			brisk::size_t read(T* data, brisk::size_t count)
+			{
+				brisk::size_t read = std::fread(data, sizeof(T), count, m_file);
+				if (read < count && std::ferror(m_file)) {
+					throw std::runtime_error("[brisk::external_sort][Exception]: read failed");
+				}
+
+				return read;
+			}
+
+			template <class T>
+			void write(const T* data, brisk::size_t count)
+			{
+				if (std::fwrite(data, sizeof(T), count, m_file) != count) {
+					throw std::runtime_error("[brisk::external_sort][Exception]: write failed");
+				}
+			}
+
+			// Flushes and closes, reporting what the destructor can't.
+			void finish()
+			{
+				int result = std::fclose(m_file);
+				m_file = nullptr;
+				if (result != 0) {
+					throw std::runtime_error("[brisk::external_sort][Exception]: write failed");
+				}
+			}
+
+		private:
+			void close() noexcept
+			{
+				if (m_file != nullptr) {
+					std::fclose(m_file);
+					m_file = nullptr;
+				}
+			}
+
+			std::FILE* m_file;
+		};
+
+		// The run files of one sort, removed when it's done or has failed.
+		class run_files
+		{
+		public:
+			explicit run_files(const std::filesystem::path& directory)
+				: m_directory(directory.empty() ? std::filesystem::temp_directory_path() : directory), m_next(0)
+			{
+				static std::atomic<unsigned long long> sorts(0);
+				m_prefix = "brisk_sort_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())
+					+ "_" + std::to_string(sorts.fetch_add(1, std::memory_order_relaxed)) + "_";
+			}
+
+			run_files(const run_files&) = delete;
+			run_files& operator=(const run_files&) = delete;
+
+			~run_files()
+			{
+				for (brisk::size_t i = 0; i < m_paths.size(); ++i) {
+					remove(m_paths[i]);
+				}
+			}
+
+			std::filesystem::path create()
+			{
+				std::filesystem::path path = m_directory / (m_prefix + std::to_string(m_next++) + ".run");
+				m_paths.push_back(path.string());
+				return path;
+			}
+
+			static void remove(const std::string& path) noexcept
+			{
+				std::error_code ignored;
+				std::filesystem::remove(path, ignored);
+			}
+
+		private:
+			std::filesystem::path m_directory;
+			std::string m_prefix;
+			vector<std::string> m_paths;
+			brisk::size_t m_next;
+		};
+
+		// A run being merged, read a buffer at a time.
+		template <class T>
+		struct file_source
+		{
+			sort_file* file = nullptr;
+			T* buffer = nullptr;
+			brisk::size_t capacity = 0;
+			brisk::size_t count = 0;
+			brisk::size_t position = 0;
+
+			bool empty() const noexcept
+			{
+				return position == count;
+			}
+
+			const T& front() const noexcept
+			{
+				return buffer[position];
+			}
+
+			void pop()
+			{
+				if (++position == count) {
+					count = file->read(buffer, capacity);
+					position = 0;
+				}
+			}
+		};
+
+		// Writes what it's given a buffer at a time.
+		template <class T>
+		class file_sink
+		{
+		public:
+			file_sink(sort_file& file, T* buffer, brisk::size_t capacity) noexcept
+				: m_file(file), m_buffer(buffer), m_capacity(capacity), m_count(0)
+			{
+
+			}
+
+			void push(const T& value)
+			{
+				m_buffer[m_count++] = value;
+				if (m_count == m_capacity) {
+					flush();
+				}
+			}
+
+			void flush()
+			{
+				m_file.write(m_buffer, m_count);
+				m_count = 0;
+			}
+
+		private:
+			sort_file& m_file;
+			T* m_buffer;
+			brisk::size_t m_capacity;
+			brisk::size_t m_count;
+		};
+
+		// Merges the runs in paths into output, with a buffer of
+		// bufferElements per run and one for the output, all cut from
+		// memory.
+		template <class T, class Compare>
+		void mergeRunFiles(const vector<std::string>& paths, brisk::size_t first, brisk::size_t last, const std::filesystem::path& output, T* memory, brisk::size_t bufferElements, Compare& comp)
+		{
+			const brisk::size_t runs = last - first;
+			vector<sort_file> files(runs);
+			vector<file_source<T>> sources(runs);
+			for (brisk::size_t i = 0; i < runs; ++i) {
+				files.emplace_back(std::filesystem::path(paths[first + i]), "rb");
+			}
+			for (brisk::size_t i = 0; i < runs; ++i) {
+				file_source<T> source;
+				source.file = &files[i];
+				source.buffer = memory + i * bufferElements;
+				source.capacity = bufferElements;
+				source.count = files[i].read(source.buffer, bufferElements);
+				sources.push_back(source);
+			}
+
+			sort_file out(output, "wb");
+			file_sink<T> sink(out, memory + runs * bufferElements, bufferElements);
+			loser_tree<file_source<T>, Compare> tree(brisk::move(sources), comp);
+			while (!tree.empty()) {
+				sink.push(tree.top());
+				tree.pop();
+			}
+
+			sink.flush();
+			out.finish();
+		}
+
+		template <class T, class Policy, class Compare>
+		void externalSort(const Policy& policy, const std::filesystem::path& input, const std::filesystem::path& output, Compare& comp, const external_sort_options& options)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "[brisk::external_sort]: records must be trivially copyable");
+			const brisk::size_t bytes = static_cast<brisk::size_t>(std::filesystem::file_size(input));
+			if (bytes % sizeof(T) != 0) {
+				throw std::runtime_error("[brisk::external_sort][Exception]: " + input.string() + " isn't a whole number of records");
+			}
+
+			// never more memory than the input takes, none for an empty one
+			const brisk::size_t total = bytes / sizeof(T);
+			brisk::size_t runElements = options.memory_bytes / sizeof(T);
+			runElements = (runElements < 3) ? 3 : runElements;
+			runElements = (runElements > total) ? total : runElements;
+			sort_buffer<T> memory(runElements);
+			T* data = memory.data();
+
+			// everything fits: one sort, no run files
+			if (total <= runElements) {
+				brisk::size_t count = 0;
+				{
+					sort_file in(input, "rb");
+					count = in.read(data, total);
+				}
+
+				brisk::stable_sort(policy, data, data + count, comp);
+				sort_file out(output, "wb");
+				out.write(data, count);
+				out.finish();
+				return;
+			}
+
+			run_files temp(options.temp_directory);
+			vector<std::string> runs;
+			{
+				sort_file in(input, "rb");
+				for (brisk::size_t count; (count = in.read(data, runElements)) != 0; ) {
+					brisk::stable_sort(policy, data, data + count, comp);
+					std::filesystem::path path = temp.create();
+					sort_file run(path, "wb");
+					run.write(data, count);
+					run.finish();
+					runs.push_back(path.string());
+				}
+			}
+
+			// the merge reuses the run memory: a buffer per run being merged
+			// and one for the output
+			brisk::size_t bufferElements = options.buffer_bytes / sizeof(T);
+			bufferElements = (bufferElements == 0) ? 1 : bufferElements;
+			brisk::size_t fanIn = runElements / bufferElements;
+			fanIn = (fanIn > 1) ? fanIn - 1 : 0;
+			if (fanIn < 2) {
+				fanIn = 2;
+				bufferElements = runElements / 3;
+			}
+
+			// merge fanIn runs at a time until one pass can finish the job
+			while (runs.size() > fanIn) {
+				vector<std::string> merged;
+				for (brisk::size_t first = 0; first < runs.size(); first += fanIn) {
+					brisk::size_t last = (first + fanIn < runs.size()) ? first + fanIn : runs.size();
+					if (last - first == 1) {
+						merged.push_back(runs[first]);
+						continue;
+					}
+
+					std::filesystem::path path = temp.create();
+					mergeRunFiles(runs, first, last, path, data, bufferElements, comp);
+					for (brisk::size_t i = first; i < last; ++i) {
+						run_files::remove(runs[i]);
+					}
+					merged.push_back(path.string());
+				}
+
+				runs = brisk::move(merged);
+			}
+
+			if (runs.size() > 1) {
+				brisk::size_t fitted = runElements / (runs.size() + 1);
+				bufferElements = (fitted > bufferElements) ? fitted : bufferElements;
+			}
+			mergeRunFiles(runs, 0, runs.size(), output, data, bufferElements, comp);
+		}
+	}
+
+	// Sorts a file of T records too large for memory: runs of
+	// options.memory_bytes are read, sorted and written to temporary
+	// files, which are then k-way merged through a loser tree, in several
+	// passes if there are more runs than buffers. Stable. T must be
+	// trivially copyable and is read and written as its raw bytes; output
+	// may be the input. Throws std::runtime_error on I/O failure and
+	// std::filesystem::filesystem_error if input can't be found.
+	template <class T, class Compare = brisk::less<>>
+	void external_sort(const std::filesystem::path& input, const std::filesystem::path& output, Compare comp = Compare(), const external_sort_options& options = external_sort_options())
+	{
+		detail::externalSort<T>(execution::seq, input, output, comp, options);
+	}
+
+	// The same, sorting each run with the parallel stable_sort. The merge
+	// is bound by the disk and stays on one thread.
+	template <class T, class Policy, class Compare = brisk::less<>>
+		requires is_execution_policy_v<Policy>
+	void external_sort(Policy&& policy, const std::filesystem::path& input, const std::filesystem::path& output, Compare comp = Compare(), const external_sort_options& options = external_sort_options())
+	{
+		detail::externalSort<T>(policy, input, output, comp, options);
+	}
+}
@@ -0,0 +1,304 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+#include "functional.hpp"
+#include "vector.hpp"
+#include "memory_resource.hpp"
+#ifdef BRISK_HEAP_PROFILE
+#include "heap_profiler.hpp"
+#endif
+
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <type_traits>
+
+namespace brisk
+{
+	// A sorted set of keys laid out for searching rather than for walking in
+	// order. A plain binary search touches a new cache line at almost every
+	// step, and none of them can be fetched early because the next probe
+	// depends on this comparison.
+	//
+	// The default layout is Eytzinger's: the implicit binary search tree
+	// stored breadth first, so node k has its children at 2k and 2k + 1.
+	// The top levels that every search passes through share a few hot cache
+	// lines, and the 16 (for 4-byte keys) possible descendants four levels
+	// down sit in one line, which is prefetched while the levels in between
+	// are compared.
+	//
+	// Blocked = true packs a cache line of keys into each node instead, a
+	// static B-tree with 64 / sizeof(T) + 1 children per node, so a search
+	// makes one miss per node rather than one per level, but those misses
+	// can't be prefetched. Without SIMD ranking inside a node the Eytzinger
+	// layout has come out ahead for int keys; measure both with
+	// search_benchmark. Unused slots in the last nodes repeat the largest
+	// key.
+	//
+	// Lookups return a pointer to a key equal to the answer, or nullptr
+	// when there's none; the index doesn't keep the original positions.
+	template <class T, class Compare = brisk::less<>, bool Blocked = false>
+	class eytzinger_index
+	{
+	public:
+		using size_type = brisk::size_t;
+		using value_type = T;
+		using const_pointer = const T*;
+
+		// Built from a range sorted by comp.
+		template <class Iterator>
+		eytzinger_index(Iterator first, Iterator last, Compare comp = Compare(), memory_resource* resource = brisk::get_default_resource())
+			: m_data(nullptr), m_slots(0), m_size(0), m_nodes(0), m_comp(comp), m_resource(resource)
+		{
+			m_size = static_cast<size_type>(std::distance(first, last));
+			if (m_size == 0) {
+				return;
+			}
+
+			if constexpr (Blocked) {
+				m_nodes = (m_size + nodeKeys - 1) / nodeKeys;
+				m_slots = m_nodes * nodeKeys;
+			} else {
+				m_nodes = m_size;
+				m_slots = m_size + 1;
+			}
+
+			allocate(*std::next(first, m_size - 1));
+			size_type remaining = m_size;
+			build(first, remaining, Blocked ? 0 : 1);
+		}
+
+		explicit eytzinger_index(const vector<T>& sorted, Compare comp = Compare(), memory_resource* resource = brisk::get_default_resource())
+			: eytzinger_index(sorted.cbegin(), sorted.cend(), comp, resource)
+		{
+
+		}
+
+		// A copy allocates from other's resource unless it's given one.
+		eytzinger_index(const eytzinger_index& other)
+			: eytzinger_index(other, other.m_resource)
+		{
+
+		}
+
+		eytzinger_index(const eytzinger_index& other, memory_resource* resource)
+			: m_data(nullptr), m_slots(other.m_slots), m_size(other.m_size), m_nodes(other.m_nodes), m_comp(other.m_comp), m_resource(resource)
+		{
+			if (m_slots != 0) {
+				copyFrom(other);
+			}
+		}
+
+		eytzinger_index(eytzinger_index&& other) noexcept
+			: m_data(other.m_data), m_slots(other.m_slots), m_size(other.m_size), m_nodes(other.m_nodes), m_comp(other.m_comp), m_resource(other.m_resource)
+		{
+			other.m_data = nullptr;
+			other.m_slots = 0;
+			other.m_size = 0;
+			other.m_nodes = 0;
+		}
+
+		eytzinger_index& operator=(const eytzinger_index& other)
+		{
+			if (this != &other) {
+				eytzinger_index copy(other);
+				*this = brisk::move(copy);
+			}
+
+			return *this;
+		}
+
+		eytzinger_index& operator=(eytzinger_index&& other) noexcept
+		{
+			if (this != &other) {
+				release();
+				m_data = other.m_data;
+				m_slots = other.m_slots;
+				m_size = other.m_size;
+				m_nodes = other.m_nodes;
+				m_comp = other.m_comp;
+				m_resource = other.m_resource;
+				other.m_data = nullptr;
+				other.m_slots = 0;
+				other.m_size = 0;
+				other.m_nodes = 0;
+			}
+
+			return *this;
+		}
+
+		~eytzinger_index()
+		{
+			release();
+		}
+
+		size_type size() const noexcept
+		{
+			return m_size;
+		}
+
+		bool empty() const noexcept
+		{
+			return m_size == 0;
+		}
+
+		memory_resource* resource() const noexcept
+		{
+			return m_resource;
+		}
+
+		// The smallest key that isn't less than value.
+		template <class K>
+		const_pointer lower_bound(const K& value) const
+		{
+			return search([this, &value](const T& key) -> bool { return m_comp(key, value); });
+		}
+
+		// The smallest key greater than value.
+		template <class K>
+		const_pointer upper_bound(const K& value) const
+		{
+			return search([this, &value](const T& key) -> bool { return !m_comp(value, key); });
+		}
+
+		template <class K>
+		bool contains(const K& value) const
+		{
+			const_pointer key = lower_bound(value);
+			return key != nullptr && !m_comp(value, *key);
+		}
+
+	private:
+		static constexpr size_type lineBytes = 64;
+		// keys per node when blocked, and how many nodes ahead of the
+		// current one the Eytzinger search prefetches
+		static constexpr size_type nodeKeys = (sizeof(T) < lineBytes) ? lineBytes / sizeof(T) : 1;
+		static constexpr size_type alignment = (alignof(T) > lineBytes) ? alignof(T) : lineBytes;
+
+		// Every slot starts as a copy of the largest key, which leaves the
+		// padding right and lets the tree be filled in any order.
+		void allocate(const T& largest)
+		{
+			BRISK_HEAP_SAMPLE(m_slots * sizeof(T));
+			m_data = static_cast<T*>(m_resource->allocate(m_slots * sizeof(T), alignment));
+			size_type i = 0;
+			try {
+				for (; i < m_slots; ++i) {
+					::new (static_cast<void*>(m_data + i)) T(largest);
+				}
+			} catch (...) {
+				destroy(i);
+				throw;
+			}
+		}
+
+		void copyFrom(const eytzinger_index& other)
+		{
+			BRISK_HEAP_SAMPLE(m_slots * sizeof(T));
+			m_data = static_cast<T*>(m_resource->allocate(m_slots * sizeof(T), alignment));
+			size_type i = 0;
+			try {
+				for (; i < m_slots; ++i) {
+					::new (static_cast<void*>(m_data + i)) T(other.m_data[i]);
+				}
+			} catch (...) {
+				destroy(i);
+				throw;
+			}
+		}
+
+		void destroy(size_type constructed) noexcept
+		{
+			if constexpr (!std::is_trivially_destructible_v<T>) {
+				for (size_type i = 0; i < constructed; ++i) {
+					m_data[i].~T();
+				}
+			}
+
+			m_resource->deallocate(m_data, m_slots * sizeof(T), alignment);
+			m_data = nullptr;
+		}
+
+		void release() noexcept
+		{
+			if (m_data != nullptr) {
+				destroy(m_slots);
+			}
+		}
+
+		// An in-order walk of the tree hands out the sorted keys in order.
+		template <class Iterator>
+		void build(Iterator& it, size_type& remaining, size_type k)
+		{
+			if constexpr (Blocked) {
+				if (k >= m_nodes) {
+					return;
+				}
+
+				for (size_type i = 0; i <= nodeKeys; ++i) {
+					build(it, remaining, k * (nodeKeys + 1) + i + 1);
+					if (i < nodeKeys && remaining != 0) {
+						m_data[k * nodeKeys + i] = *it;
+						++it;
+						--remaining;
+					}
+				}
+			} else {
+				if (k > m_nodes) {
+					return;
+				}
+
+				build(it, remaining, 2 * k);
+				m_data[k] = *it;
+				++it;
+				--remaining;
+				build(it, remaining, 2 * k + 1);
+			}
+		}
+
+		// goRight(key) says the answer lies past key.
+		template <class GoRight>
+		const_pointer search(GoRight goRight) const
+		{
+			if constexpr (Blocked) {
+				const_pointer result = nullptr;
+				for (size_type k = 0; k < m_nodes; ) {
+					const_pointer node = m_data + k * nodeKeys;
+					size_type rank = 0;
+					for (size_type i = 0; i < nodeKeys; ++i) {
+						rank += goRight(node[i]);
+					}
+
+					result = (rank < nodeKeys) ? node + rank : result;
+					k = k * (nodeKeys + 1) + rank + 1;
+				}
+
+				return result;
+			} else {
+				size_type k = 1;
+				const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(m_data);
+				while (k <= m_nodes) {
+					BRISK_PREFETCH(reinterpret_cast<const void*>(base + k * nodeKeys * sizeof(T)));
+					k = 2 * k + goRight(m_data[k]);
+				}
+
+				// the path went right until it overshot; the last left turn
+				// is the answer, found by dropping the trailing right turns
+				k >>= std::countr_one(k) + 1;
+				return (k != 0) ? m_data + k : nullptr;
+			}
+		}
+
+		T* m_data;
+		size_type m_slots;
+		size_type m_size;
+		size_type m_nodes;
+		Compare m_comp;
+		memory_resource* m_resource;
+	};
+
+	template <class T, class Compare = brisk::less<>>
+	using blocked_eytzinger_index = eytzinger_index<T, Compare, true>;
+}
@@ -0,0 +1,278 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "memory_resource.hpp"
+#include "string.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace brisk
+{
+	// These are never defined. A format string that fails validation calls one
+	// of them from a consteval constructor, which turns the mistake into a
+	// compile error that names the problem.
+	void format_string_has_more_placeholders_than_arguments();
+	void format_string_has_fewer_placeholders_than_arguments();
+	void format_string_has_unmatched_brace();
+	void format_string_only_supports_empty_placeholders();
+
+	// A format string checked at compile time against the argument types.
+	// "{}" is replaced by the next argument and "{{" / "}}" write a literal
+	// brace. Parsing happens once, in the consteval constructor, and leaves
+	// behind the literal segments between placeholders so rendering is just a
+	// memcpy per segment and one writer call per argument.
+	template <class... Args>
+	class format_string
+	{
+	public:
+		static constexpr brisk::size_t segments = sizeof...(Args) + 1;
+
+		template <brisk::size_t N>
+		consteval format_string(const char (&s)[N])
+			: m_text(s), m_begin(), m_end(), m_escaped()
+		{
+			brisk::size_t segment = 0;
+			brisk::size_t start = 0;
+			for (brisk::size_t i = 0; i + 1 < N; ++i)
+			{
+				if (s[i] == '{' && i + 2 < N && s[i + 1] == '{') {
+					m_escaped[segment] = true;
+					++i;
+				} else if (s[i] == '}' && i + 2 < N && s[i + 1] == '}') {
+					m_escaped[segment] = true;
+					++i;
+				} else if (s[i] == '{') {
+					if (i + 2 >= N || s[i + 1] != '}') {
+						format_string_only_supports_empty_placeholders();
+					}
+
+					if (segment + 1 >= segments) {
+						format_string_has_more_placeholders_than_arguments();
+					}
+
+					m_begin[segment] = start;
+					m_end[segment] = i;
+					++segment;
+					start = i + 2;
+					++i;
+				} else if (s[i] == '}') {
+					format_string_has_unmatched_brace();
+				}
+			}
+
+			if (segment + 1 != segments) {
+				format_string_has_fewer_placeholders_than_arguments();
+			}
+
+			m_begin[segment] = start;
+			m_end[segment] = N - 1;
+		}
+
+		std::string_view literal(brisk::size_t i) const noexcept
+		{
+			return std::string_view(m_text + m_begin[i], m_end[i] - m_begin[i]);
+		}
+
+		bool escaped(brisk::size_t i) const noexcept
+		{
+			return m_escaped[i];
+		}
+
+	private:
+		const char* m_text;
+		brisk::size_t m_begin[segments];
+		brisk::size_t m_end[segments];
+		bool m_escaped[segments];
+	};
+
+	// Keeps format_string's Args out of deduction so they come from the
+	// arguments and the literal converts to the matching format_string.
+	template <class... Args>
+	using format_string_for = format_string<std::type_identity_t<std::decay_t<Args>>...>;
+
+	// A growable character buffer that keeps its capacity between uses, so
+	// formatting into a long-lived one stops allocating once it has grown.
+	class format_buffer
+	{
+	public:
+		explicit format_buffer(memory_resource* resource = brisk::get_default_resource())
+			: m_data(nullptr), m_size(0), m_capacity(256), m_resource(resource)
+		{
+			m_data = static_cast<char*>(m_resource->allocate(m_capacity, 1));
+		}
+
+		format_buffer(const format_buffer& other)
+			: m_data(nullptr), m_size(other.m_size), m_capacity(other.m_capacity), m_resource(brisk::get_default_resource())
+		{
+			m_data = static_cast<char*>(m_resource->allocate(m_capacity, 1));
+			memcpy(m_data, other.m_data, m_size);
+		}
+
+		format_buffer& operator=(const format_buffer& other)
+		{
+			if (this != &other) {
+				reserve(other.m_size);
+				memcpy(m_data, other.m_data, other.m_size);
+				m_size = other.m_size;
+			}
+			return *this;
+		}
+
+		~format_buffer()
+		{
+			m_resource->deallocate(m_data, m_capacity, 1);
+		}
+
+		void clear() noexcept
+		{
+			m_size = 0;
+		}
+
+		void append(const char* s, brisk::size_t n)
+		{
+			reserve(m_size + n);
+			memcpy(m_data + m_size, s, n);
+			m_size += n;
+		}
+
+		void push_back(char c)
+		{
+			reserve(m_size + 1);
+			m_data[m_size++] = c;
+		}
+
+		// Space for at least n more characters, committed with commit().
+		char* prepare(brisk::size_t n)
+		{
+			reserve(m_size + n);
+			return m_data + m_size;
+		}
+
+		void commit(brisk::size_t n) noexcept
+		{
+			m_size += n;
+		}
+
+		// Null-terminates the contents without counting the terminator.
+		const char* c_str()
+		{
+			reserve(m_size + 1);
+			m_data[m_size] = '\0';
+			return m_data;
+		}
+
+		const char* data() const noexcept
+		{
+			return m_data;
+		}
+
+		brisk::size_t size() const noexcept
+		{
+			return m_size;
+		}
+
+		void reserve(brisk::size_t n)
+		{
+			if (n <= m_capacity) {
+				return;
+			}
+
+			brisk::size_t capacity = m_capacity << 1;
+			capacity = (capacity < n) ? n : capacity;
+			char* buffer = static_cast<char*>(m_resource->allocate(capacity, 1));
+			memcpy(buffer, m_data, m_size);
+			m_resource->deallocate(m_data, m_capacity, 1);
+			m_data = buffer;
+			m_capacity = capacity;
+		}
+
+	private:
+		char* m_data;
+		brisk::size_t m_size;
+		brisk::size_t m_capacity;
+		memory_resource* m_resource;
+	};
+
+	namespace detail
+	{
+		inline void writeLiteral(format_buffer& out, std::string_view text, bool escaped)
+		{
+			if (!escaped) {
+				out.append(text.data(), text.size());
+				return;
+			}
+
+			for (brisk::size_t i = 0; i < text.size(); ++i)
+			{
+				out.push_back(text[i]);
+				if ((text[i] == '{' || text[i] == '}') && i + 1 < text.size() && text[i + 1] == text[i]) {
+					++i;
+				}
+			}
+		}
+
+		template <class T>
+		inline void writeArgument(format_buffer& out, const T& value)
+		{
+			using U = std::decay_t<T>;
+			if constexpr (std::is_same_v<U, bool>) {
+				out.append(value ? "true" : "false", value ? 4 : 5);
+			} else if constexpr (std::is_same_v<U, char>) {
+				out.push_back(value);
+			} else if constexpr (std::is_integral_v<U> || std::is_floating_point_v<U>) {
+				char* first = out.prepare(64);
+				std::to_chars_result result = std::to_chars(first, first + 64, value);
+				out.commit(result.ptr - first);
+			} else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+				out.append(value, std::strlen(value));
+			} else if constexpr (std::is_same_v<U, brisk::string>) {
+				out.append(value.c_str(), std::strlen(value.c_str()));
+			} else if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+				std::string_view text = value;
+				out.append(text.data(), text.size());
+			} else if constexpr (std::is_pointer_v<U>) {
+				char* first = out.prepare(2 + 2 * sizeof(void*));
+				first[0] = '0';
+				first[1] = 'x';
+				std::to_chars_result result = std::to_chars(first + 2, first + 2 + 2 * sizeof(void*),
+					reinterpret_cast<std::uintptr_t>(value), 16);
+				out.commit(result.ptr - first);
+			} else {
+				// anything else goes through its stream operator
+				std::stringstream stream;
+				stream << value;
+				std::string text = stream.str();
+				out.append(text.data(), text.size());
+			}
+		}
+
+		template <class Format, class... Args, brisk::size_t... I>
+		inline void formatTo(format_buffer& out, const Format& f, std::index_sequence<I...>, const Args&... args)
+		{
+			writeLiteral(out, f.literal(0), f.escaped(0));
+			((writeArgument(out, args), writeLiteral(out, f.literal(I + 1), f.escaped(I + 1))), ...);
+		}
+	}
+
+	// Appends the formatted text to out.
+	template <class... Args>
+	inline void format_to(format_buffer& out, format_string_for<Args...> f, const Args&... args)
+	{
+		detail::formatTo(out, f, std::index_sequence_for<Args...>(), args...);
+	}
+
+	template <class... Args>
+	inline std::string format(format_string_for<Args...> f, const Args&... args)
+	{
+		format_buffer out;
+		detail::formatTo(out, f, std::index_sequence_for<Args...>(), args...);
+		return std::string(out.data(), out.size());
+	}
+}
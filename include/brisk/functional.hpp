@@ -1,7 +1,14 @@
 #pragma once
 
+#include "briskdef.hpp"
 #include "utility.hpp"
 
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
 namespace brisk
 {
 	template <class Function, class... Args>
@@ -10,16 +17,27 @@ namespace brisk
 		return forward<Function>(f)(forward<Args>(args)...);
 	}
 
-	template <class Type>
+	template <class Type = void>
 	struct less
 	{
-		constexpr bool operator()(const Type& lhs, const T& rhs) const
+		constexpr bool operator()(const Type& lhs, const Type& rhs) const
 		{
 			return lhs < rhs;
 		}
 	};
 
-	template <class Type>
+	// less<> and greater<> compare any two types that have the operator
+	template <>
+	struct less<void>
+	{
+		template <class T, class T2>
+		constexpr bool operator()(const T& lhs, const T2& rhs) const
+		{
+			return lhs < rhs;
+		}
+	};
+
+	template <class Type = void>
 	struct greater
 	{
 		constexpr bool operator()(const Type& lhs, const Type& rhs) const
@@ -28,6 +46,16 @@ namespace brisk
 		}
 	};
 
+	template <>
+	struct greater<void>
+	{
+		template <class T, class T2>
+		constexpr bool operator()(const T& lhs, const T2& rhs) const
+		{
+			return lhs > rhs;
+		}
+	};
+
 	template <class Type>
 	struct less_equal
 	{
@@ -63,4 +91,66 @@ namespace brisk
 			return lhs != rhs;
 		}
 	};
-}
\ No newline at end of file
+
+	namespace detail
+	{
+		// MurmurHash3's finalizer: every bit of x affects every bit of the
+		// result.
+		constexpr std::uint64_t mix64(std::uint64_t x) noexcept
+		{
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdull;
+			x ^= x >> 33;
+			x *= 0xc4ceb9fe1a85ec53ull;
+			x ^= x >> 33;
+			return x;
+		}
+
+		// Eight bytes at a time, each word multiplied in, then the finalizer.
+		inline std::uint64_t hashBytes(const void* data, brisk::size_t size) noexcept
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			std::uint64_t h = 0x9e3779b97f4a7c15ull ^ (size * 0xc6a4a7935bd1e995ull);
+			for (; size >= 8; bytes += 8, size -= 8) {
+				std::uint64_t word;
+				std::memcpy(&word, bytes, 8);
+				h = std::rotl(h ^ (word * 0xc6a4a7935bd1e995ull), 29) * 0x9e3779b97f4a7c15ull;
+			}
+
+			if (size != 0) {
+				std::uint64_t word = 0;
+				std::memcpy(&word, bytes, size);
+				h = std::rotl(h ^ (word * 0xc6a4a7935bd1e995ull), 29) * 0x9e3779b97f4a7c15ull;
+			}
+
+			return mix64(h);
+		}
+	}
+
+	// 64-bit hashes for the hash tables. Integers, enums and pointers are
+	// mixed so that any of their bits can index a table, floating point
+	// values hash by value (0.0 and -0.0 alike), and anything with data()
+	// and size() over bytes, like std::string, std::string_view and
+	// brisk::string, by its contents. Everything else goes through
+	// std::hash and is mixed the same way.
+	template <class Type>
+	struct hash
+	{
+		std::uint64_t operator()(const Type& value) const
+		{
+			if constexpr (std::is_integral_v<Type> || std::is_enum_v<Type>) {
+				return detail::mix64(static_cast<std::uint64_t>(value));
+			} else if constexpr (std::is_pointer_v<Type>) {
+				return detail::mix64(static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(value)));
+			} else if constexpr (std::is_same_v<Type, float>) {
+				return detail::mix64((value == 0.0f) ? 0 : std::bit_cast<std::uint32_t>(value));
+			} else if constexpr (std::is_same_v<Type, double>) {
+				return detail::mix64((value == 0.0) ? 0 : std::bit_cast<std::uint64_t>(value));
+			} else if constexpr (requires { value.data(); value.size(); requires sizeof(*value.data()) == 1; }) {
+				return detail::hashBytes(value.data(), value.size());
+			} else {
+				return detail::mix64(static_cast<std::uint64_t>(std::hash<Type>()(value)));
+			}
+		}
+	};
+}
@@ -0,0 +1,513 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+#include "functional.hpp"
+#include "algorithm.hpp"
+#include "execution.hpp"
+#include "hash_table.hpp"
+#include "hyperloglog.hpp"
+#include "vector.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <ranges>
+#include <type_traits>
+
+namespace brisk
+{
+	namespace detail
+	{
+		template <class Range, class KeyOf>
+		using group_key_t = std::remove_cvref_t<std::invoke_result_t<KeyOf&, std::ranges::range_reference_t<Range>>>;
+
+		struct hashed_index
+		{
+			std::uint64_t hash;
+			brisk::size_t index;
+		};
+
+		// Lookups issued ahead of the one being done, so that a join's
+		// probes don't wait on one cache miss at a time.
+		constexpr brisk::size_t probeBatch = 16;
+
+		struct count_rows
+		{
+			template <class Row>
+			brisk::size_t operator()(brisk::size_t count, const Row&) const noexcept
+			{
+				return count + 1;
+			}
+		};
+
+		// Rows go to partitions by the low bits of their hash, which the
+		// tables don't use for their slots, so each partition is a
+		// table's worth of work no other thread touches.
+		template <class Policy>
+		brisk::size_t hashPartitions(const Policy& policy)
+		{
+			brisk::size_t partitions = std::bit_ceil(policy.pool().size() * chunksPerThread);
+			partitions = (partitions < 64) ? 64 : partitions;
+			return (partitions > 1024) ? 1024 : partitions;
+		}
+
+		// Radix partitions rows [0, n) by hash(keyOf(first[i])): the first
+		// pass hashes every row and counts each chunk's rows per
+		// partition, the second scatters {hash, row} into rows at the
+		// offsets those counts give. Rows keep their order within a
+		// partition, and partition p is rows[offsets[p], offsets[p + 1]).
+		template <class Policy, class Iterator, class KeyOf, class Hash>
+		void partitionByHash(const Policy& policy, const chunk_plan& plan, Iterator first, brisk::size_t n, KeyOf& keyOf, Hash& hash,
+			brisk::size_t partitions, hashed_index* rows, brisk::size_t* offsets)
+		{
+			const brisk::size_t mask = partitions - 1;
+			sort_buffer<std::uint64_t> hashes(n);
+			sort_buffer<brisk::size_t> counts(plan.count * partitions);
+			std::uint64_t* h = hashes.data();
+			brisk::size_t* table = counts.data();
+			runChunks(policy, plan, n, [&](brisk::size_t chunk, brisk::size_t begin, brisk::size_t end) {
+				brisk::size_t* count = table + chunk * partitions;
+				brisk::fill(count, count + partitions, brisk::size_t(0));
+				for (brisk::size_t i = begin; i < end; ++i) {
+					h[i] = hash(keyOf(first[i]));
+					++count[h[i] & mask];
+				}
+			});
+
+			// partition by partition, each chunk's rows after the last's
+			brisk::size_t next = 0;
+			for (brisk::size_t p = 0; p < partitions; ++p) {
+				offsets[p] = next;
+				for (brisk::size_t chunk = 0; chunk < plan.count; ++chunk) {
+					brisk::size_t count = table[chunk * partitions + p];
+					table[chunk * partitions + p] = next;
+					next += count;
+				}
+			}
+			offsets[partitions] = next;
+
+			runChunks(policy, plan, n, [&](brisk::size_t chunk, brisk::size_t begin, brisk::size_t end) {
+				brisk::size_t* position = table + chunk * partitions;
+				for (brisk::size_t i = begin; i < end; ++i) {
+					rows[position[h[i] & mask]++] = hashed_index{h[i], i};
+				}
+			});
+		}
+
+		// Partitions [first, first + n) and calls body(p, rows, count) for
+		// each partition, on the policy's pool.
+		template <class Policy, class Iterator, class KeyOf, class Hash, class Body>
+		void forEachPartition(const Policy& policy, const chunk_plan& plan, Iterator first, brisk::size_t n, KeyOf& keyOf, Hash& hash, brisk::size_t partitions, Body&& body)
+		{
+			sort_buffer<hashed_index> rows(n);
+			sort_buffer<brisk::size_t> offsets(partitions + 1);
+			hashed_index* row = rows.data();
+			brisk::size_t* offset = offsets.data();
+			partitionByHash(policy, plan, first, n, keyOf, hash, partitions, row, offset);
+			runChunks(policy, chunk_plan{partitions, 1}, partitions, [&](brisk::size_t p, brisk::size_t, brisk::size_t) {
+				body(p, row + offset[p], offset[p + 1] - offset[p]);
+			});
+		}
+
+		template <class Entry>
+		vector<Entry> concatenate(vector<vector<Entry>>& parts)
+		{
+			brisk::size_t total = 0;
+			for (brisk::size_t p = 0; p < parts.size(); ++p) {
+				total += parts[p].size();
+			}
+
+			vector<Entry> result(total);
+			for (brisk::size_t p = 0; p < parts.size(); ++p) {
+				for (brisk::size_t i = 0; i < parts[p].size(); ++i) {
+					result.push_back(brisk::move(parts[p][i]));
+				}
+			}
+
+			return result;
+		}
+
+		template <class Entry>
+		vector<vector<Entry>> partitionResults(brisk::size_t partitions)
+		{
+			vector<vector<Entry>> parts(partitions);
+			for (brisk::size_t p = 0; p < partitions; ++p) {
+				parts.push_back(vector<Entry>());
+			}
+
+			return parts;
+		}
+
+		// Joins rows matching on key with a table of chains over the build
+		// side: each key's entry holds its first and last build row and
+		// next links the rest, in row order, so matches come out ordered
+		// by probe row and then build row.
+		template <class Key, class Hash>
+		class join_table
+		{
+		public:
+			static constexpr brisk::size_t none = ~brisk::size_t(0);
+
+			explicit join_table(brisk::size_t rows)
+				: m_heads(), m_next(rows)
+			{
+
+			}
+
+			// Adds the next build row; slots count up from 0.
+			void add(std::uint64_t hash, const Key& key)
+			{
+				const brisk::size_t slot = m_next.size();
+				m_next.push_back(none);
+				auto [entry, inserted] = m_heads.try_emplace_hashed(hash, key, slot, slot);
+				if (!inserted) {
+					m_next[entry->second.second] = slot;
+					entry->second.second = slot;
+				}
+			}
+
+			void prefetch(std::uint64_t hash) const noexcept
+			{
+				m_heads.prefetch(hash);
+			}
+
+			// Calls match(rowOf(slot)) for every build row with key.
+			template <class Rows, class Match>
+			void probe(std::uint64_t hash, const Key& key, Rows rowOf, Match&& match)
+			{
+				auto entry = m_heads.find_hashed(hash, key);
+				if (entry == m_heads.end()) {
+					return;
+				}
+
+				// stopping at the tail saves reading next for a key's only row
+				const brisk::size_t last = entry->second.second;
+				for (brisk::size_t slot = entry->second.first; ; slot = m_next[slot]) {
+					match(rowOf(slot));
+					if (slot == last) {
+						break;
+					}
+				}
+			}
+
+		private:
+			flat_hash_map<Key, pair<brisk::size_t, brisk::size_t>, Hash> m_heads;
+			vector<brisk::size_t> m_next;
+		};
+	}
+
+	// Hash-based relational algorithms over ranges. Each is one pass over
+	// its input with a flat_hash_map or flat_hash_set, rather than the
+	// sort that std::unique or a merge join would need first, and returns
+	// a brisk::vector. With an execution policy the rows are radix
+	// partitioned by hash first and every partition gets its own table on
+	// the pool, so nothing is shared or locked; the results are in
+	// partition order then.
+
+	// The distinct elements of range, each where it first occurs.
+	template <std::ranges::input_range Range, class Hash = brisk::hash<std::ranges::range_value_t<Range>>, class Equal = brisk::equal<std::ranges::range_value_t<Range>>>
+	vector<std::ranges::range_value_t<Range>> unique_hashed(Range&& range, Hash hash = Hash(), Equal equal = Equal())
+	{
+		flat_hash_set<std::ranges::range_value_t<Range>, Hash, Equal> seen(0, hash, equal);
+		for (auto&& value : range) {
+			seen.insert(value);
+		}
+
+		return seen.release();
+	}
+
+	// In first occurrence order, as the sequential version.
+	template <class Policy, std::ranges::random_access_range Range, class Hash = brisk::hash<std::ranges::range_value_t<Range>>, class Equal = brisk::equal<std::ranges::range_value_t<Range>>>
+		requires is_execution_policy_v<Policy>
+	vector<std::ranges::range_value_t<Range>> unique_hashed(Policy&& policy, Range&& range, Hash hash = Hash(), Equal equal = Equal())
+	{
+		using T = std::ranges::range_value_t<Range>;
+		auto first = std::ranges::begin(range);
+		const brisk::size_t n = static_cast<brisk::size_t>(std::ranges::size(range));
+		detail::chunk_plan plan = detail::planChunks(policy, n);
+		if (plan.count == 1) {
+			return brisk::unique_hashed(range, hash, equal);
+		}
+
+		// mark each partition's first occurrences, then keep them in order
+		detail::sort_buffer<unsigned char> keep(n);
+		unsigned char* kept = keep.data();
+		detail::identity self;
+		detail::forEachPartition(policy, plan, first, n, self, hash, detail::hashPartitions(policy), [&](brisk::size_t, const detail::hashed_index* rows, brisk::size_t count) {
+			flat_hash_set<T, Hash, Equal> seen(0, hash, equal);
+			for (brisk::size_t i = 0; i < count; ++i) {
+				kept[rows[i].index] = seen.insert_hashed(rows[i].hash, first[rows[i].index]).second;
+			}
+		});
+
+		brisk::size_t total = 0;
+		for (brisk::size_t i = 0; i < n; ++i) {
+			total += kept[i];
+		}
+
+		vector<T> result(total);
+		for (brisk::size_t i = 0; i < n; ++i) {
+			if (kept[i]) {
+				result.push_back(first[i]);
+			}
+		}
+
+		return result;
+	}
+
+	// Groups the rows of range by key(row) and folds each group with
+	// acc = agg(acc, row), starting from init, in row order. One
+	// pair<key, acc> per group, in order of each group's first row.
+	template <std::ranges::input_range Range, class KeyOf, class Aggregate, class T>
+	vector<pair<detail::group_key_t<Range, KeyOf>, T>> group_by(Range&& range, KeyOf key, Aggregate agg, T init)
+	{
+		flat_hash_map<detail::group_key_t<Range, KeyOf>, T> groups;
+		for (auto&& row : range) {
+			auto entry = groups.try_emplace(key(row), init).first;
+			entry->second = agg(brisk::move(entry->second), row);
+		}
+
+		return groups.release();
+	}
+
+	// Rows per key.
+	template <std::ranges::input_range Range, class KeyOf>
+	vector<pair<detail::group_key_t<Range, KeyOf>, brisk::size_t>> group_by(Range&& range, KeyOf key)
+	{
+		return brisk::group_by(range, key, detail::count_rows(), brisk::size_t(0));
+	}
+
+	// Each group is still folded in row order, so agg needn't commute.
+	template <class Policy, std::ranges::random_access_range Range, class KeyOf, class Aggregate, class T>
+		requires is_execution_policy_v<Policy>
+	vector<pair<detail::group_key_t<Range, KeyOf>, T>> group_by(Policy&& policy, Range&& range, KeyOf key, Aggregate agg, T init)
+	{
+		using Key = detail::group_key_t<Range, KeyOf>;
+		auto first = std::ranges::begin(range);
+		const brisk::size_t n = static_cast<brisk::size_t>(std::ranges::size(range));
+		detail::chunk_plan plan = detail::planChunks(policy, n);
+		if (plan.count == 1) {
+			return brisk::group_by(range, key, agg, init);
+		}
+
+		const brisk::size_t partitions = detail::hashPartitions(policy);
+		vector<vector<pair<Key, T>>> parts = detail::partitionResults<pair<Key, T>>(partitions);
+		brisk::hash<Key> hash;
+		detail::forEachPartition(policy, plan, first, n, key, hash, partitions, [&](brisk::size_t p, const detail::hashed_index* rows, brisk::size_t count) {
+			flat_hash_map<Key, T> groups;
+			for (brisk::size_t i = 0; i < count; ++i) {
+				auto&& row = first[rows[i].index];
+				auto entry = groups.try_emplace_hashed(rows[i].hash, key(row), init).first;
+				entry->second = agg(brisk::move(entry->second), row);
+			}
+			parts[p] = groups.release();
+		});
+
+		return detail::concatenate(parts);
+	}
+
+	template <class Policy, std::ranges::random_access_range Range, class KeyOf>
+		requires is_execution_policy_v<Policy>
+	vector<pair<detail::group_key_t<Range, KeyOf>, brisk::size_t>> group_by(Policy&& policy, Range&& range, KeyOf key)
+	{
+		return brisk::group_by(policy, range, key, detail::count_rows(), brisk::size_t(0));
+	}
+
+	// How many distinct elements range has, exactly.
+	template <std::ranges::input_range Range, class Hash = brisk::hash<std::ranges::range_value_t<Range>>, class Equal = brisk::equal<std::ranges::range_value_t<Range>>>
+	brisk::size_t count_distinct(Range&& range, Hash hash = Hash(), Equal equal = Equal())
+	{
+		flat_hash_set<std::ranges::range_value_t<Range>, Hash, Equal> seen(0, hash, equal);
+		for (auto&& value : range) {
+			seen.insert(value);
+		}
+
+		return seen.size();
+	}
+
+	template <class Policy, std::ranges::random_access_range Range, class Hash = brisk::hash<std::ranges::range_value_t<Range>>, class Equal = brisk::equal<std::ranges::range_value_t<Range>>>
+		requires is_execution_policy_v<Policy>
+	brisk::size_t count_distinct(Policy&& policy, Range&& range, Hash hash = Hash(), Equal equal = Equal())
+	{
+		auto first = std::ranges::begin(range);
+		const brisk::size_t n = static_cast<brisk::size_t>(std::ranges::size(range));
+		detail::chunk_plan plan = detail::planChunks(policy, n);
+		if (plan.count == 1) {
+			return brisk::count_distinct(range, hash, equal);
+		}
+
+		const brisk::size_t partitions = detail::hashPartitions(policy);
+		detail::sort_buffer<brisk::size_t> counts(partitions);
+		brisk::size_t* count = counts.data();
+		detail::identity self;
+		detail::forEachPartition(policy, plan, first, n, self, hash, partitions, [&](brisk::size_t p, const detail::hashed_index* rows, brisk::size_t size) {
+			flat_hash_set<std::ranges::range_value_t<Range>, Hash, Equal> seen(0, hash, equal);
+			for (brisk::size_t i = 0; i < size; ++i) {
+				seen.insert_hashed(rows[i].hash, first[rows[i].index]);
+			}
+			count[p] = seen.size();
+		});
+
+		brisk::size_t total = 0;
+		for (brisk::size_t p = 0; p < partitions; ++p) {
+			total += count[p];
+		}
+
+		return total;
+	}
+
+	// An estimate of count_distinct from a hyperloglog sketch, in
+	// 2^precision bytes whatever the input: within about 1.04 /
+	// sqrt(2^precision) of the true count, 0.8% by default.
+	template <std::ranges::input_range Range, class Hash = brisk::hash<std::ranges::range_value_t<Range>>>
+	brisk::size_t approx_count_distinct(Range&& range, unsigned precision = 14, Hash hash = Hash())
+	{
+		hyperloglog sketch(precision);
+		for (auto&& value : range) {
+			sketch.add_hash(hash(value));
+		}
+
+		return static_cast<brisk::size_t>(std::llround(sketch.estimate()));
+	}
+
+	// A sketch per chunk, merged.
+	template <class Policy, std::ranges::random_access_range Range, class Hash = brisk::hash<std::ranges::range_value_t<Range>>>
+		requires is_execution_policy_v<Policy>
+	brisk::size_t approx_count_distinct(Policy&& policy, Range&& range, unsigned precision = 14, Hash hash = Hash())
+	{
+		auto first = std::ranges::begin(range);
+		const brisk::size_t n = static_cast<brisk::size_t>(std::ranges::size(range));
+		detail::chunk_plan plan = detail::planChunks(policy, n);
+		if (plan.count == 1) {
+			return brisk::approx_count_distinct(range, precision, hash);
+		}
+
+		vector<hyperloglog> sketches(plan.count);
+		for (brisk::size_t chunk = 0; chunk < plan.count; ++chunk) {
+			sketches.push_back(hyperloglog(precision));
+		}
+		detail::runChunks(policy, plan, n, [&](brisk::size_t chunk, brisk::size_t begin, brisk::size_t end) {
+			for (brisk::size_t i = begin; i < end; ++i) {
+				sketches[chunk].add_hash(hash(first[i]));
+			}
+		});
+
+		for (brisk::size_t chunk = 1; chunk < plan.count; ++chunk) {
+			sketches[0].merge(sketches[chunk]);
+		}
+
+		return static_cast<brisk::size_t>(std::llround(sketches[0].estimate()));
+	}
+
+	// An equi-join: every (i, j) with lkey(lhs[i]) == rkey(rhs[j]), as
+	// positions in the two ranges, ordered by i and then j. The table is
+	// built over rhs, so pass the smaller side there.
+	template <std::ranges::input_range Left, std::ranges::input_range Right, class LeftKey, class RightKey>
+	vector<pair<brisk::size_t, brisk::size_t>> hash_join(Left&& lhs, Right&& rhs, LeftKey lkey, RightKey rkey)
+	{
+		using Key = detail::group_key_t<Right, RightKey>;
+		brisk::hash<Key> hash;
+		detail::join_table<Key, brisk::hash<Key>> table(0);
+		for (auto&& row : rhs) {
+			const Key& key = rkey(row);
+			table.add(hash(key), key);
+		}
+
+		// probe a batch at a time, with every slot in the batch prefetched
+		// first so that their cache misses overlap
+		vector<pair<brisk::size_t, brisk::size_t>> matches;
+		Key keys[detail::probeBatch];
+		std::uint64_t hashes[detail::probeBatch];
+		brisk::size_t filled = 0;
+		brisk::size_t i = 0;
+		auto probe = [&]() {
+			for (brisk::size_t b = 0; b < filled; ++b) {
+				table.probe(hashes[b], keys[b], detail::identity(), [&matches, row = i - filled + b](brisk::size_t match) {
+					matches.push_back(pair<brisk::size_t, brisk::size_t>(row, match));
+				});
+			}
+			filled = 0;
+		};
+		for (auto&& row : lhs) {
+			keys[filled] = lkey(row);
+			hashes[filled] = hash(keys[filled]);
+			table.prefetch(hashes[filled]);
+			++i;
+			if (++filled == detail::probeBatch) {
+				probe();
+			}
+		}
+		probe();
+
+		return matches;
+	}
+
+	template <std::ranges::input_range Left, std::ranges::input_range Right, class KeyOf>
+	vector<pair<brisk::size_t, brisk::size_t>> hash_join(Left&& lhs, Right&& rhs, KeyOf key)
+	{
+		return brisk::hash_join(lhs, rhs, key, key);
+	}
+
+	// Both sides are partitioned alike and each partition joined on its
+	// own; ordered by i and then j within a partition.
+	template <class Policy, std::ranges::random_access_range Left, std::ranges::random_access_range Right, class LeftKey, class RightKey>
+		requires is_execution_policy_v<Policy>
+	vector<pair<brisk::size_t, brisk::size_t>> hash_join(Policy&& policy, Left&& lhs, Right&& rhs, LeftKey lkey, RightKey rkey)
+	{
+		using Key = detail::group_key_t<Right, RightKey>;
+		using Match = pair<brisk::size_t, brisk::size_t>;
+		auto left = std::ranges::begin(lhs);
+		auto right = std::ranges::begin(rhs);
+		const brisk::size_t n = static_cast<brisk::size_t>(std::ranges::size(lhs));
+		const brisk::size_t m = static_cast<brisk::size_t>(std::ranges::size(rhs));
+		detail::chunk_plan plan = detail::planChunks(policy, n + m);
+		if (plan.count == 1) {
+			return brisk::hash_join(lhs, rhs, lkey, rkey);
+		}
+
+		const brisk::size_t partitions = detail::hashPartitions(policy);
+		brisk::hash<Key> hash;
+		detail::sort_buffer<detail::hashed_index> leftRows(n);
+		detail::sort_buffer<detail::hashed_index> rightRows(m);
+		detail::sort_buffer<brisk::size_t> leftOffsets(partitions + 1);
+		detail::sort_buffer<brisk::size_t> rightOffsets(partitions + 1);
+		detail::hashed_index* lrow = leftRows.data();
+		detail::hashed_index* rrow = rightRows.data();
+		brisk::size_t* loffset = leftOffsets.data();
+		brisk::size_t* roffset = rightOffsets.data();
+		detail::partitionByHash(policy, detail::planChunks(policy, n), left, n, lkey, hash, partitions, lrow, loffset);
+		detail::partitionByHash(policy, detail::planChunks(policy, m), right, m, rkey, hash, partitions, rrow, roffset);
+
+		vector<vector<Match>> parts = detail::partitionResults<Match>(partitions);
+		detail::runChunks(policy, detail::chunk_plan{partitions, 1}, partitions, [&](brisk::size_t p, brisk::size_t, brisk::size_t) {
+			const detail::hashed_index* build = rrow + roffset[p];
+			const brisk::size_t builds = roffset[p + 1] - roffset[p];
+			detail::join_table<Key, brisk::hash<Key>> table(builds);
+			for (brisk::size_t j = 0; j < builds; ++j) {
+				table.add(build[j].hash, rkey(right[build[j].index]));
+			}
+
+			vector<Match>& matches = parts[p];
+			for (brisk::size_t i = loffset[p]; i < loffset[p + 1]; ++i) {
+				if (i + detail::probeBatch < loffset[p + 1]) {
+					table.prefetch(lrow[i + detail::probeBatch].hash);
+				}
+				const brisk::size_t row = lrow[i].index;
+				table.probe(lrow[i].hash, lkey(left[row]), [build](brisk::size_t slot) { return build[slot].index; }, [&matches, row](brisk::size_t match) {
+					matches.push_back(Match(row, match));
+				});
+			}
+		});
+
+		return detail::concatenate(parts);
+	}
+
+	template <class Policy, std::ranges::random_access_range Left, std::ranges::random_access_range Right, class KeyOf>
+		requires is_execution_policy_v<Policy>
+	vector<pair<brisk::size_t, brisk::size_t>> hash_join(Policy&& policy, Left&& lhs, Right&& rhs, KeyOf key)
+	{
+		return brisk::hash_join(policy, lhs, rhs, key, key);
+	}
+}
@@ -0,0 +1,561 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+#include "functional.hpp"
+#include "vector.hpp"
+#include "memory_resource.hpp"
+#ifdef BRISK_HEAP_PROFILE
+#include "heap_profiler.hpp"
+#endif
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace brisk
+{
+	namespace detail
+	{
+		// Slots a lookup looks at in one go.
+		constexpr brisk::size_t slotGroup = 4;
+
+		// Bit i of match is set where the hash bits kept in group[i] equal
+		// high, and of empty where group[i] is empty.
+		inline void matchSlots(const std::uint64_t* group, std::uint32_t high, unsigned& match, unsigned& empty) noexcept
+		{
+#if defined(__SSE2__)
+			// the high halves of the four slots in one register, the low
+			// halves in another
+			__m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+			__m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group + 2)));
+			__m128i highs = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			__m128i lows = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			match = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(highs, _mm_set1_epi32(static_cast<int>(high))))));
+			empty = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lows, _mm_setzero_si128()))));
+#else
+			match = 0;
+			empty = 0;
+			for (unsigned i = 0; i < slotGroup; ++i) {
+				match |= unsigned((group[i] >> 32) == high) << i;
+				empty |= unsigned(group[i] == 0) << i;
+			}
+#endif
+		}
+
+		struct set_key
+		{
+			template <class Entry>
+			const Entry& operator()(const Entry& entry) const noexcept
+			{
+				return entry;
+			}
+		};
+
+		struct map_key
+		{
+			template <class Entry>
+			const auto& operator()(const Entry& entry) const noexcept
+			{
+				return entry.first;
+			}
+		};
+
+		// Open addressing with linear probing. The entries sit densely in a
+		// vector, in the order they went in, and the table itself is an
+		// array of 8-byte slots: the entry's index plus one in the low half
+		// (0 is empty) and the top 32 bits of its hash in the high half.
+		// Since the home slot is taken from those bits, growing never
+		// hashes a key again. A lookup compares four slots' hash bits at
+		// once and only goes to an entry when they match, so a missing key
+		// is usually one load and no walk along the cluster, and a present
+		// one two. At most three quarters of the slots are used.
+		template <class Key, class Entry, class KeyOf, class Hash, class Equal>
+		class hash_table
+		{
+		public:
+			using key_type = Key;
+			using value_type = Entry;
+			using size_type = brisk::size_t;
+			using hasher = Hash;
+			using key_equal = Equal;
+			using iterator = Entry*;
+			using const_iterator = const Entry*;
+
+			hash_table(size_type capacity, Hash hash, Equal equal, memory_resource* resource)
+				: m_entries(resource), m_slots(nullptr), m_capacity(0), m_shift(64), m_hash(hash), m_equal(equal), m_resource(resource)
+			{
+				if (capacity != 0) {
+					reserve(capacity);
+				}
+			}
+
+			// A copy allocates from the same resource as other, so copying
+			// a table out of an arena keeps it in the arena; the second
+			// form puts the copy somewhere else.
+			hash_table(const hash_table& other)
+				: hash_table(other, other.m_resource)
+			{
+
+			}
+
+			hash_table(const hash_table& other, memory_resource* resource)
+				: m_entries(other.m_entries, resource), m_slots(nullptr), m_capacity(0), m_shift(64), m_hash(other.m_hash), m_equal(other.m_equal), m_resource(resource)
+			{
+				if (other.m_capacity != 0) {
+					allocateSlots(other.m_capacity);
+					std::memcpy(m_slots, other.m_slots, blockBytes(m_capacity));
+				}
+			}
+
+			hash_table(hash_table&& other) noexcept
+				: m_entries(brisk::move(other.m_entries)), m_slots(other.m_slots), m_capacity(other.m_capacity), m_shift(other.m_shift), m_hash(other.m_hash), m_equal(other.m_equal), m_resource(other.m_resource)
+			{
+				other.m_slots = nullptr;
+				other.m_capacity = 0;
+				other.m_shift = 64;
+			}
+
+			hash_table& operator=(const hash_table& other)
+			{
+				if (this != &other) {
+					hash_table copy(other);
+					*this = brisk::move(copy);
+				}
+
+				return *this;
+			}
+
+			// Takes other's entries and slots along with the resource they
+			// came from, so nothing is allocated.
+			hash_table& operator=(hash_table&& other) noexcept
+			{
+				if (this != &other) {
+					releaseSlots();
+					vector<Entry> entries(brisk::move(other.m_entries));
+					m_entries.swap(entries);
+					m_slots = other.m_slots;
+					m_capacity = other.m_capacity;
+					m_shift = other.m_shift;
+					m_hash = other.m_hash;
+					m_equal = other.m_equal;
+					m_resource = other.m_resource;
+					other.m_slots = nullptr;
+					other.m_capacity = 0;
+					other.m_shift = 64;
+				}
+
+				return *this;
+			}
+
+			~hash_table()
+			{
+				releaseSlots();
+			}
+
+			size_type size() const noexcept
+			{
+				return m_entries.size();
+			}
+
+			bool empty() const noexcept
+			{
+				return m_entries.empty();
+			}
+
+			// Entries in the order they were added, except that erasing
+			// moves the last one into the gap. Keys mustn't be changed
+			// through them.
+			iterator begin() noexcept
+			{
+				return m_entries.data();
+			}
+
+			iterator end() noexcept
+			{
+				return m_entries.data() + m_entries.size();
+			}
+
+			const_iterator begin() const noexcept
+			{
+				return m_entries.data();
+			}
+
+			const_iterator end() const noexcept
+			{
+				return m_entries.data() + m_entries.size();
+			}
+
+			// Room for count entries without growing.
+			void reserve(size_type count)
+			{
+				if (count > maxEntries) {
+					throw std::length_error("[brisk::hash_table][Exception]: too many entries");
+				}
+
+				m_entries.reserve(count);
+				size_type capacity = slotsFor(count);
+				if (capacity > m_capacity) {
+					rehash(capacity);
+				}
+			}
+
+			void clear() noexcept
+			{
+				m_entries.clear();
+				if (m_slots != nullptr) {
+					std::memset(m_slots, 0, blockBytes(m_capacity));
+				}
+			}
+
+			template <class K>
+			iterator find(const K& key)
+			{
+				return find_hashed(m_hash(key), key);
+			}
+
+			template <class K>
+			const_iterator find(const K& key) const
+			{
+				return const_cast<hash_table*>(this)->find_hashed(m_hash(key), key);
+			}
+
+			// For callers that already have the key's hash from hasher,
+			// like the partitioned algorithms.
+			template <class K>
+			iterator find_hashed(std::uint64_t hash, const K& key)
+			{
+				size_type slot = findSlot(hash, key);
+				return (slot != npos) ? m_entries.data() + ((m_slots[slot] & indexMask) - 1) : end();
+			}
+
+			// Starts loading the slot a lookup of hash begins at, so that a
+			// caller with a batch of keys can overlap their cache misses.
+			void prefetch(std::uint64_t hash) const noexcept
+			{
+				if (m_capacity != 0) {
+					BRISK_PREFETCH(m_slots + home(hash));
+				}
+			}
+
+			template <class K>
+			bool contains(const K& key) const
+			{
+				return find(key) != end();
+			}
+
+			// Removes key's entry, moving the last entry into its place, and
+			// says whether there was one.
+			template <class K>
+			bool erase(const K& key)
+			{
+				size_type slot = findSlot(m_hash(key), key);
+				if (slot == npos) {
+					return false;
+				}
+
+				size_type index = static_cast<size_type>((m_slots[slot] & indexMask) - 1);
+				removeSlot(slot);
+				size_type last = m_entries.size() - 1;
+				if (index != last) {
+					// point the last entry's slot at its new place
+					std::uint64_t hash = m_hash(KeyOf()(m_entries[last]));
+					for (size_type i = home(hash); ; i = (i + 1) & (m_capacity - 1)) {
+						if ((m_slots[i] & indexMask) == last + 1) {
+							setSlot(i, (m_slots[i] & ~indexMask) | (index + 1));
+							break;
+						}
+					}
+
+					m_entries[index] = brisk::move(m_entries[last]);
+				}
+
+				m_entries.pop_back();
+				return true;
+			}
+
+			// Hands over the entries and leaves the table empty.
+			vector<Entry> release()
+			{
+				vector<Entry> entries(brisk::move(m_entries));
+				m_entries = vector<Entry>(m_resource);
+				clear();
+				return entries;
+			}
+
+			const vector<Entry>& entries() const noexcept
+			{
+				return m_entries;
+			}
+
+			hasher hash_function() const
+			{
+				return m_hash;
+			}
+
+			memory_resource* resource() const noexcept
+			{
+				return m_resource;
+			}
+
+		protected:
+			// Finds key, or adds make()'s entry for it.
+			template <class K, class Make>
+			std::pair<iterator, bool> insertHashed(std::uint64_t hash, const K& key, Make&& make)
+			{
+				size_type slot = findSlot(hash, key);
+				if (slot != npos) {
+					return std::pair<iterator, bool>(m_entries.data() + ((m_slots[slot] & indexMask) - 1), false);
+				}
+
+				if ((m_entries.size() + 1) * 4 > m_capacity * 3) {
+					if (m_entries.size() >= maxEntries) {
+						throw std::length_error("[brisk::hash_table][Exception]: too many entries");
+					}
+					rehash((m_capacity == 0) ? slotsFor(1) : m_capacity * 2);
+				}
+
+				m_entries.emplace_back(make());
+				setSlot(firstEmpty(home(hash)), ((hash >> 32) << 32) | m_entries.size());
+				return std::pair<iterator, bool>(m_entries.data() + (m_entries.size() - 1), true);
+			}
+
+			template <class K>
+			std::uint64_t hashOf(const K& key) const
+			{
+				return m_hash(key);
+			}
+
+		private:
+			static constexpr std::uint64_t indexMask = 0xffffffffull;
+			static constexpr size_type npos = ~size_type(0);
+			// the home slot comes from the 32 hash bits kept in a slot
+			static constexpr size_type maxEntries = size_type(3) << 30;
+
+			static size_type slotsFor(size_type count) noexcept
+			{
+				size_type capacity = 16;
+				while (count * 4 > capacity * 3) {
+					capacity *= 2;
+				}
+
+				return capacity;
+			}
+
+			static size_type blockBytes(size_type capacity) noexcept
+			{
+				return (capacity + slotGroup - 1) * sizeof(std::uint64_t);
+			}
+
+			size_type home(std::uint64_t hash) const noexcept
+			{
+				return static_cast<size_type>(hash >> m_shift);
+			}
+
+			// The first few slots are repeated past the end, so a group can
+			// be loaded from any slot.
+			void setSlot(size_type i, std::uint64_t slot) noexcept
+			{
+				m_slots[i] = slot;
+				if (i < slotGroup - 1) {
+					m_slots[m_capacity + i] = slot;
+				}
+			}
+
+			size_type firstEmpty(size_type i) const noexcept
+			{
+				while (m_slots[i] != 0) {
+					i = (i + 1) & (m_capacity - 1);
+				}
+
+				return i;
+			}
+
+			template <class K>
+			size_type findSlot(std::uint64_t hash, const K& key) const
+			{
+				if (m_capacity == 0) {
+					return npos;
+				}
+
+				const std::uint32_t high = static_cast<std::uint32_t>(hash >> 32);
+				const size_type mask = m_capacity - 1;
+				for (size_type i = home(hash); ; i = (i + slotGroup) & mask) {
+					unsigned match;
+					unsigned empty;
+					matchSlots(m_slots + i, high, match, empty);
+					// the cluster ends at the first empty slot
+					if (empty != 0) {
+						match &= (empty & (0u - empty)) - 1;
+					}
+
+					for (; match != 0; match &= match - 1) {
+						size_type at = (i + static_cast<size_type>(std::countr_zero(match))) & mask;
+						if (m_equal(KeyOf()(m_entries[static_cast<size_type>((m_slots[at] & indexMask) - 1)]), key)) {
+							return at;
+						}
+					}
+
+					if (empty != 0) {
+						return npos;
+					}
+				}
+			}
+
+			// Backward shift deletion: later slots of the same cluster move
+			// up into the hole unless that would put them before their home.
+			void removeSlot(size_type hole) noexcept
+			{
+				const size_type mask = m_capacity - 1;
+				for (size_type i = (hole + 1) & mask; m_slots[i] != 0; i = (i + 1) & mask) {
+					size_type want = static_cast<size_type>((m_slots[i] >> 32) >> (32 - (64 - m_shift)));
+					if (((i - want) & mask) >= ((i - hole) & mask)) {
+						setSlot(hole, m_slots[i]);
+						hole = i;
+					}
+				}
+
+				setSlot(hole, 0);
+			}
+
+			void allocateSlots(size_type capacity)
+			{
+				BRISK_HEAP_SAMPLE(blockBytes(capacity));
+				m_slots = static_cast<std::uint64_t*>(m_resource->allocate(blockBytes(capacity), alignof(std::uint64_t)));
+				std::memset(m_slots, 0, blockBytes(capacity));
+				m_capacity = capacity;
+				m_shift = 64 - static_cast<unsigned>(std::countr_zero(capacity));
+			}
+
+			void releaseSlots() noexcept
+			{
+				if (m_slots != nullptr) {
+					m_resource->deallocate(m_slots, blockBytes(m_capacity), alignof(std::uint64_t));
+					m_slots = nullptr;
+				}
+			}
+
+			void rehash(size_type capacity)
+			{
+				std::uint64_t* old = m_slots;
+				size_type oldCapacity = m_capacity;
+				allocateSlots(capacity);
+				const unsigned homeShift = 32 - (64 - m_shift);
+				for (size_type j = 0; j < oldCapacity; ++j) {
+					if (old[j] != 0) {
+						setSlot(firstEmpty(static_cast<size_type>((old[j] >> 32) >> homeShift)), old[j]);
+					}
+				}
+
+				if (old != nullptr) {
+					m_resource->deallocate(old, blockBytes(oldCapacity), alignof(std::uint64_t));
+				}
+			}
+
+			vector<Entry> m_entries;
+			std::uint64_t* m_slots;
+			size_type m_capacity;
+			unsigned m_shift;
+			Hash m_hash;
+			Equal m_equal;
+			memory_resource* m_resource;
+		};
+	}
+
+	// A hash map that keeps its entries in a vector, in insertion order,
+	// so walking it is a walk over an array and release() hands them over
+	// as a vector<pair<Key, Value>>. Key and Value have to be default
+	// constructible, as for vector.
+	template <class Key, class Value, class Hash = brisk::hash<Key>, class Equal = brisk::equal<Key>>
+	class flat_hash_map : public detail::hash_table<Key, pair<Key, Value>, detail::map_key, Hash, Equal>
+	{
+		using base = detail::hash_table<Key, pair<Key, Value>, detail::map_key, Hash, Equal>;
+
+	public:
+		using mapped_type = Value;
+		using typename base::iterator;
+		using typename base::size_type;
+		using typename base::value_type;
+
+		explicit flat_hash_map(size_type capacity = 0, Hash hash = Hash(), Equal equal = Equal(), memory_resource* resource = brisk::get_default_resource())
+			: base(capacity, hash, equal, resource)
+		{
+
+		}
+
+		explicit flat_hash_map(memory_resource* resource)
+			: base(0, Hash(), Equal(), resource)
+		{
+
+		}
+
+		flat_hash_map(const flat_hash_map& other, memory_resource* resource)
+			: base(other, resource)
+		{
+
+		}
+
+		// Adds key with a Value made from args unless it's there already.
+		template <class... Args>
+		std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+		{
+			return try_emplace_hashed(this->hashOf(key), key, brisk::forward<Args>(args)...);
+		}
+
+		template <class... Args>
+		std::pair<iterator, bool> try_emplace_hashed(std::uint64_t hash, const Key& key, Args&&... args)
+		{
+			return this->insertHashed(hash, key, [&]() { return value_type(key, Value(brisk::forward<Args>(args)...)); });
+		}
+
+		Value& operator[](const Key& key)
+		{
+			return try_emplace(key).first->second;
+		}
+	};
+
+	// The set version of flat_hash_map: release() gives a vector<Key> of
+	// the distinct keys in the order they were first inserted.
+	template <class Key, class Hash = brisk::hash<Key>, class Equal = brisk::equal<Key>>
+	class flat_hash_set : public detail::hash_table<Key, Key, detail::set_key, Hash, Equal>
+	{
+		using base = detail::hash_table<Key, Key, detail::set_key, Hash, Equal>;
+
+	public:
+		using typename base::iterator;
+		using typename base::size_type;
+
+		explicit flat_hash_set(size_type capacity = 0, Hash hash = Hash(), Equal equal = Equal(), memory_resource* resource = brisk::get_default_resource())
+			: base(capacity, hash, equal, resource)
+		{
+
+		}
+
+		explicit flat_hash_set(memory_resource* resource)
+			: base(0, Hash(), Equal(), resource)
+		{
+
+		}
+
+		flat_hash_set(const flat_hash_set& other, memory_resource* resource)
+			: base(other, resource)
+		{
+
+		}
+
+		std::pair<iterator, bool> insert(const Key& key)
+		{
+			return insert_hashed(this->hashOf(key), key);
+		}
+
+		std::pair<iterator, bool> insert_hashed(std::uint64_t hash, const Key& key)
+		{
+			return this->insertHashed(hash, key, [&key]() { return key; });
+		}
+	};
+}
@@ -0,0 +1,371 @@
+#pragma once
+
+#include "briskdef.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BRISK_HAS_HEAP_PROFILER
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+
+namespace brisk
+{
+	// Sampling heap profiler for brisk's own allocations. With
+	// BRISK_HEAP_PROFILE defined, vector, string, make_unique,
+	// make_shared and friends report every allocation here; each thread
+	// picks one allocation out of roughly every sampleBytes bytes
+	// (exponentially spaced, like tcmalloc), walks its stack with
+	// backtrace() and adds it to a lock-free table keyed by the stack.
+	//
+	// Without BRISK_HEAP_PROFILE the hooks compile to nothing. With it but
+	// with the profiler stopped, each allocation costs a thread-local
+	// subtraction. Only allocations are profiled, not what is still live.
+	struct heap_profile_stats
+	{
+		std::uint64_t samples = 0;
+		std::uint64_t sampledBytes = 0;
+		std::uint64_t stacks = 0;
+		std::uint64_t dropped = 0;
+		brisk::size_t sampleBytes = 0;
+	};
+
+	namespace detail
+	{
+		constexpr int heapMaxDepth = 32;
+		constexpr brisk::size_t heapTableSize = 4096;
+		// how often a thread looks again while the profiler is off
+		constexpr std::int64_t heapRecheckBytes = std::int64_t(1) << 20;
+
+		struct heap_stack
+		{
+			std::atomic<std::uint64_t> hash;
+			std::atomic<bool> ready;
+			int depth;
+			void* frames[heapMaxDepth];
+			std::atomic<std::uint64_t> samples;
+			std::atomic<std::uint64_t> bytes;
+		};
+
+		struct heap_profiler_state
+		{
+			std::atomic<bool> enabled{false};
+			std::atomic<brisk::size_t> sampleBytes{2 * 1024 * 1024};
+			std::atomic<heap_stack*> table{nullptr};
+			std::atomic<std::uint64_t> dropped{0};
+		};
+
+		inline heap_profiler_state& heapState() noexcept
+		{
+			static heap_profiler_state state;
+			return state;
+		}
+
+		// armed is set once untilSample has been drawn with the profiler on;
+		// until then running out of it only means it's time to look again.
+		struct heap_thread
+		{
+			std::int64_t untilSample;
+			std::uint64_t random;
+			bool armed;
+		};
+
+		// Constant-initialized, so reaching it costs no guard.
+		inline thread_local heap_thread heapThread = {0, 0, false};
+
+		inline std::int64_t heapNextSample(heap_thread& thread, brisk::size_t sampleBytes) noexcept
+		{
+			if (thread.random == 0) {
+				thread.random = reinterpret_cast<std::uintptr_t>(&thread) * 0x9e3779b97f4a7c15ull | 1;
+			}
+
+			// xorshift64*, then an exponential draw with mean sampleBytes
+			thread.random ^= thread.random >> 12;
+			thread.random ^= thread.random << 25;
+			thread.random ^= thread.random >> 27;
+			double u = static_cast<double>((thread.random * 0x2545f4914f6cdd1dull) >> 11) * (1.0 / 9007199254740992.0);
+			return static_cast<std::int64_t>(-std::log(1.0 - u) * static_cast<double>(sampleBytes)) + 1;
+		}
+
+		inline std::uint64_t heapHash(void* const* frames, int depth) noexcept
+		{
+			std::uint64_t h = 0xcbf29ce484222325ull;
+			for (int i = 0; i < depth; ++i) {
+				h = (h ^ reinterpret_cast<std::uintptr_t>(frames[i])) * 0x100000001b3ull;
+			}
+			return h | 1;
+		}
+
+		inline void heapInsert(heap_stack* table, void* const* frames, int depth, brisk::size_t bytes) noexcept
+		{
+			std::uint64_t h = heapHash(frames, depth);
+			for (brisk::size_t probe = 0; probe < heapTableSize; ++probe) {
+				heap_stack& entry = table[(h + probe) & (heapTableSize - 1)];
+				std::uint64_t current = entry.hash.load(std::memory_order_acquire);
+				if (current == 0) {
+					if (entry.hash.compare_exchange_strong(current, h, std::memory_order_acq_rel)) {
+						entry.depth = depth;
+						std::memcpy(entry.frames, frames, sizeof(void*) * depth);
+						entry.ready.store(true, std::memory_order_release);
+						current = h;
+					}
+				}
+
+				if (current == h) {
+					entry.samples.fetch_add(1, std::memory_order_relaxed);
+					entry.bytes.fetch_add(bytes, std::memory_order_relaxed);
+					return;
+				}
+			}
+
+			heapState().dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// Out of line so the stack it records starts one frame up, at the
+		// allocation site.
+		[[gnu::noinline]] inline void heapRecord(brisk::size_t bytes) noexcept
+		{
+			heap_thread& thread = heapThread;
+			heap_profiler_state& state = heapState();
+			if (!state.enabled.load(std::memory_order_relaxed)) {
+				thread.untilSample = heapRecheckBytes;
+				thread.armed = false;
+				return;
+			}
+
+			bool armed = thread.armed;
+			thread.untilSample = heapNextSample(thread, state.sampleBytes.load(std::memory_order_relaxed));
+			thread.armed = true;
+			heap_stack* table = state.table.load(std::memory_order_acquire);
+			if (!armed || table == nullptr) {
+				return;
+			}
+
+			void* frames[heapMaxDepth + 1];
+			int depth = ::backtrace(frames, heapMaxDepth + 1);
+			if (depth > 1) {
+				heapInsert(table, frames + 1, depth - 1, bytes);
+			}
+		}
+
+		inline void heapSample(brisk::size_t bytes) noexcept
+		{
+			heap_thread& thread = heapThread;
+			thread.untilSample -= static_cast<std::int64_t>(bytes);
+			if (thread.untilSample < 0) [[unlikely]] {
+				heapRecord(bytes);
+			}
+		}
+
+		// pprof's correction for sampling: a stack seen `samples` times for
+		// `bytes` bytes stands for about this many bytes.
+		inline double heapScale(std::uint64_t samples, std::uint64_t bytes, brisk::size_t sampleBytes) noexcept
+		{
+			if (samples == 0 || bytes == 0) {
+				return 0;
+			}
+			double average = static_cast<double>(bytes) / static_cast<double>(samples);
+			return 1.0 / (1.0 - std::exp(-average / static_cast<double>(sampleBytes)));
+		}
+
+		// The demangled name if the dynamic symbol table has one, else
+		// module+offset, which addr2line can still resolve.
+		inline std::string heapSymbol(void* address)
+		{
+			Dl_info info;
+			if (::dladdr(address, &info) == 0) {
+				char text[32];
+				std::snprintf(text, sizeof(text), "%p", address);
+				return text;
+			}
+
+			if (info.dli_sname != nullptr) {
+				int status = 0;
+				char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+				std::string name = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+				std::free(demangled);
+				return name;
+			}
+
+			const char* module = (info.dli_fname != nullptr) ? info.dli_fname : "";
+			const char* slash = std::strrchr(module, '/');
+			char text[32];
+			std::snprintf(text, sizeof(text), "+0x%zx", static_cast<std::size_t>(
+				reinterpret_cast<std::uintptr_t>(address) - reinterpret_cast<std::uintptr_t>(info.dli_fbase)));
+			return std::string((slash != nullptr) ? slash + 1 : module) + text;
+		}
+	}
+
+	// Starts sampling about one allocation per sampleBytes allocated; 2MB
+	// is tcmalloc's default. Each thread picks up a change within a
+	// megabyte of its next allocations.
+	inline bool heap_profiler_start(brisk::size_t sampleBytes = 2 * 1024 * 1024)
+	{
+		detail::heap_profiler_state& state = detail::heapState();
+		if (state.table.load(std::memory_order_acquire) == nullptr) {
+			detail::heap_stack* table = new (std::nothrow) detail::heap_stack[detail::heapTableSize]();
+			if (table == nullptr) {
+				return false;
+			}
+
+			detail::heap_stack* expected = nullptr;
+			if (!state.table.compare_exchange_strong(expected, table, std::memory_order_acq_rel)) {
+				delete[] table;
+			}
+		}
+
+		// the first backtrace() loads the unwinder, which allocates
+		void* frames[1];
+		::backtrace(frames, 1);
+
+		state.sampleBytes.store(sampleBytes > 0 ? sampleBytes : 1, std::memory_order_relaxed);
+		state.enabled.store(true, std::memory_order_relaxed);
+		detail::heapThread.untilSample = detail::heapNextSample(detail::heapThread, state.sampleBytes.load(std::memory_order_relaxed));
+		detail::heapThread.armed = true;
+		return true;
+	}
+
+	inline void heap_profiler_stop() noexcept
+	{
+		detail::heapState().enabled.store(false, std::memory_order_relaxed);
+	}
+
+	// Zeroes the counts but keeps the stacks seen so far.
+	inline void heap_profiler_reset() noexcept
+	{
+		detail::heap_profiler_state& state = detail::heapState();
+		detail::heap_stack* table = state.table.load(std::memory_order_acquire);
+		if (table != nullptr) {
+			for (brisk::size_t i = 0; i < detail::heapTableSize; ++i) {
+				table[i].samples.store(0, std::memory_order_relaxed);
+				table[i].bytes.store(0, std::memory_order_relaxed);
+			}
+		}
+		state.dropped.store(0, std::memory_order_relaxed);
+	}
+
+	inline heap_profile_stats heap_profiler_stats() noexcept
+	{
+		heap_profile_stats stats;
+		detail::heap_profiler_state& state = detail::heapState();
+		stats.dropped = state.dropped.load(std::memory_order_relaxed);
+		stats.sampleBytes = state.sampleBytes.load(std::memory_order_relaxed);
+
+		detail::heap_stack* table = state.table.load(std::memory_order_acquire);
+		if (table != nullptr) {
+			for (brisk::size_t i = 0; i < detail::heapTableSize; ++i) {
+				std::uint64_t samples = table[i].samples.load(std::memory_order_relaxed);
+				if (table[i].ready.load(std::memory_order_acquire) && samples != 0) {
+					++stats.stacks;
+					stats.samples += samples;
+					stats.sampledBytes += table[i].bytes.load(std::memory_order_relaxed);
+				}
+			}
+		}
+		return stats;
+	}
+
+	// Folded stacks, outermost frame first, one line per call site with its
+	// estimated bytes, ready for flamegraph.pl. Symbols in the executable
+	// only get names when it's linked with -rdynamic.
+	template <class Log>
+	void heap_profiler_write_folded(Log& log)
+	{
+		detail::heap_profiler_state& state = detail::heapState();
+		detail::heap_stack* table = state.table.load(std::memory_order_acquire);
+		if (table == nullptr) {
+			return;
+		}
+
+		brisk::size_t sampleBytes = state.sampleBytes.load(std::memory_order_relaxed);
+		for (brisk::size_t i = 0; i < detail::heapTableSize; ++i) {
+			detail::heap_stack& entry = table[i];
+			std::uint64_t samples = entry.samples.load(std::memory_order_relaxed);
+			if (!entry.ready.load(std::memory_order_acquire) || samples == 0) {
+				continue;
+			}
+
+			std::uint64_t bytes = entry.bytes.load(std::memory_order_relaxed);
+			std::string line;
+			for (int frame = entry.depth - 1; frame >= 0; --frame) {
+				line += detail::heapSymbol(entry.frames[frame]);
+				line += (frame > 0) ? ';' : ' ';
+			}
+			line += std::to_string(static_cast<std::uint64_t>(bytes * detail::heapScale(samples, bytes, sampleBytes)));
+			line += '\n';
+			log << line.c_str();
+		}
+	}
+
+	// The legacy text heap profile pprof reads ("heap_v2"), with raw sample
+	// counts that pprof scales itself. Only allocation counts are filled in;
+	// view it with -sample_index=alloc_space.
+	template <class Log>
+	void heap_profiler_write_pprof(Log& log)
+	{
+		detail::heap_profiler_state& state = detail::heapState();
+		detail::heap_stack* table = state.table.load(std::memory_order_acquire);
+		heap_profile_stats stats = heap_profiler_stats();
+
+		char text[128];
+		std::snprintf(text, sizeof(text), "heap profile: 0: 0 [%llu: %llu] @ heap_v2/%zu\n",
+			static_cast<unsigned long long>(stats.samples), static_cast<unsigned long long>(stats.sampledBytes),
+			static_cast<std::size_t>(stats.sampleBytes));
+		log << text;
+
+		for (brisk::size_t i = 0; table != nullptr && i < detail::heapTableSize; ++i) {
+			detail::heap_stack& entry = table[i];
+			std::uint64_t samples = entry.samples.load(std::memory_order_relaxed);
+			if (!entry.ready.load(std::memory_order_acquire) || samples == 0) {
+				continue;
+			}
+
+			std::snprintf(text, sizeof(text), "0: 0 [%llu: %llu] @",
+				static_cast<unsigned long long>(samples),
+				static_cast<unsigned long long>(entry.bytes.load(std::memory_order_relaxed)));
+			std::string line = text;
+			for (int frame = 0; frame < entry.depth; ++frame) {
+				std::snprintf(text, sizeof(text), " %p", entry.frames[frame]);
+				line += text;
+			}
+			line += '\n';
+			log << line.c_str();
+		}
+
+		// pprof symbolizes against the mappings
+		std::ifstream maps("/proc/self/maps");
+		if (maps.is_open()) {
+			log << "\nMAPPED_LIBRARIES:\n";
+			std::string mapping;
+			while (std::getline(maps, mapping)) {
+				mapping += '\n';
+				log << mapping.c_str();
+			}
+		}
+	}
+}
+
+#else
+
+namespace brisk
+{
+	namespace detail
+	{
+		inline void heapSample(brisk::size_t) noexcept
+		{
+
+		}
+	}
+}
+
+#endif
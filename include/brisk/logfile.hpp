@@ -0,0 +1,572 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "compress.hpp"
+#include "logmetrics.hpp"
+#include "memory.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BRISK_HAS_LOGFILE 1
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace brisk
+{
+	struct rotation_policy
+	{
+		brisk::size_t segmentSize = brisk::size_t(64) << 20;   // bytes per segment
+		brisk::size_t retention = 8;                           // closed segments kept on disk
+		std::chrono::seconds maxAge = std::chrono::seconds(0); // 0 = rotate on size only
+		bool compress = false;                                 // archive closed segments as "<base>.<seq>.lz"
+	};
+
+	// A single preallocated log file that is written through a shared mapping.
+	// While it is being written the file is named "<base>.<seq>.open", once it
+	// has been closed it is truncated to the bytes actually used and renamed
+	// to "<base>.<seq>".
+	class log_segment
+	{
+	public:
+		log_segment(const std::string& base, brisk::size_t seq)
+			: m_base(base), m_seq(seq), m_fd(-1), m_data(nullptr), m_capacity(0), m_used(0), next(nullptr)
+		{
+
+		}
+
+		log_segment(const log_segment&) = delete;
+		log_segment& operator=(const log_segment&) = delete;
+
+		~log_segment()
+		{
+			unmap();
+		}
+
+		bool open(brisk::size_t capacity)
+		{
+			std::string path = openPath();
+			m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+			if (m_fd < 0) {
+				return false;
+			}
+
+#if defined(__linux__)
+			if (::fallocate(m_fd, 0, 0, static_cast<off_t>(capacity)) != 0 && ::ftruncate(m_fd, static_cast<off_t>(capacity)) != 0)
+#else
+			if (::ftruncate(m_fd, static_cast<off_t>(capacity)) != 0)
+#endif
+			{
+				unmap();
+				::unlink(path.c_str());
+				return false;
+			}
+
+			int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+			// segments are opened ahead of time on the rotation thread, so fault the
+			// pages in there instead of on the first write into each page
+			flags |= MAP_POPULATE;
+#endif
+			void* mapping = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, flags, m_fd, 0);
+			if (mapping == MAP_FAILED) {
+				unmap();
+				::unlink(path.c_str());
+				return false;
+			}
+
+			m_data = static_cast<char*>(mapping);
+			m_capacity = capacity;
+			m_used = 0;
+			m_opened = std::chrono::steady_clock::now();
+			return true;
+		}
+
+		// Unmaps the segment, trims the preallocated tail and renames it to its
+		// final name. Empty segments are removed instead.
+		bool close()
+		{
+			brisk::size_t used = m_used;
+			bool ok = (m_fd >= 0);
+			if (m_data != nullptr) {
+				ok = (::munmap(m_data, m_capacity) == 0) && ok;
+				m_data = nullptr;
+			}
+
+			if (m_fd >= 0) {
+				ok = (::ftruncate(m_fd, static_cast<off_t>(used)) == 0) && ok;
+				ok = (::close(m_fd) == 0) && ok;
+				m_fd = -1;
+			}
+
+			std::string from = openPath();
+			if (used == 0) {
+				::unlink(from.c_str());
+				return ok;
+			}
+
+			return (::rename(from.c_str(), path().c_str()) == 0) && ok;
+		}
+
+		void discard()
+		{
+			unmap();
+			::unlink(openPath().c_str());
+		}
+
+		bool flush()
+		{
+			if (m_data == nullptr) {
+				return false;
+			}
+
+			return ::msync(m_data, m_capacity, MS_ASYNC) == 0;
+		}
+
+		char* tail() noexcept
+		{
+			return m_data + m_used;
+		}
+
+		void commit(brisk::size_t n) noexcept
+		{
+			m_used += n;
+		}
+
+		brisk::size_t remaining() const noexcept
+		{
+			return m_capacity - m_used;
+		}
+
+		brisk::size_t used() const noexcept
+		{
+			return m_used;
+		}
+
+		brisk::size_t capacity() const noexcept
+		{
+			return m_capacity;
+		}
+
+		brisk::size_t sequence() const noexcept
+		{
+			return m_seq;
+		}
+
+		std::chrono::steady_clock::time_point opened() const noexcept
+		{
+			return m_opened;
+		}
+
+		std::string path() const
+		{
+			char suffix[32];
+			std::snprintf(suffix, sizeof(suffix), ".%06zu", m_seq);
+			return m_base + suffix;
+		}
+
+		std::string openPath() const
+		{
+			return path() + ".open";
+		}
+
+	private:
+		void unmap()
+		{
+			if (m_data != nullptr) {
+				::munmap(m_data, m_capacity);
+				m_data = nullptr;
+			}
+
+			if (m_fd >= 0) {
+				::close(m_fd);
+				m_fd = -1;
+			}
+		}
+
+		std::string m_base;
+		brisk::size_t m_seq;
+		int m_fd;
+		char* m_data;
+		brisk::size_t m_capacity;
+		brisk::size_t m_used;
+		std::chrono::steady_clock::time_point m_opened;
+
+	public:
+		log_segment* next;      // link in the retire queue
+	};
+
+	// Writes log bytes into a chain of fixed-size mmap-backed segments.
+	//
+	// A write is a memcpy into the active segment. When it fills up, the active
+	// segment is swapped for a spare that the background thread has already
+	// created, preallocated and mapped, so the calling thread never waits on
+	// open(), fallocate() or munmap(). Closing, renaming and deleting segments
+	// past the retention count all happen on the background thread too.
+	// Segments a crashed run left open are trimmed and renamed on startup.
+	class rotating_logfile
+	{
+	public:
+		rotating_logfile(const char* basename, const rotation_policy& policy = rotation_policy(),
+			brisk::shared_ptr<log_counters> counters = brisk::make_shared<log_counters>())
+			: m_base(basename), m_policy(policy), m_counters(counters), m_nextSeq(0), m_active(nullptr), m_spare(nullptr),
+			  m_retireHead(nullptr), m_retireTail(nullptr), m_stop(false)
+		{
+			if (m_policy.segmentSize == 0) {
+				m_policy.segmentSize = rotation_policy().segmentSize;
+			}
+
+			m_nextSeq = resumeSequence();
+			m_active = createSegment();
+			m_worker = std::thread(&rotating_logfile::worker, this);
+		}
+
+		rotating_logfile(const rotating_logfile&) = delete;
+		rotating_logfile& operator=(const rotating_logfile&) = delete;
+
+		~rotating_logfile()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_active != nullptr) {
+					retire(m_active);
+					m_active = nullptr;
+				}
+				m_stop = true;
+			}
+
+			m_cv.notify_one();
+			m_worker.join();
+
+			if (m_spare != nullptr) {
+				m_spare->discard();
+				delete m_spare;
+			}
+		}
+
+		// Messages are kept whole inside one segment unless they are larger
+		// than a segment, in which case they are split across several.
+		bool write(const char* data, brisk::size_t n)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_counters->message(n);
+			if (m_active != nullptr && n > m_active->remaining() && n <= m_policy.segmentSize) {
+				if (!rotate()) {
+					m_counters->drop();
+					return false;
+				}
+			}
+
+			while (n > 0)
+			{
+				if (m_active == nullptr || m_active->remaining() == 0) {
+					if (!rotate()) {
+						m_counters->drop();
+						return false;
+					}
+				}
+
+				brisk::size_t chunk = (n < m_active->remaining()) ? n : m_active->remaining();
+				memcpy(m_active->tail(), data, chunk);
+				m_active->commit(chunk);
+				data += chunk;
+				n -= chunk;
+			}
+
+			m_counters->occupy(m_active->used());
+			return true;
+		}
+
+		// Schedules write-back of the active segment; does not block on I/O.
+		bool flush()
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			std::lock_guard<std::mutex> lock(m_mutex);
+			bool ok = (m_active != nullptr) && m_active->flush();
+			if (!ok) {
+				m_counters->error();
+			}
+
+			m_counters->flushed(std::chrono::steady_clock::now() - start);
+			return ok;
+		}
+
+		const brisk::shared_ptr<log_counters>& counters() const noexcept
+		{
+			return m_counters;
+		}
+
+		bool is_open()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_active != nullptr;
+		}
+
+		const std::string& basename() const noexcept
+		{
+			return m_base;
+		}
+
+		const rotation_policy& policy() const noexcept
+		{
+			return m_policy;
+		}
+
+	private:
+		// Continues numbering after any segments left by a previous run so they
+		// are neither overwritten nor kept past the retention count. Segments
+		// a crash left open are closed here, as the run would have done.
+		brisk::size_t resumeSequence() const
+		{
+			std::string dir = ".";
+			std::string prefix = m_base;
+			std::string::size_type slash = m_base.rfind('/');
+			if (slash != std::string::npos) {
+				dir = m_base.substr(0, slash + 1);
+				prefix = m_base.substr(slash + 1);
+			}
+			prefix += '.';
+
+			DIR* d = ::opendir(dir.c_str());
+			if (d == nullptr) {
+				return 0;
+			}
+
+			brisk::size_t next = 0;
+			std::vector<std::string> leftovers;
+			while (dirent* entry = ::readdir(d))
+			{
+				const char* name = entry->d_name;
+				if (std::strncmp(name, prefix.c_str(), prefix.size()) != 0) {
+					continue;
+				}
+
+				char* end = nullptr;
+				unsigned long long seq = std::strtoull(name + prefix.size(), &end, 10);
+				bool leftOpen = (std::strcmp(end, ".open") == 0);
+				bool known = (*end == '\0' || leftOpen || std::strcmp(end, ".lz") == 0);
+				if (end != name + prefix.size() && known) {
+					if (seq + 1 > next) {
+						next = static_cast<brisk::size_t>(seq + 1);
+					}
+
+					if (leftOpen) {
+						leftovers.push_back((slash != std::string::npos) ? dir + name : std::string(name));
+					}
+				}
+			}
+
+			::closedir(d);
+
+			for (const std::string& path : leftovers) {
+				recoverSegment(path);
+			}
+
+			return next;
+		}
+
+		// A segment still named .open was being written when its process died,
+		// so nothing trimmed its preallocated tail, which is all zero bytes.
+		// Log text doesn't end in zero bytes, so the data ends at the last
+		// nonzero one: truncate there and rename it the way close() would, or
+		// remove it if nothing was written.
+		static void recoverSegment(const std::string& openPath)
+		{
+			int fd = ::open(openPath.c_str(), O_RDWR);
+			if (fd < 0) {
+				return;
+			}
+
+			struct stat info;
+			if (::fstat(fd, &info) != 0) {
+				::close(fd);
+				return;
+			}
+
+			brisk::size_t used = static_cast<brisk::size_t>(info.st_size);
+			if (used != 0) {
+				void* mapping = ::mmap(nullptr, used, PROT_READ, MAP_SHARED, fd, 0);
+				if (mapping == MAP_FAILED) {
+					::close(fd);
+					return;
+				}
+
+				const char* data = static_cast<const char*>(mapping);
+				while (used > 0 && data[used - 1] == '\0') {
+					--used;
+				}
+				::munmap(mapping, static_cast<brisk::size_t>(info.st_size));
+			}
+
+			bool ok = (::ftruncate(fd, static_cast<off_t>(used)) == 0);
+			ok = (::close(fd) == 0) && ok;
+			if (used == 0) {
+				::unlink(openPath.c_str());
+			} else if (ok) {
+				::rename(openPath.c_str(), openPath.substr(0, openPath.size() - 5).c_str());
+			}
+		}
+
+		log_segment* createSegment()
+		{
+			brisk::size_t seq;
+			{
+				std::lock_guard<std::mutex> lock(m_seqMutex);
+				seq = m_nextSeq++;
+			}
+
+			log_segment* segment = new log_segment(m_base, seq);
+			if (!segment->open(m_policy.segmentSize)) {
+				delete segment;
+				return nullptr;
+			}
+
+			return segment;
+		}
+
+		// Called with m_mutex held.
+		bool rotate()
+		{
+			log_segment* next = m_spare;
+			m_spare = nullptr;
+			if (next == nullptr) {
+				// the background thread fell behind, open one inline
+				next = createSegment();
+				if (next == nullptr) {
+					return false;
+				}
+			}
+
+			if (m_active != nullptr) {
+				retire(m_active);
+			}
+
+			m_active = next;
+			m_cv.notify_one();
+			return true;
+		}
+
+		// Called with m_mutex held.
+		void retire(log_segment* segment)
+		{
+			segment->next = nullptr;
+			if (m_retireTail != nullptr) {
+				m_retireTail->next = segment;
+			} else {
+				m_retireHead = segment;
+			}
+			m_retireTail = segment;
+		}
+
+		void worker()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for (;;)
+			{
+				if (m_policy.maxAge.count() > 0 && m_active != nullptr && m_active->used() > 0 &&
+					std::chrono::steady_clock::now() - m_active->opened() >= m_policy.maxAge) {
+					rotate();
+				}
+
+				log_segment* retired = m_retireHead;
+				m_retireHead = m_retireTail = nullptr;
+				bool needSpare = (m_spare == nullptr && !m_stop);
+
+				if (retired != nullptr || needSpare)
+				{
+					lock.unlock();
+					closeAll(retired);
+					log_segment* spare = needSpare ? createSegment() : nullptr;
+					lock.lock();
+
+					if (spare != nullptr) {
+						if (m_spare == nullptr && !m_stop) {
+							m_spare = spare;
+						} else {
+							spare->discard();
+							delete spare;
+						}
+					}
+					continue;
+				}
+
+				if (m_stop) {
+					break;
+				}
+
+				if (m_policy.maxAge.count() > 0) {
+					m_cv.wait_for(lock, std::chrono::seconds(1));
+				} else {
+					m_cv.wait(lock);
+				}
+			}
+		}
+
+		void closeAll(log_segment* segment)
+		{
+			while (segment != nullptr)
+			{
+				log_segment* next = segment->next;
+				brisk::size_t seq = segment->sequence();
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				bool closed = segment->close();
+				if (!closed) {
+					m_counters->error();
+				}
+
+				if (closed && segment->used() > 0 && m_policy.compress) {
+					std::string path = segment->path();
+					std::string archive = path + ".lz";
+					if (compress_file(path.c_str(), archive.c_str())) {
+						::unlink(path.c_str());
+					} else {
+						::unlink(archive.c_str());
+						m_counters->error();
+					}
+				}
+
+				m_counters->flushed(std::chrono::steady_clock::now() - start);
+				delete segment;
+
+				if (seq >= m_policy.retention) {
+					std::string expired = log_segment(m_base, seq - m_policy.retention).path();
+					::unlink(expired.c_str());
+					::unlink((expired + ".lz").c_str());
+				}
+
+				segment = next;
+			}
+		}
+
+		std::string m_base;
+		rotation_policy m_policy;
+		brisk::shared_ptr<log_counters> m_counters;
+
+		std::mutex m_seqMutex;
+		brisk::size_t m_nextSeq;
+
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		log_segment* m_active;
+		log_segment* m_spare;
+		log_segment* m_retireHead;
+		log_segment* m_retireTail;
+		bool m_stop;
+		std::thread m_worker;
+	};
+}
+
+#endif
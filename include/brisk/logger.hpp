@@ -3,10 +3,19 @@
 #include "vector.hpp"
 #include "string.hpp"
 #include "utility.hpp"
-
+#include "memory.hpp"
+#include "logfile.hpp"
+#include "compress.hpp"
+#include "eventlog.hpp"
+#include "logmetrics.hpp"
+#include "loghistory.hpp"
+#include "format.hpp"
+
+#include <chrono>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <memory>
 
 namespace brisk
 {
@@ -18,25 +27,42 @@ namespace brisk
 			m_logFile = logfile;
 			m_amILogging = true;
 			m_amIPrinting = true;
+			m_amICompressing = false;
+			m_stats.counters = brisk::make_shared<log_counters>();
 		}
 
 		logger(const logger& other)
 		{
-			logHistory = other.logHistory;
+			m_history = other.m_history;
 			m_logFile = other.m_logFile;
 			m_amILogging = other.m_amILogging;
 			m_amIPrinting = other.m_amIPrinting;
+			m_amICompressing = other.m_amICompressing;
+			m_events = other.m_events;
+			m_stats = other.m_stats;
+#ifdef BRISK_HAS_LOGFILE
+			m_segments = other.m_segments;
+#endif
+			ownCounters();
 		}
 
 		logger(logger&& other) noexcept
 		{
-			logHistory = brisk::move(other.logHistory);
+			m_history = brisk::move(other.m_history);
 			m_logFile = brisk::move(other.m_logFile);
 			m_amILogging = brisk::move(other.m_amILogging);
 			m_amIPrinting = brisk::move(other.m_amIPrinting);
+			m_amICompressing = brisk::move(other.m_amICompressing);
+			m_events = brisk::move(other.m_events);
+			m_stats = brisk::move(other.m_stats);
+#ifdef BRISK_HAS_LOGFILE
+			m_segments = brisk::move(other.m_segments);
+#endif
 
 			other.m_amILogging = true;
 			other.m_amIPrinting = true;
+			other.m_stats = metrics_state();
+			other.m_stats.counters = brisk::make_shared<log_counters>();
 		}
 
 		~logger()
@@ -46,10 +72,17 @@ namespace brisk
 
 		logger& operator=(const logger& other)
 		{
-			logHistory = other.logHistory;
+			m_history = other.m_history;
 			m_logFile = other.m_logFile;
 			m_amILogging = other.m_amILogging;
 			m_amIPrinting = other.m_amIPrinting;
+			m_amICompressing = other.m_amICompressing;
+			m_events = other.m_events;
+			m_stats = other.m_stats;
+#ifdef BRISK_HAS_LOGFILE
+			m_segments = other.m_segments;
+#endif
+			ownCounters();
 
 			return *this;
 		}
@@ -58,13 +91,21 @@ namespace brisk
 		{
 			if (this != &other)
 			{
-				logHistory = brisk::move(other.logHistory);
+				m_history = brisk::move(other.m_history);
 				m_logFile = brisk::move(other.m_logFile);
 				m_amILogging = brisk::move(other.m_amILogging);
 				m_amIPrinting = brisk::move(other.m_amIPrinting);
+				m_amICompressing = brisk::move(other.m_amICompressing);
+				m_events = brisk::move(other.m_events);
+				m_stats = brisk::move(other.m_stats);
+#ifdef BRISK_HAS_LOGFILE
+				m_segments = brisk::move(other.m_segments);
+#endif
 
 				other.m_amILogging = true;
 				other.m_amIPrinting = true;
+				other.m_stats = metrics_state();
+				other.m_stats.counters = brisk::make_shared<log_counters>();
 			}
 
 			return *this;
@@ -81,6 +122,53 @@ namespace brisk
 		}
 
 
+#ifdef BRISK_HAS_LOGFILE
+		// Switches the logger from in-memory history to rotating mmap-backed
+		// segments named "<filename>.NNNNNN". Messages are then written to disk
+		// as they are logged and buffer() stays empty.
+		bool rotate(const rotation_policy& policy = rotation_policy())
+		{
+			m_segments = brisk::make_shared<rotating_logfile>(m_logFile.c_str(), policy, m_stats.counters);
+			return m_segments->is_open();
+		}
+
+		bool rotating() const noexcept
+		{
+			return m_segments != nullptr;
+		}
+#endif
+
+		// Structured events go to a separate binary log, "<filename>.events"
+		// unless events() names another file. See eventlog.hpp for the format.
+		bool events(const char* path)
+		{
+			m_events = brisk::make_shared<event_writer>();
+			return m_events->open(path);
+		}
+
+		template <class... Args>
+		bool event(const char* name, const Args&... fields)
+		{
+			if (!m_amILogging) {
+				return false;
+			}
+
+			if (m_events == nullptr) {
+				std::string path = m_logFile.c_str();
+				path += ".events";
+				if (!events(path.c_str())) {
+					return false;
+				}
+			}
+
+			if (!m_events->event(name, fields...)) {
+				m_stats.counters->drop();
+				return false;
+			}
+
+			return true;
+		}
+
 		template <class T>
 		void print(T value)
 		{
@@ -89,7 +177,22 @@ namespace brisk
 			if (m_amIPrinting) {
 				std::cout << value;
 			}
-			logHistory.push_back(casted_value.str().c_str());
+			std::string text = casted_value.str();
+			record(text.c_str(), text.size());
+		}
+
+		// log.fmt("user {} took {}us", id, t) renders the whole line into one
+		// reusable buffer and logs it as a single message. The format string is
+		// checked against the arguments at compile time (see format.hpp).
+		template <class... Args>
+		void fmt(format_string_for<Args...> format, const Args&... args)
+		{
+			m_line.clear();
+			format_to(m_line, format, args...);
+			if (m_amIPrinting) {
+				std::cout.write(m_line.data(), m_line.size());
+			}
+			record(m_line.c_str(), m_line.size());
 		}
 
 		void print(logger&(*func)(logger&))
@@ -103,57 +206,74 @@ namespace brisk
 			std::cin >> var;
 			std::stringstream varToString;
 			varToString << var << "\n";
-			logHistory.push_back(varToString.str().c_str());
+			std::string text = varToString.str();
+			record(text.c_str(), text.size());
 		}
 
-		const brisk::vector<brisk::string>& buffer() const noexcept
+		// The logged messages, as views into the history's chunks.
+		const log_history& buffer() const noexcept
 		{
-			return logHistory;
+			return m_history;
 		}
 
-		size_t size() noexcept
+		size_t size() const noexcept
 		{
-			size_t sz = 0;
-			for (brisk::string& it : logHistory) {
-				sz += it.size();
-			}
-
-			return sz;
+			return m_history.bytes();
 		}
 
 		void shrink_to_fit()
 		{
-			brisk::string s;
-			for (brisk::string& it : logHistory) {
-				s.append(it);
-			}
-			
-			logHistory.clear();
-			logHistory.emplace_back(s);
-			logHistory.shrink_to_fit();
+			m_history.shrink_to_fit();
 		}
 
 		bool dumpLog(const brisk::string file)
 		{
-			if (logHistory.size() != 0 && m_amILogging == true)
+			if (m_history.empty() || m_amILogging == false) {
+				return false;
+			}
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			bool ok = false;
+			if (m_amICompressing == true)
 			{
-				std::ofstream log_file(file.c_str());
-				if (log_file.is_open())
+				// compressed in 64KB blocks as the history is streamed out
+				compressed_writer log_file;
+				if (log_file.open(file.c_str()))
 				{
-					for (brisk::string& x : logHistory) {
-						log_file << x;
+					ok = true;
+					for (brisk::size_t i = 0; i < m_history.chunks(); i++) {
+						std::string_view bytes = m_history.chunk_data(i);
+						ok = log_file.write(bytes.data(), bytes.size()) && ok;
 					}
 
-					log_file.close();
-					return true;
+					ok = log_file.close() && ok;
 				}
 			}
-			
-			return false;
+
+			else
+			{
+				ok = m_history.write(file.c_str());
+			}
+
+			if (!ok) {
+				m_stats.counters->error();
+			}
+
+			m_stats.counters->flushed(std::chrono::steady_clock::now() - start);
+			return ok;
 		}
 
 		bool dumpLog()
 		{
+			if (m_events != nullptr) {
+				m_events->flush();
+			}
+
+#ifdef BRISK_HAS_LOGFILE
+			if (m_segments != nullptr) {
+				return m_amILogging && m_segments->flush();
+			}
+#endif
 			return dumpLog(m_logFile);
 		}
 
@@ -167,6 +287,44 @@ namespace brisk
 			m_amILogging = true;
 		}
 
+		// Makes dumpLog write the framed block-compressed format from
+		// compress.hpp instead of plain text.
+		void enableCompression() noexcept
+		{
+			m_amICompressing = true;
+		}
+
+		void disableCompression() noexcept
+		{
+			m_amICompressing = false;
+		}
+
+		// Snapshot of this logger's counters. Rates cover the time since the
+		// previous call.
+		log_metrics metrics()
+		{
+			log_metrics m = log_metrics::read(*m_stats.counters);
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(now - m_stats.lastSnapshot).count();
+			if (seconds > 0) {
+				m.messagesPerSec = (m.messages - m_stats.lastMessages) / seconds;
+				m.bytesPerSec = (m.bytes - m_stats.lastBytes) / seconds;
+			}
+
+			m_stats.lastSnapshot = now;
+			m_stats.lastMessages = m.messages;
+			m_stats.lastBytes = m.bytes;
+			return m;
+		}
+
+		// Writes a metrics() line into the log itself every interval, checked
+		// as messages are logged. A zero interval turns reporting off.
+		void reportMetrics(std::chrono::seconds interval) noexcept
+		{
+			m_stats.reportInterval = interval;
+			m_stats.lastReport = std::chrono::steady_clock::now();
+		}
+
 		void disablePrinting() noexcept
 		{
 			m_amIPrinting = false;
@@ -178,10 +336,87 @@ namespace brisk
 		}
 
 	private:
-		brisk::vector<brisk::string> logHistory;
+		struct metrics_state
+		{
+			brisk::shared_ptr<log_counters> counters;
+			std::uint64_t historyBytes = 0;
+			std::uint64_t lastMessages = 0;
+			std::uint64_t lastBytes = 0;
+			std::chrono::steady_clock::time_point lastSnapshot = std::chrono::steady_clock::now();
+			std::chrono::steady_clock::time_point lastReport = std::chrono::steady_clock::now();
+			std::chrono::seconds reportInterval = std::chrono::seconds(0);
+		};
+
+		// A copy counts its own traffic from here on, with the history it
+		// started with as occupancy. Copies writing to the same rotating
+		// segments keep sharing the segments' counters, since that's where
+		// their messages are counted.
+		void ownCounters()
+		{
+#ifdef BRISK_HAS_LOGFILE
+			if (m_segments != nullptr) {
+				return;
+			}
+#endif
+			m_stats.counters = brisk::make_shared<log_counters>();
+			m_stats.counters->occupy(m_stats.historyBytes);
+			m_stats.lastMessages = 0;
+			m_stats.lastBytes = 0;
+			m_stats.lastSnapshot = std::chrono::steady_clock::now();
+		}
+
+		// message must be null-terminated
+		void record(const char* message, brisk::size_t n)
+		{
+			append(message, n);
+
+			// only at the end of a line, so a report never splits a << chain
+			if (m_stats.reportInterval.count() > 0 && n != 0 && message[n - 1] == '\n') {
+				report();
+			}
+		}
+
+		void append(const char* message, brisk::size_t n)
+		{
+#ifdef BRISK_HAS_LOGFILE
+			if (m_segments != nullptr) {
+				if (m_amILogging) {
+					m_segments->write(message, n);
+				}
+				return;
+			}
+#endif
+			m_history.append(message, n);
+			m_stats.historyBytes += n;
+			m_stats.counters->message(n);
+			m_stats.counters->occupy(m_stats.historyBytes);
+		}
+
+		void report()
+		{
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if (now - m_stats.lastReport < m_stats.reportInterval) {
+				return;
+			}
+
+			m_stats.lastReport = now;
+			std::stringstream line;
+			line << "[brisk::logger][Metrics]: " << metrics() << "\n";
+			std::string text = line.str();
+			append(text.c_str(), text.size());
+		}
+
+		log_history m_history;
 		brisk::string m_logFile;
 		bool m_amILogging;
 		bool m_amIPrinting;
+		bool m_amICompressing;
+		brisk::shared_ptr<event_writer> m_events;
+		metrics_state m_stats;
+		format_buffer m_line;
+#ifdef BRISK_HAS_LOGFILE
+		brisk::shared_ptr<rotating_logfile> m_segments;
+#endif
 	};
 
 	template <class T>
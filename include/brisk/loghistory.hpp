@@ -0,0 +1,427 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+#include "memory_resource.hpp"
+#ifdef BRISK_HEAP_PROFILE
+#include "heap_profiler.hpp"
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BRISK_HAS_WRITEV 1
+
+#include <cerrno>
+#include <climits>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace brisk
+{
+	// The messages a logger keeps in memory. Their bytes are packed one after
+	// another into large chunks, so logging a message is a memcpy and the
+	// history can be written out a chunk at a time; a small index of
+	// (chunk, offset, length) entries gives the messages back as views.
+	// A message never straddles two chunks, one bigger than the chunk size
+	// gets a chunk to itself. Views stay valid until clear().
+	class log_history
+	{
+	private:
+		struct chunk
+		{
+			char* data;
+			brisk::size_t capacity;
+			brisk::size_t used;
+		};
+
+		struct entry
+		{
+			std::uint32_t chunk;
+			std::uint32_t offset;
+			brisk::size_t length;
+		};
+
+	public:
+		using size_type = brisk::size_t;
+		using value_type = std::string_view;
+
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = brisk::ptrdiff_t;
+			using pointer = void;
+			using reference = std::string_view;
+
+			const_iterator() noexcept
+				: m_history(nullptr), m_index(0)
+			{
+
+			}
+
+			std::string_view operator*() const noexcept
+			{
+				return (*m_history)[m_index];
+			}
+
+			std::string_view operator[](difference_type n) const noexcept
+			{
+				return (*m_history)[m_index + n];
+			}
+
+			const_iterator& operator++() noexcept { ++m_index; return *this; }
+			const_iterator operator++(int) noexcept { const_iterator it = *this; ++m_index; return it; }
+			const_iterator& operator--() noexcept { --m_index; return *this; }
+			const_iterator operator--(int) noexcept { const_iterator it = *this; --m_index; return it; }
+			const_iterator& operator+=(difference_type n) noexcept { m_index += n; return *this; }
+			const_iterator& operator-=(difference_type n) noexcept { m_index -= n; return *this; }
+			const_iterator operator+(difference_type n) const noexcept { return const_iterator(m_history, m_index + n); }
+			const_iterator operator-(difference_type n) const noexcept { return const_iterator(m_history, m_index - n); }
+			friend const_iterator operator+(difference_type n, const const_iterator& it) noexcept { return it + n; }
+
+			difference_type operator-(const const_iterator& rhs) const noexcept
+			{
+				return static_cast<difference_type>(m_index) - static_cast<difference_type>(rhs.m_index);
+			}
+
+			bool operator==(const const_iterator& rhs) const noexcept { return m_index == rhs.m_index; }
+			bool operator!=(const const_iterator& rhs) const noexcept { return m_index != rhs.m_index; }
+			bool operator<(const const_iterator& rhs) const noexcept { return m_index < rhs.m_index; }
+			bool operator>(const const_iterator& rhs) const noexcept { return m_index > rhs.m_index; }
+			bool operator<=(const const_iterator& rhs) const noexcept { return m_index <= rhs.m_index; }
+			bool operator>=(const const_iterator& rhs) const noexcept { return m_index >= rhs.m_index; }
+
+		private:
+			friend class log_history;
+
+			const_iterator(const log_history* history, brisk::size_t index) noexcept
+				: m_history(history), m_index(index)
+			{
+
+			}
+
+			const log_history* m_history;
+			brisk::size_t m_index;
+		};
+
+		using iterator = const_iterator;
+
+		// Offsets within a chunk are 32 bits, so chunks stay under 4GB.
+		static constexpr brisk::size_t defaultChunkSize = brisk::size_t(64) << 10;
+		static constexpr brisk::size_t maxChunkSize = brisk::size_t(1) << 31;
+
+		explicit log_history(brisk::size_t chunkSize = defaultChunkSize, memory_resource* resource = brisk::get_default_resource())
+			: m_chunks(resource), m_index(resource), m_resource(resource), m_chunkSize(clampChunkSize(chunkSize)), m_bytes(0)
+		{
+
+		}
+
+		// A copy keeps other's resource unless it's given one.
+		log_history(const log_history& other)
+			: log_history(other, other.m_resource)
+		{
+
+		}
+
+		log_history(const log_history& other, memory_resource* resource)
+			: m_chunks(resource), m_index(other.m_index, resource), m_resource(resource), m_chunkSize(other.m_chunkSize), m_bytes(0)
+		{
+			try {
+				copyChunks(other);
+			} catch (...) {
+				release(0);
+				throw;
+			}
+		}
+
+		log_history(log_history&& other) noexcept
+			: m_chunks(brisk::move(other.m_chunks)), m_index(brisk::move(other.m_index)), m_resource(other.m_resource),
+			  m_chunkSize(other.m_chunkSize), m_bytes(other.m_bytes)
+		{
+			other.m_bytes = 0;
+		}
+
+		~log_history()
+		{
+			release(0);
+		}
+
+		// Assignment keeps this history's resource. The copy is built on
+		// the side, so if it throws nothing here has changed.
+		log_history& operator=(const log_history& other)
+		{
+			if (this != &other) {
+				log_history copy(other, m_resource);
+				swap(copy);
+			}
+
+			return *this;
+		}
+
+		// Takes other's chunks, and the resource they came from, without
+		// copying them; other is left empty.
+		log_history& operator=(log_history&& other) noexcept
+		{
+			if (this != &other) {
+				log_history moved(brisk::move(other));
+				swap(moved);
+			}
+
+			return *this;
+		}
+
+		void swap(log_history& other) noexcept
+		{
+			m_chunks.swap(other.m_chunks);
+			m_index.swap(other.m_index);
+			brisk::swap(m_resource, other.m_resource);
+			brisk::swap(m_chunkSize, other.m_chunkSize);
+			brisk::swap(m_bytes, other.m_bytes);
+		}
+
+		void append(const char* message, brisk::size_t n)
+		{
+			if (m_chunks.empty() || m_chunks.back().capacity - m_chunks.back().used < n) {
+				grow(n);
+			}
+
+			chunk& c = m_chunks.back();
+			if (n != 0) {
+				std::memcpy(c.data + c.used, message, n);
+			}
+
+			m_index.push_back(entry{static_cast<std::uint32_t>(m_chunks.size() - 1), static_cast<std::uint32_t>(c.used), n});
+			c.used += n;
+			m_bytes += n;
+		}
+
+		void append(std::string_view message)
+		{
+			append(message.data(), message.size());
+		}
+
+		std::string_view operator[](brisk::size_t index) const noexcept
+		{
+			const entry& e = m_index[index];
+			return std::string_view(m_chunks[e.chunk].data + e.offset, e.length);
+		}
+
+		const_iterator begin() const noexcept
+		{
+			return const_iterator(this, 0);
+		}
+
+		const_iterator end() const noexcept
+		{
+			return const_iterator(this, m_index.size());
+		}
+
+		// Number of messages.
+		brisk::size_t size() const noexcept
+		{
+			return m_index.size();
+		}
+
+		bool empty() const noexcept
+		{
+			return m_index.empty();
+		}
+
+		// Message bytes held, not counting unused chunk space.
+		brisk::size_t bytes() const noexcept
+		{
+			return m_bytes;
+		}
+
+		// The packed bytes, in logging order, one contiguous run per chunk.
+		brisk::size_t chunks() const noexcept
+		{
+			return m_chunks.size();
+		}
+
+		std::string_view chunk_data(brisk::size_t index) const noexcept
+		{
+			return std::string_view(m_chunks[index].data, m_chunks[index].used);
+		}
+
+		// Drops every message but keeps the first chunk for reuse.
+		void clear() noexcept
+		{
+			release(1);
+			if (!m_chunks.empty()) {
+				m_chunks.front().used = 0;
+			}
+
+			m_index.clear();
+			m_bytes = 0;
+		}
+
+		// Frees the chunk clear() kept if it's empty, and trims the index.
+		void shrink_to_fit()
+		{
+			if (m_index.empty()) {
+				release(0);
+				m_chunks.clear();
+			}
+
+			m_chunks.shrink_to_fit();
+			m_index.shrink_to_fit();
+		}
+
+		// Writes every message, in order, to path. Returns false if the file
+		// can't be opened or a write fails.
+		bool write(const char* path) const
+		{
+#ifdef BRISK_HAS_WRITEV
+			int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (fd < 0) {
+				return false;
+			}
+
+			bool ok = writeChunks(fd);
+			return (::close(fd) == 0) && ok;
+#else
+			std::ofstream file(path, std::ios::binary);
+			if (!file.is_open()) {
+				return false;
+			}
+
+			for (brisk::size_t i = 0; i < m_chunks.size(); i++) {
+				file.write(m_chunks[i].data, m_chunks[i].used);
+			}
+
+			file.close();
+			return !file.fail();
+#endif
+		}
+
+	private:
+		static brisk::size_t clampChunkSize(brisk::size_t chunkSize) noexcept
+		{
+			if (chunkSize == 0) {
+				return defaultChunkSize;
+			}
+
+			return (chunkSize > maxChunkSize) ? maxChunkSize : chunkSize;
+		}
+
+		void grow(brisk::size_t n)
+		{
+			// a message past the chunk size gets a chunk of exactly its size
+			brisk::size_t capacity = (n > m_chunkSize) ? n : m_chunkSize;
+			if (capacity > maxChunkSize) {
+				throw std::length_error("[brisk::log_history][Exception]: Message too long");
+			}
+
+			BRISK_HEAP_SAMPLE(capacity);
+			char* data = static_cast<char*>(m_resource->allocate(capacity, 1));
+			try {
+				m_chunks.push_back(chunk{data, capacity, 0});
+			} catch (...) {
+				m_resource->deallocate(data, capacity, 1);
+				throw;
+			}
+		}
+
+		// Frees every chunk from index first on. The caller fixes m_chunks.
+		void release(brisk::size_t first) noexcept
+		{
+			while (m_chunks.size() > first) {
+				chunk& c = m_chunks.back();
+				m_resource->deallocate(c.data, c.capacity, 1);
+				m_chunks.pop_back();
+			}
+		}
+
+		// Packed to the bytes used, so a copy carries no slack. The index
+		// entries keep pointing at the same chunks and offsets.
+		void copyChunks(const log_history& other)
+		{
+			for (brisk::size_t i = 0; i < other.m_chunks.size(); i++) {
+				const chunk& c = other.m_chunks[i];
+				brisk::size_t capacity = (c.used != 0) ? c.used : m_chunkSize;
+				char* data = static_cast<char*>(m_resource->allocate(capacity, 1));
+				if (c.used != 0) {
+					std::memcpy(data, c.data, c.used);
+				}
+
+				try {
+					m_chunks.push_back(chunk{data, capacity, c.used});
+				} catch (...) {
+					m_resource->deallocate(data, capacity, 1);
+					throw;
+				}
+			}
+
+			m_bytes = other.m_bytes;
+		}
+
+#ifdef BRISK_HAS_WRITEV
+		bool writeChunks(int fd) const
+		{
+#ifdef IOV_MAX
+			constexpr int batch = (IOV_MAX < 1024) ? IOV_MAX : 1024;
+#else
+			constexpr int batch = 16;
+#endif
+			iovec iov[batch];
+
+			brisk::size_t next = 0;
+			while (next < m_chunks.size()) {
+				int count = 0;
+				for (; count < batch && next < m_chunks.size(); ++next) {
+					if (m_chunks[next].used != 0) {
+						iov[count].iov_base = m_chunks[next].data;
+						iov[count].iov_len = m_chunks[next].used;
+						++count;
+					}
+				}
+
+				// writev may stop short; skip past what it wrote and go again
+				iovec* pending = iov;
+				while (count > 0) {
+					ssize_t written = ::writev(fd, pending, count);
+					if (written < 0) {
+						if (errno == EINTR) {
+							continue;
+						}
+
+						return false;
+					}
+
+					brisk::size_t left = static_cast<brisk::size_t>(written);
+					while (count > 0 && left >= pending->iov_len) {
+						left -= pending->iov_len;
+						++pending;
+						--count;
+					}
+
+					if (count > 0) {
+						pending->iov_base = static_cast<char*>(pending->iov_base) + left;
+						pending->iov_len -= left;
+					}
+				}
+			}
+
+			return true;
+		}
+#endif
+
+		brisk::vector<chunk> m_chunks;
+		brisk::vector<entry> m_index;
+		memory_resource* m_resource;
+		brisk::size_t m_chunkSize;
+		brisk::size_t m_bytes;
+	};
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "briskdef.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace brisk
+{
+	// Counters a logger and its sinks bump as they work. Every update is a
+	// relaxed atomic, so reading them never slows the logging threads down;
+	// a snapshot is only approximately consistent across fields.
+	struct log_counters
+	{
+		static constexpr brisk::size_t latencyBuckets = 24;
+
+		std::atomic<std::uint64_t> messages{0};
+		std::atomic<std::uint64_t> bytes{0};
+		std::atomic<std::uint64_t> dropped{0};
+		std::atomic<std::uint64_t> writeErrors{0};
+		std::atomic<std::uint64_t> flushes{0};
+		std::atomic<std::uint64_t> occupancy{0};
+		std::atomic<std::uint64_t> peakOccupancy{0};
+
+		// bucket i counts flushes that took [2^i, 2^(i+1)) microseconds,
+		// bucket 0 also holds everything under 1us
+		std::atomic<std::uint64_t> flushLatency[latencyBuckets] = {};
+
+		void message(brisk::size_t n) noexcept
+		{
+			messages.fetch_add(1, std::memory_order_relaxed);
+			bytes.fetch_add(n, std::memory_order_relaxed);
+		}
+
+		void drop() noexcept
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void error() noexcept
+		{
+			writeErrors.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void occupy(std::uint64_t current) noexcept
+		{
+			occupancy.store(current, std::memory_order_relaxed);
+			std::uint64_t peak = peakOccupancy.load(std::memory_order_relaxed);
+			while (current > peak && !peakOccupancy.compare_exchange_weak(peak, current, std::memory_order_relaxed));
+		}
+
+		void flushed(std::chrono::steady_clock::duration elapsed) noexcept
+		{
+			std::uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+			brisk::size_t bucket = 0;
+			for (; us > 1 && bucket < latencyBuckets - 1; us >>= 1) {
+				++bucket;
+			}
+
+			flushes.fetch_add(1, std::memory_order_relaxed);
+			flushLatency[bucket].fetch_add(1, std::memory_order_relaxed);
+		}
+	};
+
+	// A point-in-time copy of log_counters. Rates cover the interval since
+	// the previous snapshot taken from the same logger.
+	struct log_metrics
+	{
+		std::uint64_t messages = 0;
+		std::uint64_t bytes = 0;
+		std::uint64_t dropped = 0;
+		std::uint64_t writeErrors = 0;
+		std::uint64_t flushes = 0;
+		std::uint64_t occupancy = 0;
+		std::uint64_t peakOccupancy = 0;
+		std::uint64_t flushLatency[log_counters::latencyBuckets] = {};
+		double messagesPerSec = 0;
+		double bytesPerSec = 0;
+
+		static log_metrics read(const log_counters& counters) noexcept
+		{
+			log_metrics m;
+			m.messages = counters.messages.load(std::memory_order_relaxed);
+			m.bytes = counters.bytes.load(std::memory_order_relaxed);
+			m.dropped = counters.dropped.load(std::memory_order_relaxed);
+			m.writeErrors = counters.writeErrors.load(std::memory_order_relaxed);
+			m.flushes = counters.flushes.load(std::memory_order_relaxed);
+			m.occupancy = counters.occupancy.load(std::memory_order_relaxed);
+			m.peakOccupancy = counters.peakOccupancy.load(std::memory_order_relaxed);
+			for (brisk::size_t i = 0; i < log_counters::latencyBuckets; ++i) {
+				m.flushLatency[i] = counters.flushLatency[i].load(std::memory_order_relaxed);
+			}
+
+			return m;
+		}
+
+		// Upper bound in microseconds of the bucket holding the p-th flush
+		// latency percentile (p in [0, 1]).
+		std::uint64_t flushLatencyPercentile(double p) const noexcept
+		{
+			std::uint64_t total = 0;
+			for (std::uint64_t n : flushLatency) {
+				total += n;
+			}
+
+			std::uint64_t rank = static_cast<std::uint64_t>(p * total);
+			std::uint64_t seen = 0;
+			for (brisk::size_t i = 0; i < log_counters::latencyBuckets; ++i) {
+				seen += flushLatency[i];
+				if (seen > rank) {
+					return std::uint64_t(2) << i;
+				}
+			}
+
+			return 0;
+		}
+
+		friend std::ostream& operator<<(std::ostream& out, const log_metrics& m)
+		{
+			out << "messages=" << m.messages << " bytes=" << m.bytes
+				<< " messages/s=" << m.messagesPerSec << " bytes/s=" << m.bytesPerSec
+				<< " occupancy=" << m.occupancy << " peak=" << m.peakOccupancy
+				<< " flushes=" << m.flushes << " flush_p50<=" << m.flushLatencyPercentile(0.5) << "us"
+				<< " flush_p99<=" << m.flushLatencyPercentile(0.99) << "us"
+				<< " dropped=" << m.dropped << " write_errors=" << m.writeErrors;
+			return out;
+		}
+	};
+}
@@ -1,23 +1,53 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <new>
 #include <type_traits>
+#include "briskdef.hpp"
 #include "utility.hpp"
+#ifdef BRISK_HEAP_PROFILE
+#include "heap_profiler.hpp"
+#endif
 
 namespace brisk
 {
 	using nullptr_t = decltype(nullptr);
 	
-	template <class Type>
+	namespace detail
+	{
+		// Deleter::pointer when the deleter names one, so a unique_ptr can
+		// own handles that aren't plain pointers; Type* otherwise.
+		template <class Type, class Deleter, class = void>
+		struct unique_pointer
+		{
+			using type = Type*;
+		};
+
+		template <class Type, class Deleter>
+		struct unique_pointer<Type, Deleter, std::void_t<typename std::remove_reference_t<Deleter>::pointer>>
+		{
+			using type = typename std::remove_reference_t<Deleter>::pointer;
+		};
+	}
+
+	// The deleter is [[no_unique_address]], so a stateless one (the default,
+	// or one for pool or mmap'd memory that knows its size statically) takes
+	// no space and unique_ptr stays the size of a pointer.
+	template <class Type, class Deleter = std::default_delete<Type>>
 	class unique_ptr
 	{
 	public:
-		typedef Type* pointer;
+		typedef typename detail::unique_pointer<Type, Deleter>::type pointer;
 		typedef Type element_type;
+		typedef Deleter deleter_type;
 
 	public:
 		constexpr unique_ptr() noexcept
+			: ptr()
 		{
-			ptr = nullptr;
+
 		}
 
 		constexpr unique_ptr(nullptr_t) noexcept : unique_ptr()
@@ -26,40 +56,95 @@ namespace brisk
 		}
 
 		explicit unique_ptr(pointer p) noexcept
+			: ptr(p)
 		{
-			ptr = p;
+
+		}
+
+		unique_ptr(pointer p, const Deleter& d) noexcept
+			: ptr(p), deleter(d)
+		{
+
+		}
+
+		// a reference Deleter only takes the deleter it refers to, through
+		// the overload above; this one would collapse to the same signature
+		unique_ptr(pointer p, Deleter&& d) noexcept
+			requires (!std::is_reference_v<Deleter>)
+			: ptr(p), deleter(brisk::move(d))
+		{
+
 		}
 
 		unique_ptr(unique_ptr&& x) noexcept
+			: ptr(x.release()), deleter(brisk::forward<Deleter>(x.deleter))
+		{
+
+		}
+
+		template <class Other, class OtherDeleter, class = std::enable_if_t<
+			!std::is_array_v<Other> &&
+			std::is_convertible_v<typename unique_ptr<Other, OtherDeleter>::pointer, pointer> &&
+			std::is_convertible_v<OtherDeleter, Deleter>>>
+		unique_ptr(unique_ptr<Other, OtherDeleter>&& x) noexcept
+			: ptr(x.release()), deleter(brisk::forward<OtherDeleter>(x.get_deleter()))
 		{
-			ptr = x.ptr;
-			x.ptr = nullptr;
+
 		}
 
 		unique_ptr(const unique_ptr&) = delete;
+		unique_ptr& operator=(const unique_ptr&) = delete;
 
 		~unique_ptr()
 		{
-			delete ptr;
+			if (ptr != pointer())
+				deleter(ptr);
+		}
+
+		unique_ptr& operator=(unique_ptr&& x) noexcept
+		{
+			reset(x.release());
+			deleter = brisk::forward<Deleter>(x.deleter);
+			return *this;
+		}
+
+		template <class Other, class OtherDeleter, class = std::enable_if_t<
+			!std::is_array_v<Other> &&
+			std::is_convertible_v<typename unique_ptr<Other, OtherDeleter>::pointer, pointer> &&
+			std::is_assignable_v<Deleter&, OtherDeleter&&>>>
+		unique_ptr& operator=(unique_ptr<Other, OtherDeleter>&& x) noexcept
+		{
+			reset(x.release());
+			deleter = brisk::forward<OtherDeleter>(x.get_deleter());
+			return *this;
+		}
+
+		unique_ptr& operator=(nullptr_t) noexcept
+		{
+			reset();
+			return *this;
 		}
 
 		explicit operator bool() const noexcept
 		{
-			return ptr != nullptr;
+			return ptr != pointer();
 		}
 
 		pointer release() noexcept
 		{
 			pointer temp = ptr;
-			ptr = nullptr;
+			ptr = pointer();
 			return temp;
 		}
 
+		// The new pointer is in place before the old one is deleted, in case
+		// deleting it ends up back here.
 		void reset(pointer p = pointer())
 		{
-			if (ptr != nullptr)
-				delete ptr;
+			pointer old = ptr;
 			ptr = p;
+			if (old != pointer())
+				deleter(old);
 		}
 
 		void swap(unique_ptr& other) noexcept
@@ -67,6 +152,10 @@ namespace brisk
 			pointer temp = ptr;
 			ptr = other.ptr;
 			other.ptr = temp;
+
+			Deleter d = brisk::move(deleter);
+			deleter = brisk::move(other.deleter);
+			other.deleter = brisk::move(d);
 		}
 
 		pointer get() const noexcept
@@ -74,6 +163,16 @@ namespace brisk
 			return ptr;
 		}
 
+		Deleter& get_deleter() noexcept
+		{
+			return deleter;
+		}
+
+		const Deleter& get_deleter() const noexcept
+		{
+			return deleter;
+		}
+
 		typename std::add_lvalue_reference<element_type>::type operator*() const
 		{
 			return *ptr;
@@ -86,120 +185,1232 @@ namespace brisk
 
 	private:
 		pointer ptr;
+		[[no_unique_address]] Deleter deleter;
 	};
 
-	template <class Type, class... Args>
+	// Arrays: delete[] by default, operator[] instead of * and ->, and no
+	// conversions from other element types (deleting a derived array through
+	// a base pointer is undefined).
+	template <class Type, class Deleter>
+	class unique_ptr<Type[], Deleter>
+	{
+	public:
+		typedef typename detail::unique_pointer<Type, Deleter>::type pointer;
+		typedef Type element_type;
+		typedef Deleter deleter_type;
+
+	public:
+		constexpr unique_ptr() noexcept
+			: ptr()
+		{
+
+		}
+
+		constexpr unique_ptr(nullptr_t) noexcept : unique_ptr()
+		{
+
+		}
+
+		explicit unique_ptr(pointer p) noexcept
+			: ptr(p)
+		{
+
+		}
+
+		unique_ptr(pointer p, const Deleter& d) noexcept
+			: ptr(p), deleter(d)
+		{
+
+		}
+
+		unique_ptr(pointer p, Deleter&& d) noexcept
+			requires (!std::is_reference_v<Deleter>)
+			: ptr(p), deleter(brisk::move(d))
+		{
+
+		}
+
+		unique_ptr(unique_ptr&& x) noexcept
+			: ptr(x.release()), deleter(brisk::forward<Deleter>(x.deleter))
+		{
+
+		}
+
+		unique_ptr(const unique_ptr&) = delete;
+		unique_ptr& operator=(const unique_ptr&) = delete;
+
+		~unique_ptr()
+		{
+			if (ptr != pointer())
+				deleter(ptr);
+		}
+
+		unique_ptr& operator=(unique_ptr&& x) noexcept
+		{
+			reset(x.release());
+			deleter = brisk::forward<Deleter>(x.deleter);
+			return *this;
+		}
+
+		unique_ptr& operator=(nullptr_t) noexcept
+		{
+			reset();
+			return *this;
+		}
+
+		explicit operator bool() const noexcept
+		{
+			return ptr != pointer();
+		}
+
+		pointer release() noexcept
+		{
+			pointer temp = ptr;
+			ptr = pointer();
+			return temp;
+		}
+
+		void reset(pointer p = pointer())
+		{
+			pointer old = ptr;
+			ptr = p;
+			if (old != pointer())
+				deleter(old);
+		}
+
+		void swap(unique_ptr& other) noexcept
+		{
+			pointer temp = ptr;
+			ptr = other.ptr;
+			other.ptr = temp;
+
+			Deleter d = brisk::move(deleter);
+			deleter = brisk::move(other.deleter);
+			other.deleter = brisk::move(d);
+		}
+
+		pointer get() const noexcept
+		{
+			return ptr;
+		}
+
+		Deleter& get_deleter() noexcept
+		{
+			return deleter;
+		}
+
+		const Deleter& get_deleter() const noexcept
+		{
+			return deleter;
+		}
+
+		Type& operator[](brisk::size_t i) const
+		{
+			return ptr[i];
+		}
+
+	private:
+		pointer ptr;
+		[[no_unique_address]] Deleter deleter;
+	};
+
+	static_assert(sizeof(unique_ptr<int>) == sizeof(int*), "unique_ptr with the default deleter must be pointer-sized");
+	static_assert(sizeof(unique_ptr<int[]>) == sizeof(int*), "unique_ptr<T[]> with the default deleter must be pointer-sized");
+	static_assert(sizeof(unique_ptr<int, void (*)(int*)>) == 2 * sizeof(int*), "a function pointer deleter is stored");
+
+	template <class Type, class... Args, class = std::enable_if_t<!std::is_array_v<Type>>>
 	unique_ptr<Type> make_unique(Args&&... args)
 	{
+		BRISK_HEAP_SAMPLE(sizeof(Type));
 		return unique_ptr<Type>(new Type(forward<Args>(args)...));
 	}
 
-	template <class Type1, class Type2>
-	bool operator==(const unique_ptr<Type1>& x, const unique_ptr<Type2>& y)
+	// make_unique<T[]>(n) value-initialises the n elements.
+	template <class Type, class = std::enable_if_t<std::is_unbounded_array_v<Type>>>
+	unique_ptr<Type> make_unique(brisk::size_t n)
+	{
+		BRISK_HEAP_SAMPLE(n * sizeof(std::remove_extent_t<Type>));
+		return unique_ptr<Type>(new std::remove_extent_t<Type>[n]());
+	}
+
+	// Default-initialises instead, so a large buffer of trivial type isn't
+	// zeroed when it's about to be written anyway.
+	template <class Type, class = std::enable_if_t<!std::is_array_v<Type>>>
+	unique_ptr<Type> make_unique_for_overwrite()
+	{
+		BRISK_HEAP_SAMPLE(sizeof(Type));
+		return unique_ptr<Type>(new Type);
+	}
+
+	template <class Type, class = std::enable_if_t<std::is_unbounded_array_v<Type>>>
+	unique_ptr<Type> make_unique_for_overwrite(brisk::size_t n)
+	{
+		BRISK_HEAP_SAMPLE(n * sizeof(std::remove_extent_t<Type>));
+		return unique_ptr<Type>(new std::remove_extent_t<Type>[n]);
+	}
+
+	template <class Type, class Deleter>
+	void swap(unique_ptr<Type, Deleter>& x, unique_ptr<Type, Deleter>& y) noexcept
+	{
+		x.swap(y);
+	}
+
+	// Deleter for objects that came from an allocator rather than new.
+	template <class Allocator>
+	struct allocator_delete
+	{
+		using traits = std::allocator_traits<Allocator>;
+		using pointer = typename traits::pointer;
+
+		allocator_delete() = default;
+
+		explicit allocator_delete(const Allocator& a) noexcept
+			: allocator(a)
+		{
+
+		}
+
+		void operator()(pointer p)
+		{
+			traits::destroy(allocator, p);
+			traits::deallocate(allocator, p, 1);
+		}
+
+		[[no_unique_address]] Allocator allocator;
+	};
+
+	template <class Type, class Allocator>
+	using allocated_unique_ptr = unique_ptr<Type, allocator_delete<typename std::allocator_traits<Allocator>::template rebind_alloc<Type>>>;
+
+	// make_unique with the memory coming from an allocator.
+	template <class Type, class Allocator, class... Args>
+	allocated_unique_ptr<Type, Allocator> allocate_unique(const Allocator& allocator, Args&&... args)
+	{
+		using rebound = typename std::allocator_traits<Allocator>::template rebind_alloc<Type>;
+		using traits = std::allocator_traits<rebound>;
+
+		rebound a(allocator);
+		BRISK_HEAP_SAMPLE(sizeof(Type));
+		Type* p = traits::allocate(a, 1);
+		try {
+			traits::construct(a, p, brisk::forward<Args>(args)...);
+		} catch (...) {
+			traits::deallocate(a, p, 1);
+			throw;
+		}
+		return allocated_unique_ptr<Type, Allocator>(p, allocator_delete<rebound>(a));
+	}
+
+	template <class Type1, class D1, class Type2, class D2>
+	bool operator==(const unique_ptr<Type1, D1>& x, const unique_ptr<Type2, D2>& y)
 	{
 		return x.get() == y.get();
 	}
 
-	template <class Type1, class Type2>
-	bool operator!=(const unique_ptr<Type1>& x, const unique_ptr<Type2>& y)
+	template <class Type1, class D1, class Type2, class D2>
+	bool operator!=(const unique_ptr<Type1, D1>& x, const unique_ptr<Type2, D2>& y)
 	{
 		return x.get() != y.get();
 	}
 
-	template <class Type1, class Type2>
-	bool operator<(const unique_ptr<Type1>& x, const unique_ptr<Type2>& y)
+	template <class Type1, class D1, class Type2, class D2>
+	bool operator<(const unique_ptr<Type1, D1>& x, const unique_ptr<Type2, D2>& y)
 	{
-		return std::less<typename std::common_type<typename unique_ptr<Type1>::pointer, typename unique_ptr<Type2>::pointer>::type>()(x.get(), y.get());
+		return std::less<typename std::common_type<typename unique_ptr<Type1, D1>::pointer, typename unique_ptr<Type2, D2>::pointer>::type>()(x.get(), y.get());
 	}
 
-	template <class Type1, class Type2>
-	bool operator<=(const unique_ptr<Type1>& x, const unique_ptr<Type2>& y)
+	template <class Type1, class D1, class Type2, class D2>
+	bool operator<=(const unique_ptr<Type1, D1>& x, const unique_ptr<Type2, D2>& y)
 	{
 		return !(y < x);
 	}
 
-	template <class Type1, class Type2>
-	bool operator>(const unique_ptr<Type1>& x, const unique_ptr<Type2>& y)
+	template <class Type1, class D1, class Type2, class D2>
+	bool operator>(const unique_ptr<Type1, D1>& x, const unique_ptr<Type2, D2>& y)
 	{
-		return std::greater<typename std::common_type<typename unique_ptr<Type1>::pointer, typename unique_ptr<Type2>::pointer>::type>()(x.get(), y.get());
+		return std::greater<typename std::common_type<typename unique_ptr<Type1, D1>::pointer, typename unique_ptr<Type2, D2>::pointer>::type>()(x.get(), y.get());
 		// could also be "return (y < x)" but im using that ^ for now because more verbose
 	}
 
-	template <class Type1, class Type2>
-	bool operator>=(const unique_ptr<Type1>& x, const unique_ptr<Type2>& y)
+	template <class Type1, class D1, class Type2, class D2>
+	bool operator>=(const unique_ptr<Type1, D1>& x, const unique_ptr<Type2, D2>& y)
 	{
 		return !(x < y);
 	}
 
-	template <class Type>
-	bool operator==(const unique_ptr<Type>& x, nullptr_t) noexcept
+	template <class Type, class D>
+	bool operator==(const unique_ptr<Type, D>& x, nullptr_t) noexcept
 	{
 		return !(x.get());
 	}
 
-	template <class Type>
-	bool operator!=(const unique_ptr<Type>& x, nullptr_t) noexcept
+	template <class Type, class D>
+	bool operator!=(const unique_ptr<Type, D>& x, nullptr_t) noexcept
 	{
 		return bool(x.get());
 	}
 
-	template <class Type>
-	bool operator==(nullptr_t, const unique_ptr<Type>& x) noexcept
+	template <class Type, class D>
+	bool operator==(nullptr_t, const unique_ptr<Type, D>& x) noexcept
 	{
 		return !(x.get());
 	}
 
-	template <class Type>
-	bool operator!=(nullptr_t, const unique_ptr<Type>& x) noexcept
+	template <class Type, class D>
+	bool operator!=(nullptr_t, const unique_ptr<Type, D>& x) noexcept
 	{
 		return bool(x.get());
 	}
 
-	template <class Type>
-	bool operator<(const unique_ptr<Type>& x, nullptr_t)
+	template <class Type, class D>
+	bool operator<(const unique_ptr<Type, D>& x, nullptr_t)
 	{
-		return std::less<typename unique_ptr<Type>::pointer>()(x.get(), nullptr);
+		return std::less<typename unique_ptr<Type, D>::pointer>()(x.get(), nullptr);
 	}
 
-	template <class Type>
-	bool operator<(nullptr_t, const unique_ptr<Type>&x) noexcept
+	template <class Type, class D>
+	bool operator<(nullptr_t, const unique_ptr<Type, D>& x) noexcept
 	{
-		return std::less<typename unique_ptr<Type>::pointer>()(nullptr, x.get());
+		return std::less<typename unique_ptr<Type, D>::pointer>()(nullptr, x.get());
 	}
 
-	template <class Type>
-	bool operator<=(const unique_ptr<Type>& x, nullptr_t)
+	template <class Type, class D>
+	bool operator<=(const unique_ptr<Type, D>& x, nullptr_t)
 	{
 		return !(nullptr < x);
 	}
 
-	template <class Type>
-	bool operator<=(nullptr_t, const unique_ptr<Type>& x)
+	template <class Type, class D>
+	bool operator<=(nullptr_t, const unique_ptr<Type, D>& x)
 	{
 		return !(x < nullptr);
 	}
 
-	template <class Type>
-	bool operator>(const unique_ptr<Type&> x, nullptr_t)
+	template <class Type, class D>
+	bool operator>(const unique_ptr<Type, D>& x, nullptr_t)
 	{
 		return (nullptr < x);
 	}
 
-	template <class Type>
-	bool operator>(nullptr_t, const unique_ptr<Type>& x)
+	template <class Type, class D>
+	bool operator>(nullptr_t, const unique_ptr<Type, D>& x)
 	{
 		return (x < nullptr);
 	}
 
-	template <class Type>
-	bool operator>=(const unique_ptr<Type>& x, nullptr_t)
+	template <class Type, class D>
+	bool operator>=(const unique_ptr<Type, D>& x, nullptr_t)
 	{
 		return !(x < nullptr);
 	}
 
-	template <class Type>
-	bool operator>=(nullptr_t, const unique_ptr<Type>& x)
+	template <class Type, class D>
+	bool operator>=(nullptr_t, const unique_ptr<Type, D>& x)
 	{
 		return !(nullptr < x);
 	}
+
+	namespace detail
+	{
+		// Reference counts shared between threads.
+		struct atomic_count_policy
+		{
+			using count_type = std::atomic<long>;
+
+			static void increment(count_type& count) noexcept
+			{
+				count.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			// Returns the new count. acq_rel so the thread that drops the last
+			// reference sees every write made through the other references.
+			static long decrement(count_type& count) noexcept
+			{
+				return count.fetch_sub(1, std::memory_order_acq_rel) - 1;
+			}
+
+			static bool increment_if_nonzero(count_type& count) noexcept
+			{
+				long n = count.load(std::memory_order_relaxed);
+				while (n != 0) {
+					if (count.compare_exchange_weak(n, n + 1, std::memory_order_relaxed)) {
+						return true;
+					}
+				}
+				return false;
+			}
+
+			static long load(const count_type& count) noexcept
+			{
+				return count.load(std::memory_order_relaxed);
+			}
+
+			// True if the caller holds the only reference left; acquire pairs
+			// with the release half of decrement() in other threads.
+			static bool last(const count_type& count) noexcept
+			{
+				return count.load(std::memory_order_acquire) == 1;
+			}
+		};
+
+		// Plain counts for objects that never leave one thread.
+		struct local_count_policy
+		{
+			using count_type = long;
+
+			static void increment(count_type& count) noexcept
+			{
+				++count;
+			}
+
+			static long decrement(count_type& count) noexcept
+			{
+				return --count;
+			}
+
+			static bool increment_if_nonzero(count_type& count) noexcept
+			{
+				return (count != 0) ? (++count, true) : false;
+			}
+
+			static long load(const count_type& count) noexcept
+			{
+				return count;
+			}
+
+			static bool last(const count_type& count) noexcept
+			{
+				return count == 1;
+			}
+		};
+
+		// The weak count includes one reference held collectively by all the
+		// strong references, so the block outlives the object until the last
+		// weak_ptr is gone.
+		template <class Policy>
+		class control_block
+		{
+		public:
+			control_block() noexcept
+				: m_uses(1), m_weak(1)
+			{
+
+			}
+
+			virtual ~control_block() = default;
+
+			void add_ref() noexcept
+			{
+				Policy::increment(m_uses);
+			}
+
+			void release() noexcept
+			{
+				if (Policy::decrement(m_uses) == 0) {
+					dispose();
+					weak_release();
+				}
+			}
+
+			void weak_add_ref() noexcept
+			{
+				Policy::increment(m_weak);
+			}
+
+			void weak_release() noexcept
+			{
+				// nobody can gain a weak reference without already holding one,
+				// so the last holder can skip the read-modify-write
+				if (Policy::last(m_weak) || Policy::decrement(m_weak) == 0) {
+					destroy();
+				}
+			}
+
+			bool lock() noexcept
+			{
+				return Policy::increment_if_nonzero(m_uses);
+			}
+
+			long use_count() const noexcept
+			{
+				return Policy::load(m_uses);
+			}
+
+		protected:
+			virtual void dispose() noexcept = 0;    // destroys the object
+			virtual void destroy() noexcept = 0;    // frees the block
+
+		private:
+			typename Policy::count_type m_uses;
+			typename Policy::count_type m_weak;
+		};
+
+		// Block for an object that was allocated on its own.
+		template <class Policy, class Type, class Deleter>
+		class pointer_control_block : public control_block<Policy>
+		{
+		public:
+			pointer_control_block(Type* ptr, Deleter deleter) noexcept
+				: m_ptr(ptr), m_deleter(brisk::move(deleter))
+			{
+
+			}
+
+		protected:
+			void dispose() noexcept override
+			{
+				m_deleter(m_ptr);
+			}
+
+			void destroy() noexcept override
+			{
+				delete this;
+			}
+
+		private:
+			Type* m_ptr;
+			Deleter m_deleter;
+		};
+
+		// Block with the object stored inline, so make_shared and
+		// allocate_shared need a single allocation.
+		template <class Policy, class Type, class Allocator>
+		class inplace_control_block : public control_block<Policy>
+		{
+		public:
+			using block_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<inplace_control_block>;
+
+			template <class... Args>
+			inplace_control_block(const Allocator& allocator, Args&&... args)
+				: m_allocator(allocator)
+			{
+				::new (static_cast<void*>(m_storage)) Type(brisk::forward<Args>(args)...);
+			}
+
+			Type* get() noexcept
+			{
+				return reinterpret_cast<Type*>(m_storage);
+			}
+
+			template <class... Args>
+			static inplace_control_block* create(const Allocator& allocator, Args&&... args)
+			{
+				block_allocator blocks(allocator);
+				inplace_control_block* block = std::allocator_traits<block_allocator>::allocate(blocks, 1);
+				try {
+					::new (static_cast<void*>(block)) inplace_control_block(allocator, brisk::forward<Args>(args)...);
+				} catch (...) {
+					std::allocator_traits<block_allocator>::deallocate(blocks, block, 1);
+					throw;
+				}
+				return block;
+			}
+
+		protected:
+			void dispose() noexcept override
+			{
+				get()->~Type();
+			}
+
+			void destroy() noexcept override
+			{
+				block_allocator blocks(m_allocator);
+				this->~inplace_control_block();
+				std::allocator_traits<block_allocator>::deallocate(blocks, this, 1);
+			}
+
+		private:
+			Allocator m_allocator;
+			alignas(Type) unsigned char m_storage[sizeof(Type)];
+		};
+	}
+
+	template <class Type, class Policy>
+	class basic_weak_ptr;
+
+	// Shared ownership with the counting strategy as a policy. shared_ptr
+	// uses atomic counts; local_shared_ptr uses plain ones and must stay on
+	// one thread.
+	template <class Type, class Policy>
+	class basic_shared_ptr
+	{
+	public:
+		typedef Type element_type;
+		typedef Type* pointer;
+		typedef basic_weak_ptr<Type, Policy> weak_type;
+
+	public:
+		constexpr basic_shared_ptr() noexcept
+			: m_ptr(nullptr), m_block(nullptr)
+		{
+
+		}
+
+		constexpr basic_shared_ptr(nullptr_t) noexcept : basic_shared_ptr()
+		{
+
+		}
+
+		template <class Other, class = std::enable_if_t<std::is_convertible_v<Other*, Type*>>>
+		explicit basic_shared_ptr(Other* p)
+			: basic_shared_ptr(p, std::default_delete<Other>())
+		{
+
+		}
+
+		template <class Other, class Deleter, class = std::enable_if_t<std::is_convertible_v<Other*, Type*>>>
+		basic_shared_ptr(Other* p, Deleter deleter)
+			: m_ptr(p), m_block(nullptr)
+		{
+			try {
+				m_block = new detail::pointer_control_block<Policy, Other, Deleter>(p, deleter);
+			} catch (...) {
+				deleter(p);
+				throw;
+			}
+		}
+
+		basic_shared_ptr(const basic_shared_ptr& x) noexcept
+			: m_ptr(x.m_ptr), m_block(x.m_block)
+		{
+			if (m_block != nullptr)
+				m_block->add_ref();
+		}
+
+		template <class Other, class = std::enable_if_t<std::is_convertible_v<Other*, Type*>>>
+		basic_shared_ptr(const basic_shared_ptr<Other, Policy>& x) noexcept
+			: m_ptr(x.m_ptr), m_block(x.m_block)
+		{
+			if (m_block != nullptr)
+				m_block->add_ref();
+		}
+
+		basic_shared_ptr(basic_shared_ptr&& x) noexcept
+			: m_ptr(x.m_ptr), m_block(x.m_block)
+		{
+			x.m_ptr = nullptr;
+			x.m_block = nullptr;
+		}
+
+		template <class Other, class = std::enable_if_t<std::is_convertible_v<Other*, Type*>>>
+		basic_shared_ptr(basic_shared_ptr<Other, Policy>&& x) noexcept
+			: m_ptr(x.m_ptr), m_block(x.m_block)
+		{
+			x.m_ptr = nullptr;
+			x.m_block = nullptr;
+		}
+
+		// Aliasing constructor: shares x's ownership but points at p, e.g. a
+		// member of the object x owns.
+		template <class Other>
+		basic_shared_ptr(const basic_shared_ptr<Other, Policy>& x, pointer p) noexcept
+			: m_ptr(p), m_block(x.m_block)
+		{
+			if (m_block != nullptr)
+				m_block->add_ref();
+		}
+
+		template <class Other, class Deleter, class = std::enable_if_t<std::is_convertible_v<Other*, Type*>>>
+		basic_shared_ptr(unique_ptr<Other, Deleter>&& x)
+			: basic_shared_ptr()
+		{
+			if (x) {
+				Other* p = x.get();
+				m_block = new detail::pointer_control_block<Policy, Other, Deleter>(p, x.get_deleter());
+				m_ptr = x.release();
+			}
+		}
+
+		// Throws std::bad_weak_ptr if the object is already gone.
+		template <class Other, class = std::enable_if_t<std::is_convertible_v<Other*, Type*>>>
+		explicit basic_shared_ptr(const basic_weak_ptr<Other, Policy>& x)
+			: m_ptr(x.m_ptr), m_block(x.m_block)
+		{
+			if (m_block == nullptr || !m_block->lock()) {
+				throw std::bad_weak_ptr();
+			}
+		}
+
+		~basic_shared_ptr()
+		{
+			if (m_block != nullptr)
+				m_block->release();
+		}
+
+		basic_shared_ptr& operator=(const basic_shared_ptr& x) noexcept
+		{
+			basic_shared_ptr(x).swap(*this);
+			return *this;
+		}
+
+		template <class Other>
+		basic_shared_ptr& operator=(const basic_shared_ptr<Other, Policy>& x) noexcept
+		{
+			basic_shared_ptr(x).swap(*this);
+			return *this;
+		}
+
+		basic_shared_ptr& operator=(basic_shared_ptr&& x) noexcept
+		{
+			basic_shared_ptr(brisk::move(x)).swap(*this);
+			return *this;
+		}
+
+		template <class Other>
+		basic_shared_ptr& operator=(basic_shared_ptr<Other, Policy>&& x) noexcept
+		{
+			basic_shared_ptr(brisk::move(x)).swap(*this);
+			return *this;
+		}
+
+		explicit operator bool() const noexcept
+		{
+			return m_ptr != nullptr;
+		}
+
+		void reset() noexcept
+		{
+			basic_shared_ptr().swap(*this);
+		}
+
+		template <class Other>
+		void reset(Other* p)
+		{
+			basic_shared_ptr(p).swap(*this);
+		}
+
+		template <class Other, class Deleter>
+		void reset(Other* p, Deleter deleter)
+		{
+			basic_shared_ptr(p, deleter).swap(*this);
+		}
+
+		void swap(basic_shared_ptr& other) noexcept
+		{
+			pointer temp = m_ptr;
+			m_ptr = other.m_ptr;
+			other.m_ptr = temp;
+
+			detail::control_block<Policy>* block = m_block;
+			m_block = other.m_block;
+			other.m_block = block;
+		}
+
+		pointer get() const noexcept
+		{
+			return m_ptr;
+		}
+
+		typename std::add_lvalue_reference<element_type>::type operator*() const noexcept
+		{
+			return *m_ptr;
+		}
+
+		pointer operator->() const noexcept
+		{
+			return m_ptr;
+		}
+
+		long use_count() const noexcept
+		{
+			return (m_block != nullptr) ? m_block->use_count() : 0;
+		}
+
+		template <class Other>
+		bool owner_before(const basic_shared_ptr<Other, Policy>& other) const noexcept
+		{
+			return std::less<detail::control_block<Policy>*>()(m_block, other.m_block);
+		}
+
+	private:
+		template <class, class> friend class basic_shared_ptr;
+		template <class, class> friend class basic_weak_ptr;
+		template <class T, class P, class Allocator, class... Args>
+		friend basic_shared_ptr<T, P> allocate_basic_shared(const Allocator& allocator, Args&&... args);
+
+		pointer m_ptr;
+		detail::control_block<Policy>* m_block;
+	};
+
+	template <class Type, class Policy>
+	class basic_weak_ptr
+	{
+	public:
+		typedef Type element_type;
+
+	public:
+		constexpr basic_weak_ptr() noexcept
+			: m_ptr(nullptr), m_block(nullptr)
+		{
+
+		}
+
+		template <class Other, class = std::enable_if_t<std::is_convertible_v<Other*, Type*>>>
+		basic_weak_ptr(const basic_shared_ptr<Other, Policy>& x) noexcept
+			: m_ptr(x.m_ptr), m_block(x.m_block)
+		{
+			if (m_block != nullptr)
+				m_block->weak_add_ref();
+		}
+
+		basic_weak_ptr(const basic_weak_ptr& x) noexcept
+			: m_ptr(x.m_ptr), m_block(x.m_block)
+		{
+			if (m_block != nullptr)
+				m_block->weak_add_ref();
+		}
+
+		template <class Other, class = std::enable_if_t<std::is_convertible_v<Other*, Type*>>>
+		basic_weak_ptr(const basic_weak_ptr<Other, Policy>& x) noexcept
+			: m_ptr(x.m_ptr), m_block(x.m_block)
+		{
+			if (m_block != nullptr)
+				m_block->weak_add_ref();
+		}
+
+		basic_weak_ptr(basic_weak_ptr&& x) noexcept
+			: m_ptr(x.m_ptr), m_block(x.m_block)
+		{
+			x.m_ptr = nullptr;
+			x.m_block = nullptr;
+		}
+
+		~basic_weak_ptr()
+		{
+			if (m_block != nullptr)
+				m_block->weak_release();
+		}
+
+		basic_weak_ptr& operator=(const basic_weak_ptr& x) noexcept
+		{
+			basic_weak_ptr(x).swap(*this);
+			return *this;
+		}
+
+		basic_weak_ptr& operator=(basic_weak_ptr&& x) noexcept
+		{
+			basic_weak_ptr(brisk::move(x)).swap(*this);
+			return *this;
+		}
+
+		template <class Other>
+		basic_weak_ptr& operator=(const basic_shared_ptr<Other, Policy>& x) noexcept
+		{
+			basic_weak_ptr(x).swap(*this);
+			return *this;
+		}
+
+		void reset() noexcept
+		{
+			basic_weak_ptr().swap(*this);
+		}
+
+		void swap(basic_weak_ptr& other) noexcept
+		{
+			Type* temp = m_ptr;
+			m_ptr = other.m_ptr;
+			other.m_ptr = temp;
+
+			detail::control_block<Policy>* block = m_block;
+			m_block = other.m_block;
+			other.m_block = block;
+		}
+
+		long use_count() const noexcept
+		{
+			return (m_block != nullptr) ? m_block->use_count() : 0;
+		}
+
+		bool expired() const noexcept
+		{
+			return use_count() == 0;
+		}
+
+		basic_shared_ptr<Type, Policy> lock() const noexcept
+		{
+			basic_shared_ptr<Type, Policy> result;
+			if (m_block != nullptr && m_block->lock()) {
+				result.m_ptr = m_ptr;
+				result.m_block = m_block;
+			}
+			return result;
+		}
+
+	private:
+		template <class, class> friend class basic_shared_ptr;
+		template <class, class> friend class basic_weak_ptr;
+
+		Type* m_ptr;
+		detail::control_block<Policy>* m_block;
+	};
+
+	template <class Type>
+	using shared_ptr = basic_shared_ptr<Type, detail::atomic_count_policy>;
+
+	template <class Type>
+	using weak_ptr = basic_weak_ptr<Type, detail::atomic_count_policy>;
+
+	template <class Type>
+	using local_shared_ptr = basic_shared_ptr<Type, detail::local_count_policy>;
+
+	template <class Type>
+	using local_weak_ptr = basic_weak_ptr<Type, detail::local_count_policy>;
+
+	template <class Type, class Policy, class Allocator, class... Args>
+	basic_shared_ptr<Type, Policy> allocate_basic_shared(const Allocator& allocator, Args&&... args)
+	{
+		using block_type = detail::inplace_control_block<Policy, Type, Allocator>;
+		BRISK_HEAP_SAMPLE(sizeof(block_type));
+		block_type* block = block_type::create(allocator, brisk::forward<Args>(args)...);
+
+		basic_shared_ptr<Type, Policy> result;
+		result.m_ptr = block->get();
+		result.m_block = block;
+		return result;
+	}
+
+	template <class Type, class Allocator, class... Args>
+	shared_ptr<Type> allocate_shared(const Allocator& allocator, Args&&... args)
+	{
+		return brisk::allocate_basic_shared<Type, detail::atomic_count_policy>(allocator, brisk::forward<Args>(args)...);
+	}
+
+	template <class Type, class... Args>
+	shared_ptr<Type> make_shared(Args&&... args)
+	{
+		return brisk::allocate_shared<Type>(std::allocator<Type>(), brisk::forward<Args>(args)...);
+	}
+
+	template <class Type, class Allocator, class... Args>
+	local_shared_ptr<Type> allocate_local_shared(const Allocator& allocator, Args&&... args)
+	{
+		return brisk::allocate_basic_shared<Type, detail::local_count_policy>(allocator, brisk::forward<Args>(args)...);
+	}
+
+	template <class Type, class... Args>
+	local_shared_ptr<Type> make_local_shared(Args&&... args)
+	{
+		return brisk::allocate_local_shared<Type>(std::allocator<Type>(), brisk::forward<Args>(args)...);
+	}
+
+	template <class Type, class Other, class Policy>
+	basic_shared_ptr<Type, Policy> static_pointer_cast(const basic_shared_ptr<Other, Policy>& x) noexcept
+	{
+		return basic_shared_ptr<Type, Policy>(x, static_cast<Type*>(x.get()));
+	}
+
+	template <class Type, class Other, class Policy>
+	basic_shared_ptr<Type, Policy> dynamic_pointer_cast(const basic_shared_ptr<Other, Policy>& x) noexcept
+	{
+		Type* p = dynamic_cast<Type*>(x.get());
+		return (p != nullptr) ? basic_shared_ptr<Type, Policy>(x, p) : basic_shared_ptr<Type, Policy>();
+	}
+
+	template <class Type1, class Type2, class Policy>
+	bool operator==(const basic_shared_ptr<Type1, Policy>& x, const basic_shared_ptr<Type2, Policy>& y) noexcept
+	{
+		return x.get() == y.get();
+	}
+
+	template <class Type1, class Type2, class Policy>
+	bool operator!=(const basic_shared_ptr<Type1, Policy>& x, const basic_shared_ptr<Type2, Policy>& y) noexcept
+	{
+		return x.get() != y.get();
+	}
+
+	template <class Type1, class Type2, class Policy>
+	bool operator<(const basic_shared_ptr<Type1, Policy>& x, const basic_shared_ptr<Type2, Policy>& y) noexcept
+	{
+		return std::less<typename std::common_type<Type1*, Type2*>::type>()(x.get(), y.get());
+	}
+
+	template <class Type, class Policy>
+	bool operator==(const basic_shared_ptr<Type, Policy>& x, nullptr_t) noexcept
+	{
+		return !(x.get());
+	}
+
+	template <class Type, class Policy>
+	bool operator!=(const basic_shared_ptr<Type, Policy>& x, nullptr_t) noexcept
+	{
+		return bool(x.get());
+	}
+
+	template <class Type, class Policy>
+	bool operator==(nullptr_t, const basic_shared_ptr<Type, Policy>& x) noexcept
+	{
+		return !(x.get());
+	}
+
+	template <class Type, class Policy>
+	bool operator!=(nullptr_t, const basic_shared_ptr<Type, Policy>& x) noexcept
+	{
+		return bool(x.get());
+	}
+
+	// Public names for the count policies, for ref_counted.
+	using atomic_ref_count = detail::atomic_count_policy;
+	using local_ref_count = detail::local_count_policy;
+
+	// A pointer to an object that keeps its own reference count. Copies call
+	// intrusive_ptr_add_ref(p) and the last release calls
+	// intrusive_ptr_release(p), both found by ADL, so any type can opt in by
+	// declaring the pair next to it.
+	template <class Type>
+	class intrusive_ptr
+	{
+	public:
+		using element_type = Type;
+
+		constexpr intrusive_ptr() noexcept
+			: m_ptr(nullptr)
+		{
+
+		}
+
+		// With addRef false the pointer adopts a reference the caller
+		// already holds, e.g. one given up by detach().
+		intrusive_ptr(Type* p, bool addRef = true)
+			: m_ptr(p)
+		{
+			if (m_ptr != nullptr && addRef) {
+				intrusive_ptr_add_ref(m_ptr);
+			}
+		}
+
+		intrusive_ptr(const intrusive_ptr& x)
+			: m_ptr(x.m_ptr)
+		{
+			if (m_ptr != nullptr) {
+				intrusive_ptr_add_ref(m_ptr);
+			}
+		}
+
+		template <class Other, class = std::enable_if_t<std::is_convertible_v<Other*, Type*>>>
+		intrusive_ptr(const intrusive_ptr<Other>& x)
+			: m_ptr(x.get())
+		{
+			if (m_ptr != nullptr) {
+				intrusive_ptr_add_ref(m_ptr);
+			}
+		}
+
+		intrusive_ptr(intrusive_ptr&& x) noexcept
+			: m_ptr(x.m_ptr)
+		{
+			x.m_ptr = nullptr;
+		}
+
+		template <class Other, class = std::enable_if_t<std::is_convertible_v<Other*, Type*>>>
+		intrusive_ptr(intrusive_ptr<Other>&& x) noexcept
+			: m_ptr(x.detach())
+		{
+
+		}
+
+		~intrusive_ptr()
+		{
+			if (m_ptr != nullptr) {
+				intrusive_ptr_release(m_ptr);
+			}
+		}
+
+		intrusive_ptr& operator=(const intrusive_ptr& x)
+		{
+			intrusive_ptr(x).swap(*this);
+			return *this;
+		}
+
+		template <class Other>
+		intrusive_ptr& operator=(const intrusive_ptr<Other>& x)
+		{
+			intrusive_ptr(x).swap(*this);
+			return *this;
+		}
+
+		intrusive_ptr& operator=(intrusive_ptr&& x) noexcept
+		{
+			intrusive_ptr(brisk::move(x)).swap(*this);
+			return *this;
+		}
+
+		template <class Other>
+		intrusive_ptr& operator=(intrusive_ptr<Other>&& x) noexcept
+		{
+			intrusive_ptr(brisk::move(x)).swap(*this);
+			return *this;
+		}
+
+		intrusive_ptr& operator=(Type* p)
+		{
+			intrusive_ptr(p).swap(*this);
+			return *this;
+		}
+
+		void reset() noexcept
+		{
+			intrusive_ptr().swap(*this);
+		}
+
+		void reset(Type* p, bool addRef = true)
+		{
+			intrusive_ptr(p, addRef).swap(*this);
+		}
+
+		// Gives up ownership without releasing the reference.
+		Type* detach() noexcept
+		{
+			Type* p = m_ptr;
+			m_ptr = nullptr;
+			return p;
+		}
+
+		void swap(intrusive_ptr& x) noexcept
+		{
+			Type* tmp = m_ptr;
+			m_ptr = x.m_ptr;
+			x.m_ptr = tmp;
+		}
+
+		Type* get() const noexcept
+		{
+			return m_ptr;
+		}
+
+		Type& operator*() const noexcept
+		{
+			return *m_ptr;
+		}
+
+		Type* operator->() const noexcept
+		{
+			return m_ptr;
+		}
+
+		explicit operator bool() const noexcept
+		{
+			return m_ptr != nullptr;
+		}
+
+	private:
+		Type* m_ptr;
+	};
+
+	// A CRTP base that gives Derived an embedded count and the hooks
+	// intrusive_ptr looks for. Copying an object doesn't copy its count.
+	// Use local_ref_count for objects that never cross threads.
+	template <class Derived, class Policy = atomic_ref_count>
+	class ref_counted
+	{
+	public:
+		long use_count() const noexcept
+		{
+			return Policy::load(m_refs);
+		}
+
+		friend void intrusive_ptr_add_ref(const ref_counted* p) noexcept
+		{
+			Policy::increment(p->m_refs);
+		}
+
+		// The sole owner can skip the atomic decrement, as in
+		// control_block::weak_release.
+		friend void intrusive_ptr_release(const ref_counted* p) noexcept
+		{
+			if (Policy::last(p->m_refs) || Policy::decrement(p->m_refs) == 0) {
+				delete static_cast<const Derived*>(p);
+			}
+		}
+
+	protected:
+		constexpr ref_counted() noexcept
+			: m_refs(0)
+		{
+
+		}
+
+		constexpr ref_counted(const ref_counted&) noexcept
+			: m_refs(0)
+		{
+
+		}
+
+		ref_counted& operator=(const ref_counted&) noexcept
+		{
+			return *this;
+		}
+
+		~ref_counted() = default;
+
+	private:
+		mutable typename Policy::count_type m_refs;
+	};
+
+	template <class Type, class... Args>
+	intrusive_ptr<Type> make_intrusive(Args&&... args)
+	{
+		return intrusive_ptr<Type>(new Type(brisk::forward<Args>(args)...));
+	}
+
+	template <class Type>
+	void swap(intrusive_ptr<Type>& x, intrusive_ptr<Type>& y) noexcept
+	{
+		x.swap(y);
+	}
+
+	template <class Type, class Other>
+	intrusive_ptr<Type> static_pointer_cast(const intrusive_ptr<Other>& x) noexcept
+	{
+		return intrusive_ptr<Type>(static_cast<Type*>(x.get()));
+	}
+
+	template <class Type, class Other>
+	intrusive_ptr<Type> dynamic_pointer_cast(const intrusive_ptr<Other>& x) noexcept
+	{
+		return intrusive_ptr<Type>(dynamic_cast<Type*>(x.get()));
+	}
+
+	template <class Type1, class Type2>
+	bool operator==(const intrusive_ptr<Type1>& x, const intrusive_ptr<Type2>& y) noexcept
+	{
+		return x.get() == y.get();
+	}
+
+	template <class Type1, class Type2>
+	bool operator!=(const intrusive_ptr<Type1>& x, const intrusive_ptr<Type2>& y) noexcept
+	{
+		return x.get() != y.get();
+	}
+
+	template <class Type1, class Type2>
+	bool operator<(const intrusive_ptr<Type1>& x, const intrusive_ptr<Type2>& y) noexcept
+	{
+		return std::less<typename std::common_type<Type1*, Type2*>::type>()(x.get(), y.get());
+	}
+
+	template <class Type>
+	bool operator==(const intrusive_ptr<Type>& x, nullptr_t) noexcept
+	{
+		return !(x.get());
+	}
+
+	template <class Type>
+	bool operator!=(const intrusive_ptr<Type>& x, nullptr_t) noexcept
+	{
+		return bool(x.get());
+	}
+
+	template <class Type>
+	bool operator==(nullptr_t, const intrusive_ptr<Type>& x) noexcept
+	{
+		return !(x.get());
+	}
+
+	template <class Type>
+	bool operator!=(nullptr_t, const intrusive_ptr<Type>& x) noexcept
+	{
+		return bool(x.get());
+	}
+
+	static_assert(sizeof(intrusive_ptr<int>) == sizeof(int*));
 }
@@ -0,0 +1,534 @@
+#pragma once
+
+#include "briskdef.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+namespace brisk
+{
+	// Where a container gets its memory from. Containers hold a pointer to
+	// one and never own it, so the resource has to outlive them.
+	class memory_resource
+	{
+	public:
+		static constexpr brisk::size_t max_align = alignof(std::max_align_t);
+
+		virtual ~memory_resource() = default;
+
+		void* allocate(brisk::size_t bytes, brisk::size_t alignment = max_align)
+		{
+			return do_allocate(bytes, alignment);
+		}
+
+		void deallocate(void* p, brisk::size_t bytes, brisk::size_t alignment = max_align)
+		{
+			do_deallocate(p, bytes, alignment);
+		}
+
+		bool is_equal(const memory_resource& other) const noexcept
+		{
+			return (this == &other) || do_is_equal(other);
+		}
+
+	protected:
+		virtual void* do_allocate(brisk::size_t bytes, brisk::size_t alignment) = 0;
+		virtual void do_deallocate(void* p, brisk::size_t bytes, brisk::size_t alignment) = 0;
+
+		virtual bool do_is_equal(const memory_resource& other) const noexcept
+		{
+			return this == &other;
+		}
+	};
+
+	inline bool operator==(const memory_resource& x, const memory_resource& y) noexcept
+	{
+		return x.is_equal(y);
+	}
+
+	inline bool operator!=(const memory_resource& x, const memory_resource& y) noexcept
+	{
+		return !x.is_equal(y);
+	}
+
+	namespace detail
+	{
+		class new_delete_resource final : public memory_resource
+		{
+		protected:
+			void* do_allocate(brisk::size_t bytes, brisk::size_t alignment) override
+			{
+				if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+					return ::operator new(bytes, std::align_val_t(alignment));
+				}
+				return ::operator new(bytes);
+			}
+
+			void do_deallocate(void* p, brisk::size_t bytes, brisk::size_t alignment) override
+			{
+				if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+					::operator delete(p, bytes, std::align_val_t(alignment));
+					return;
+				}
+				::operator delete(p, bytes);
+			}
+
+			bool do_is_equal(const memory_resource& other) const noexcept override
+			{
+				return dynamic_cast<const new_delete_resource*>(&other) != nullptr;
+			}
+		};
+
+		inline brisk::size_t alignUp(brisk::size_t n, brisk::size_t alignment) noexcept
+		{
+			return (n + alignment - 1) & ~(alignment - 1);
+		}
+
+		inline brisk::size_t roundUpPow2(brisk::size_t n) noexcept
+		{
+			brisk::size_t p = 1;
+			while (p < n) {
+				p <<= 1;
+			}
+			return p;
+		}
+	}
+
+	// Plain ::operator new / ::operator delete.
+	inline memory_resource* new_delete_resource() noexcept
+	{
+		static detail::new_delete_resource resource;
+		return &resource;
+	}
+
+	// Defining BRISK_DEFAULT_THREAD_CACHING before including any brisk
+	// header makes thread_caching_resource() the initial default, so every
+	// vector, string and logger that isn't given a resource uses it.
+#if defined(BRISK_DEFAULT_THREAD_CACHING) && (defined(__unix__) || defined(__APPLE__))
+	inline memory_resource* thread_caching_resource() noexcept;
+#define BRISK_INITIAL_DEFAULT_RESOURCE brisk::thread_caching_resource()
+#else
+#define BRISK_INITIAL_DEFAULT_RESOURCE brisk::new_delete_resource()
+#endif
+
+	namespace detail
+	{
+		inline std::atomic<memory_resource*>& defaultResource() noexcept
+		{
+			static std::atomic<memory_resource*> resource(BRISK_INITIAL_DEFAULT_RESOURCE);
+			return resource;
+		}
+	}
+
+	// The resource containers use when they aren't given one.
+	inline memory_resource* get_default_resource() noexcept
+	{
+		return detail::defaultResource().load(std::memory_order_acquire);
+	}
+
+	// Returns the previous default. nullptr restores new_delete_resource().
+	inline memory_resource* set_default_resource(memory_resource* resource) noexcept
+	{
+		resource = (resource != nullptr) ? resource : new_delete_resource();
+		return detail::defaultResource().exchange(resource, std::memory_order_acq_rel);
+	}
+
+	// An arena. Allocation bumps a pointer through a buffer and grabs a
+	// bigger chunk from upstream when it runs out; deallocate() does nothing
+	// and everything is given back at once by release() or reset(). Not
+	// thread safe.
+	class monotonic_buffer_resource : public memory_resource
+	{
+	public:
+		explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource()) noexcept
+			: monotonic_buffer_resource(nullptr, 0, upstream)
+		{
+
+		}
+
+		explicit monotonic_buffer_resource(brisk::size_t initialSize, memory_resource* upstream = get_default_resource()) noexcept
+			: monotonic_buffer_resource(nullptr, 0, upstream)
+		{
+			m_nextChunk = (initialSize > minChunk) ? initialSize : minChunk;
+		}
+
+		// Uses buffer first; it stays owned by the caller.
+		monotonic_buffer_resource(void* buffer, brisk::size_t size, memory_resource* upstream = get_default_resource()) noexcept
+			: m_upstream(upstream), m_buffer(static_cast<char*>(buffer)), m_bufferSize(size),
+			  m_current(static_cast<char*>(buffer)), m_end(static_cast<char*>(buffer) + size),
+			  m_chunks(nullptr), m_nextChunk((size > minChunk) ? size : minChunk), m_allocated(0)
+		{
+
+		}
+
+		monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+		monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+		~monotonic_buffer_resource() override
+		{
+			release();
+		}
+
+		// Gives every chunk back to upstream and starts over from the
+		// initial buffer.
+		void release() noexcept
+		{
+			while (m_chunks != nullptr) {
+				chunk* next = m_chunks->next;
+				m_upstream->deallocate(m_chunks, m_chunks->size, alignof(chunk));
+				m_chunks = next;
+			}
+
+			m_current = m_buffer;
+			m_end = m_buffer + m_bufferSize;
+			m_allocated = 0;
+		}
+
+		// Like release() but keeps the newest (largest) chunk and carries on
+		// from the start of it, so an arena reset once per request stops
+		// touching upstream after the first few requests.
+		void reset() noexcept
+		{
+			if (m_chunks == nullptr) {
+				release();
+				return;
+			}
+
+			chunk* keep = m_chunks;
+			m_chunks = keep->next;
+			release();
+
+			keep->next = nullptr;
+			m_chunks = keep;
+			m_current = reinterpret_cast<char*>(keep + 1);
+			m_end = reinterpret_cast<char*>(keep) + keep->size;
+		}
+
+		memory_resource* upstream_resource() const noexcept
+		{
+			return m_upstream;
+		}
+
+		// Bytes handed out since the last release() or reset().
+		brisk::size_t allocated() const noexcept
+		{
+			return m_allocated;
+		}
+
+	protected:
+		void* do_allocate(brisk::size_t bytes, brisk::size_t alignment) override
+		{
+			char* p = reinterpret_cast<char*>(detail::alignUp(reinterpret_cast<brisk::size_t>(m_current), alignment));
+			if (m_current == nullptr || p + bytes > m_end) {
+				grow(bytes, alignment);
+				p = reinterpret_cast<char*>(detail::alignUp(reinterpret_cast<brisk::size_t>(m_current), alignment));
+			}
+
+			m_current = p + bytes;
+			m_allocated += bytes;
+			return p;
+		}
+
+		void do_deallocate(void*, brisk::size_t, brisk::size_t) override
+		{
+
+		}
+
+	private:
+		struct alignas(std::max_align_t) chunk
+		{
+			chunk* next;
+			brisk::size_t size;
+		};
+
+		static constexpr brisk::size_t minChunk = 1024;
+
+		void grow(brisk::size_t bytes, brisk::size_t alignment)
+		{
+			brisk::size_t needed = sizeof(chunk) + bytes + alignment;
+			brisk::size_t size = m_nextChunk;
+			while (size < needed) {
+				size <<= 1;
+			}
+
+			chunk* c = static_cast<chunk*>(m_upstream->allocate(size, alignof(chunk)));
+			c->next = m_chunks;
+			c->size = size;
+			m_chunks = c;
+			m_current = reinterpret_cast<char*>(c + 1);
+			m_end = reinterpret_cast<char*>(c) + size;
+			m_nextChunk = size << 1;
+		}
+
+		memory_resource* m_upstream;
+		char* m_buffer;
+		brisk::size_t m_bufferSize;
+		char* m_current;
+		char* m_end;
+		chunk* m_chunks;
+		brisk::size_t m_nextChunk;
+		brisk::size_t m_allocated;
+	};
+
+	struct pool_options
+	{
+		brisk::size_t max_blocks_per_chunk = 1024;
+		brisk::size_t largest_required_pool_block = 4096;
+	};
+
+	// Free lists for power-of-two block sizes from 8 bytes up to
+	// largest_required_pool_block. Blocks come out of chunks taken from
+	// upstream, each chunk twice the size of the last up to
+	// max_blocks_per_chunk blocks. Anything bigger, or more strictly aligned
+	// than its block size, goes straight to upstream. Not thread safe.
+	class unsynchronized_pool_resource : public memory_resource
+	{
+	public:
+		explicit unsynchronized_pool_resource(memory_resource* upstream = get_default_resource())
+			: unsynchronized_pool_resource(pool_options(), upstream)
+		{
+
+		}
+
+		unsynchronized_pool_resource(const pool_options& options, memory_resource* upstream = get_default_resource())
+			: m_upstream(upstream), m_options(options), m_pools(nullptr), m_poolCount(0)
+		{
+			m_options.largest_required_pool_block = detail::roundUpPow2(
+				(m_options.largest_required_pool_block < smallest) ? smallest : m_options.largest_required_pool_block);
+			m_options.max_blocks_per_chunk = (m_options.max_blocks_per_chunk == 0) ? 1 : m_options.max_blocks_per_chunk;
+
+			for (brisk::size_t size = smallest; size <= m_options.largest_required_pool_block; size <<= 1) {
+				++m_poolCount;
+			}
+
+			m_pools = static_cast<pool*>(m_upstream->allocate(m_poolCount * sizeof(pool), alignof(pool)));
+			for (brisk::size_t i = 0; i < m_poolCount; ++i) {
+				::new (static_cast<void*>(&m_pools[i])) pool(smallest << i);
+			}
+		}
+
+		unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+		unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) = delete;
+
+		~unsynchronized_pool_resource() override
+		{
+			release();
+			m_upstream->deallocate(m_pools, m_poolCount * sizeof(pool), alignof(pool));
+		}
+
+		// Returns every chunk to upstream. Blocks that went straight to
+		// upstream are not tracked and have to be deallocated normally.
+		void release() noexcept
+		{
+			for (brisk::size_t i = 0; i < m_poolCount; ++i) {
+				m_pools[i].release(m_upstream);
+			}
+		}
+
+		memory_resource* upstream_resource() const noexcept
+		{
+			return m_upstream;
+		}
+
+		pool_options options() const noexcept
+		{
+			return m_options;
+		}
+
+	protected:
+		void* do_allocate(brisk::size_t bytes, brisk::size_t alignment) override
+		{
+			pool* p = find(bytes, alignment);
+			if (p == nullptr) {
+				return m_upstream->allocate(bytes, alignment);
+			}
+			return p->allocate(m_upstream, m_options.max_blocks_per_chunk);
+		}
+
+		void do_deallocate(void* block, brisk::size_t bytes, brisk::size_t alignment) override
+		{
+			pool* p = find(bytes, alignment);
+			if (p == nullptr) {
+				m_upstream->deallocate(block, bytes, alignment);
+				return;
+			}
+			p->deallocate(block);
+		}
+
+	private:
+		static constexpr brisk::size_t smallest = 8;
+		static constexpr brisk::size_t chunkAlignment = 4096;
+
+		struct free_block
+		{
+			free_block* next;
+		};
+
+		struct chunk
+		{
+			chunk* next;
+			void* memory;
+			brisk::size_t size;
+		};
+
+		class pool
+		{
+		public:
+			explicit pool(brisk::size_t blockSize) noexcept
+				: m_blockSize(blockSize), m_free(nullptr), m_chunks(nullptr),
+				  m_current(nullptr), m_end(nullptr), m_nextBlocks(8)
+			{
+
+			}
+
+			brisk::size_t block_size() const noexcept
+			{
+				return m_blockSize;
+			}
+
+			void* allocate(memory_resource* upstream, brisk::size_t maxBlocks)
+			{
+				if (m_free != nullptr) {
+					free_block* block = m_free;
+					m_free = block->next;
+					return block;
+				}
+
+				// carve fresh chunks lazily rather than threading every block
+				// onto the free list up front
+				if (m_current == m_end) {
+					grow(upstream, maxBlocks);
+				}
+
+				void* block = m_current;
+				m_current += m_blockSize;
+				return block;
+			}
+
+			void deallocate(void* block) noexcept
+			{
+				free_block* b = static_cast<free_block*>(block);
+				b->next = m_free;
+				m_free = b;
+			}
+
+			void release(memory_resource* upstream) noexcept
+			{
+				while (m_chunks != nullptr) {
+					chunk* next = m_chunks->next;
+					upstream->deallocate(m_chunks->memory, m_chunks->size, alignment());
+					m_chunks = next;
+				}
+
+				m_free = nullptr;
+				m_current = m_end = nullptr;
+				m_nextBlocks = 8;
+			}
+
+		private:
+			brisk::size_t alignment() const noexcept
+			{
+				return (m_blockSize < chunkAlignment) ? m_blockSize : chunkAlignment;
+			}
+
+			// The chunk header lives after the blocks so the first block
+			// keeps the chunk's alignment.
+			void grow(memory_resource* upstream, brisk::size_t maxBlocks)
+			{
+				brisk::size_t blocks = (m_nextBlocks < maxBlocks) ? m_nextBlocks : maxBlocks;
+				brisk::size_t used = detail::alignUp(blocks * m_blockSize, alignof(chunk));
+				brisk::size_t size = used + sizeof(chunk);
+
+				char* memory = static_cast<char*>(upstream->allocate(size, alignment()));
+				chunk* c = reinterpret_cast<chunk*>(memory + used);
+				c->next = m_chunks;
+				c->memory = memory;
+				c->size = size;
+				m_chunks = c;
+
+				m_current = memory;
+				m_end = memory + blocks * m_blockSize;
+				m_nextBlocks = blocks << 1;
+			}
+
+			brisk::size_t m_blockSize;
+			free_block* m_free;
+			chunk* m_chunks;
+			char* m_current;
+			char* m_end;
+			brisk::size_t m_nextBlocks;
+		};
+
+		pool* find(brisk::size_t bytes, brisk::size_t alignment) noexcept
+		{
+			brisk::size_t size = (bytes < alignment) ? alignment : bytes;
+			if (size > m_options.largest_required_pool_block || alignment > chunkAlignment) {
+				return nullptr;
+			}
+
+			return &m_pools[(size <= smallest) ? 0 : std::bit_width(size - 1) - 3];
+		}
+
+		memory_resource* m_upstream;
+		pool_options m_options;
+		pool* m_pools;
+		brisk::size_t m_poolCount;
+	};
+
+	// unsynchronized_pool_resource behind a mutex.
+	class synchronized_pool_resource : public memory_resource
+	{
+	public:
+		explicit synchronized_pool_resource(memory_resource* upstream = get_default_resource())
+			: m_pools(upstream)
+		{
+
+		}
+
+		synchronized_pool_resource(const pool_options& options, memory_resource* upstream = get_default_resource())
+			: m_pools(options, upstream)
+		{
+
+		}
+
+		void release()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pools.release();
+		}
+
+		memory_resource* upstream_resource() const noexcept
+		{
+			return m_pools.upstream_resource();
+		}
+
+		pool_options options() const noexcept
+		{
+			return m_pools.options();
+		}
+
+	protected:
+		void* do_allocate(brisk::size_t bytes, brisk::size_t alignment) override
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_pools.allocate(bytes, alignment);
+		}
+
+		void do_deallocate(void* p, brisk::size_t bytes, brisk::size_t alignment) override
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pools.deallocate(p, bytes, alignment);
+		}
+
+	private:
+		std::mutex m_mutex;
+		unsynchronized_pool_resource m_pools;
+	};
+}
+
+#if defined(BRISK_DEFAULT_THREAD_CACHING) && (defined(__unix__) || defined(__APPLE__))
+#include "thread_caching_resource.hpp"
+#endif
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+#include "functional.hpp"
+#include "algorithm.hpp"
+#include "vector.hpp"
+
+namespace brisk
+{
+	// A tournament over k sorted sources that hands out their elements in
+	// order, for k-way merges. Each internal node remembers the loser of
+	// the match played there, so after the winner is popped only the path
+	// from its leaf to the root is replayed: log2(k) comparisons per
+	// element, against the 2 log2(k) of a binary heap's sift down.
+	//
+	// A source is anything with empty(), front() and pop(), and must be
+	// default constructible and movable. Equal elements come out in
+	// source order, so merging runs of a stable sort stays stable.
+	template <class Source, class Compare = brisk::less<>>
+	class loser_tree
+	{
+	public:
+		using size_type = brisk::size_t;
+		using source_type = Source;
+
+		explicit loser_tree(vector<Source> sources, Compare comp = Compare())
+			: m_sources(brisk::move(sources)), m_tree(), m_comp(comp)
+		{
+			build();
+		}
+
+		bool empty() const
+		{
+			return m_sources.empty() || m_sources[m_tree[0]].empty();
+		}
+
+		// The least element left. Undefined when empty.
+		decltype(auto) top()
+		{
+			return m_sources[m_tree[0]].front();
+		}
+
+		// Which source top() comes from.
+		size_type top_source() const noexcept
+		{
+			return m_tree[0];
+		}
+
+		void pop()
+		{
+			size_type winner = m_tree[0];
+			m_sources[winner].pop();
+			for (size_type node = (winner + m_sources.size()) / 2; node > 0; node /= 2) {
+				if (beats(m_tree[node], winner)) {
+					brisk::swap(m_tree[node], winner);
+				}
+			}
+
+			m_tree[0] = winner;
+		}
+
+		size_type size() const noexcept
+		{
+			return m_sources.size();
+		}
+
+		vector<Source>& sources() noexcept
+		{
+			return m_sources;
+		}
+
+	private:
+		// Leaves are k..2k-1 and node n plays the winners of 2n and 2n + 1,
+		// which covers every k, not just powers of two. m_tree[0] holds
+		// the overall winner.
+		void build()
+		{
+			const size_type k = m_sources.size();
+			if (k == 0) {
+				return;
+			}
+
+			vector<size_type> winners(2 * k);
+			for (size_type leaf = 0; leaf < k; ++leaf) {
+				winners.push_back(0);
+			}
+			for (size_type leaf = 0; leaf < k; ++leaf) {
+				winners.push_back(leaf);
+			}
+
+			m_tree.reserve(k);
+			for (size_type node = 0; node < k; ++node) {
+				m_tree.push_back(0);
+			}
+			for (size_type node = k - 1; node > 0; --node) {
+				size_type left = winners[2 * node];
+				size_type right = winners[2 * node + 1];
+				bool leftWins = beats(left, right);
+				winners[node] = leftWins ? left : right;
+				m_tree[node] = leftWins ? right : left;
+			}
+
+			m_tree[0] = winners[1];
+		}
+
+		// An exhausted source loses to everything; ties go to the lower
+		// index.
+		bool beats(size_type a, size_type b)
+		{
+			if (m_sources[a].empty()) {
+				return false;
+			}
+			if (m_sources[b].empty()) {
+				return true;
+			}
+			if (m_comp(m_sources[a].front(), m_sources[b].front())) {
+				return true;
+			}
+			if (m_comp(m_sources[b].front(), m_sources[a].front())) {
+				return false;
+			}
+
+			return a < b;
+		}
+
+		vector<Source> m_sources;
+		vector<size_type> m_tree;
+		Compare m_comp;
+	};
+
+	namespace detail
+	{
+		template <class Iterator>
+		struct range_source
+		{
+			Iterator current;
+			Iterator last;
+
+			bool empty() const
+			{
+				return current == last;
+			}
+
+			decltype(auto) front() const
+			{
+				return *current;
+			}
+
+			void pop()
+			{
+				++current;
+			}
+		};
+	}
+
+	// Merges every sorted range in runs (a range of ranges) into d_first,
+	// stably. Two runs go to the plain merge, more to a loser tree.
+	template <class Runs, class OutIterator, class Compare = brisk::less<>>
+	OutIterator kway_merge(Runs& runs, OutIterator d_first, Compare comp = Compare())
+	{
+		using Iterator = decltype(brisk::begin(*brisk::begin(runs)));
+		vector<detail::range_source<Iterator>> sources;
+		for (auto&& run : runs) {
+			sources.push_back(detail::range_source<Iterator>{ brisk::begin(run), brisk::end(run) });
+		}
+
+		if (sources.size() == 1) {
+			return brisk::copy(sources[0].current, sources[0].last, d_first);
+		}
+		if (sources.size() == 2) {
+			return brisk::merge(sources[0].current, sources[0].last, sources[1].current, sources[1].last, d_first, comp);
+		}
+
+		loser_tree<detail::range_source<Iterator>, Compare> tree(brisk::move(sources), comp);
+		for (; !tree.empty(); ++d_first) {
+			*d_first = tree.top();
+			tree.pop();
+		}
+
+		return d_first;
+	}
+}
@@ -0,0 +1,254 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+
+namespace brisk
+{
+	// The default way an object_pool cleans an object before reuse: call its
+	// reset() member, which should drop the contents but keep the capacity.
+	struct call_reset
+	{
+		template <class Type>
+		void operator()(Type& object) const
+		{
+			object.reset();
+		}
+	};
+
+	namespace detail
+	{
+		constexpr brisk::size_t objectPoolShards = 8;
+
+		// Threads are numbered as they first touch any object_pool, so up to
+		// objectPoolShards threads each get a sub-pool to themselves.
+		inline brisk::size_t objectPoolShard() noexcept
+		{
+			static std::atomic<brisk::size_t> next(0);
+			static thread_local brisk::size_t shard = next.fetch_add(1, std::memory_order_relaxed) % objectPoolShards;
+			return shard;
+		}
+	}
+
+	// Recycles objects instead of destroying them. acquire() hands out a
+	// handle; when the handle goes away the object is reset and put back on
+	// the releasing thread's free list, so whatever storage it owns is there
+	// for the next user. About maxIdle objects are kept across all the
+	// sub-pools (the cap is checked without a lock); past that, released
+	// objects are destroyed.
+	//
+	// The pool must outlive its handles.
+	template <class Type, class Reset = call_reset>
+	class object_pool
+	{
+	private:
+		struct slot
+		{
+			Type value;
+			slot* next;
+		};
+
+		struct alignas(64) shard
+		{
+			std::mutex m_mutex;
+			slot* m_free = nullptr;
+		};
+
+	public:
+		class handle
+		{
+		public:
+			constexpr handle() noexcept
+				: m_pool(nullptr), m_slot(nullptr)
+			{
+
+			}
+
+			handle(handle&& x) noexcept
+				: m_pool(x.m_pool), m_slot(x.m_slot)
+			{
+				x.m_slot = nullptr;
+			}
+
+			handle& operator=(handle&& x) noexcept
+			{
+				if (this != &x) {
+					reset();
+					m_pool = x.m_pool;
+					m_slot = x.m_slot;
+					x.m_slot = nullptr;
+				}
+				return *this;
+			}
+
+			handle(const handle&) = delete;
+			handle& operator=(const handle&) = delete;
+
+			~handle()
+			{
+				reset();
+			}
+
+			// Gives the object back to the pool now.
+			void reset() noexcept
+			{
+				if (m_slot != nullptr) {
+					m_pool->release(m_slot);
+					m_slot = nullptr;
+				}
+			}
+
+			Type* get() const noexcept
+			{
+				return (m_slot != nullptr) ? &m_slot->value : nullptr;
+			}
+
+			Type& operator*() const noexcept
+			{
+				return m_slot->value;
+			}
+
+			Type* operator->() const noexcept
+			{
+				return &m_slot->value;
+			}
+
+			explicit operator bool() const noexcept
+			{
+				return m_slot != nullptr;
+			}
+
+		private:
+			friend class object_pool;
+
+			handle(object_pool* pool, slot* s) noexcept
+				: m_pool(pool), m_slot(s)
+			{
+
+			}
+
+			object_pool* m_pool;
+			slot* m_slot;
+		};
+
+		explicit object_pool(brisk::size_t maxIdle = 256, Reset reset = Reset())
+			: m_maxIdle(maxIdle), m_reset(brisk::move(reset)), m_idle(0), m_created(0)
+		{
+
+		}
+
+		object_pool(const object_pool&) = delete;
+		object_pool& operator=(const object_pool&) = delete;
+
+		~object_pool()
+		{
+			for (shard& s : m_shards) {
+				while (s.m_free != nullptr) {
+					slot* next = s.m_free->next;
+					delete s.m_free;
+					s.m_free = next;
+				}
+			}
+		}
+
+		// A recycled object if any sub-pool has one, the calling thread's
+		// first, otherwise a new default-constructed one.
+		handle acquire()
+		{
+			brisk::size_t home = detail::objectPoolShard();
+			if (slot* s = pop(m_shards[home])) {
+				return handle(this, s);
+			}
+
+			if (m_idle.load(std::memory_order_relaxed) != 0) {
+				for (brisk::size_t i = 1; i < detail::objectPoolShards; ++i) {
+					if (slot* s = pop(m_shards[(home + i) % detail::objectPoolShards])) {
+						return handle(this, s);
+					}
+				}
+			}
+
+			slot* s = new slot{Type(), nullptr};
+			m_created.fetch_add(1, std::memory_order_relaxed);
+			return handle(this, s);
+		}
+
+		// Constructs objects up front, so the first acquires don't allocate.
+		void reserve(brisk::size_t count)
+		{
+			shard& home = m_shards[detail::objectPoolShard()];
+			for (brisk::size_t i = 0; i < count && m_idle.load(std::memory_order_relaxed) < m_maxIdle; ++i) {
+				slot* s = new slot{Type(), nullptr};
+				m_created.fetch_add(1, std::memory_order_relaxed);
+				push(home, s);
+			}
+		}
+
+		// Objects sitting in the free lists.
+		brisk::size_t idle() const noexcept
+		{
+			return m_idle.load(std::memory_order_relaxed);
+		}
+
+		// Objects this pool has ever constructed.
+		brisk::size_t created() const noexcept
+		{
+			return m_created.load(std::memory_order_relaxed);
+		}
+
+		brisk::size_t max_idle() const noexcept
+		{
+			return m_maxIdle;
+		}
+
+	private:
+		slot* pop(shard& s) noexcept
+		{
+			std::lock_guard<std::mutex> lock(s.m_mutex);
+			slot* head = s.m_free;
+			if (head != nullptr) {
+				s.m_free = head->next;
+				m_idle.fetch_sub(1, std::memory_order_relaxed);
+			}
+			return head;
+		}
+
+		void push(shard& s, slot* object) noexcept
+		{
+			m_idle.fetch_add(1, std::memory_order_relaxed);
+			std::lock_guard<std::mutex> lock(s.m_mutex);
+			object->next = s.m_free;
+			s.m_free = object;
+		}
+
+		void release(slot* object) noexcept
+		{
+			// an object that can't be reset, or doesn't fit under the cap,
+			// is destroyed instead of kept
+			bool keep = m_idle.load(std::memory_order_relaxed) < m_maxIdle;
+			if (keep) {
+				try {
+					m_reset(object->value);
+				} catch (...) {
+					keep = false;
+				}
+			}
+
+			if (keep) {
+				push(m_shards[detail::objectPoolShard()], object);
+			} else {
+				delete object;
+			}
+		}
+
+		shard m_shards[detail::objectPoolShards];
+		const brisk::size_t m_maxIdle;
+		Reset m_reset;
+		std::atomic<brisk::size_t> m_idle;
+		std::atomic<brisk::size_t> m_created;
+	};
+}
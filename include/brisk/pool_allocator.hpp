@@ -0,0 +1,290 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "memory.hpp"
+#include "utility.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace brisk
+{
+	// Caching policies for pool_allocator. With thread caching each thread
+	// keeps a short free list per size class and only takes the pool's lock
+	// to move a batch of blocks in or out; without it every allocation and
+	// free takes the lock.
+	struct pool_thread_cached {};
+	struct pool_uncached {};
+
+	namespace detail
+	{
+		constexpr brisk::size_t poolGranularity = 16;
+		constexpr brisk::size_t poolMaxBlock = 1024;
+		constexpr brisk::size_t poolSlabSize = 4096;
+		constexpr brisk::size_t poolBatch = 32;
+
+		constexpr brisk::size_t poolBlockSize(brisk::size_t size, brisk::size_t alignment) noexcept
+		{
+			brisk::size_t granularity = (alignment > poolGranularity) ? alignment : poolGranularity;
+			return (size + granularity - 1) / granularity * granularity;
+		}
+
+		struct pool_block
+		{
+			pool_block* next;
+		};
+
+		// The shared free list for one block size. Slabs are carved lazily and
+		// never handed back: the memory stays with the pool for reuse, which
+		// is what node-heavy structures that grow and shrink want.
+		template <brisk::size_t BlockSize>
+		class block_pool
+		{
+		public:
+			static constexpr brisk::size_t slab_size = (BlockSize * 8 > poolSlabSize) ? BlockSize * 8 : poolSlabSize;
+			// The largest power of two dividing BlockSize, 16 for 48-byte
+			// blocks: what every block in the slab ends up aligned to, and at
+			// least the alignment of any type that rounds to BlockSize.
+			static constexpr brisk::size_t slab_alignment = BlockSize & (~BlockSize + 1);
+
+			// Never destroyed, so blocks can still be freed while other
+			// statics are being torn down.
+			static block_pool& instance()
+			{
+				static block_pool* pool = new block_pool();
+				return *pool;
+			}
+
+			void* allocate()
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_free == nullptr) {
+					refill();
+				}
+
+				pool_block* block = m_free;
+				m_free = block->next;
+				return block;
+			}
+
+			void deallocate(void* p) noexcept
+			{
+				pool_block* block = static_cast<pool_block*>(p);
+				std::lock_guard<std::mutex> lock(m_mutex);
+				block->next = m_free;
+				m_free = block;
+			}
+
+			// Moves up to n blocks onto head; returns how many.
+			brisk::size_t take(pool_block*& head, brisk::size_t n)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				brisk::size_t taken = 0;
+				for (; taken < n; ++taken) {
+					if (m_free == nullptr) {
+						refill();
+					}
+
+					pool_block* block = m_free;
+					m_free = block->next;
+					block->next = head;
+					head = block;
+				}
+				return taken;
+			}
+
+			// Splices the list first..last back onto the free list.
+			void give(pool_block* first, pool_block* last) noexcept
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				last->next = m_free;
+				m_free = first;
+			}
+
+		private:
+			block_pool() noexcept
+				: m_free(nullptr)
+			{
+
+			}
+
+			void refill()
+			{
+				char* slab = static_cast<char*>(::operator new(slab_size, std::align_val_t(slab_alignment)));
+				// pushed in reverse so blocks come out in address order
+				for (brisk::size_t i = slab_size / BlockSize; i-- > 0;) {
+					pool_block* block = reinterpret_cast<pool_block*>(slab + i * BlockSize);
+					block->next = m_free;
+					m_free = block;
+				}
+			}
+
+			std::mutex m_mutex;
+			pool_block* m_free;
+		};
+
+		// One per thread and block size. Whatever is left when the thread
+		// exits goes back to the shared pool.
+		template <brisk::size_t BlockSize>
+		class block_cache
+		{
+		public:
+			static block_cache& local()
+			{
+				static thread_local block_cache cache;
+				return cache;
+			}
+
+			~block_cache()
+			{
+				if (m_head != nullptr) {
+					block_pool<BlockSize>::instance().give(m_head, tail(m_head));
+				}
+			}
+
+			void* allocate()
+			{
+				if (m_head == nullptr) {
+					m_count = block_pool<BlockSize>::instance().take(m_head, poolBatch);
+				}
+
+				pool_block* block = m_head;
+				m_head = block->next;
+				--m_count;
+				return block;
+			}
+
+			void deallocate(void* p) noexcept
+			{
+				pool_block* block = static_cast<pool_block*>(p);
+				block->next = m_head;
+				m_head = block;
+
+				// keep one batch around for the next allocations, hand the rest
+				// back so a thread that only frees doesn't hoard memory
+				if (++m_count >= 2 * poolBatch) {
+					pool_block* last = m_head;
+					for (brisk::size_t i = 1; i < poolBatch; ++i) {
+						last = last->next;
+					}
+
+					pool_block* first = m_head;
+					m_head = last->next;
+					m_count -= poolBatch;
+					block_pool<BlockSize>::instance().give(first, last);
+				}
+			}
+
+		private:
+			block_cache() noexcept
+				: m_head(nullptr), m_count(0)
+			{
+
+			}
+
+			static pool_block* tail(pool_block* head) noexcept
+			{
+				while (head->next != nullptr) {
+					head = head->next;
+				}
+				return head;
+			}
+
+			pool_block* m_head;
+			brisk::size_t m_count;
+		};
+	}
+
+	// An allocator that serves single objects from fixed-size block pools,
+	// one pool per 16-byte size class up to 1KB, shared by every
+	// pool_allocator whose type rounds to that class. Arrays and bigger
+	// objects fall back to ::operator new.
+	template <class Type, class Caching = pool_thread_cached>
+	class pool_allocator
+	{
+	public:
+		using value_type = Type;
+		using size_type = brisk::size_t;
+		using difference_type = brisk::ptrdiff_t;
+		using is_always_equal = std::true_type;
+
+		template <class Other>
+		struct rebind
+		{
+			using other = pool_allocator<Other, Caching>;
+		};
+
+		static constexpr brisk::size_t block_size = detail::poolBlockSize(sizeof(Type), alignof(Type));
+		static constexpr bool pooled = block_size <= detail::poolMaxBlock && alignof(Type) <= detail::poolSlabSize;
+
+		constexpr pool_allocator() noexcept = default;
+
+		template <class Other>
+		constexpr pool_allocator(const pool_allocator<Other, Caching>&) noexcept
+		{
+
+		}
+
+		Type* allocate(brisk::size_t n)
+		{
+			if constexpr (pooled) {
+				if (n == 1) {
+					if constexpr (std::is_same_v<Caching, pool_thread_cached>) {
+						return static_cast<Type*>(detail::block_cache<block_size>::local().allocate());
+					} else {
+						return static_cast<Type*>(detail::block_pool<block_size>::instance().allocate());
+					}
+				}
+			}
+
+			return static_cast<Type*>(::operator new(n * sizeof(Type), std::align_val_t(alignof(Type))));
+		}
+
+		void deallocate(Type* p, brisk::size_t n) noexcept
+		{
+			if constexpr (pooled) {
+				if (n == 1) {
+					if constexpr (std::is_same_v<Caching, pool_thread_cached>) {
+						detail::block_cache<block_size>::local().deallocate(p);
+					} else {
+						detail::block_pool<block_size>::instance().deallocate(p);
+					}
+					return;
+				}
+			}
+
+			::operator delete(p, n * sizeof(Type), std::align_val_t(alignof(Type)));
+		}
+	};
+
+	template <class Type1, class Type2, class Caching>
+	constexpr bool operator==(const pool_allocator<Type1, Caching>&, const pool_allocator<Type2, Caching>&) noexcept
+	{
+		return true;
+	}
+
+	template <class Type1, class Type2, class Caching>
+	constexpr bool operator!=(const pool_allocator<Type1, Caching>&, const pool_allocator<Type2, Caching>&) noexcept
+	{
+		return false;
+	}
+
+	template <class Type>
+	using pooled_unique_ptr = allocated_unique_ptr<Type, pool_allocator<Type>>;
+
+	// make_unique and make_shared drawing from the block pools. The shared
+	// version pools the control block and object together.
+	template <class Type, class... Args>
+	pooled_unique_ptr<Type> make_pooled_unique(Args&&... args)
+	{
+		return brisk::allocate_unique<Type>(pool_allocator<Type>(), brisk::forward<Args>(args)...);
+	}
+
+	template <class Type, class... Args>
+	shared_ptr<Type> make_pooled_shared(Args&&... args)
+	{
+		return brisk::allocate_shared<Type>(pool_allocator<Type>(), brisk::forward<Args>(args)...);
+	}
+}
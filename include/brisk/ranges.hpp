@@ -0,0 +1,1065 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+#include "algorithm.hpp"
+
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+
+namespace brisk
+{
+	// Lazy views that plug into C++20 ranges. Each one is a
+	// std::ranges::view over any forward range, brisk containers included,
+	// and they chain with |:
+	//
+	//     auto evens = v | views::filter(isEven) | views::transform(square);
+	//     long long sum = brisk::accumulate(evens, 0ll);
+	//
+	// Nothing runs until the result is iterated. The iterators are thin
+	// wrappers around the underlying container's, so once inlined a whole
+	// pipeline is one loop over the source with no intermediate storage.
+	// to<Container>() collects a pipeline, reserving the exact size when
+	// the view knows it.
+	//
+	// As with std::ranges, a view refers to (or owns, for an rvalue) the
+	// range it was built over and must outlive its iterators.
+	namespace detail
+	{
+		// Keeps a function object a view can be assigned with even when the
+		// function object itself can't be, as with capturing lambdas.
+		template <class T>
+		class movable_box
+		{
+		public:
+			movable_box() = default;
+
+			explicit movable_box(T value)
+				: m_value(brisk::move(value))
+			{
+
+			}
+
+			movable_box(const movable_box&) = default;
+			movable_box(movable_box&&) = default;
+
+			movable_box& operator=(const movable_box& other)
+			{
+				if (this != &other) {
+					m_value.reset();
+					if (other.m_value) {
+						m_value.emplace(*other.m_value);
+					}
+				}
+
+				return *this;
+			}
+
+			movable_box& operator=(movable_box&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+			{
+				if (this != &other) {
+					m_value.reset();
+					if (other.m_value) {
+						m_value.emplace(brisk::move(*other.m_value));
+					}
+				}
+
+				return *this;
+			}
+
+			T& operator*() noexcept { return *m_value; }
+			const T& operator*() const noexcept { return *m_value; }
+
+		private:
+			std::optional<T> m_value;
+		};
+
+		// Something a view works out on first use and keeps, like the first
+		// match of a filter. It usually points into the view's own base, so
+		// a copy or a move starts without it rather than keep an iterator
+		// into the view it came from, as std::ranges' non-propagating cache
+		// does.
+		template <class T>
+		class non_propagating_cache
+		{
+		public:
+			non_propagating_cache() = default;
+
+			non_propagating_cache(const non_propagating_cache&) noexcept
+			{
+
+			}
+
+			non_propagating_cache(non_propagating_cache&& other) noexcept
+			{
+				other.m_value.reset();
+			}
+
+			non_propagating_cache& operator=(const non_propagating_cache& other) noexcept
+			{
+				if (this != &other) {
+					m_value.reset();
+				}
+
+				return *this;
+			}
+
+			non_propagating_cache& operator=(non_propagating_cache&& other) noexcept
+			{
+				m_value.reset();
+				other.m_value.reset();
+				return *this;
+			}
+
+			explicit operator bool() const noexcept { return m_value.has_value(); }
+			T& operator*() noexcept { return *m_value; }
+
+			template <class... Args>
+			T& emplace(Args&&... args)
+			{
+				return m_value.emplace(brisk::forward<Args>(args)...);
+			}
+
+		private:
+			std::optional<T> m_value;
+		};
+
+		// The strongest iterator category every one of the ranges supports,
+		// stopping at forward.
+		template <class... Ranges>
+		using iterator_concept_t = std::conditional_t<(std::ranges::random_access_range<Ranges> && ...), std::random_access_iterator_tag,
+			std::conditional_t<(std::ranges::bidirectional_range<Ranges> && ...), std::bidirectional_iterator_tag, std::forward_iterator_tag>>;
+
+		// The end of a view whose underlying range ends in a sentinel
+		// rather than an iterator.
+		template <class Sentinel>
+		struct end_of
+		{
+			Sentinel m_end;
+		};
+
+		// The right-hand side of a |. Calling it with a range applies the
+		// adaptor; two of them piped together make a third.
+		template <class Function>
+		struct range_closure
+		{
+			Function m_function;
+
+			template <class Range>
+			constexpr auto operator()(Range&& range) const
+			{
+				return m_function(brisk::forward<Range>(range));
+			}
+		};
+
+		template <class Function>
+		constexpr range_closure<Function> makeClosure(Function function)
+		{
+			return range_closure<Function>{ brisk::move(function) };
+		}
+
+		template <class Range, class Function>
+			requires std::ranges::range<Range>
+		constexpr auto operator|(Range&& range, const range_closure<Function>& closure)
+		{
+			return closure(brisk::forward<Range>(range));
+		}
+
+		template <class First, class Second>
+		constexpr auto operator|(const range_closure<First>& first, const range_closure<Second>& second)
+		{
+			return makeClosure([first, second]<class Range>(Range&& range) { return second(first(brisk::forward<Range>(range))); });
+		}
+	}
+
+	namespace ranges
+	{
+		template <std::integral W, class Bound = std::unreachable_sentinel_t>
+		class iota_view : public std::ranges::view_interface<iota_view<W, Bound>>
+		{
+		public:
+			class iterator
+			{
+			public:
+				using iterator_concept = std::random_access_iterator_tag;
+				using iterator_category = std::input_iterator_tag;
+				using value_type = W;
+				using difference_type = std::make_signed_t<std::common_type_t<W, brisk::ptrdiff_t>>;
+
+				iterator() = default;
+
+				constexpr explicit iterator(W value) noexcept
+					: m_value(value)
+				{
+
+				}
+
+				constexpr W operator*() const noexcept { return m_value; }
+				constexpr W operator[](difference_type n) const noexcept { return static_cast<W>(m_value + n); }
+
+				constexpr iterator& operator++() noexcept { ++m_value; return *this; }
+				constexpr iterator operator++(int) noexcept { iterator it = *this; ++m_value; return it; }
+				constexpr iterator& operator--() noexcept { --m_value; return *this; }
+				constexpr iterator operator--(int) noexcept { iterator it = *this; --m_value; return it; }
+				constexpr iterator& operator+=(difference_type n) noexcept { m_value = static_cast<W>(m_value + n); return *this; }
+				constexpr iterator& operator-=(difference_type n) noexcept { m_value = static_cast<W>(m_value - n); return *this; }
+
+				friend constexpr iterator operator+(iterator it, difference_type n) noexcept { return it += n; }
+				friend constexpr iterator operator+(difference_type n, iterator it) noexcept { return it += n; }
+				friend constexpr iterator operator-(iterator it, difference_type n) noexcept { return it -= n; }
+
+				friend constexpr difference_type operator-(const iterator& a, const iterator& b) noexcept
+				{
+					return (a.m_value >= b.m_value) ? static_cast<difference_type>(a.m_value - b.m_value) : -static_cast<difference_type>(b.m_value - a.m_value);
+				}
+
+				friend constexpr bool operator==(const iterator& a, const iterator& b) noexcept = default;
+				friend constexpr auto operator<=>(const iterator& a, const iterator& b) noexcept = default;
+
+			private:
+				W m_value = W();
+			};
+
+			iota_view() = default;
+
+			constexpr explicit iota_view(W value)
+				: m_value(value), m_bound()
+			{
+
+			}
+
+			constexpr iota_view(W value, Bound bound)
+				: m_value(value), m_bound(bound)
+			{
+
+			}
+
+			constexpr iterator begin() const noexcept
+			{
+				return iterator(m_value);
+			}
+
+			constexpr auto end() const noexcept
+			{
+				if constexpr (std::is_same_v<W, Bound>)
+					return iterator(m_bound);
+				else
+					return std::unreachable_sentinel;
+			}
+
+			constexpr auto size() const noexcept requires std::is_same_v<W, Bound>
+			{
+				return static_cast<std::make_unsigned_t<W>>(m_bound - m_value);
+			}
+
+		private:
+			W m_value = W();
+			Bound m_bound = Bound();
+		};
+
+		template <std::ranges::forward_range V, class F>
+			requires std::ranges::view<V>
+		class transform_view : public std::ranges::view_interface<transform_view<V, F>>
+		{
+		public:
+			class iterator
+			{
+			public:
+				using iterator_concept = detail::iterator_concept_t<V>;
+				using iterator_category = std::input_iterator_tag;
+				using value_type = std::remove_cvref_t<std::invoke_result_t<F&, std::ranges::range_reference_t<V>>>;
+				using difference_type = std::ranges::range_difference_t<V>;
+
+				iterator() = default;
+
+				constexpr iterator(transform_view& parent, std::ranges::iterator_t<V> current)
+					: m_parent(&parent), m_current(brisk::move(current))
+				{
+
+				}
+
+				constexpr decltype(auto) operator*() const { return std::invoke(*m_parent->m_function, *m_current); }
+				constexpr decltype(auto) operator[](difference_type n) const requires std::ranges::random_access_range<V> { return std::invoke(*m_parent->m_function, m_current[n]); }
+
+				constexpr iterator& operator++() { ++m_current; return *this; }
+				constexpr iterator operator++(int) { iterator it = *this; ++m_current; return it; }
+				constexpr iterator& operator--() requires std::ranges::bidirectional_range<V> { --m_current; return *this; }
+				constexpr iterator operator--(int) requires std::ranges::bidirectional_range<V> { iterator it = *this; --m_current; return it; }
+				constexpr iterator& operator+=(difference_type n) requires std::ranges::random_access_range<V> { m_current += n; return *this; }
+				constexpr iterator& operator-=(difference_type n) requires std::ranges::random_access_range<V> { m_current -= n; return *this; }
+
+				friend constexpr iterator operator+(iterator it, difference_type n) requires std::ranges::random_access_range<V> { return it += n; }
+				friend constexpr iterator operator+(difference_type n, iterator it) requires std::ranges::random_access_range<V> { return it += n; }
+				friend constexpr iterator operator-(iterator it, difference_type n) requires std::ranges::random_access_range<V> { return it -= n; }
+				friend constexpr difference_type operator-(const iterator& a, const iterator& b) requires std::ranges::random_access_range<V> { return a.m_current - b.m_current; }
+
+				friend constexpr bool operator==(const iterator& a, const iterator& b) { return a.m_current == b.m_current; }
+				friend constexpr auto operator<=>(const iterator& a, const iterator& b) requires std::ranges::random_access_range<V> { return a.m_current <=> b.m_current; }
+
+				template <class Sentinel>
+				friend constexpr bool operator==(const iterator& it, const detail::end_of<Sentinel>& end) { return it.m_current == end.m_end; }
+
+				constexpr const std::ranges::iterator_t<V>& base() const noexcept { return m_current; }
+
+			private:
+				transform_view* m_parent = nullptr;
+				std::ranges::iterator_t<V> m_current = std::ranges::iterator_t<V>();
+			};
+
+			transform_view() = default;
+
+			constexpr transform_view(V base, F function)
+				: m_base(brisk::move(base)), m_function(brisk::move(function))
+			{
+
+			}
+
+			constexpr iterator begin()
+			{
+				return iterator(*this, std::ranges::begin(m_base));
+			}
+
+			constexpr auto end()
+			{
+				if constexpr (std::ranges::common_range<V>)
+					return iterator(*this, std::ranges::end(m_base));
+				else
+					return detail::end_of<std::ranges::sentinel_t<V>>{ std::ranges::end(m_base) };
+			}
+
+			constexpr auto size() requires std::ranges::sized_range<V>
+			{
+				return std::ranges::size(m_base);
+			}
+
+			constexpr V base() const { return m_base; }
+
+		private:
+			V m_base = V();
+			detail::movable_box<F> m_function;
+		};
+
+		// Finds the first match once, the first time it's asked for, as
+		// std::ranges::filter_view does; iterating again starts from there.
+		template <std::ranges::forward_range V, class Predicate>
+			requires std::ranges::view<V>
+		class filter_view : public std::ranges::view_interface<filter_view<V, Predicate>>
+		{
+		public:
+			class iterator
+			{
+			public:
+				using iterator_concept = std::forward_iterator_tag;
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = std::ranges::range_value_t<V>;
+				using difference_type = std::ranges::range_difference_t<V>;
+
+				iterator() = default;
+
+				constexpr iterator(filter_view& parent, std::ranges::iterator_t<V> current)
+					: m_parent(&parent), m_current(brisk::move(current))
+				{
+
+				}
+
+				constexpr std::ranges::range_reference_t<V> operator*() const { return *m_current; }
+
+				constexpr iterator& operator++()
+				{
+					m_current = m_parent->next(++m_current);
+					return *this;
+				}
+
+				constexpr iterator operator++(int) { iterator it = *this; ++*this; return it; }
+
+				friend constexpr bool operator==(const iterator& a, const iterator& b) { return a.m_current == b.m_current; }
+
+				template <class Sentinel>
+				friend constexpr bool operator==(const iterator& it, const detail::end_of<Sentinel>& end) { return it.m_current == end.m_end; }
+
+				constexpr const std::ranges::iterator_t<V>& base() const noexcept { return m_current; }
+
+			private:
+				filter_view* m_parent = nullptr;
+				std::ranges::iterator_t<V> m_current = std::ranges::iterator_t<V>();
+			};
+
+			filter_view() = default;
+
+			constexpr filter_view(V base, Predicate predicate)
+				: m_base(brisk::move(base)), m_predicate(brisk::move(predicate))
+			{
+
+			}
+
+			constexpr iterator begin()
+			{
+				if (!m_begin) {
+					m_begin.emplace(next(std::ranges::begin(m_base)));
+				}
+
+				return iterator(*this, *m_begin);
+			}
+
+			constexpr auto end()
+			{
+				if constexpr (std::ranges::common_range<V>)
+					return iterator(*this, std::ranges::end(m_base));
+				else
+					return detail::end_of<std::ranges::sentinel_t<V>>{ std::ranges::end(m_base) };
+			}
+
+			constexpr V base() const { return m_base; }
+
+		private:
+			// The first element from it on that satisfies the predicate.
+			constexpr std::ranges::iterator_t<V> next(std::ranges::iterator_t<V> it)
+			{
+				std::ranges::sentinel_t<V> last = std::ranges::end(m_base);
+				while (it != last && !std::invoke(*m_predicate, *it)) {
+					++it;
+				}
+
+				return it;
+			}
+
+			V m_base = V();
+			detail::movable_box<Predicate> m_predicate;
+			detail::non_propagating_cache<std::ranges::iterator_t<V>> m_begin;
+		};
+
+		// Over a sized random-access range the first count elements are just
+		// a shorter range of the same iterators; anything else counts down
+		// with std::counted_iterator.
+		template <std::ranges::forward_range V>
+			requires std::ranges::view<V>
+		class take_view : public std::ranges::view_interface<take_view<V>>
+		{
+		private:
+			static constexpr bool simple = std::ranges::sized_range<V> && std::ranges::random_access_range<V>;
+
+			template <class Sentinel>
+			struct sentinel
+			{
+				Sentinel m_end;
+
+				friend constexpr bool operator==(const std::counted_iterator<std::ranges::iterator_t<V>>& it, const sentinel& end)
+				{
+					return it.count() == 0 || it.base() == end.m_end;
+				}
+			};
+
+		public:
+			using difference_type = std::ranges::range_difference_t<V>;
+
+			take_view() = default;
+
+			constexpr take_view(V base, difference_type count)
+				: m_base(brisk::move(base)), m_count(count)
+			{
+
+			}
+
+			constexpr auto begin()
+			{
+				if constexpr (simple)
+					return std::ranges::begin(m_base);
+				else
+					return std::counted_iterator(std::ranges::begin(m_base), m_count);
+			}
+
+			constexpr auto end()
+			{
+				if constexpr (simple)
+					return std::ranges::begin(m_base) + static_cast<difference_type>(size());
+				else
+					return sentinel<std::ranges::sentinel_t<V>>{ std::ranges::end(m_base) };
+			}
+
+			constexpr auto size() requires std::ranges::sized_range<V>
+			{
+				auto n = std::ranges::size(m_base);
+				using size_type = decltype(n);
+				return (static_cast<size_type>(m_count) < n) ? static_cast<size_type>(m_count) : n;
+			}
+
+			constexpr V base() const { return m_base; }
+
+		private:
+			V m_base = V();
+			difference_type m_count = 0;
+		};
+
+		template <std::ranges::forward_range V>
+			requires std::ranges::view<V>
+		class drop_view : public std::ranges::view_interface<drop_view<V>>
+		{
+		public:
+			using difference_type = std::ranges::range_difference_t<V>;
+
+			drop_view() = default;
+
+			constexpr drop_view(V base, difference_type count)
+				: m_base(brisk::move(base)), m_count(count)
+			{
+
+			}
+
+			constexpr auto begin()
+			{
+				return std::ranges::next(std::ranges::begin(m_base), m_count, std::ranges::end(m_base));
+			}
+
+			constexpr auto end()
+			{
+				return std::ranges::end(m_base);
+			}
+
+			constexpr auto size() requires std::ranges::sized_range<V>
+			{
+				auto n = std::ranges::size(m_base);
+				using size_type = decltype(n);
+				return (static_cast<size_type>(m_count) < n) ? n - static_cast<size_type>(m_count) : size_type(0);
+			}
+
+			constexpr V base() const { return m_base; }
+
+		private:
+			V m_base = V();
+			difference_type m_count = 0;
+		};
+
+		// Element i of every range together, as a tuple of references, for
+		// as long as the shortest one lasts.
+		template <std::ranges::forward_range... Vs>
+			requires (sizeof...(Vs) > 0) && (std::ranges::view<Vs> && ...)
+		class zip_view : public std::ranges::view_interface<zip_view<Vs...>>
+		{
+		private:
+			static constexpr bool randomAccess = (std::ranges::random_access_range<Vs> && ...);
+			static constexpr bool sized = (std::ranges::sized_range<Vs> && ...);
+
+		public:
+			class iterator
+			{
+			public:
+				using iterator_concept = detail::iterator_concept_t<Vs...>;
+				using iterator_category = std::input_iterator_tag;
+				using value_type = std::tuple<std::ranges::range_value_t<Vs>...>;
+				using difference_type = std::common_type_t<std::ranges::range_difference_t<Vs>...>;
+
+				iterator() = default;
+
+				constexpr explicit iterator(std::tuple<std::ranges::iterator_t<Vs>...> current)
+					: m_current(brisk::move(current))
+				{
+
+				}
+
+				constexpr std::tuple<std::ranges::range_reference_t<Vs>...> operator*() const
+				{
+					return std::apply([](const auto&... it) { return std::tuple<std::ranges::range_reference_t<Vs>...>(*it...); }, m_current);
+				}
+
+				constexpr std::tuple<std::ranges::range_reference_t<Vs>...> operator[](difference_type n) const requires randomAccess
+				{
+					return *(*this + n);
+				}
+
+				constexpr iterator& operator++() { std::apply([](auto&... it) { (++it, ...); }, m_current); return *this; }
+				constexpr iterator operator++(int) { iterator it = *this; ++*this; return it; }
+				constexpr iterator& operator--() requires (std::ranges::bidirectional_range<Vs> && ...) { std::apply([](auto&... it) { (--it, ...); }, m_current); return *this; }
+				constexpr iterator operator--(int) requires (std::ranges::bidirectional_range<Vs> && ...) { iterator it = *this; --*this; return it; }
+				constexpr iterator& operator+=(difference_type n) requires randomAccess { std::apply([n](auto&... it) { ((it += n), ...); }, m_current); return *this; }
+				constexpr iterator& operator-=(difference_type n) requires randomAccess { std::apply([n](auto&... it) { ((it -= n), ...); }, m_current); return *this; }
+
+				friend constexpr iterator operator+(iterator it, difference_type n) requires randomAccess { return it += n; }
+				friend constexpr iterator operator+(difference_type n, iterator it) requires randomAccess { return it += n; }
+				friend constexpr iterator operator-(iterator it, difference_type n) requires randomAccess { return it -= n; }
+				friend constexpr difference_type operator-(const iterator& a, const iterator& b) requires randomAccess { return std::get<0>(a.m_current) - std::get<0>(b.m_current); }
+
+				// Any position in common means both are at the end of the
+				// shortest range, which is the only way iterators over
+				// ranges of different lengths can meet.
+				friend constexpr bool operator==(const iterator& a, const iterator& b)
+				{
+					return anyEqual(a.m_current, b.m_current, std::index_sequence_for<Vs...>());
+				}
+
+				friend constexpr auto operator<=>(const iterator& a, const iterator& b) requires randomAccess
+				{
+					return std::get<0>(a.m_current) <=> std::get<0>(b.m_current);
+				}
+
+				template <class Sentinels>
+				friend constexpr bool operator==(const iterator& it, const detail::end_of<Sentinels>& end)
+				{
+					return anyEqual(it.m_current, end.m_end, std::index_sequence_for<Vs...>());
+				}
+
+			private:
+				template <class Tuple, class Tuple2, brisk::size_t... I>
+				static constexpr bool anyEqual(const Tuple& a, const Tuple2& b, std::index_sequence<I...>)
+				{
+					return ((std::get<I>(a) == std::get<I>(b)) || ...);
+				}
+
+				std::tuple<std::ranges::iterator_t<Vs>...> m_current;
+			};
+
+			zip_view() = default;
+
+			constexpr explicit zip_view(Vs... bases)
+				: m_bases(brisk::move(bases)...)
+			{
+
+			}
+
+			constexpr iterator begin()
+			{
+				return iterator(std::apply([](auto&... base) { return std::tuple<std::ranges::iterator_t<Vs>...>(std::ranges::begin(base)...); }, m_bases));
+			}
+
+			constexpr auto end()
+			{
+				if constexpr (randomAccess && sized)
+					return begin() + static_cast<typename iterator::difference_type>(size());
+				else
+					return detail::end_of<std::tuple<std::ranges::sentinel_t<Vs>...>>{
+						std::apply([](auto&... base) { return std::tuple<std::ranges::sentinel_t<Vs>...>(std::ranges::end(base)...); }, m_bases) };
+			}
+
+			constexpr auto size() requires sized
+			{
+				return std::apply([](auto&... base) {
+					using size_type = std::make_unsigned_t<std::common_type_t<std::ranges::range_size_t<Vs>...>>;
+					size_type n = std::numeric_limits<size_type>::max();
+					((n = (static_cast<size_type>(std::ranges::size(base)) < n) ? static_cast<size_type>(std::ranges::size(base)) : n), ...);
+					return n;
+				}, m_bases);
+			}
+
+		private:
+			std::tuple<Vs...> m_bases;
+		};
+
+		// Each element with its position, as a (index, reference) tuple.
+		template <std::ranges::forward_range V>
+			requires std::ranges::view<V>
+		class enumerate_view : public std::ranges::view_interface<enumerate_view<V>>
+		{
+		public:
+			class iterator
+			{
+			public:
+				using iterator_concept = detail::iterator_concept_t<V>;
+				using iterator_category = std::input_iterator_tag;
+				using difference_type = std::ranges::range_difference_t<V>;
+				using value_type = std::tuple<difference_type, std::ranges::range_value_t<V>>;
+				using reference = std::tuple<difference_type, std::ranges::range_reference_t<V>>;
+
+				iterator() = default;
+
+				constexpr iterator(std::ranges::iterator_t<V> current, difference_type index)
+					: m_current(brisk::move(current)), m_index(index)
+				{
+
+				}
+
+				constexpr reference operator*() const { return reference(m_index, *m_current); }
+				constexpr reference operator[](difference_type n) const requires std::ranges::random_access_range<V> { return reference(m_index + n, m_current[n]); }
+
+				constexpr iterator& operator++() { ++m_current; ++m_index; return *this; }
+				constexpr iterator operator++(int) { iterator it = *this; ++*this; return it; }
+				constexpr iterator& operator--() requires std::ranges::bidirectional_range<V> { --m_current; --m_index; return *this; }
+				constexpr iterator operator--(int) requires std::ranges::bidirectional_range<V> { iterator it = *this; --*this; return it; }
+				constexpr iterator& operator+=(difference_type n) requires std::ranges::random_access_range<V> { m_current += n; m_index += n; return *this; }
+				constexpr iterator& operator-=(difference_type n) requires std::ranges::random_access_range<V> { m_current -= n; m_index -= n; return *this; }
+
+				friend constexpr iterator operator+(iterator it, difference_type n) requires std::ranges::random_access_range<V> { return it += n; }
+				friend constexpr iterator operator+(difference_type n, iterator it) requires std::ranges::random_access_range<V> { return it += n; }
+				friend constexpr iterator operator-(iterator it, difference_type n) requires std::ranges::random_access_range<V> { return it -= n; }
+				friend constexpr difference_type operator-(const iterator& a, const iterator& b) requires std::ranges::random_access_range<V> { return a.m_current - b.m_current; }
+
+				friend constexpr bool operator==(const iterator& a, const iterator& b) { return a.m_current == b.m_current; }
+				friend constexpr auto operator<=>(const iterator& a, const iterator& b) requires std::ranges::random_access_range<V> { return a.m_current <=> b.m_current; }
+
+				template <class Sentinel>
+				friend constexpr bool operator==(const iterator& it, const detail::end_of<Sentinel>& end) { return it.m_current == end.m_end; }
+
+				constexpr const std::ranges::iterator_t<V>& base() const noexcept { return m_current; }
+
+			private:
+				std::ranges::iterator_t<V> m_current = std::ranges::iterator_t<V>();
+				difference_type m_index = 0;
+			};
+
+			enumerate_view() = default;
+
+			constexpr explicit enumerate_view(V base)
+				: m_base(brisk::move(base))
+			{
+
+			}
+
+			constexpr iterator begin()
+			{
+				return iterator(std::ranges::begin(m_base), 0);
+			}
+
+			constexpr auto end()
+			{
+				if constexpr (std::ranges::common_range<V> && std::ranges::sized_range<V>)
+					return iterator(std::ranges::end(m_base), static_cast<typename iterator::difference_type>(std::ranges::size(m_base)));
+				else
+					return detail::end_of<std::ranges::sentinel_t<V>>{ std::ranges::end(m_base) };
+			}
+
+			constexpr auto size() requires std::ranges::sized_range<V>
+			{
+				return std::ranges::size(m_base);
+			}
+
+			constexpr V base() const { return m_base; }
+
+		private:
+			V m_base = V();
+		};
+
+		// Every step-th element, starting with the first.
+		template <std::ranges::forward_range V>
+			requires std::ranges::view<V>
+		class stride_view : public std::ranges::view_interface<stride_view<V>>
+		{
+		public:
+			using difference_type = std::ranges::range_difference_t<V>;
+
+			class iterator
+			{
+			public:
+				using iterator_concept = std::forward_iterator_tag;
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = std::ranges::range_value_t<V>;
+				using difference_type = std::ranges::range_difference_t<V>;
+
+				iterator() = default;
+
+				constexpr iterator(std::ranges::iterator_t<V> current, std::ranges::sentinel_t<V> end, difference_type step)
+					: m_current(brisk::move(current)), m_end(brisk::move(end)), m_step(step)
+				{
+
+				}
+
+				constexpr std::ranges::range_reference_t<V> operator*() const { return *m_current; }
+
+				constexpr iterator& operator++()
+				{
+					std::ranges::advance(m_current, m_step, m_end);
+					return *this;
+				}
+
+				constexpr iterator operator++(int) { iterator it = *this; ++*this; return it; }
+
+				friend constexpr bool operator==(const iterator& a, const iterator& b) { return a.m_current == b.m_current; }
+				friend constexpr bool operator==(const iterator& it, std::default_sentinel_t) { return it.m_current == it.m_end; }
+
+			private:
+				std::ranges::iterator_t<V> m_current = std::ranges::iterator_t<V>();
+				std::ranges::sentinel_t<V> m_end = std::ranges::sentinel_t<V>();
+				difference_type m_step = 1;
+			};
+
+			stride_view() = default;
+
+			constexpr stride_view(V base, difference_type step)
+				: m_base(brisk::move(base)), m_step(step)
+			{
+				if (step <= 0) {
+					throw std::invalid_argument("[brisk::views::stride][Exception]: Step must be positive");
+				}
+			}
+
+			constexpr iterator begin()
+			{
+				return iterator(std::ranges::begin(m_base), std::ranges::end(m_base), m_step);
+			}
+
+			constexpr std::default_sentinel_t end() const noexcept
+			{
+				return std::default_sentinel;
+			}
+
+			constexpr auto size() requires std::ranges::sized_range<V>
+			{
+				auto n = std::ranges::size(m_base);
+				using size_type = decltype(n);
+				return (n + static_cast<size_type>(m_step) - 1) / static_cast<size_type>(m_step);
+			}
+
+			constexpr V base() const { return m_base; }
+
+		private:
+			V m_base = V();
+			difference_type m_step = 1;
+		};
+
+		// Consecutive runs of size elements, as subranges of the underlying
+		// range; the last one may be shorter.
+		template <std::ranges::forward_range V>
+			requires std::ranges::view<V>
+		class chunk_view : public std::ranges::view_interface<chunk_view<V>>
+		{
+		public:
+			using difference_type = std::ranges::range_difference_t<V>;
+
+			class iterator
+			{
+			public:
+				using iterator_concept = std::forward_iterator_tag;
+				using iterator_category = std::input_iterator_tag;
+				using value_type = std::ranges::subrange<std::ranges::iterator_t<V>>;
+				using difference_type = std::ranges::range_difference_t<V>;
+
+				iterator() = default;
+
+				constexpr iterator(std::ranges::iterator_t<V> current, std::ranges::sentinel_t<V> end, difference_type size)
+					: m_current(brisk::move(current)), m_end(brisk::move(end)), m_size(size)
+				{
+
+				}
+
+				constexpr value_type operator*() const
+				{
+					return value_type(m_current, std::ranges::next(m_current, m_size, m_end));
+				}
+
+				constexpr iterator& operator++()
+				{
+					std::ranges::advance(m_current, m_size, m_end);
+					return *this;
+				}
+
+				constexpr iterator operator++(int) { iterator it = *this; ++*this; return it; }
+
+				friend constexpr bool operator==(const iterator& a, const iterator& b) { return a.m_current == b.m_current; }
+				friend constexpr bool operator==(const iterator& it, std::default_sentinel_t) { return it.m_current == it.m_end; }
+
+			private:
+				std::ranges::iterator_t<V> m_current = std::ranges::iterator_t<V>();
+				std::ranges::sentinel_t<V> m_end = std::ranges::sentinel_t<V>();
+				difference_type m_size = 1;
+			};
+
+			chunk_view() = default;
+
+			constexpr chunk_view(V base, difference_type size)
+				: m_base(brisk::move(base)), m_size(size)
+			{
+				if (size <= 0) {
+					throw std::invalid_argument("[brisk::views::chunk][Exception]: Chunk size must be positive");
+				}
+			}
+
+			constexpr iterator begin()
+			{
+				return iterator(std::ranges::begin(m_base), std::ranges::end(m_base), m_size);
+			}
+
+			constexpr std::default_sentinel_t end() const noexcept
+			{
+				return std::default_sentinel;
+			}
+
+			constexpr auto size() requires std::ranges::sized_range<V>
+			{
+				auto n = std::ranges::size(m_base);
+				using size_type = decltype(n);
+				return (n + static_cast<size_type>(m_size) - 1) / static_cast<size_type>(m_size);
+			}
+
+			constexpr V base() const { return m_base; }
+
+		private:
+			V m_base = V();
+			difference_type m_size = 1;
+		};
+	}
+
+	namespace views
+	{
+		template <class Range>
+		using all_t = std::views::all_t<Range>;
+
+		namespace detail
+		{
+			struct iota_fn
+			{
+				template <std::integral W>
+				constexpr auto operator()(W value) const
+				{
+					return ranges::iota_view<W>(value);
+				}
+
+				template <std::integral W, std::integral Bound>
+				constexpr auto operator()(W value, Bound bound) const
+				{
+					return ranges::iota_view<W, W>(value, static_cast<W>(bound));
+				}
+			};
+
+			struct transform_fn
+			{
+				template <std::ranges::viewable_range Range, class F>
+				constexpr auto operator()(Range&& range, F function) const
+				{
+					return ranges::transform_view<all_t<Range>, F>(std::views::all(brisk::forward<Range>(range)), brisk::move(function));
+				}
+
+				template <class F>
+				constexpr auto operator()(F function) const
+				{
+					return brisk::detail::makeClosure([function]<class Range>(Range&& range) { return transform_fn()(brisk::forward<Range>(range), function); });
+				}
+			};
+
+			struct filter_fn
+			{
+				template <std::ranges::viewable_range Range, class Predicate>
+				constexpr auto operator()(Range&& range, Predicate predicate) const
+				{
+					return ranges::filter_view<all_t<Range>, Predicate>(std::views::all(brisk::forward<Range>(range)), brisk::move(predicate));
+				}
+
+				template <class Predicate>
+				constexpr auto operator()(Predicate predicate) const
+				{
+					return brisk::detail::makeClosure([predicate]<class Range>(Range&& range) { return filter_fn()(brisk::forward<Range>(range), predicate); });
+				}
+			};
+
+			// Shared by the adaptors that take a count: take, drop, stride
+			// and chunk.
+			template <template <class> class View>
+			struct counted_fn
+			{
+				template <std::ranges::viewable_range Range>
+				constexpr auto operator()(Range&& range, std::ranges::range_difference_t<Range> count) const
+				{
+					return View<all_t<Range>>(std::views::all(brisk::forward<Range>(range)), count);
+				}
+
+				template <std::integral Count>
+				constexpr auto operator()(Count count) const
+				{
+					return brisk::detail::makeClosure([count]<class Range>(Range&& range) {
+						return counted_fn()(brisk::forward<Range>(range), static_cast<std::ranges::range_difference_t<Range>>(count));
+					});
+				}
+			};
+
+			struct zip_fn
+			{
+				template <std::ranges::viewable_range... Ranges>
+				constexpr auto operator()(Ranges&&... ranges) const
+				{
+					return ranges::zip_view<all_t<Ranges>...>(std::views::all(brisk::forward<Ranges>(ranges))...);
+				}
+			};
+
+			struct enumerate_fn
+			{
+				template <std::ranges::viewable_range Range>
+				constexpr auto operator()(Range&& range) const
+				{
+					return ranges::enumerate_view<all_t<Range>>(std::views::all(brisk::forward<Range>(range)));
+				}
+			};
+		}
+
+		inline constexpr detail::iota_fn iota;
+		inline constexpr detail::transform_fn transform;
+		inline constexpr detail::filter_fn filter;
+		inline constexpr detail::counted_fn<ranges::take_view> take;
+		inline constexpr detail::counted_fn<ranges::drop_view> drop;
+		inline constexpr detail::counted_fn<ranges::stride_view> stride;
+		inline constexpr detail::counted_fn<ranges::chunk_view> chunk;
+		inline constexpr detail::zip_fn zip;
+		// enumerate takes no arguments, so it's a closure already
+		inline constexpr auto enumerate = brisk::detail::makeClosure(detail::enumerate_fn());
+	}
+
+	// Collects a range into a new container, reserving the exact size first
+	// when the range knows it. to<brisk::vector>() works out the element
+	// type; to<brisk::vector<long>>() converts to the one given.
+	template <class Container, std::ranges::input_range Range>
+	Container to(Range&& range)
+	{
+		Container container;
+		if constexpr (std::ranges::sized_range<Range> && requires { container.reserve(std::ranges::size(range)); }) {
+			container.reserve(std::ranges::size(range));
+		}
+
+		for (auto it = std::ranges::begin(range); it != std::ranges::end(range); ++it) {
+			container.push_back(*it);
+		}
+
+		return container;
+	}
+
+	template <template <class...> class Container, std::ranges::input_range Range>
+	auto to(Range&& range)
+	{
+		return brisk::to<Container<std::ranges::range_value_t<Range>>>(brisk::forward<Range>(range));
+	}
+
+	template <class Container>
+	auto to()
+	{
+		return detail::makeClosure([]<class Range>(Range&& range) { return brisk::to<Container>(brisk::forward<Range>(range)); });
+	}
+
+	template <template <class...> class Container>
+	auto to()
+	{
+		return detail::makeClosure([]<class Range>(Range&& range) { return brisk::to<Container>(brisk::forward<Range>(range)); });
+	}
+
+	// Whole-range versions of for_each and accumulate, for views whose end
+	// is a sentinel rather than an iterator.
+	template <std::ranges::input_range Range, class Function>
+	Function for_each(Range&& range, Function f)
+	{
+		std::ranges::sentinel_t<Range> last = std::ranges::end(range);
+		for (std::ranges::iterator_t<Range> it = std::ranges::begin(range); it != last; ++it)
+			f(*it);
+
+		return f;
+	}
+
+	template <std::ranges::input_range Range, class T>
+	T accumulate(Range&& range, T init)
+	{
+		std::ranges::sentinel_t<Range> last = std::ranges::end(range);
+		for (std::ranges::iterator_t<Range> it = std::ranges::begin(range); it != last; ++it)
+			init = brisk::move(init) + *it;
+
+		return init;
+	}
+
+	template <std::ranges::input_range Range, class T, class BinaryOp>
+	T accumulate(Range&& range, T init, BinaryOp op)
+	{
+		std::ranges::sentinel_t<Range> last = std::ranges::end(range);
+		for (std::ranges::iterator_t<Range> it = std::ranges::begin(range); it != last; ++it)
+			init = op(brisk::move(init), *it);
+
+		return init;
+	}
+}
@@ -0,0 +1,688 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "pool_allocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#if defined(__SANITIZE_THREAD__)
+	#define BRISK_TSAN 1
+#elif defined(__has_feature)
+	#if __has_feature(thread_sanitizer)
+		#define BRISK_TSAN 1
+	#endif
+#endif
+
+namespace brisk
+{
+	// Deferred deletion for lock-free structures. A writer unlinks a node and
+	// hands it to retire(); the domain frees it once no reader can still be
+	// looking at it. Readers never lock: an epoch_guard costs one store and a
+	// fence per critical section, a hazard_pointer one store and a fence per
+	// pointer protected.
+	//
+	// Both domains take the same retire() calls:
+	//     domain.retire(node);                   // delete node
+	//     domain.retire(node, reclaimFunction);  // reclaimFunction(node)
+	class epoch_domain;
+	class hazard_domain;
+
+	namespace detail
+	{
+		constexpr brisk::size_t reclaimBatch = 64;
+
+		// The store-load fence both schemes hang on. ThreadSanitizer doesn't
+		// model fences, so under it a seq_cst RMW stands in, which it does.
+		inline void reclaimFence() noexcept
+		{
+#ifdef BRISK_TSAN
+			static std::atomic<int> fence(0);
+			fence.fetch_add(0, std::memory_order_seq_cst);
+#else
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+		}
+
+		struct retired_node
+		{
+			void* object;
+			void (*reclaim)(void*);
+			std::uint64_t epoch;
+			retired_node* next;
+		};
+
+		template <class Type>
+		void reclaimDelete(void* p)
+		{
+			delete static_cast<Type*>(p);
+		}
+
+		// Retire records come and go at the rate objects are retired, and are
+		// often freed by a different thread from the one that made them.
+		inline retired_node* makeRetired(void* object, void (*reclaim)(void*), std::uint64_t epoch)
+		{
+			retired_node* node = pool_allocator<retired_node>().allocate(1);
+			node->object = object;
+			node->reclaim = reclaim;
+			node->epoch = epoch;
+			node->next = nullptr;
+			return node;
+		}
+
+		inline void freeRetired(retired_node* node) noexcept
+		{
+			node->reclaim(node->object);
+			pool_allocator<retired_node>().deallocate(node, 1);
+		}
+
+		inline void freeRetiredList(retired_node* node) noexcept
+		{
+			while (node != nullptr) {
+				retired_node* next = node->next;
+				freeRetired(node);
+				node = next;
+			}
+		}
+
+		// One per thread per domain. Records are claimed through m_owned and
+		// never freed before the domain, so scanning them needs no lock; a
+		// thread that exits gives its record, and whatever is still in its
+		// limbo list, to the next thread that claims it.
+		struct alignas(64) epoch_record
+		{
+			// (epoch << 1) | 1 while pinned, 0 otherwise
+			std::atomic<std::uint64_t> m_state{0};
+			std::atomic<bool> m_owned{true};
+			epoch_record* m_next = nullptr;
+
+			// touched only by the owning thread
+			brisk::size_t m_nesting = 0;
+			retired_node* m_limbo = nullptr;
+			brisk::size_t m_limboCount = 0;
+		};
+
+		struct epoch_registry
+		{
+			std::mutex m_mutex;
+			epoch_domain* m_head = nullptr;
+
+			static epoch_registry& instance()
+			{
+				static epoch_registry* registry = new epoch_registry();
+				return *registry;
+			}
+		};
+
+		// Which record this thread owns in each domain it has used. The id
+		// tells a live domain apart from a dead one at the same address.
+		struct epoch_binding
+		{
+			epoch_domain* m_domain;
+			std::uint64_t m_id;
+			epoch_record* m_record;
+			epoch_binding* m_next;
+		};
+
+		class epoch_thread
+		{
+		public:
+			static epoch_thread& local()
+			{
+				static thread_local epoch_thread thread;
+				return thread;
+			}
+
+			~epoch_thread();
+
+			epoch_binding* m_head = nullptr;
+		};
+
+		inline std::uint64_t nextDomainId() noexcept
+		{
+			static std::atomic<std::uint64_t> id{1};
+			return id.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// Epoch-based reclamation. A retired object is tagged with the global
+	// epoch; the epoch only advances once every pinned thread has seen the
+	// current one, so two advances later nobody can hold a reference from
+	// before the object was unlinked. Cheapest for readers, but one stalled
+	// reader holds up all reclamation in the domain.
+	//
+	// A domain must outlive the critical sections and retire calls made on
+	// it; threads may exit at any time.
+	class epoch_domain
+	{
+	public:
+		epoch_domain()
+			: m_epoch(2), m_records(nullptr), m_id(detail::nextDomainId()), m_nextLive(nullptr)
+		{
+			detail::epoch_registry& registry = detail::epoch_registry::instance();
+			std::lock_guard<std::mutex> lock(registry.m_mutex);
+			m_nextLive = registry.m_head;
+			registry.m_head = this;
+		}
+
+		epoch_domain(const epoch_domain&) = delete;
+		epoch_domain& operator=(const epoch_domain&) = delete;
+
+		~epoch_domain()
+		{
+			{
+				detail::epoch_registry& registry = detail::epoch_registry::instance();
+				std::lock_guard<std::mutex> lock(registry.m_mutex);
+				epoch_domain** link = &registry.m_head;
+				while (*link != this) {
+					link = &(*link)->m_nextLive;
+				}
+				*link = m_nextLive;
+			}
+
+			detail::epoch_record* record = m_records.load(std::memory_order_acquire);
+			while (record != nullptr) {
+				detail::epoch_record* next = record->m_next;
+				detail::freeRetiredList(record->m_limbo);
+				delete record;
+				record = next;
+			}
+		}
+
+		template <class Type>
+		void retire(Type* p)
+		{
+			retire(static_cast<void*>(const_cast<std::remove_cv_t<Type>*>(p)), &detail::reclaimDelete<std::remove_cv_t<Type>>);
+		}
+
+		void retire(void* p, void (*reclaimFunction)(void*))
+		{
+			detail::epoch_record* record = local();
+
+			// orders the caller's unlink before the epoch read, pairing with
+			// the fence in pin()
+			detail::reclaimFence();
+			std::uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+
+			detail::retired_node* node = detail::makeRetired(p, reclaimFunction, epoch);
+			node->next = record->m_limbo;
+			record->m_limbo = node;
+
+			if (++record->m_limboCount >= detail::reclaimBatch) {
+				collect(record);
+			}
+		}
+
+		// Advances the epoch as far as the pinned threads allow and frees
+		// what this thread has retired since. Returns the number of objects
+		// still waiting.
+		brisk::size_t reclaim()
+		{
+			detail::epoch_record* record = local();
+			for (int i = 0; i < 3 && record->m_limbo != nullptr; ++i) {
+				collect(record);
+			}
+			return record->m_limboCount;
+		}
+
+		std::uint64_t epoch() const noexcept
+		{
+			return m_epoch.load(std::memory_order_relaxed);
+		}
+
+	private:
+		friend class epoch_guard;
+		friend class detail::epoch_thread;
+
+		detail::epoch_record* local()
+		{
+			detail::epoch_thread& thread = detail::epoch_thread::local();
+			detail::epoch_binding* binding = thread.m_head;
+			if (binding != nullptr && binding->m_domain == this && binding->m_id == m_id) {
+				return binding->m_record;
+			}
+			return bind(thread);
+		}
+
+		detail::epoch_record* bind(detail::epoch_thread& thread)
+		{
+			detail::epoch_binding* previous = nullptr;
+			for (detail::epoch_binding* binding = thread.m_head; binding != nullptr; binding = binding->m_next) {
+				if (binding->m_domain == this) {
+					if (binding->m_id != m_id) {
+						// a dead domain's record at this address; it went with the domain
+						binding->m_id = m_id;
+						binding->m_record = claim();
+					}
+
+					// move to the front so the next lookup is one compare
+					if (previous != nullptr) {
+						previous->m_next = binding->m_next;
+						binding->m_next = thread.m_head;
+						thread.m_head = binding;
+					}
+					return binding->m_record;
+				}
+				previous = binding;
+			}
+
+			detail::epoch_record* record = claim();
+			thread.m_head = new detail::epoch_binding{this, m_id, record, thread.m_head};
+			return record;
+		}
+
+		detail::epoch_record* claim()
+		{
+			for (detail::epoch_record* record = m_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+				bool owned = false;
+				if (!record->m_owned.load(std::memory_order_relaxed) &&
+					record->m_owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+					return record;
+				}
+			}
+
+			detail::epoch_record* record = new detail::epoch_record();
+			record->m_next = m_records.load(std::memory_order_relaxed);
+			while (!m_records.compare_exchange_weak(record->m_next, record, std::memory_order_release, std::memory_order_relaxed)) {
+
+			}
+			return record;
+		}
+
+		// Called with the registry lock held when the owning thread exits.
+		void release(detail::epoch_record* record) noexcept
+		{
+			if (record->m_limbo != nullptr) {
+				collect(record);
+			}
+			record->m_owned.store(false, std::memory_order_release);
+		}
+
+		void pin(detail::epoch_record* record) noexcept
+		{
+			std::uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+			// release so a reclaimer that sees this pin also sees the reads
+			// made under the previous one
+			record->m_state.store((epoch << 1) | 1, std::memory_order_release);
+			// the pin must be visible before any pointer the reader loads
+			detail::reclaimFence();
+		}
+
+		void unpin(detail::epoch_record* record) noexcept
+		{
+			record->m_state.store(0, std::memory_order_release);
+		}
+
+		bool try_advance() noexcept
+		{
+			std::uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+			detail::reclaimFence();
+			for (detail::epoch_record* record = m_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+				std::uint64_t state = record->m_state.load(std::memory_order_acquire);
+				if ((state & 1) && (state >> 1) != epoch) {
+					return false;
+				}
+			}
+
+			// a CAS rather than a store, so a slow thread can't move the
+			// epoch back after someone else has advanced it twice
+			return m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+		}
+
+		void collect(detail::epoch_record* record) noexcept
+		{
+			try_advance();
+			std::uint64_t epoch = m_epoch.load(std::memory_order_acquire);
+
+			detail::retired_node** link = &record->m_limbo;
+			while (*link != nullptr) {
+				detail::retired_node* node = *link;
+				if (node->epoch + 2 <= epoch) {
+					*link = node->next;
+					detail::freeRetired(node);
+					--record->m_limboCount;
+				} else {
+					link = &node->next;
+				}
+			}
+		}
+
+		std::atomic<std::uint64_t> m_epoch;
+		std::atomic<detail::epoch_record*> m_records;
+		const std::uint64_t m_id;
+		epoch_domain* m_nextLive;
+	};
+
+	// Never destroyed, like the block pools, so threads can retire into it
+	// while statics are being torn down.
+	inline epoch_domain& default_epoch_domain()
+	{
+		static epoch_domain* domain = new epoch_domain();
+		return *domain;
+	}
+
+	// Pins the calling thread for the guard's lifetime. Pointers loaded from
+	// the structure stay valid until the guard goes away. Guards nest.
+	class epoch_guard
+	{
+	public:
+		explicit epoch_guard(epoch_domain& domain = brisk::default_epoch_domain())
+			: m_domain(&domain), m_record(domain.local())
+		{
+			if (m_record->m_nesting++ == 0) {
+				m_domain->pin(m_record);
+			}
+		}
+
+		epoch_guard(const epoch_guard&) = delete;
+		epoch_guard& operator=(const epoch_guard&) = delete;
+
+		~epoch_guard()
+		{
+			if (--m_record->m_nesting == 0) {
+				m_domain->unpin(m_record);
+			}
+		}
+
+	private:
+		epoch_domain* m_domain;
+		detail::epoch_record* m_record;
+	};
+
+	inline detail::epoch_thread::~epoch_thread()
+	{
+		epoch_registry& registry = epoch_registry::instance();
+		std::lock_guard<std::mutex> lock(registry.m_mutex);
+		while (m_head != nullptr) {
+			epoch_binding* binding = m_head;
+			m_head = binding->m_next;
+
+			for (epoch_domain* domain = registry.m_head; domain != nullptr; domain = domain->m_nextLive) {
+				if (domain == binding->m_domain && domain->m_id == binding->m_id) {
+					domain->release(binding->m_record);
+					break;
+				}
+			}
+			delete binding;
+		}
+	}
+
+	namespace detail
+	{
+		struct alignas(64) hazard_record
+		{
+			std::atomic<const void*> m_slot{nullptr};
+			std::atomic<bool> m_owned{true};
+			hazard_record* m_next = nullptr;
+		};
+	}
+
+	// Hazard-pointer reclamation. Each reader publishes the exact pointer it
+	// is about to use; a retired object is freed once no slot holds it. A
+	// stalled reader pins only what it protects, at the price of a fence per
+	// pointer. Retired objects go on one shared list, scanned once it holds
+	// more than twice as many objects as there are hazard pointers.
+	class hazard_domain
+	{
+	public:
+		hazard_domain() noexcept
+			: m_records(nullptr), m_recordCount(0), m_retired(nullptr), m_retiredCount(0)
+		{
+
+		}
+
+		hazard_domain(const hazard_domain&) = delete;
+		hazard_domain& operator=(const hazard_domain&) = delete;
+
+		~hazard_domain()
+		{
+			detail::freeRetiredList(m_retired.load(std::memory_order_acquire));
+
+			detail::hazard_record* record = m_records.load(std::memory_order_acquire);
+			while (record != nullptr) {
+				detail::hazard_record* next = record->m_next;
+				delete record;
+				record = next;
+			}
+		}
+
+		template <class Type>
+		void retire(Type* p)
+		{
+			retire(static_cast<void*>(const_cast<std::remove_cv_t<Type>*>(p)), &detail::reclaimDelete<std::remove_cv_t<Type>>);
+		}
+
+		void retire(void* p, void (*reclaimFunction)(void*))
+		{
+			detail::retired_node* node = detail::makeRetired(p, reclaimFunction, 0);
+			push(node, node, 1);
+
+			brisk::size_t threshold = 2 * m_recordCount.load(std::memory_order_relaxed);
+			if (threshold < detail::reclaimBatch) {
+				threshold = detail::reclaimBatch;
+			}
+			if (m_retiredCount.load(std::memory_order_relaxed) >= threshold) {
+				reclaim();
+			}
+		}
+
+		// Frees every retired object no hazard pointer holds. Returns the
+		// number of objects this scan had to keep.
+		brisk::size_t reclaim()
+		{
+			detail::retired_node* list = m_retired.exchange(nullptr, std::memory_order_acquire);
+			if (list == nullptr) {
+				return 0;
+			}
+
+			brisk::size_t taken = 0;
+			for (detail::retired_node* node = list; node != nullptr; node = node->next) {
+				++taken;
+			}
+			m_retiredCount.fetch_sub(taken, std::memory_order_relaxed);
+
+			// pairs with the fence in protect(): either the reader's slot is
+			// visible here, or the reader sees the unlink and retries
+			detail::reclaimFence();
+
+			// records are only ever pushed at the head, so counting and then
+			// filling from one snapshot sees the same records
+			detail::hazard_record* head = m_records.load(std::memory_order_acquire);
+			brisk::size_t records = 0;
+			for (detail::hazard_record* record = head; record != nullptr; record = record->m_next) {
+				++records;
+			}
+
+			brisk::unique_ptr<const void*[]> hazards = brisk::make_unique_for_overwrite<const void*[]>(records);
+			brisk::size_t count = 0;
+			for (detail::hazard_record* record = head; record != nullptr; record = record->m_next) {
+				const void* p = record->m_slot.load(std::memory_order_acquire);
+				if (p != nullptr) {
+					hazards[count++] = p;
+				}
+			}
+			std::sort(hazards.get(), hazards.get() + count);
+
+			detail::retired_node* keptFirst = nullptr;
+			detail::retired_node* keptLast = nullptr;
+			brisk::size_t kept = 0;
+			while (list != nullptr) {
+				detail::retired_node* node = list;
+				list = node->next;
+				if (std::binary_search(hazards.get(), hazards.get() + count, static_cast<const void*>(node->object))) {
+					node->next = keptFirst;
+					keptFirst = node;
+					if (keptLast == nullptr) {
+						keptLast = node;
+					}
+					++kept;
+				} else {
+					detail::freeRetired(node);
+				}
+			}
+
+			if (keptFirst != nullptr) {
+				push(keptFirst, keptLast, kept);
+			}
+			return kept;
+		}
+
+	private:
+		friend class hazard_pointer;
+
+		detail::hazard_record* acquire()
+		{
+			for (detail::hazard_record* record = m_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+				bool owned = false;
+				if (!record->m_owned.load(std::memory_order_relaxed) &&
+					record->m_owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+					return record;
+				}
+			}
+
+			detail::hazard_record* record = new detail::hazard_record();
+			record->m_next = m_records.load(std::memory_order_relaxed);
+			while (!m_records.compare_exchange_weak(record->m_next, record, std::memory_order_release, std::memory_order_relaxed)) {
+
+			}
+			m_recordCount.fetch_add(1, std::memory_order_relaxed);
+			return record;
+		}
+
+		void release(detail::hazard_record* record) noexcept
+		{
+			record->m_slot.store(nullptr, std::memory_order_release);
+			record->m_owned.store(false, std::memory_order_release);
+		}
+
+		void push(detail::retired_node* first, detail::retired_node* last, brisk::size_t count) noexcept
+		{
+			last->next = m_retired.load(std::memory_order_relaxed);
+			while (!m_retired.compare_exchange_weak(last->next, first, std::memory_order_release, std::memory_order_relaxed)) {
+
+			}
+			m_retiredCount.fetch_add(count, std::memory_order_relaxed);
+		}
+
+		std::atomic<detail::hazard_record*> m_records;
+		std::atomic<brisk::size_t> m_recordCount;
+		std::atomic<detail::retired_node*> m_retired;
+		std::atomic<brisk::size_t> m_retiredCount;
+	};
+
+	inline hazard_domain& default_hazard_domain()
+	{
+		static hazard_domain* domain = new hazard_domain();
+		return *domain;
+	}
+
+	// One protection slot. Claiming a slot walks the domain's records, so
+	// keep a hazard_pointer around (one per thread and role) rather than
+	// making one per read.
+	class hazard_pointer
+	{
+	public:
+		explicit hazard_pointer(hazard_domain& domain = brisk::default_hazard_domain())
+			: m_domain(&domain), m_record(domain.acquire())
+		{
+
+		}
+
+		hazard_pointer(hazard_pointer&& x) noexcept
+			: m_domain(x.m_domain), m_record(x.m_record)
+		{
+			x.m_record = nullptr;
+		}
+
+		hazard_pointer& operator=(hazard_pointer&& x) noexcept
+		{
+			if (this != &x) {
+				if (m_record != nullptr) {
+					m_domain->release(m_record);
+				}
+				m_domain = x.m_domain;
+				m_record = x.m_record;
+				x.m_record = nullptr;
+			}
+			return *this;
+		}
+
+		hazard_pointer(const hazard_pointer&) = delete;
+		hazard_pointer& operator=(const hazard_pointer&) = delete;
+
+		~hazard_pointer()
+		{
+			if (m_record != nullptr) {
+				m_domain->release(m_record);
+			}
+		}
+
+		// Loads src and protects the result, retrying until the value is
+		// still in src after the slot is published.
+		template <class Type>
+		Type* protect(const std::atomic<Type*>& src) noexcept
+		{
+			Type* p = src.load(std::memory_order_relaxed);
+			while (!try_protect(p, src)) {
+
+			}
+			return p;
+		}
+
+		// Protects p if src still holds it; otherwise stores src's current
+		// value into p and returns false.
+		template <class Type>
+		bool try_protect(Type*& p, const std::atomic<Type*>& src) noexcept
+		{
+			Type* expected = p;
+			reset_protection(expected);
+			detail::reclaimFence();
+			p = src.load(std::memory_order_acquire);
+			if (p != expected) {
+				reset_protection();
+				return false;
+			}
+			return true;
+		}
+
+		template <class Type>
+		void reset_protection(const Type* p) noexcept
+		{
+			m_record->m_slot.store(static_cast<const void*>(p), std::memory_order_release);
+		}
+
+		void reset_protection(nullptr_t = nullptr) noexcept
+		{
+			m_record->m_slot.store(nullptr, std::memory_order_release);
+		}
+
+		bool empty() const noexcept
+		{
+			return m_record == nullptr;
+		}
+
+		void swap(hazard_pointer& x) noexcept
+		{
+			hazard_domain* domain = m_domain;
+			detail::hazard_record* record = m_record;
+			m_domain = x.m_domain;
+			m_record = x.m_record;
+			x.m_domain = domain;
+			x.m_record = record;
+		}
+
+	private:
+		hazard_domain* m_domain;
+		detail::hazard_record* m_record;
+	};
+
+	inline hazard_pointer make_hazard_pointer(hazard_domain& domain = brisk::default_hazard_domain())
+	{
+		return hazard_pointer(domain);
+	}
+}
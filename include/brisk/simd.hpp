@@ -0,0 +1,2092 @@
+#pragma once
+
+#include "briskdef.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+// x86 builds get register backends for SSE2, AVX2 and AVX-512 whatever
+// they were compiled for: each backend's functions carry a target
+// attribute, and simd_dispatch only calls into one after checking the CPU
+// has it. Anywhere else everything runs on the scalar backend.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define BRISK_SIMD_X86
+#endif
+
+// GCC 12's gathers and AVX-512 intrinsics start from an undefined register
+// made from itself, which trips the uninitialized warnings once they're
+// inlined into a kernel.
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wuninitialized"
+	#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#if defined(BRISK_SIMD_X86)
+	#include <immintrin.h>
+	#define BRISK_TARGET_SSE2 __attribute__((target("sse2")))
+	#define BRISK_TARGET_AVX2 __attribute__((target("avx2")))
+	#define BRISK_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl")))
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define BRISK_SIMD_FLATTEN __attribute__((flatten))
+#else
+	#define BRISK_SIMD_FLATTEN
+#endif
+
+namespace brisk
+{
+	enum class simd_isa : unsigned char
+	{
+		scalar,
+		sse2,
+		avx2,
+		avx512
+	};
+
+	namespace simd_abi
+	{
+		// N lanes in an array, one at a time.
+		template <brisk::size_t N>
+		struct fixed
+		{
+
+		};
+
+		using scalar = fixed<1>;
+
+		struct sse2
+		{
+
+		};
+
+		struct avx2
+		{
+
+		};
+
+		struct avx512
+		{
+
+		};
+	}
+
+	namespace detail
+	{
+		template <class T>
+		constexpr bool isSimdElement = (std::is_integral_v<T> && !std::is_same_v<T, bool> && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8))
+			|| std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+		enum simd_compare : unsigned char
+		{
+			compare_eq,
+			compare_ne,
+			compare_lt,
+			compare_le,
+			compare_gt,
+			compare_ge
+		};
+
+		constexpr std::uint64_t laneBits(brisk::size_t lanes) noexcept
+		{
+			return (lanes >= 64) ? ~std::uint64_t(0) : (std::uint64_t(1) << lanes) - 1;
+		}
+
+		// Integer lanes wrap around, in registers and out of them.
+		template <class T>
+		constexpr T wrapAdd(T a, T b) noexcept
+		{
+			if constexpr (std::is_integral_v<T>) {
+				using U = std::make_unsigned_t<T>;
+				return static_cast<T>(static_cast<U>(0u + static_cast<U>(a) + static_cast<U>(b)));
+			} else {
+				return a + b;
+			}
+		}
+
+		template <class T>
+		constexpr T wrapSub(T a, T b) noexcept
+		{
+			if constexpr (std::is_integral_v<T>) {
+				using U = std::make_unsigned_t<T>;
+				return static_cast<T>(static_cast<U>(0u + static_cast<U>(a) - static_cast<U>(b)));
+			} else {
+				return a - b;
+			}
+		}
+
+		template <class T>
+		constexpr T wrapMul(T a, T b) noexcept
+		{
+			if constexpr (std::is_integral_v<T>) {
+				using U = std::make_unsigned_t<T>;
+				return static_cast<T>(static_cast<U>(1u * static_cast<U>(a) * static_cast<U>(b)));
+			} else {
+				return a * b;
+			}
+		}
+
+		template <class T, simd_compare Compare>
+		constexpr bool compareScalar(T a, T b) noexcept
+		{
+			if constexpr (Compare == compare_eq) {
+				return a == b;
+			} else if constexpr (Compare == compare_ne) {
+				return a != b;
+			} else if constexpr (Compare == compare_lt) {
+				return a < b;
+			} else if constexpr (Compare == compare_le) {
+				return a <= b;
+			} else if constexpr (Compare == compare_gt) {
+				return a > b;
+			} else {
+				return a >= b;
+			}
+		}
+
+		template <class Abi>
+		struct simd_ops;
+
+		template <class T, brisk::size_t N>
+		struct simd_lanes
+		{
+			T lane[N];
+		};
+
+		// The scalar backend: a loop per operation, and a mask is a bit per
+		// lane.
+		template <brisk::size_t N>
+		struct simd_ops<simd_abi::fixed<N>>
+		{
+			static_assert(N >= 1 && N <= 64, "[brisk::simd]: fixed width simd has 1 to 64 lanes");
+
+			template <class T>
+			using reg = simd_lanes<T, N>;
+			template <class T>
+			using mask = std::uint64_t;
+			template <class T>
+			static constexpr brisk::size_t lanes = N;
+
+			// Runs Op and writes what it returns to result, taking and giving
+			// registers by reference; see basic_simd.
+			template <auto Op, class Result, class... Args>
+			static void invoke(Result& result, const Args&... args) noexcept
+			{
+				result = Op(args...);
+			}
+
+			template <class T, class Function>
+			static reg<T> map(const reg<T>& a, const reg<T>& b, Function f) noexcept
+			{
+				reg<T> r;
+				for (brisk::size_t i = 0; i < N; ++i) {
+					r.lane[i] = static_cast<T>(f(a.lane[i], b.lane[i]));
+				}
+				return r;
+			}
+
+			template <class T>
+			static reg<T> zero() noexcept
+			{
+				return broadcast(T(0));
+			}
+
+			template <class T>
+			static reg<T> broadcast(T x) noexcept
+			{
+				reg<T> r;
+				for (brisk::size_t i = 0; i < N; ++i) {
+					r.lane[i] = x;
+				}
+				return r;
+			}
+
+			template <class T>
+			static reg<T> load(const T* p) noexcept
+			{
+				reg<T> r;
+				for (brisk::size_t i = 0; i < N; ++i) {
+					r.lane[i] = p[i];
+				}
+				return r;
+			}
+
+			template <class T>
+			static void store(T* p, const reg<T>& a) noexcept
+			{
+				for (brisk::size_t i = 0; i < N; ++i) {
+					p[i] = a.lane[i];
+				}
+			}
+
+			template <class T>
+			static reg<T> add(const reg<T>& a, const reg<T>& b) noexcept
+			{
+				return map<T>(a, b, [](T x, T y) { return wrapAdd(x, y); });
+			}
+
+			template <class T>
+			static reg<T> sub(const reg<T>& a, const reg<T>& b) noexcept
+			{
+				return map<T>(a, b, [](T x, T y) { return wrapSub(x, y); });
+			}
+
+			template <class T>
+			static reg<T> mul(const reg<T>& a, const reg<T>& b) noexcept
+			{
+				return map<T>(a, b, [](T x, T y) { return wrapMul(x, y); });
+			}
+
+			template <class T>
+			static reg<T> div(const reg<T>& a, const reg<T>& b) noexcept
+			{
+				return map<T>(a, b, [](T x, T y) { return x / y; });
+			}
+
+			template <class T>
+			static reg<T> bitAnd(const reg<T>& a, const reg<T>& b) noexcept
+			{
+				return map<T>(a, b, [](T x, T y) { return x & y; });
+			}
+
+			template <class T>
+			static reg<T> bitOr(const reg<T>& a, const reg<T>& b) noexcept
+			{
+				return map<T>(a, b, [](T x, T y) { return x | y; });
+			}
+
+			template <class T>
+			static reg<T> bitXor(const reg<T>& a, const reg<T>& b) noexcept
+			{
+				return map<T>(a, b, [](T x, T y) { return x ^ y; });
+			}
+
+			template <class T, simd_compare Compare>
+			static mask<T> compare(const reg<T>& a, const reg<T>& b) noexcept
+			{
+				std::uint64_t bits = 0;
+				for (brisk::size_t i = 0; i < N; ++i) {
+					bits |= std::uint64_t(compareScalar<T, Compare>(a.lane[i], b.lane[i])) << i;
+				}
+				return bits;
+			}
+
+			template <class T>
+			static reg<T> select(mask<T> m, const reg<T>& a, const reg<T>& b) noexcept
+			{
+				reg<T> r;
+				for (brisk::size_t i = 0; i < N; ++i) {
+					r.lane[i] = ((m >> i) & 1) ? a.lane[i] : b.lane[i];
+				}
+				return r;
+			}
+
+			template <class T>
+			static reg<T> min(const reg<T>& a, const reg<T>& b) noexcept
+			{
+				return map<T>(a, b, [](T x, T y) { return (x < y) ? x : y; });
+			}
+
+			template <class T>
+			static reg<T> max(const reg<T>& a, const reg<T>& b) noexcept
+			{
+				return map<T>(a, b, [](T x, T y) { return (x > y) ? x : y; });
+			}
+
+			template <class T>
+			static std::uint64_t bits(mask<T> m) noexcept
+			{
+				return m;
+			}
+
+			template <class T>
+			static mask<T> maskAnd(mask<T> a, mask<T> b) noexcept
+			{
+				return a & b;
+			}
+
+			template <class T>
+			static mask<T> maskOr(mask<T> a, mask<T> b) noexcept
+			{
+				return a | b;
+			}
+
+			template <class T>
+			static mask<T> maskXor(mask<T> a, mask<T> b) noexcept
+			{
+				return a ^ b;
+			}
+
+			template <class T>
+			static mask<T> maskNot(mask<T> a) noexcept
+			{
+				return ~a & laneBits(N);
+			}
+
+			template <class T>
+			static reg<T> gather(const T* base, const std::int32_t* index) noexcept
+			{
+				reg<T> r;
+				for (brisk::size_t i = 0; i < N; ++i) {
+					r.lane[i] = base[index[i]];
+				}
+				return r;
+			}
+
+			template <class T>
+			static reg<T> permute(const reg<T>& a, const std::int32_t* index) noexcept
+			{
+				reg<T> r;
+				for (brisk::size_t i = 0; i < N; ++i) {
+					r.lane[i] = a.lane[index[i]];
+				}
+				return r;
+			}
+		};
+
+#if defined(BRISK_SIMD_X86)
+		// Vector types lose their attributes as template arguments, so they're
+		// picked by specialization.
+		template <class T>
+		struct sse2_register
+		{
+			using type = __m128i;
+		};
+
+		template <>
+		struct sse2_register<float>
+		{
+			using type = __m128;
+		};
+
+		template <>
+		struct sse2_register<double>
+		{
+			using type = __m128d;
+		};
+
+		// 128-bit registers. SSE2 has no 64-bit compares and multiplies only
+		// 16-bit lanes: 32-bit products are emulated and the rest done a lane
+		// at a time.
+		template <>
+		struct simd_ops<simd_abi::sse2>
+		{
+			template <class T>
+			using reg = typename sse2_register<T>::type;
+			template <class T>
+			using mask = reg<T>;
+			template <class T>
+			static constexpr brisk::size_t lanes = 16 / sizeof(T);
+
+			template <auto Op, class Result, class... Args>
+			BRISK_TARGET_SSE2 static void invoke(Result& result, const Args&... args) noexcept
+			{
+				result = Op(args...);
+			}
+
+			template <class T, class Function>
+			BRISK_TARGET_SSE2 static reg<T> map(reg<T> a, reg<T> b, Function f) noexcept
+			{
+				alignas(16) T x[lanes<T>];
+				alignas(16) T y[lanes<T>];
+				store(x, a);
+				store(y, b);
+				for (brisk::size_t i = 0; i < lanes<T>; ++i) {
+					x[i] = static_cast<T>(f(x[i], y[i]));
+				}
+				return load(x);
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> zero() noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_setzero_ps();
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_setzero_pd();
+				} else {
+					return _mm_setzero_si128();
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> broadcast(T x) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_set1_ps(x);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_set1_pd(x);
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm_set1_epi8(static_cast<char>(x));
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm_set1_epi16(static_cast<short>(x));
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm_set1_epi32(static_cast<int>(x));
+				} else {
+					return _mm_set1_epi64x(static_cast<long long>(x));
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> load(const T* p) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_loadu_ps(p);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_loadu_pd(p);
+				} else {
+					return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static void store(T* p, const reg<T>& a) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					_mm_storeu_ps(p, a);
+				} else if constexpr (std::is_same_v<T, double>) {
+					_mm_storeu_pd(p, a);
+				} else {
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(p), a);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> add(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_add_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_add_pd(a, b);
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm_add_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm_add_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm_add_epi32(a, b);
+				} else {
+					return _mm_add_epi64(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> sub(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_sub_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_sub_pd(a, b);
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm_sub_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm_sub_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm_sub_epi32(a, b);
+				} else {
+					return _mm_sub_epi64(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> mul(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_mul_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_mul_pd(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm_mullo_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					// even and odd lanes as 64-bit products, low halves
+					// put back together
+					__m128i even = _mm_mul_epu32(a, b);
+					__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+					return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+				} else {
+					return map<T>(a, b, [](T x, T y) { return wrapMul(x, y); });
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> div(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_div_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_div_pd(a, b);
+				} else {
+					return map<T>(a, b, [](T x, T y) { return x / y; });
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> bitAnd(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_and_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_and_pd(a, b);
+				} else {
+					return _mm_and_si128(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> bitOr(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_or_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_or_pd(a, b);
+				} else {
+					return _mm_or_si128(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> bitXor(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_xor_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_xor_pd(a, b);
+				} else {
+					return _mm_xor_si128(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static mask<T> maskNot(mask<T> a) noexcept
+			{
+				return bitXor<T>(a, reinterpret<T>(_mm_set1_epi32(-1)));
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> reinterpret(__m128i a) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_castsi128_ps(a);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_castsi128_pd(a);
+				} else {
+					return a;
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static __m128i equal(__m128i a, __m128i b) noexcept
+			{
+				if constexpr (sizeof(T) == 1) {
+					return _mm_cmpeq_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm_cmpeq_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm_cmpeq_epi32(a, b);
+				} else {
+					// both halves equal
+					__m128i halves = _mm_cmpeq_epi32(a, b);
+					return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static __m128i greater(__m128i a, __m128i b) noexcept
+			{
+				if constexpr (std::is_unsigned_v<T> && sizeof(T) < 8) {
+					// flipping the top bit turns unsigned order into signed
+					__m128i bias = broadcast<T>(static_cast<T>(T(1) << (sizeof(T) * 8 - 1)));
+					return greater<std::make_signed_t<T>>(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm_cmpgt_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm_cmpgt_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm_cmpgt_epi32(a, b);
+				} else {
+					// from dword compares: the high halves decide unless they're
+					// equal, then the low halves do, compared unsigned
+					const int high = std::is_signed_v<T> ? 0 : static_cast<int>(0x80000000u);
+					const __m128i bias = _mm_set_epi32(high, static_cast<int>(0x80000000u), high, static_cast<int>(0x80000000u));
+					const __m128i x = _mm_xor_si128(a, bias);
+					const __m128i y = _mm_xor_si128(b, bias);
+					const __m128i gt = _mm_cmpgt_epi32(x, y);
+					const __m128i r = _mm_or_si128(gt, _mm_and_si128(_mm_cmpeq_epi32(x, y), _mm_shuffle_epi32(gt, _MM_SHUFFLE(2, 2, 0, 0))));
+					return _mm_shuffle_epi32(r, _MM_SHUFFLE(3, 3, 1, 1));
+				}
+			}
+
+			template <class T, simd_compare Compare>
+			BRISK_TARGET_SSE2 static mask<T> compare(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					if constexpr (Compare == compare_eq) {
+						return _mm_cmpeq_ps(a, b);
+					} else if constexpr (Compare == compare_ne) {
+						return _mm_cmpneq_ps(a, b);
+					} else if constexpr (Compare == compare_lt) {
+						return _mm_cmplt_ps(a, b);
+					} else if constexpr (Compare == compare_le) {
+						return _mm_cmple_ps(a, b);
+					} else if constexpr (Compare == compare_gt) {
+						return _mm_cmpgt_ps(a, b);
+					} else {
+						return _mm_cmpge_ps(a, b);
+					}
+				} else if constexpr (std::is_same_v<T, double>) {
+					if constexpr (Compare == compare_eq) {
+						return _mm_cmpeq_pd(a, b);
+					} else if constexpr (Compare == compare_ne) {
+						return _mm_cmpneq_pd(a, b);
+					} else if constexpr (Compare == compare_lt) {
+						return _mm_cmplt_pd(a, b);
+					} else if constexpr (Compare == compare_le) {
+						return _mm_cmple_pd(a, b);
+					} else if constexpr (Compare == compare_gt) {
+						return _mm_cmpgt_pd(a, b);
+					} else {
+						return _mm_cmpge_pd(a, b);
+					}
+				} else if constexpr (Compare == compare_eq) {
+					return equal<T>(a, b);
+				} else if constexpr (Compare == compare_ne) {
+					return maskNot<T>(equal<T>(a, b));
+				} else if constexpr (Compare == compare_lt) {
+					return greater<T>(b, a);
+				} else if constexpr (Compare == compare_le) {
+					return maskNot<T>(greater<T>(a, b));
+				} else if constexpr (Compare == compare_gt) {
+					return greater<T>(a, b);
+				} else {
+					return maskNot<T>(greater<T>(b, a));
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> select(mask<T> m, reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b));
+				} else {
+					return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+				}
+			}
+
+			// minps and maxps return their second operand on a tie or a
+			// NaN, which is brisk::min's and brisk::max's (a < b) ? a : b
+			// and (a > b) ? a : b.
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> min(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_min_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_min_pd(a, b);
+				} else if constexpr (std::is_unsigned_v<T> && sizeof(T) == 1) {
+					return _mm_min_epu8(a, b);
+				} else if constexpr (std::is_signed_v<T> && sizeof(T) == 2) {
+					return _mm_min_epi16(a, b);
+				} else {
+					return select<T>(greater<T>(b, a), a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> max(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm_max_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm_max_pd(a, b);
+				} else if constexpr (std::is_unsigned_v<T> && sizeof(T) == 1) {
+					return _mm_max_epu8(a, b);
+				} else if constexpr (std::is_signed_v<T> && sizeof(T) == 2) {
+					return _mm_max_epi16(a, b);
+				} else {
+					return select<T>(greater<T>(a, b), a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static std::uint64_t bits(mask<T> m) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return static_cast<unsigned>(_mm_movemask_ps(m));
+				} else if constexpr (std::is_same_v<T, double>) {
+					return static_cast<unsigned>(_mm_movemask_pd(m));
+				} else if constexpr (sizeof(T) == 1) {
+					return static_cast<unsigned>(_mm_movemask_epi8(m));
+				} else if constexpr (sizeof(T) == 2) {
+					return static_cast<unsigned>(_mm_movemask_epi8(_mm_packs_epi16(m, _mm_setzero_si128())));
+				} else if constexpr (sizeof(T) == 4) {
+					return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(m)));
+				} else {
+					return static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(m)));
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static mask<T> maskAnd(mask<T> a, mask<T> b) noexcept
+			{
+				return bitAnd<T>(a, b);
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static mask<T> maskOr(mask<T> a, mask<T> b) noexcept
+			{
+				return bitOr<T>(a, b);
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static mask<T> maskXor(mask<T> a, mask<T> b) noexcept
+			{
+				return bitXor<T>(a, b);
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> gather(const T* base, const std::int32_t* index) noexcept
+			{
+				alignas(16) T x[lanes<T>];
+				for (brisk::size_t i = 0; i < lanes<T>; ++i) {
+					x[i] = base[index[i]];
+				}
+				return load(x);
+			}
+
+			template <class T>
+			BRISK_TARGET_SSE2 static reg<T> permute(reg<T> a, const std::int32_t* index) noexcept
+			{
+				alignas(16) T x[lanes<T>];
+				alignas(16) T r[lanes<T>];
+				store(x, a);
+				for (brisk::size_t i = 0; i < lanes<T>; ++i) {
+					r[i] = x[index[i]];
+				}
+				return load(r);
+			}
+		};
+
+		template <class T>
+		struct avx2_register
+		{
+			using type = __m256i;
+		};
+
+		template <>
+		struct avx2_register<float>
+		{
+			using type = __m256;
+		};
+
+		template <>
+		struct avx2_register<double>
+		{
+			using type = __m256d;
+		};
+
+		// 256-bit registers: every compare and 32-bit multiply is native,
+		// as are gathers of 4- and 8-byte elements.
+		template <>
+		struct simd_ops<simd_abi::avx2>
+		{
+			template <class T>
+			using reg = typename avx2_register<T>::type;
+			template <class T>
+			using mask = reg<T>;
+			template <class T>
+			static constexpr brisk::size_t lanes = 32 / sizeof(T);
+
+			template <auto Op, class Result, class... Args>
+			BRISK_TARGET_AVX2 static void invoke(Result& result, const Args&... args) noexcept
+			{
+				result = Op(args...);
+			}
+
+			template <class T, class Function>
+			BRISK_TARGET_AVX2 static reg<T> map(reg<T> a, reg<T> b, Function f) noexcept
+			{
+				alignas(32) T x[lanes<T>];
+				alignas(32) T y[lanes<T>];
+				store(x, a);
+				store(y, b);
+				for (brisk::size_t i = 0; i < lanes<T>; ++i) {
+					x[i] = static_cast<T>(f(x[i], y[i]));
+				}
+				return load(x);
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> zero() noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_setzero_ps();
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_setzero_pd();
+				} else {
+					return _mm256_setzero_si256();
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> broadcast(T x) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_set1_ps(x);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_set1_pd(x);
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm256_set1_epi8(static_cast<char>(x));
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm256_set1_epi16(static_cast<short>(x));
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm256_set1_epi32(static_cast<int>(x));
+				} else {
+					return _mm256_set1_epi64x(static_cast<long long>(x));
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> load(const T* p) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_loadu_ps(p);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_loadu_pd(p);
+				} else {
+					return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static void store(T* p, const reg<T>& a) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					_mm256_storeu_ps(p, a);
+				} else if constexpr (std::is_same_v<T, double>) {
+					_mm256_storeu_pd(p, a);
+				} else {
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> add(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_add_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_add_pd(a, b);
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm256_add_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm256_add_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm256_add_epi32(a, b);
+				} else {
+					return _mm256_add_epi64(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> sub(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_sub_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_sub_pd(a, b);
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm256_sub_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm256_sub_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm256_sub_epi32(a, b);
+				} else {
+					return _mm256_sub_epi64(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> mul(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_mul_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_mul_pd(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm256_mullo_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm256_mullo_epi32(a, b);
+				} else {
+					return map<T>(a, b, [](T x, T y) { return wrapMul(x, y); });
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> div(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_div_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_div_pd(a, b);
+				} else {
+					return map<T>(a, b, [](T x, T y) { return x / y; });
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> bitAnd(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_and_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_and_pd(a, b);
+				} else {
+					return _mm256_and_si256(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> bitOr(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_or_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_or_pd(a, b);
+				} else {
+					return _mm256_or_si256(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> bitXor(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_xor_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_xor_pd(a, b);
+				} else {
+					return _mm256_xor_si256(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> reinterpret(__m256i a) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_castsi256_ps(a);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_castsi256_pd(a);
+				} else {
+					return a;
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static mask<T> maskNot(mask<T> a) noexcept
+			{
+				return bitXor<T>(a, reinterpret<T>(_mm256_set1_epi32(-1)));
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static __m256i equal(__m256i a, __m256i b) noexcept
+			{
+				if constexpr (sizeof(T) == 1) {
+					return _mm256_cmpeq_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm256_cmpeq_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm256_cmpeq_epi32(a, b);
+				} else {
+					return _mm256_cmpeq_epi64(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static __m256i greater(__m256i a, __m256i b) noexcept
+			{
+				if constexpr (std::is_unsigned_v<T>) {
+					__m256i bias = broadcast<T>(static_cast<T>(T(1) << (sizeof(T) * 8 - 1)));
+					return greater<std::make_signed_t<T>>(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias));
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm256_cmpgt_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm256_cmpgt_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm256_cmpgt_epi32(a, b);
+				} else {
+					return _mm256_cmpgt_epi64(a, b);
+				}
+			}
+
+			template <class T, simd_compare Compare>
+			BRISK_TARGET_AVX2 static mask<T> compare(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_floating_point_v<T>) {
+					// ordered, except that != holds for NaN as it does on scalars
+					constexpr int predicate = (Compare == compare_eq) ? _CMP_EQ_OQ : (Compare == compare_ne) ? _CMP_NEQ_UQ
+						: (Compare == compare_lt) ? _CMP_LT_OQ : (Compare == compare_le) ? _CMP_LE_OQ
+						: (Compare == compare_gt) ? _CMP_GT_OQ : _CMP_GE_OQ;
+					if constexpr (std::is_same_v<T, float>) {
+						return _mm256_cmp_ps(a, b, predicate);
+					} else {
+						return _mm256_cmp_pd(a, b, predicate);
+					}
+				} else if constexpr (Compare == compare_eq) {
+					return equal<T>(a, b);
+				} else if constexpr (Compare == compare_ne) {
+					return maskNot<T>(equal<T>(a, b));
+				} else if constexpr (Compare == compare_lt) {
+					return greater<T>(b, a);
+				} else if constexpr (Compare == compare_le) {
+					return maskNot<T>(greater<T>(a, b));
+				} else if constexpr (Compare == compare_gt) {
+					return greater<T>(a, b);
+				} else {
+					return maskNot<T>(greater<T>(b, a));
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> select(mask<T> m, reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_blendv_ps(b, a, m);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_blendv_pd(b, a, m);
+				} else {
+					return _mm256_blendv_epi8(b, a, m);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> min(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_min_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_min_pd(a, b);
+				} else if constexpr (sizeof(T) == 8) {
+					return select<T>(greater<T>(b, a), a, b);
+				} else if constexpr (std::is_unsigned_v<T>) {
+					if constexpr (sizeof(T) == 1) {
+						return _mm256_min_epu8(a, b);
+					} else if constexpr (sizeof(T) == 2) {
+						return _mm256_min_epu16(a, b);
+					} else {
+						return _mm256_min_epu32(a, b);
+					}
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm256_min_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm256_min_epi16(a, b);
+				} else {
+					return _mm256_min_epi32(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> max(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_max_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_max_pd(a, b);
+				} else if constexpr (sizeof(T) == 8) {
+					return select<T>(greater<T>(a, b), a, b);
+				} else if constexpr (std::is_unsigned_v<T>) {
+					if constexpr (sizeof(T) == 1) {
+						return _mm256_max_epu8(a, b);
+					} else if constexpr (sizeof(T) == 2) {
+						return _mm256_max_epu16(a, b);
+					} else {
+						return _mm256_max_epu32(a, b);
+					}
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm256_max_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm256_max_epi16(a, b);
+				} else {
+					return _mm256_max_epi32(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static std::uint64_t bits(mask<T> m) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return static_cast<unsigned>(_mm256_movemask_ps(m));
+				} else if constexpr (std::is_same_v<T, double>) {
+					return static_cast<unsigned>(_mm256_movemask_pd(m));
+				} else if constexpr (sizeof(T) == 1) {
+					return static_cast<unsigned>(_mm256_movemask_epi8(m));
+				} else if constexpr (sizeof(T) == 2) {
+					// packing works within 128-bit halves; gather the two
+					// packed quarters into the low half
+					__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(m, _mm256_setzero_si256()), _MM_SHUFFLE(3, 1, 2, 0));
+					return static_cast<unsigned>(_mm256_movemask_epi8(packed)) & 0xffffu;
+				} else if constexpr (sizeof(T) == 4) {
+					return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+				} else {
+					return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(m)));
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static mask<T> maskAnd(mask<T> a, mask<T> b) noexcept
+			{
+				return bitAnd<T>(a, b);
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static mask<T> maskOr(mask<T> a, mask<T> b) noexcept
+			{
+				return bitOr<T>(a, b);
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static mask<T> maskXor(mask<T> a, mask<T> b) noexcept
+			{
+				return bitXor<T>(a, b);
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> gather(const T* base, const std::int32_t* index) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)), 4);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm256_i32gather_pd(base, _mm_loadu_si128(reinterpret_cast<const __m128i*>(index)), 8);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm256_i32gather_epi32(reinterpret_cast<const int*>(base), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)), 4);
+				} else if constexpr (sizeof(T) == 8) {
+					return _mm256_i32gather_epi64(reinterpret_cast<const long long*>(base), _mm_loadu_si128(reinterpret_cast<const __m128i*>(index)), 8);
+				} else {
+					alignas(32) T x[lanes<T>];
+					for (brisk::size_t i = 0; i < lanes<T>; ++i) {
+						x[i] = base[index[i]];
+					}
+					return load(x);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX2 static reg<T> permute(reg<T> a, const std::int32_t* index) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm256_permutevar8x32_ps(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)));
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm256_permutevar8x32_epi32(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)));
+				} else {
+					alignas(32) T x[lanes<T>];
+					alignas(32) T r[lanes<T>];
+					store(x, a);
+					for (brisk::size_t i = 0; i < lanes<T>; ++i) {
+						r[i] = x[index[i]];
+					}
+					return load(r);
+				}
+			}
+		};
+
+		template <class T>
+		struct avx512_register
+		{
+			using type = __m512i;
+		};
+
+		template <>
+		struct avx512_register<float>
+		{
+			using type = __m512;
+		};
+
+		template <>
+		struct avx512_register<double>
+		{
+			using type = __m512d;
+		};
+
+		// 512-bit registers with AVX-512 F, BW, DQ and VL, where a compare
+		// gives a bit per lane in a mask register.
+		template <>
+		struct simd_ops<simd_abi::avx512>
+		{
+			template <class T>
+			using reg = typename avx512_register<T>::type;
+			template <class T>
+			using mask = std::uint64_t;
+			template <class T>
+			static constexpr brisk::size_t lanes = 64 / sizeof(T);
+
+			template <auto Op, class Result, class... Args>
+			BRISK_TARGET_AVX512 static void invoke(Result& result, const Args&... args) noexcept
+			{
+				result = Op(args...);
+			}
+
+			template <class T, class Function>
+			BRISK_TARGET_AVX512 static reg<T> map(reg<T> a, reg<T> b, Function f) noexcept
+			{
+				alignas(64) T x[lanes<T>];
+				alignas(64) T y[lanes<T>];
+				store(x, a);
+				store(y, b);
+				for (brisk::size_t i = 0; i < lanes<T>; ++i) {
+					x[i] = static_cast<T>(f(x[i], y[i]));
+				}
+				return load(x);
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> zero() noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_setzero_ps();
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_setzero_pd();
+				} else {
+					return _mm512_setzero_si512();
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> broadcast(T x) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_set1_ps(x);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_set1_pd(x);
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm512_set1_epi8(static_cast<char>(x));
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm512_set1_epi16(static_cast<short>(x));
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm512_set1_epi32(static_cast<int>(x));
+				} else {
+					return _mm512_set1_epi64(static_cast<long long>(x));
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> load(const T* p) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_loadu_ps(p);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_loadu_pd(p);
+				} else {
+					return _mm512_loadu_si512(p);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static void store(T* p, const reg<T>& a) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					_mm512_storeu_ps(p, a);
+				} else if constexpr (std::is_same_v<T, double>) {
+					_mm512_storeu_pd(p, a);
+				} else {
+					_mm512_storeu_si512(p, a);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> add(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_add_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_add_pd(a, b);
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm512_add_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm512_add_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm512_add_epi32(a, b);
+				} else {
+					return _mm512_add_epi64(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> sub(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_sub_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_sub_pd(a, b);
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm512_sub_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm512_sub_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm512_sub_epi32(a, b);
+				} else {
+					return _mm512_sub_epi64(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> mul(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_mul_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_mul_pd(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm512_mullo_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm512_mullo_epi32(a, b);
+				} else if constexpr (sizeof(T) == 8) {
+					return _mm512_mullo_epi64(a, b);
+				} else {
+					return map<T>(a, b, [](T x, T y) { return wrapMul(x, y); });
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> div(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_div_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_div_pd(a, b);
+				} else {
+					return map<T>(a, b, [](T x, T y) { return x / y; });
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> bitAnd(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_and_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_and_pd(a, b);
+				} else {
+					return _mm512_and_si512(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> bitOr(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_or_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_or_pd(a, b);
+				} else {
+					return _mm512_or_si512(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> bitXor(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_xor_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_xor_pd(a, b);
+				} else {
+					return _mm512_xor_si512(a, b);
+				}
+			}
+
+			template <class T, simd_compare Compare>
+			BRISK_TARGET_AVX512 static mask<T> compare(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_floating_point_v<T>) {
+					constexpr int predicate = (Compare == compare_eq) ? _CMP_EQ_OQ : (Compare == compare_ne) ? _CMP_NEQ_UQ
+						: (Compare == compare_lt) ? _CMP_LT_OQ : (Compare == compare_le) ? _CMP_LE_OQ
+						: (Compare == compare_gt) ? _CMP_GT_OQ : _CMP_GE_OQ;
+					if constexpr (std::is_same_v<T, float>) {
+						return _mm512_cmp_ps_mask(a, b, predicate);
+					} else {
+						return _mm512_cmp_pd_mask(a, b, predicate);
+					}
+				} else {
+					constexpr int predicate = (Compare == compare_eq) ? _MM_CMPINT_EQ : (Compare == compare_ne) ? _MM_CMPINT_NE
+						: (Compare == compare_lt) ? _MM_CMPINT_LT : (Compare == compare_le) ? _MM_CMPINT_LE
+						: (Compare == compare_gt) ? _MM_CMPINT_NLE : _MM_CMPINT_NLT;
+					if constexpr (std::is_unsigned_v<T>) {
+						if constexpr (sizeof(T) == 1) {
+							return _mm512_cmp_epu8_mask(a, b, predicate);
+						} else if constexpr (sizeof(T) == 2) {
+							return _mm512_cmp_epu16_mask(a, b, predicate);
+						} else if constexpr (sizeof(T) == 4) {
+							return _mm512_cmp_epu32_mask(a, b, predicate);
+						} else {
+							return _mm512_cmp_epu64_mask(a, b, predicate);
+						}
+					} else if constexpr (sizeof(T) == 1) {
+						return _mm512_cmp_epi8_mask(a, b, predicate);
+					} else if constexpr (sizeof(T) == 2) {
+						return _mm512_cmp_epi16_mask(a, b, predicate);
+					} else if constexpr (sizeof(T) == 4) {
+						return _mm512_cmp_epi32_mask(a, b, predicate);
+					} else {
+						return _mm512_cmp_epi64_mask(a, b, predicate);
+					}
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> select(mask<T> m, reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_mask_blend_ps(static_cast<__mmask16>(m), b, a);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_mask_blend_pd(static_cast<__mmask8>(m), b, a);
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm512_mask_blend_epi8(static_cast<__mmask64>(m), b, a);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm512_mask_blend_epi16(static_cast<__mmask32>(m), b, a);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm512_mask_blend_epi32(static_cast<__mmask16>(m), b, a);
+				} else {
+					return _mm512_mask_blend_epi64(static_cast<__mmask8>(m), b, a);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> min(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_min_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_min_pd(a, b);
+				} else if constexpr (std::is_unsigned_v<T>) {
+					if constexpr (sizeof(T) == 1) {
+						return _mm512_min_epu8(a, b);
+					} else if constexpr (sizeof(T) == 2) {
+						return _mm512_min_epu16(a, b);
+					} else if constexpr (sizeof(T) == 4) {
+						return _mm512_min_epu32(a, b);
+					} else {
+						return _mm512_min_epu64(a, b);
+					}
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm512_min_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm512_min_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm512_min_epi32(a, b);
+				} else {
+					return _mm512_min_epi64(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> max(reg<T> a, reg<T> b) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_max_ps(a, b);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_max_pd(a, b);
+				} else if constexpr (std::is_unsigned_v<T>) {
+					if constexpr (sizeof(T) == 1) {
+						return _mm512_max_epu8(a, b);
+					} else if constexpr (sizeof(T) == 2) {
+						return _mm512_max_epu16(a, b);
+					} else if constexpr (sizeof(T) == 4) {
+						return _mm512_max_epu32(a, b);
+					} else {
+						return _mm512_max_epu64(a, b);
+					}
+				} else if constexpr (sizeof(T) == 1) {
+					return _mm512_max_epi8(a, b);
+				} else if constexpr (sizeof(T) == 2) {
+					return _mm512_max_epi16(a, b);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm512_max_epi32(a, b);
+				} else {
+					return _mm512_max_epi64(a, b);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static std::uint64_t bits(mask<T> m) noexcept
+			{
+				return m;
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static mask<T> maskAnd(mask<T> a, mask<T> b) noexcept
+			{
+				return a & b;
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static mask<T> maskOr(mask<T> a, mask<T> b) noexcept
+			{
+				return a | b;
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static mask<T> maskXor(mask<T> a, mask<T> b) noexcept
+			{
+				return a ^ b;
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static mask<T> maskNot(mask<T> a) noexcept
+			{
+				return ~a & laneBits(lanes<T>);
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> gather(const T* base, const std::int32_t* index) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_i32gather_ps(_mm512_loadu_si512(index), base, 4);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_i32gather_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)), base, 8);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm512_i32gather_epi32(_mm512_loadu_si512(index), base, 4);
+				} else if constexpr (sizeof(T) == 8) {
+					return _mm512_i32gather_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)), base, 8);
+				} else {
+					alignas(64) T x[lanes<T>];
+					for (brisk::size_t i = 0; i < lanes<T>; ++i) {
+						x[i] = base[index[i]];
+					}
+					return load(x);
+				}
+			}
+
+			template <class T>
+			BRISK_TARGET_AVX512 static reg<T> permute(reg<T> a, const std::int32_t* index) noexcept
+			{
+				if constexpr (std::is_same_v<T, float>) {
+					return _mm512_permutexvar_ps(_mm512_loadu_si512(index), a);
+				} else if constexpr (std::is_same_v<T, double>) {
+					return _mm512_permutexvar_pd(_mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(index))), a);
+				} else if constexpr (sizeof(T) == 4) {
+					return _mm512_permutexvar_epi32(_mm512_loadu_si512(index), a);
+				} else if constexpr (sizeof(T) == 8) {
+					return _mm512_permutexvar_epi64(_mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(index))), a);
+				} else {
+					alignas(64) T x[lanes<T>];
+					alignas(64) T r[lanes<T>];
+					store(x, a);
+					for (brisk::size_t i = 0; i < lanes<T>; ++i) {
+						r[i] = x[index[i]];
+					}
+					return load(r);
+				}
+			}
+		};
+#endif
+
+		template <class T, brisk::size_t Bytes>
+		struct deduce_abi
+		{
+			using type = simd_abi::fixed<Bytes / sizeof(T)>;
+		};
+
+#if defined(BRISK_SIMD_X86)
+		template <class T>
+		struct deduce_abi<T, 16>
+		{
+			using type = simd_abi::sse2;
+		};
+
+		template <class T>
+		struct deduce_abi<T, 32>
+		{
+			using type = simd_abi::avx2;
+		};
+
+		template <class T>
+		struct deduce_abi<T, 64>
+		{
+			using type = simd_abi::avx512;
+		};
+#endif
+
+		// Result made from what Op returns, run in Result's backend.
+		template <class Result, auto Op, class... Args>
+		Result simdInvoke(const Args&... args) noexcept
+		{
+			typename Result::native_type r;
+			simd_ops<typename Result::abi_type>::template invoke<Op>(r, args...);
+			return Result(r);
+		}
+	}
+
+	template <class T, class Abi>
+	class basic_simd_mask
+	{
+		using ops = detail::simd_ops<Abi>;
+
+	public:
+		using value_type = bool;
+		using abi_type = Abi;
+		using native_type = typename ops::template mask<T>;
+
+		explicit basic_simd_mask(const native_type& m) noexcept
+			: m_mask(m)
+		{
+
+		}
+
+		static constexpr brisk::size_t size() noexcept
+		{
+			return ops::template lanes<T>;
+		}
+
+		// Bit i is lane i.
+		std::uint64_t to_bits() const noexcept
+		{
+			std::uint64_t bits;
+			ops::template invoke<&ops::template bits<T>>(bits, m_mask);
+			return bits;
+		}
+
+		bool operator[](brisk::size_t i) const noexcept
+		{
+			return (to_bits() >> i) & 1;
+		}
+
+		const native_type& native() const noexcept
+		{
+			return m_mask;
+		}
+
+		basic_simd_mask operator!() const noexcept
+		{
+			return detail::simdInvoke<basic_simd_mask, &ops::template maskNot<T>>(m_mask);
+		}
+
+		friend basic_simd_mask operator&(const basic_simd_mask& a, const basic_simd_mask& b) noexcept
+		{
+			return detail::simdInvoke<basic_simd_mask, &ops::template maskAnd<T>>(a.m_mask, b.m_mask);
+		}
+
+		friend basic_simd_mask operator|(const basic_simd_mask& a, const basic_simd_mask& b) noexcept
+		{
+			return detail::simdInvoke<basic_simd_mask, &ops::template maskOr<T>>(a.m_mask, b.m_mask);
+		}
+
+		friend basic_simd_mask operator^(const basic_simd_mask& a, const basic_simd_mask& b) noexcept
+		{
+			return detail::simdInvoke<basic_simd_mask, &ops::template maskXor<T>>(a.m_mask, b.m_mask);
+		}
+
+	private:
+		native_type m_mask;
+	};
+
+	template <class T, class Abi>
+	bool any_of(const basic_simd_mask<T, Abi>& m) noexcept
+	{
+		return m.to_bits() != 0;
+	}
+
+	template <class T, class Abi>
+	bool all_of(const basic_simd_mask<T, Abi>& m) noexcept
+	{
+		return m.to_bits() == detail::laneBits(m.size());
+	}
+
+	template <class T, class Abi>
+	bool none_of(const basic_simd_mask<T, Abi>& m) noexcept
+	{
+		return m.to_bits() == 0;
+	}
+
+	// A register's worth of T, or N of them in an array for the scalar
+	// ABI. Loads and stores needn't be aligned.
+	//
+	// The members aren't target specific, and a function without AVX passes
+	// and returns AVX registers differently from one with it. So the
+	// register only goes into and out of a backend by reference, through
+	// simd_ops::invoke, and is right whether or not anything gets inlined.
+	template <class T, class Abi>
+	class basic_simd
+	{
+		static_assert(detail::isSimdElement<T>, "[brisk::simd]: lanes must be integers of 1, 2, 4 or 8 bytes, float or double");
+
+		using ops = detail::simd_ops<Abi>;
+
+	public:
+		using value_type = T;
+		using abi_type = Abi;
+		using mask_type = basic_simd_mask<T, Abi>;
+		using native_type = typename ops::template reg<T>;
+
+		basic_simd() noexcept
+		{
+			ops::template invoke<&ops::template zero<T>>(m_reg);
+		}
+
+		basic_simd(T value) noexcept
+		{
+			ops::template invoke<&ops::template broadcast<T>>(m_reg, value);
+		}
+
+		explicit basic_simd(const native_type& r) noexcept
+			: m_reg(r)
+		{
+
+		}
+
+		static constexpr brisk::size_t size() noexcept
+		{
+			return ops::template lanes<T>;
+		}
+
+		static basic_simd load(const T* p) noexcept
+		{
+			return detail::simdInvoke<basic_simd, &ops::template load<T>>(p);
+		}
+
+		// Lane i is base[index[i]].
+		static basic_simd gather(const T* base, const std::int32_t* index) noexcept
+		{
+			return detail::simdInvoke<basic_simd, &ops::template gather<T>>(base, index);
+		}
+
+		void store(T* p) const noexcept
+		{
+			ops::template store<T>(p, m_reg);
+		}
+
+		T operator[](brisk::size_t i) const noexcept
+		{
+			T lanes[size()];
+			store(lanes);
+			return lanes[i];
+		}
+
+		const native_type& native() const noexcept
+		{
+			return m_reg;
+		}
+
+		basic_simd operator-() const noexcept
+		{
+			return basic_simd() - *this;
+		}
+
+		basic_simd& operator+=(const basic_simd& other) noexcept
+		{
+			ops::template invoke<&ops::template add<T>>(m_reg, m_reg, other.m_reg);
+			return *this;
+		}
+
+		basic_simd& operator-=(const basic_simd& other) noexcept
+		{
+			ops::template invoke<&ops::template sub<T>>(m_reg, m_reg, other.m_reg);
+			return *this;
+		}
+
+		basic_simd& operator*=(const basic_simd& other) noexcept
+		{
+			ops::template invoke<&ops::template mul<T>>(m_reg, m_reg, other.m_reg);
+			return *this;
+		}
+
+		basic_simd& operator/=(const basic_simd& other) noexcept
+		{
+			ops::template invoke<&ops::template div<T>>(m_reg, m_reg, other.m_reg);
+			return *this;
+		}
+
+		basic_simd& operator&=(const basic_simd& other) noexcept
+		{
+			ops::template invoke<&ops::template bitAnd<T>>(m_reg, m_reg, other.m_reg);
+			return *this;
+		}
+
+		basic_simd& operator|=(const basic_simd& other) noexcept
+		{
+			ops::template invoke<&ops::template bitOr<T>>(m_reg, m_reg, other.m_reg);
+			return *this;
+		}
+
+		basic_simd& operator^=(const basic_simd& other) noexcept
+		{
+			ops::template invoke<&ops::template bitXor<T>>(m_reg, m_reg, other.m_reg);
+			return *this;
+		}
+
+		friend basic_simd operator+(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<basic_simd, &ops::template add<T>>(a.m_reg, b.m_reg);
+		}
+
+		friend basic_simd operator-(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<basic_simd, &ops::template sub<T>>(a.m_reg, b.m_reg);
+		}
+
+		friend basic_simd operator*(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<basic_simd, &ops::template mul<T>>(a.m_reg, b.m_reg);
+		}
+
+		friend basic_simd operator/(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<basic_simd, &ops::template div<T>>(a.m_reg, b.m_reg);
+		}
+
+		friend basic_simd operator&(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<basic_simd, &ops::template bitAnd<T>>(a.m_reg, b.m_reg);
+		}
+
+		friend basic_simd operator|(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<basic_simd, &ops::template bitOr<T>>(a.m_reg, b.m_reg);
+		}
+
+		friend basic_simd operator^(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<basic_simd, &ops::template bitXor<T>>(a.m_reg, b.m_reg);
+		}
+
+		friend mask_type operator==(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<mask_type, &ops::template compare<T, detail::compare_eq>>(a.m_reg, b.m_reg);
+		}
+
+		friend mask_type operator!=(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<mask_type, &ops::template compare<T, detail::compare_ne>>(a.m_reg, b.m_reg);
+		}
+
+		friend mask_type operator<(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<mask_type, &ops::template compare<T, detail::compare_lt>>(a.m_reg, b.m_reg);
+		}
+
+		friend mask_type operator<=(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<mask_type, &ops::template compare<T, detail::compare_le>>(a.m_reg, b.m_reg);
+		}
+
+		friend mask_type operator>(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<mask_type, &ops::template compare<T, detail::compare_gt>>(a.m_reg, b.m_reg);
+		}
+
+		friend mask_type operator>=(const basic_simd& a, const basic_simd& b) noexcept
+		{
+			return detail::simdInvoke<mask_type, &ops::template compare<T, detail::compare_ge>>(a.m_reg, b.m_reg);
+		}
+
+	private:
+		native_type m_reg;
+	};
+
+	// N lanes of T in the register that holds them exactly, else an array.
+	template <class T, brisk::size_t N>
+	using simd = basic_simd<T, typename detail::deduce_abi<T, N * sizeof(T)>::type>;
+
+	template <class T, brisk::size_t N>
+	using simd_mask = basic_simd_mask<T, typename detail::deduce_abi<T, N * sizeof(T)>::type>;
+
+	// Lane i is a's where m is set, b's where not.
+	template <class T, class Abi>
+	basic_simd<T, Abi> select(const basic_simd_mask<T, Abi>& m, const basic_simd<T, Abi>& a, const basic_simd<T, Abi>& b) noexcept
+	{
+		return detail::simdInvoke<basic_simd<T, Abi>, &detail::simd_ops<Abi>::template select<T>>(m.native(), a.native(), b.native());
+	}
+
+	// Lane-wise brisk::min and brisk::max, NaNs included.
+	template <class T, class Abi>
+	basic_simd<T, Abi> min(const basic_simd<T, Abi>& a, const basic_simd<T, Abi>& b) noexcept
+	{
+		return detail::simdInvoke<basic_simd<T, Abi>, &detail::simd_ops<Abi>::template min<T>>(a.native(), b.native());
+	}
+
+	template <class T, class Abi>
+	basic_simd<T, Abi> max(const basic_simd<T, Abi>& a, const basic_simd<T, Abi>& b) noexcept
+	{
+		return detail::simdInvoke<basic_simd<T, Abi>, &detail::simd_ops<Abi>::template max<T>>(a.native(), b.native());
+	}
+
+	// Lane i is v[index[i]].
+	template <class T, class Abi>
+	basic_simd<T, Abi> permute(const basic_simd<T, Abi>& v, const std::int32_t* index) noexcept
+	{
+		return detail::simdInvoke<basic_simd<T, Abi>, &detail::simd_ops<Abi>::template permute<T>>(v.native(), index);
+	}
+
+	template <class T, class Abi>
+	basic_simd<T, Abi> reverse(const basic_simd<T, Abi>& v) noexcept
+	{
+		constexpr brisk::size_t lanes = basic_simd<T, Abi>::size();
+		std::int32_t index[lanes];
+		for (brisk::size_t i = 0; i < lanes; ++i) {
+			index[i] = static_cast<std::int32_t>(lanes - 1 - i);
+		}
+		return permute(v, index);
+	}
+
+	// The horizontal reductions run once, after a kernel's loop, so they
+	// go through memory rather than a ladder of shuffles per width.
+	template <class T, class Abi>
+	T reduce_add(const basic_simd<T, Abi>& v) noexcept
+	{
+		T lanes[basic_simd<T, Abi>::size()];
+		v.store(lanes);
+		T sum = lanes[0];
+		for (brisk::size_t i = 1; i < v.size(); ++i) {
+			sum = detail::wrapAdd(sum, lanes[i]);
+		}
+		return sum;
+	}
+
+	template <class T, class Abi>
+	T reduce_min(const basic_simd<T, Abi>& v) noexcept
+	{
+		T lanes[basic_simd<T, Abi>::size()];
+		v.store(lanes);
+		T least = lanes[0];
+		for (brisk::size_t i = 1; i < v.size(); ++i) {
+			least = (lanes[i] < least) ? lanes[i] : least;
+		}
+		return least;
+	}
+
+	template <class T, class Abi>
+	T reduce_max(const basic_simd<T, Abi>& v) noexcept
+	{
+		T lanes[basic_simd<T, Abi>::size()];
+		v.store(lanes);
+		T greatest = lanes[0];
+		for (brisk::size_t i = 1; i < v.size(); ++i) {
+			greatest = (greatest < lanes[i]) ? lanes[i] : greatest;
+		}
+		return greatest;
+	}
+
+	namespace detail
+	{
+		inline simd_isa detectSimdIsa() noexcept
+		{
+#if defined(BRISK_SIMD_X86)
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl")) {
+				return simd_isa::avx512;
+			}
+			if (__builtin_cpu_supports("avx2")) {
+				return simd_isa::avx2;
+			}
+			if (__builtin_cpu_supports("sse2")) {
+				return simd_isa::sse2;
+			}
+#endif
+			return simd_isa::scalar;
+		}
+	}
+
+	// The best instruction set this CPU runs, detected once.
+	inline simd_isa simd_supported_isa() noexcept
+	{
+		static const simd_isa supported = detail::detectSimdIsa();
+		return supported;
+	}
+
+	namespace detail
+	{
+		inline std::atomic<simd_isa>& activeSimdIsa() noexcept
+		{
+			static std::atomic<simd_isa> active(simd_supported_isa());
+			return active;
+		}
+
+		template <class Kernel, class... Args>
+		BRISK_SIMD_FLATTEN auto runScalar(Args... args)
+		{
+			return Kernel::template run<simd_abi::scalar>(args...);
+		}
+
+#if defined(BRISK_SIMD_X86)
+		template <class Kernel, class... Args>
+		BRISK_TARGET_SSE2 BRISK_SIMD_FLATTEN auto runSse2(Args... args)
+		{
+			return Kernel::template run<simd_abi::sse2>(args...);
+		}
+
+		template <class Kernel, class... Args>
+		BRISK_TARGET_AVX2 BRISK_SIMD_FLATTEN auto runAvx2(Args... args)
+		{
+			return Kernel::template run<simd_abi::avx2>(args...);
+		}
+
+		template <class Kernel, class... Args>
+		BRISK_TARGET_AVX512 BRISK_SIMD_FLATTEN auto runAvx512(Args... args)
+		{
+			return Kernel::template run<simd_abi::avx512>(args...);
+		}
+#endif
+	}
+
+	// What simd_dispatch runs on: the supported set unless set_simd_isa
+	// asked for less.
+	inline simd_isa simd_active_isa() noexcept
+	{
+		return detail::activeSimdIsa().load(std::memory_order_relaxed);
+	}
+
+	// Caps dispatch at isa, or at what the CPU has if that's less, and
+	// returns the one now active. For benchmarks and for pinning results
+	// that depend on the lane count, like a float reduce.
+	inline simd_isa set_simd_isa(simd_isa isa) noexcept
+	{
+		if (isa > simd_supported_isa()) {
+			isa = simd_supported_isa();
+		}
+
+		detail::activeSimdIsa().store(isa, std::memory_order_relaxed);
+		return isa;
+	}
+
+	inline const char* simd_isa_name(simd_isa isa) noexcept
+	{
+		switch (isa) {
+		case simd_isa::sse2:
+			return "sse2";
+		case simd_isa::avx2:
+			return "avx2";
+		case simd_isa::avx512:
+			return "avx512";
+		default:
+			return "scalar";
+		}
+	}
+
+	// Runs Kernel::run<Abi>(args...) for the ABI of the active instruction
+	// set. Each one is compiled in a wrapper targeting its instruction set,
+	// so one binary carries all of them whatever flags it was built with;
+	// the wrapper inlines everything the kernel calls when optimizing, so
+	// the registers stay in registers.
+	template <class Kernel, class... Args>
+	auto simd_dispatch(Args... args)
+	{
+#if defined(BRISK_SIMD_X86)
+		switch (simd_active_isa()) {
+		case simd_isa::avx512:
+			return detail::runAvx512<Kernel>(args...);
+		case simd_isa::avx2:
+			return detail::runAvx2<Kernel>(args...);
+		case simd_isa::sse2:
+			return detail::runSse2<Kernel>(args...);
+		default:
+			break;
+		}
+#endif
+		return detail::runScalar<Kernel>(args...);
+	}
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC diagnostic pop
+#endif
@@ -3,8 +3,15 @@
 #include <istream>
 #include <ostream>
 #include <iterator>
+#include <cstring>
+#include <stdexcept>
 
+#include "briskdef.hpp"
 #include "utility.hpp"
+#include "memory_resource.hpp"
+#ifdef BRISK_HEAP_PROFILE
+#include "heap_profiler.hpp"
+#endif
 
 namespace brisk
 {
@@ -25,69 +32,94 @@ namespace brisk
     class string
     {        
     public:
-        string()
+        string() : string(brisk::get_default_resource())
+        {
+
+        }
+
+        explicit string(memory_resource* resource)
+            : m_resource(resource)
         {
             m_size = 16;
-            m_characters = 0;
-            m_string = new char[m_size];
+            m_characters = 1;
+            m_string = allocate(m_size);
+            memset(m_string, 0, m_size);
         }
 
-        string(const char* s)
+        string(const char* s, memory_resource* resource = brisk::get_default_resource())
+            : m_resource(resource)
         {
             m_characters = brisk::strsize(s);
             m_size = m_characters << 2;
-            m_string = new char[m_size];
+            m_string = allocate(m_size);
             memcpy(m_string, s, m_characters);
             memset(&m_string[m_characters], 0, m_size - m_characters);
         }
 
         string(const char c)
+            : m_resource(brisk::get_default_resource())
         {
             m_size = 16;
             m_characters = 2;
-            m_string = new char[m_size];
+            m_string = allocate(m_size);
             m_string[0] = c;
             memset(&m_string[1], 0 , m_size - m_characters);
         }
 
         string(size_t newSize)
+            : m_resource(brisk::get_default_resource())
         {
             m_size = newSize;
             m_characters = 0;
-            m_string = new char[newSize];
+            m_string = allocate(newSize);
             memset(m_string, 0, m_size);
         }
 
-        string(const string& other)
+        // A copy uses the default resource unless it's given one.
+        string(const string& other) : string(other, brisk::get_default_resource())
+        {
+
+        }
+
+        string(const string& other, memory_resource* resource)
+            : m_resource(resource)
         {
             m_size = other.m_size;
             m_characters = other.m_characters;
-            m_string = new char[m_size];
+            m_string = allocate(m_size);
             memcpy(m_string, other.m_string, m_size);
             memset(&m_string[m_characters], 0, m_size - m_characters);
         }
 
         string(string&& other)
+            : m_resource(other.m_resource)
         {
             m_string = other.m_string;
             m_size = brisk::move(other.m_size);
             m_characters = brisk::move(other.m_characters);
-            other.m_string = new char[16];
+            other.m_string = other.allocate(16);
             other.m_size = 16;
-            other.m_characters = 0;
+            other.m_characters = 1;
+            memset(other.m_string, 0, other.m_size);
         }
 
         ~string()
         {
-            delete[] m_string;
+            deallocate(m_string, m_size);
         }
 
+        // Assignment keeps this string's resource.
         string& operator=(const string& str)
         {
-            m_characters = str.size();
-            m_size = str.capacity();
-            m_string = new char[m_size];
-            memcpy(m_string, str.data(), m_size);
+            if (this != &str)
+            {
+                char* buffer = allocate(str.m_size);
+                memcpy(buffer, str.m_string, str.m_size);
+                deallocate(m_string, m_size);
+                m_string = buffer;
+                m_characters = str.m_characters;
+                m_size = str.m_size;
+            }
             return *this;
         }
 
@@ -201,6 +233,13 @@ namespace brisk
             }
         }
 
+        // Empties the string but keeps its buffer.
+        void clear() noexcept
+        {
+            memset(m_string, 0, m_characters);
+            m_characters = 1;
+        }
+
         char& operator[](size_t index)
         {
             return m_string[index];
@@ -257,6 +296,11 @@ namespace brisk
             return m_string;
         }
 
+        memory_resource* resource() const noexcept
+        {
+            return m_resource;
+        }
+
         char* begin() noexcept
         {
             return &m_string[0];
@@ -305,7 +349,7 @@ namespace brisk
         {
             // Destination = (beginning of m_string) + (number of characters without null term)
             // Size = (allocated size) - (number of characters with null term)
-            char* buffer = new char[newSize];
+            char* buffer = allocate(newSize);
             if (newSize > m_size)
             {
                 for (brisk::size_t i = 0; i < m_size; i++) {
@@ -322,15 +366,29 @@ namespace brisk
 
             memset((buffer + strlen(buffer)), 0, (newSize - strsize(buffer)));
 
-            delete[] m_string;
+            deallocate(m_string, m_size);
             m_string = buffer;
             m_size = newSize;
             m_characters = strsize(m_string);
         }
 
+        char* allocate(size_t n)
+        {
+            BRISK_HEAP_SAMPLE(n);
+            return static_cast<char*>(m_resource->allocate(n, 1));
+        }
+
+        void deallocate(char* s, size_t n) noexcept
+        {
+            if (s != nullptr) {
+                m_resource->deallocate(s, n, 1);
+            }
+        }
+
         char* m_string;
         size_t m_characters;    // Includes null-term char
         size_t m_size;          // Actual allocated size
+        memory_resource* m_resource;
     };
     
     std::ostream& operator<<(std::ostream& out, const brisk::string& string)
@@ -341,9 +399,9 @@ namespace brisk
 
     std::istream& operator>>(std::istream& in, brisk::string& string)
     {
-        delete[] string.m_string;
+        string.deallocate(string.m_string, string.m_size);
         string.m_size = 256;
-        string.m_string = new char[string.m_size];
+        string.m_string = string.allocate(string.m_size);
         in.getline(string.m_string, 256, 10);
         string.m_characters = strsize(string.m_string);
         return in;
@@ -0,0 +1,814 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "memory_resource.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BRISK_HAS_THREAD_CACHING_RESOURCE
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace brisk
+{
+	// Counters for thread_caching_resource. Pages are 4KB; "free" pages
+	// sit in the page heap still backed by memory, "released" ones have been
+	// given back to the OS with madvise and fault back in as zero pages.
+	struct thread_caching_stats
+	{
+		brisk::size_t mappedBytes = 0;
+		brisk::size_t freeBytes = 0;
+		brisk::size_t releasedBytes = 0;
+		brisk::size_t largeBytes = 0;
+	};
+
+	namespace detail
+	{
+		namespace tc
+		{
+			constexpr brisk::size_t pageShift = 12;
+			constexpr brisk::size_t pageSize = brisk::size_t(1) << pageShift;
+			constexpr brisk::size_t maxSmall = 32768;
+			constexpr brisk::size_t classCount = 40;
+			constexpr brisk::size_t heapGrowth = brisk::size_t(2) << 20;     // mmap 2MB at a time
+			constexpr brisk::size_t freeListCount = 128;                     // exact lists for spans up to 128 pages
+			constexpr brisk::size_t releaseThreshold = brisk::size_t(32) << 20;
+
+			// Classes go up in 16 byte steps to 128, then four steps per
+			// power of two up to 32KB, which keeps internal waste under 25%.
+			// A class size is a multiple of every power of two up to its step,
+			// so objects carved from a page-aligned span are aligned to it.
+			constexpr brisk::size_t sizeClass(brisk::size_t size) noexcept
+			{
+				if (size <= 128) {
+					return (size <= 16) ? 0 : (size + 15) / 16 - 1;
+				}
+
+				brisk::size_t p = std::bit_width(size - 1);
+				brisk::size_t offset = (size - 1 - (brisk::size_t(1) << (p - 1))) >> (p - 3);
+				return 8 + (p - 8) * 4 + offset;
+			}
+
+			constexpr brisk::size_t classSize(brisk::size_t c) noexcept
+			{
+				if (c < 8) {
+					return (c + 1) * 16;
+				}
+
+				brisk::size_t p = 8 + (c - 8) / 4;
+				return (brisk::size_t(1) << (p - 1)) + ((c - 8) % 4 + 1) * (brisk::size_t(1) << (p - 3));
+			}
+
+			// How many objects move between a thread cache and the central
+			// lists at once: about 64KB worth, between 2 and 32 objects.
+			constexpr brisk::size_t batchSize(brisk::size_t c) noexcept
+			{
+				brisk::size_t n = (brisk::size_t(64) << 10) / classSize(c);
+				return (n < 2) ? 2 : (n > 32) ? 32 : n;
+			}
+
+			// Pages per span, enough for at least eight objects.
+			constexpr brisk::size_t spanPages(brisk::size_t c) noexcept
+			{
+				brisk::size_t bytes = classSize(c) * 8;
+				return (bytes + pageSize - 1) / pageSize;
+			}
+
+			struct object
+			{
+				object* next;
+			};
+
+			struct span
+			{
+				std::uintptr_t start;          // first page number
+				brisk::size_t pages;
+				object* free;
+				brisk::size_t allocated;       // objects handed out
+				span* next;
+				span* prev;
+				int sizeClass;                 // -1 while the span is in the page heap
+				bool inHeap;
+				bool released;
+			};
+
+			inline void listInit(span* list) noexcept
+			{
+				list->next = list->prev = list;
+			}
+
+			inline bool listEmpty(const span* list) noexcept
+			{
+				return list->next == list;
+			}
+
+			inline void listPush(span* list, span* s) noexcept
+			{
+				s->next = list->next;
+				s->prev = list;
+				list->next->prev = s;
+				list->next = s;
+			}
+
+			inline void listRemove(span* s) noexcept
+			{
+				s->prev->next = s->next;
+				s->next->prev = s->prev;
+				s->next = s->prev = nullptr;
+			}
+
+			inline void* mapPages(brisk::size_t bytes) noexcept
+			{
+				void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				return (p == MAP_FAILED) ? nullptr : p;
+			}
+
+			// Fixed-size metadata (spans, pagemap leaves) comes from here so
+			// the allocator never calls back into the heap it is managing.
+			template <class Type>
+			class metadata_pool
+			{
+			public:
+				Type* allocate()
+				{
+					if (m_free != nullptr) {
+						object* o = m_free;
+						m_free = o->next;
+						return reinterpret_cast<Type*>(o);
+					}
+
+					if (m_current + sizeof(Type) > m_end) {
+						brisk::size_t bytes = (sizeof(Type) > (brisk::size_t(64) << 10)) ? sizeof(Type) : (brisk::size_t(64) << 10);
+						m_current = static_cast<char*>(mapPages(bytes));
+						if (m_current == nullptr) {
+							throw std::bad_alloc();
+						}
+						m_end = m_current + bytes;
+					}
+
+					Type* t = reinterpret_cast<Type*>(m_current);
+					m_current += (sizeof(Type) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+					return t;
+				}
+
+				void deallocate(Type* t) noexcept
+				{
+					object* o = reinterpret_cast<object*>(t);
+					o->next = m_free;
+					m_free = o;
+				}
+
+			private:
+				object* m_free = nullptr;
+				char* m_current = nullptr;
+				char* m_end = nullptr;
+			};
+
+			// Page number -> span, as a two level radix tree over 48-bit
+			// addresses. Leaves are mapped on first use. Relies on living in
+			// fresh anonymous memory for the zeroed root and leaves, so it
+			// never touches the 2MB root or a leaf until it needs to.
+			class pagemap
+			{
+			public:
+				static constexpr brisk::size_t bits = 48 - pageShift;
+				static constexpr brisk::size_t leafBits = bits / 2;
+				static constexpr brisk::size_t rootBits = bits - leafBits;
+
+				span* get(std::uintptr_t page) const noexcept
+				{
+					leaf* l = m_root[page >> leafBits];
+					return (l == nullptr) ? nullptr : l->spans[page & ((brisk::size_t(1) << leafBits) - 1)];
+				}
+
+				void set(std::uintptr_t page, span* s)
+				{
+					leaf*& l = m_root[page >> leafBits];
+					if (l == nullptr) {
+						l = m_leaves.allocate();
+					}
+					l->spans[page & ((brisk::size_t(1) << leafBits) - 1)] = s;
+				}
+
+			private:
+				struct leaf
+				{
+					span* spans[brisk::size_t(1) << leafBits];
+				};
+
+				leaf* m_root[brisk::size_t(1) << rootBits];
+				metadata_pool<leaf> m_leaves;
+			};
+
+			// Free runs of pages, coalesced with their neighbours as they come
+			// back. Memory is mapped from the OS in 2MB steps and never
+			// unmapped; once more than releaseThreshold sits free, the largest
+			// free spans are madvised away.
+			class page_heap
+			{
+			public:
+				page_heap() noexcept
+				{
+					for (span& list : m_free) {
+						listInit(&list);
+					}
+					listInit(&m_large);
+				}
+
+				span* allocate(brisk::size_t pages)
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					span* s = find(pages);
+					if (s == nullptr) {
+						grow(pages);
+						s = find(pages);
+						if (s == nullptr) {
+							throw std::bad_alloc();
+						}
+					}
+
+					removeFree(s);
+					if (s->pages > pages) {
+						span* rest = m_spans.allocate();
+						*rest = span{s->start + pages, s->pages - pages, nullptr, 0, nullptr, nullptr, -1, false, s->released};
+						s->pages = pages;
+						insertFree(rest);
+					}
+
+					s->inHeap = false;
+					s->released = false;
+					return s;
+				}
+
+				// Makes every page of s point at it, for small-object spans
+				// whose objects can be anywhere inside.
+				void registerSpan(span* s)
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					for (brisk::size_t i = 0; i < s->pages; ++i) {
+						m_pagemap.set(s->start + i, s);
+					}
+				}
+
+				span* lookup(const void* p) const noexcept
+				{
+					return m_pagemap.get(reinterpret_cast<std::uintptr_t>(p) >> pageShift);
+				}
+
+				void deallocate(span* s)
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					s->sizeClass = -1;
+					s->free = nullptr;
+					s->allocated = 0;
+
+					span* before = (s->start > 0) ? m_pagemap.get(s->start - 1) : nullptr;
+					if (before != nullptr && before->inHeap) {
+						removeFree(before);
+						s->start = before->start;
+						s->pages += before->pages;
+						s->released = s->released && before->released;
+						m_spans.deallocate(before);
+					}
+
+					span* after = m_pagemap.get(s->start + s->pages);
+					if (after != nullptr && after->inHeap) {
+						removeFree(after);
+						s->pages += after->pages;
+						s->released = s->released && after->released;
+						m_spans.deallocate(after);
+					}
+
+					insertFree(s);
+					if (m_freePages * pageSize > releaseThreshold) {
+						release(m_freePages - (releaseThreshold / pageSize) / 2);
+					}
+				}
+
+				// Gives up to pages free pages back to the OS, biggest spans first.
+				brisk::size_t release(brisk::size_t pages) noexcept
+				{
+					brisk::size_t released = 0;
+					for (span* list = &m_large; released < pages; ) {
+						span* s = nullptr;
+						for (span* it = list->next; it != list; it = it->next) {
+							if (!it->released) {
+								s = it;
+								break;
+							}
+						}
+
+						if (s == nullptr) {
+							if (list == &m_free[0]) {
+								break;
+							}
+							list = (list == &m_large) ? &m_free[freeListCount - 1] : list - 1;
+							continue;
+						}
+
+						madvise(reinterpret_cast<void*>(s->start << pageShift), s->pages << pageShift, MADV_DONTNEED);
+						s->released = true;
+						m_freePages -= s->pages;
+						m_releasedPages += s->pages;
+						released += s->pages;
+					}
+					return released;
+				}
+
+				brisk::size_t release_all() noexcept
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					return release(m_freePages);
+				}
+
+				span* new_span()
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					return m_spans.allocate();
+				}
+
+				void delete_span(span* s) noexcept
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_spans.deallocate(s);
+				}
+
+				void stats(thread_caching_stats& out) noexcept
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					out.mappedBytes = m_mappedPages * pageSize;
+					out.freeBytes = m_freePages * pageSize;
+					out.releasedBytes = m_releasedPages * pageSize;
+				}
+
+			private:
+				span* find(brisk::size_t pages) noexcept
+				{
+					for (brisk::size_t n = pages; n <= freeListCount; ++n) {
+						if (!listEmpty(&m_free[n - 1])) {
+							return m_free[n - 1].next;
+						}
+					}
+
+					// best fit among the big ones
+					span* best = nullptr;
+					for (span* s = m_large.next; s != &m_large; s = s->next) {
+						if (s->pages >= pages && (best == nullptr || s->pages < best->pages)) {
+							best = s;
+						}
+					}
+					return best;
+				}
+
+				void grow(brisk::size_t pages)
+				{
+					brisk::size_t bytes = pages * pageSize;
+					bytes = (bytes < heapGrowth) ? heapGrowth : (bytes + heapGrowth - 1) / heapGrowth * heapGrowth;
+
+					void* memory = mapPages(bytes);
+					if (memory == nullptr) {
+						throw std::bad_alloc();
+					}
+
+					span* s = m_spans.allocate();
+					*s = span{reinterpret_cast<std::uintptr_t>(memory) >> pageShift, bytes / pageSize, nullptr, 0, nullptr, nullptr, -1, false, false};
+					m_mappedPages += s->pages;
+					insertFree(s);
+				}
+
+				void insertFree(span* s)
+				{
+					s->inHeap = true;
+					m_pagemap.set(s->start, s);
+					m_pagemap.set(s->start + s->pages - 1, s);
+					listPush((s->pages <= freeListCount) ? &m_free[s->pages - 1] : &m_large, s);
+					if (s->released) {
+						m_releasedPages += s->pages;
+					} else {
+						m_freePages += s->pages;
+					}
+				}
+
+				void removeFree(span* s) noexcept
+				{
+					listRemove(s);
+					if (s->released) {
+						m_releasedPages -= s->pages;
+					} else {
+						m_freePages -= s->pages;
+					}
+				}
+
+				std::mutex m_mutex;
+				span m_free[freeListCount];
+				span m_large;
+				pagemap m_pagemap;
+				metadata_pool<span> m_spans;
+				brisk::size_t m_mappedPages = 0;
+				brisk::size_t m_freePages = 0;
+				brisk::size_t m_releasedPages = 0;
+			};
+
+			// Spans of one size class with objects still free in them. A span
+			// whose last object comes back is returned to the page heap.
+			class central_list
+			{
+			public:
+				void init(brisk::size_t c, page_heap* heap) noexcept
+				{
+					m_class = c;
+					m_heap = heap;
+					listInit(&m_nonempty);
+				}
+
+				// Pops up to n objects onto head; returns how many.
+				brisk::size_t remove(object*& head, brisk::size_t n)
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					brisk::size_t taken = 0;
+					while (taken < n) {
+						if (listEmpty(&m_nonempty)) {
+							populate();
+						}
+
+						span* s = m_nonempty.next;
+						while (s->free != nullptr && taken < n) {
+							object* o = s->free;
+							s->free = o->next;
+							o->next = head;
+							head = o;
+							++s->allocated;
+							++taken;
+						}
+
+						if (s->free == nullptr) {
+							listRemove(s);
+						}
+					}
+					return taken;
+				}
+
+				void insert(object* head)
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					while (head != nullptr) {
+						object* o = head;
+						head = head->next;
+
+						span* s = m_heap->lookup(o);
+						if (s->free == nullptr) {
+							listPush(&m_nonempty, s);
+						}
+						o->next = s->free;
+						s->free = o;
+
+						if (--s->allocated == 0) {
+							listRemove(s);
+							m_heap->deallocate(s);
+						}
+					}
+				}
+
+			private:
+				void populate()
+				{
+					brisk::size_t size = classSize(m_class);
+					span* s = m_heap->allocate(spanPages(m_class));
+					s->sizeClass = static_cast<int>(m_class);
+					m_heap->registerSpan(s);
+
+					char* base = reinterpret_cast<char*>(s->start << pageShift);
+					brisk::size_t count = (s->pages << pageShift) / size;
+					object* head = nullptr;
+					for (brisk::size_t i = count; i-- > 0;) {
+						object* o = reinterpret_cast<object*>(base + i * size);
+						o->next = head;
+						head = o;
+					}
+					s->free = head;
+					s->allocated = 0;
+					listPush(&m_nonempty, s);
+				}
+
+				std::mutex m_mutex;
+				span m_nonempty;
+				brisk::size_t m_class = 0;
+				page_heap* m_heap = nullptr;
+			};
+
+			// Whole batches parked between thread caches, so a batch one thread
+			// frees can go straight to another thread without touching spans.
+			class transfer_cache
+			{
+			public:
+				static constexpr brisk::size_t slots = 256;
+
+				void init(brisk::size_t c) noexcept
+				{
+					m_batch = batchSize(c);
+					m_capacity = (slots / m_batch) * m_batch;
+				}
+
+				bool insert(object* head, brisk::size_t n)
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (n != m_batch || m_count + n > m_capacity) {
+						return false;
+					}
+
+					for (; head != nullptr; head = head->next) {
+						m_slots[m_count++] = head;
+					}
+					return true;
+				}
+
+				bool remove(object*& head, brisk::size_t n)
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (n != m_batch || m_count < n) {
+						return false;
+					}
+
+					for (brisk::size_t i = 0; i < n; ++i) {
+						object* o = m_slots[--m_count];
+						o->next = head;
+						head = o;
+					}
+					return true;
+				}
+
+			private:
+				std::mutex m_mutex;
+				object* m_slots[slots];
+				brisk::size_t m_count = 0;
+				brisk::size_t m_batch = 0;
+				brisk::size_t m_capacity = 0;
+			};
+
+			class heap
+			{
+			public:
+				// Lives in its own mapping (see pagemap) and is never destroyed,
+				// so memory can still be freed during static destruction.
+				static heap& instance()
+				{
+					static heap* h = create();
+					return *h;
+				}
+
+				// Fetches a batch for a thread cache.
+				brisk::size_t fetch(brisk::size_t c, object*& head)
+				{
+					brisk::size_t n = batchSize(c);
+					if (m_transfer[c].remove(head, n)) {
+						return n;
+					}
+					return m_central[c].remove(head, n);
+				}
+
+				// head is a null-terminated list of n objects.
+				void give(brisk::size_t c, object* head, brisk::size_t n)
+				{
+					if (!m_transfer[c].insert(head, n)) {
+						m_central[c].insert(head);
+					}
+				}
+
+				void* allocate_large(brisk::size_t bytes, brisk::size_t alignment)
+				{
+					brisk::size_t pages = (bytes + alignment - pageSize + pageSize - 1) / pageSize;
+					span* s = m_pages.allocate(pages);
+					s->sizeClass = -2;
+					m_pages.registerSpan(s);
+
+					std::lock_guard<std::mutex> lock(m_largeMutex);
+					m_largeBytes += s->pages << pageShift;
+
+					std::uintptr_t address = s->start << pageShift;
+					return reinterpret_cast<void*>((address + alignment - 1) & ~(alignment - 1));
+				}
+
+				void deallocate_large(void* p) noexcept
+				{
+					span* s = m_pages.lookup(p);
+					{
+						std::lock_guard<std::mutex> lock(m_largeMutex);
+						m_largeBytes -= s->pages << pageShift;
+					}
+					m_pages.deallocate(s);
+				}
+
+				brisk::size_t release_free_memory() noexcept
+				{
+					return m_pages.release_all() * pageSize;
+				}
+
+				thread_caching_stats stats() noexcept
+				{
+					thread_caching_stats out;
+					m_pages.stats(out);
+					std::lock_guard<std::mutex> lock(m_largeMutex);
+					out.largeBytes = m_largeBytes;
+					return out;
+				}
+
+			private:
+				static heap* create()
+				{
+					void* memory = mapPages(sizeof(heap));
+					if (memory == nullptr) {
+						throw std::bad_alloc();
+					}
+					return ::new (memory) heap();
+				}
+
+				heap() noexcept
+				{
+					for (brisk::size_t c = 0; c < classCount; ++c) {
+						m_central[c].init(c, &m_pages);
+						m_transfer[c].init(c);
+					}
+				}
+
+				page_heap m_pages;
+				central_list m_central[classCount];
+				transfer_cache m_transfer[classCount];
+				std::mutex m_largeMutex;
+				brisk::size_t m_largeBytes = 0;
+			};
+
+			// Per-thread free lists, one per size class. A list that grows past
+			// two batches hands one back; whatever is left when the thread exits
+			// goes back to the central lists.
+			class thread_cache
+			{
+			public:
+				void* allocate(brisk::size_t c)
+				{
+					list& l = m_lists[c];
+					if (l.head == nullptr) {
+						l.length = heap::instance().fetch(c, l.head);
+					}
+
+					object* o = l.head;
+					l.head = o->next;
+					--l.length;
+					return o;
+				}
+
+				void deallocate(void* p, brisk::size_t c)
+				{
+					list& l = m_lists[c];
+					object* o = static_cast<object*>(p);
+					o->next = l.head;
+					l.head = o;
+
+					brisk::size_t batch = batchSize(c);
+					if (++l.length > 2 * batch) {
+						object* first = l.head;
+						object* last = first;
+						for (brisk::size_t i = 1; i < batch; ++i) {
+							last = last->next;
+						}
+						l.head = last->next;
+						last->next = nullptr;
+						l.length -= batch;
+						heap::instance().give(c, first, batch);
+					}
+				}
+
+				~thread_cache()
+				{
+					for (brisk::size_t c = 0; c < classCount; ++c) {
+						if (m_lists[c].head != nullptr) {
+							heap::instance().give(c, m_lists[c].head, m_lists[c].length);
+						}
+					}
+				}
+
+			private:
+				struct list
+				{
+					object* head = nullptr;
+					brisk::size_t length = 0;
+				};
+
+				list m_lists[classCount];
+			};
+
+			// The cache pointer stays valid until the thread's destructors run;
+			// anything freed after that goes to the central lists directly.
+			inline thread_cache* dead() noexcept
+			{
+				return reinterpret_cast<thread_cache*>(std::uintptr_t(1));
+			}
+
+			inline thread_local thread_cache* currentCache = nullptr;
+
+			struct thread_cache_owner
+			{
+				thread_cache cache;
+
+				~thread_cache_owner()
+				{
+					currentCache = dead();
+				}
+			};
+
+			inline thread_cache* localCache()
+			{
+				thread_cache* cache = currentCache;
+				if (cache == nullptr) {
+					static thread_local thread_cache_owner owner;
+					cache = currentCache = &owner.cache;
+				}
+				return cache;
+			}
+		}
+
+		// Small requests go through a per-thread cache; bigger or over-aligned
+		// ones take whole pages from the page heap. Every instance shares the
+		// same process-wide heap.
+		class thread_caching_resource final : public memory_resource
+		{
+		protected:
+			void* do_allocate(brisk::size_t bytes, brisk::size_t alignment) override
+			{
+				brisk::size_t size = roundedSize(bytes, alignment);
+				if (size > tc::maxSmall || alignment > tc::pageSize) {
+					return tc::heap::instance().allocate_large(bytes, (alignment < tc::pageSize) ? tc::pageSize : alignment);
+				}
+
+				brisk::size_t c = tc::sizeClass(size);
+				tc::thread_cache* cache = tc::localCache();
+				if (cache == tc::dead()) {
+					tc::object* o = nullptr;
+					tc::heap::instance().fetch(c, o);
+					if (o->next != nullptr) {
+						tc::heap::instance().give(c, o->next, tc::batchSize(c) - 1);
+					}
+					return o;
+				}
+				return cache->allocate(c);
+			}
+
+			void do_deallocate(void* p, brisk::size_t bytes, brisk::size_t alignment) override
+			{
+				brisk::size_t size = roundedSize(bytes, alignment);
+				if (size > tc::maxSmall || alignment > tc::pageSize) {
+					tc::heap::instance().deallocate_large(p);
+					return;
+				}
+
+				brisk::size_t c = tc::sizeClass(size);
+				tc::thread_cache* cache = tc::localCache();
+				if (cache == tc::dead()) {
+					tc::object* o = static_cast<tc::object*>(p);
+					o->next = nullptr;
+					tc::heap::instance().give(c, o, 1);
+					return;
+				}
+				cache->deallocate(p, c);
+			}
+
+			bool do_is_equal(const memory_resource& other) const noexcept override
+			{
+				return dynamic_cast<const thread_caching_resource*>(&other) != nullptr;
+			}
+
+		private:
+			static brisk::size_t roundedSize(brisk::size_t bytes, brisk::size_t alignment) noexcept
+			{
+				bytes = (bytes == 0) ? 1 : bytes;
+				return (alignment <= 16) ? bytes : (bytes + alignment - 1) & ~(alignment - 1);
+			}
+		};
+	}
+
+	// A tcmalloc-style general purpose resource: per-thread size-class
+	// caches in front of a transfer cache, central span lists and a page
+	// heap that madvises free memory back to the OS once enough piles up.
+	inline memory_resource* thread_caching_resource() noexcept
+	{
+		static detail::thread_caching_resource resource;
+		return &resource;
+	}
+
+	inline thread_caching_stats thread_caching_resource_stats() noexcept
+	{
+		return detail::tc::heap::instance().stats();
+	}
+
+	// Returns every free page to the OS; returns the number of bytes.
+	inline brisk::size_t thread_caching_release_free_memory() noexcept
+	{
+		return detail::tc::heap::instance().release_free_memory();
+	}
+}
+
+#endif
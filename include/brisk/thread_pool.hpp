@@ -0,0 +1,195 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace brisk
+{
+	// A fixed set of worker threads taking tasks from one queue. submit()
+	// runs a single task and hands back a future; bulk() runs a task over an
+	// index range on as many workers as will help, with the calling thread
+	// working too, and returns once every index is done. Because the caller
+	// takes part, bulk() from inside a task can't deadlock: at worst the
+	// caller does all of it.
+	class thread_pool
+	{
+	private:
+		// Shared with the helpers bulk() posts, so one that only gets to run
+		// after the caller has returned still has somewhere to look.
+		struct bulk_state
+		{
+			std::atomic<brisk::size_t> next{0};
+			std::atomic<brisk::size_t> finished{0};
+			std::atomic<bool> failed{false};
+			std::exception_ptr error;
+			brisk::size_t count = 0;
+			void (*run)(void*, brisk::size_t) = nullptr;
+			void* task = nullptr;
+
+			// Takes indices until there are none left. After a task has
+			// thrown, the rest are counted off without being run.
+			void work() noexcept
+			{
+				for (;;) {
+					brisk::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+					if (i >= count) {
+						return;
+					}
+
+					if (!failed.load(std::memory_order_relaxed)) {
+						try {
+							run(task, i);
+						} catch (...) {
+							if (!failed.exchange(true)) {
+								error = std::current_exception();
+							}
+						}
+					}
+
+					if (finished.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+						finished.notify_all();
+					}
+				}
+			}
+		};
+
+	public:
+		explicit thread_pool(brisk::size_t threads = defaultThreads())
+			: m_stopping(false)
+		{
+			if (threads == 0) {
+				threads = 1;
+			}
+
+			for (brisk::size_t i = 0; i < threads; ++i) {
+				m_workers.emplace_back(&thread_pool::workerLoop, this);
+			}
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		// Runs whatever is still queued, then joins the workers.
+		~thread_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stopping = true;
+			}
+
+			m_wake.notify_all();
+			for (brisk::size_t i = 0; i < m_workers.size(); ++i) {
+				m_workers[i].join();
+			}
+		}
+
+		brisk::size_t size() const noexcept
+		{
+			return m_workers.size();
+		}
+
+		template <class Function>
+		std::future<std::invoke_result_t<Function&>> submit(Function f)
+		{
+			using Result = std::invoke_result_t<Function&>;
+			std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(brisk::move(f));
+			std::future<Result> result = task->get_future();
+			post([task]() { (*task)(); });
+			return result;
+		}
+
+		// Calls task(i) for every i in [0, count), spread over the calling
+		// thread and up to size() - 1 workers, in no particular order. The
+		// first exception a task throws is rethrown here once the others
+		// have stopped.
+		template <class Task>
+		void bulk(brisk::size_t count, Task&& task)
+		{
+			if (count == 0) {
+				return;
+			}
+
+			using Body = std::remove_reference_t<Task>;
+			std::shared_ptr<bulk_state> state = std::make_shared<bulk_state>();
+			state->count = count;
+			state->task = const_cast<void*>(static_cast<const void*>(&task));
+			state->run = [](void* body, brisk::size_t i) { (*static_cast<Body*>(body))(i); };
+
+			brisk::size_t helpers = ((count < size()) ? count : size()) - 1;
+			for (brisk::size_t i = 0; i < helpers; ++i) {
+				post([state]() { state->work(); });
+			}
+
+			state->work();
+			for (brisk::size_t done = state->finished.load(std::memory_order_acquire); done != count; done = state->finished.load(std::memory_order_acquire)) {
+				state->finished.wait(done, std::memory_order_acquire);
+			}
+
+			if (state->failed.load(std::memory_order_relaxed)) {
+				std::rethrow_exception(state->error);
+			}
+		}
+
+	private:
+		static brisk::size_t defaultThreads() noexcept
+		{
+			unsigned int threads = std::thread::hardware_concurrency();
+			return (threads != 0) ? threads : 1;
+		}
+
+		void post(std::function<void()> job)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_queue.push_back(brisk::move(job));
+			}
+
+			m_wake.notify_one();
+		}
+
+		void workerLoop()
+		{
+			for (;;) {
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_wake.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+					if (m_queue.empty()) {
+						return;
+					}
+
+					job = brisk::move(m_queue.front());
+					m_queue.pop_front();
+				}
+
+				job();
+			}
+		}
+
+		brisk::vector<std::thread> m_workers;
+		std::deque<std::function<void()>> m_queue;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		bool m_stopping;
+	};
+
+	// The pool the parallel algorithms use unless they're given another,
+	// with a worker per hardware thread. Started on first use.
+	inline thread_pool& default_thread_pool()
+	{
+		static thread_pool pool;
+		return pool;
+	}
+}
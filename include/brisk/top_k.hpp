@@ -0,0 +1,123 @@
+#pragma once
+
+#include "briskdef.hpp"
+#include "utility.hpp"
+#include "functional.hpp"
+#include "algorithm.hpp"
+#include "vector.hpp"
+#include "memory_resource.hpp"
+
+namespace brisk
+{
+	// Keeps the k greatest values (by Compare) of a stream, in O(k) memory:
+	// the largest values of a billion latencies with less, the smallest
+	// with greater. The values are kept in a heap with the least of them
+	// on top, so most pushes are one comparison against threshold() and
+	// turned away.
+	//
+	// Not synchronized. To use it from several threads give each its own
+	// and merge() them when they're done, which gives the same set as
+	// pushing everything into one.
+	template <class T, class Compare = brisk::less<>>
+	class top_k
+	{
+	public:
+		using size_type = brisk::size_t;
+		using value_type = T;
+
+		explicit top_k(size_type k, Compare comp = Compare(), memory_resource* resource = brisk::get_default_resource())
+			: m_heap(resource), m_k(k), m_comp(comp)
+		{
+			m_heap.reserve(k);
+		}
+
+		void push(const T& value)
+		{
+			if (m_heap.size() < m_k) {
+				m_heap.push_back(value);
+				heap_order order{ &m_comp };
+				detail::siftUp(m_heap.begin(), static_cast<brisk::ptrdiff_t>(m_heap.size() - 1), order);
+			} else if (m_k != 0 && m_comp(m_heap[0], value)) {
+				m_heap[0] = value;
+				heap_order order{ &m_comp };
+				detail::siftDown(m_heap.begin(), static_cast<brisk::ptrdiff_t>(m_heap.size()), brisk::ptrdiff_t(0), order);
+			}
+		}
+
+		template <class Iterator>
+		void push(Iterator first, Iterator last)
+		{
+			for (; first != last; ++first)
+				push(*first);
+		}
+
+		// Folds in what another top_k has kept, as if its values had been
+		// pushed here. This one's k still applies.
+		void merge(const top_k& other)
+		{
+			for (size_type i = 0; i < other.m_heap.size(); ++i) {
+				push(other.m_heap[i]);
+			}
+		}
+
+		size_type size() const noexcept
+		{
+			return m_heap.size();
+		}
+
+		size_type k() const noexcept
+		{
+			return m_k;
+		}
+
+		bool empty() const noexcept
+		{
+			return m_heap.empty();
+		}
+
+		// The least of the values kept, which a new value has to beat once
+		// k of them have been seen. Undefined when empty.
+		const T& threshold() const noexcept
+		{
+			return m_heap[0];
+		}
+
+		// The values kept, in heap order.
+		const vector<T>& values() const noexcept
+		{
+			return m_heap;
+		}
+
+		// The values kept, greatest first.
+		vector<T> sorted() const
+		{
+			vector<T> result(m_heap, m_heap.resource());
+			heap_order order{ &m_comp };
+			detail::sortHeap(result.begin(), static_cast<brisk::ptrdiff_t>(result.size()), order);
+			return result;
+		}
+
+		void clear() noexcept
+		{
+			m_heap.clear();
+		}
+
+	private:
+		// Reversed, so the max-heap the sorting helpers build keeps the
+		// least value on top.
+		struct heap_order
+		{
+			const Compare* comp;
+
+			template <class A, class B>
+			bool operator()(const A& a, const B& b) const
+			{
+				return (*comp)(b, a);
+			}
+		};
+
+		vector<T> m_heap;
+		size_type m_k;
+		Compare m_comp;
+	};
+}
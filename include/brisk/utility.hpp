@@ -31,10 +31,17 @@ namespace brisk
 		pair() = default;
 
 		pair(T&& x, T2&& y)
-			: first(forward<T>(x)), second(forward<T2>(y))
+			: first(brisk::forward<T>(x)), second(brisk::forward<T2>(y))
 		{
 			
 		}
+
+		template <class U, class U2>
+		pair(U&& x, U2&& y)
+			: first(brisk::forward<U>(x)), second(brisk::forward<U2>(y))
+		{
+
+		}
 	};
 
 	template <class T, class T2>
@@ -46,6 +53,6 @@ namespace brisk
 	template <class T, class T2>
 	constexpr pair<T, T2> make_pair(T&& x, T2&& y)
 	{
-		return pair<T, T2>(forward<T>(x), forward<T2>(y));
+		return pair<T, T2>(brisk::forward<T>(x), brisk::forward<T2>(y));
 	}
 }
\ No newline at end of file
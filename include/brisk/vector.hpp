@@ -4,9 +4,16 @@
 #include <stdexcept>
 #include <iterator>
 #include <cstring>
+#include <new>
+#include <type_traits>
 
 #include "briskdef.hpp"
 #include "utility.hpp"
+#include "algorithm.hpp"
+#include "memory_resource.hpp"
+#ifdef BRISK_HEAP_PROFILE
+#include "heap_profiler.hpp"
+#endif
 
 namespace brisk
 {
@@ -29,18 +36,21 @@ namespace brisk
 
         // Constructors / Destructor
         vector();
-        explicit vector(const size_type size);
-        vector(const std::initializer_list<Type>&& list);
-        vector(iterator const begin, iterator const end);
+        explicit vector(memory_resource* resource);
+        explicit vector(const size_type size, memory_resource* resource = brisk::get_default_resource());
+        vector(const std::initializer_list<Type>&& list, memory_resource* resource = brisk::get_default_resource());
+        vector(iterator const begin, iterator const end, memory_resource* resource = brisk::get_default_resource());
         vector(const vector& v2);   // Copy constructor
+        vector(const vector& v2, memory_resource* resource);
         vector(vector&& v2);        // Move constructor
         virtual ~vector();
         
         // Equals operators
         vector<Type>& operator=(const vector<Type>& v2);
-        vector<Type>& operator=(vector&& v2) noexcept;
+        vector<Type>& operator=(vector&& v2);
         bool operator==(const vector<Type>& rhs) const noexcept;
         bool operator!=(const vector<Type>& rhs) const noexcept;
+        void swap(vector<Type>& v2) noexcept;
 
         // Array operators
         reference operator[](const size_type index) noexcept;
@@ -79,22 +89,73 @@ namespace brisk
         const_pointer data() const noexcept;
         iterator begin() noexcept;
         iterator end() noexcept;
+        const_iterator begin() const noexcept;
+        const_iterator end() const noexcept;
         const_iterator cbegin() const noexcept;
         const_iterator cend() const noexcept;
         reverse_iterator rbegin() noexcept;
         reverse_iterator rend() noexcept;
         const_reverse_iterator crbegin() const noexcept;
         const_reverse_iterator crend() const noexcept;
-        
+
+        // Memory resource
+        memory_resource* resource() const noexcept;
+
     private:
         void realloc(const size_t newSize);
+        Type* allocate(const size_type size);
+        void deallocate(Type* array, const size_type size) noexcept;
 
     private:
         size_type m_elements;
         size_type m_size;
         value_type* m_array;
+        memory_resource* m_resource;
     };
 
+    // Every slot up to capacity holds a constructed object, the same as
+    // new Type[size] would give, but the memory comes from m_resource.
+    template <class Type>
+    Type* vector<Type>::allocate(const size_type size)
+    {
+        BRISK_HEAP_SAMPLE(size * sizeof(Type));
+        Type* array = static_cast<Type*>(m_resource->allocate(size * sizeof(Type), alignof(Type)));
+        if constexpr (!std::is_trivially_default_constructible_v<Type>)
+        {
+            size_type i = 0;
+            try {
+                for (; i < size; ++i) {
+                    ::new (static_cast<void*>(array + i)) Type;
+                }
+            } catch (...) {
+                for (size_type j = 0; j < i; ++j) {
+                    array[j].~Type();
+                }
+                m_resource->deallocate(array, size * sizeof(Type), alignof(Type));
+                throw;
+            }
+        }
+
+        return array;
+    }
+
+    template <class Type>
+    void vector<Type>::deallocate(Type* array, const size_type size) noexcept
+    {
+        if (array == nullptr) {
+            return;
+        }
+
+        if constexpr (!std::is_trivially_destructible_v<Type>)
+        {
+            for (size_type i = 0; i < size; ++i) {
+                array[i].~Type();
+            }
+        }
+
+        m_resource->deallocate(array, size * sizeof(Type), alignof(Type));
+    }
+
     // All reallocation logic lies here.
     // 
     // Value modifying functions check bounds and call for reallocation if
@@ -120,12 +181,10 @@ namespace brisk
 
         if (reallocate == true) 
         {
-            Type* buffer = new Type[reallocSz];
-            for (size_type i = 0; i < m_elements; ++i) {
-                buffer[i] = brisk::move(m_array[i]);
-            }
-            
-            delete[] m_array;
+            Type* buffer = allocate(reallocSz);
+            brisk::move(m_array, m_array + m_elements, buffer);
+
+            deallocate(m_array, m_size);
             m_array = buffer;
             m_size = reallocSz;
         }
@@ -134,67 +193,90 @@ namespace brisk
     // Constructors / Destructor
     // ------------------------------------------------------
     // vector();
-    // explicit vector(const size_type size);
-    // vector(const std::initializer_list<Type>&& list);
-    // vector(iterator const begin, iterator const end);
+    // explicit vector(memory_resource* resource);
+    // explicit vector(const size_type size, memory_resource* resource);
+    // vector(const std::initializer_list<Type>&& list, memory_resource* resource);
+    // vector(iterator const begin, iterator const end, memory_resource* resource);
     // vector(const vector& v2);   // Copy constructor
+    // vector(const vector& v2, memory_resource* resource);
     // vector(vector&& v2);        // Move constructor
     // virtual ~vector();
     // ------------------------------------------------------
     template <class Type>
     vector<Type>::vector()
-        :   m_elements(0), 
-            m_size(4), 
-            m_array(new Type[4])
+        :   vector(brisk::get_default_resource())
     {}
-    
+
     template <class Type>
-    vector<Type>::vector(const size_type size)
-        :   m_elements(0), 
-            m_size(size), 
-            m_array(new Type[size])
-    {}
-    
+    vector<Type>::vector(memory_resource* resource)
+        :   m_elements(0),
+            m_size(4),
+            m_array(nullptr),
+            m_resource(resource)
+    {
+        m_array = allocate(4);
+    }
+
     template <class Type>
-    vector<Type>::vector(const std::initializer_list<Type>&& list)
-        :   m_elements(list.size()), 
-            m_size(list.size() << 2), 
-            m_array(new Type[list.size() << 2])
+    vector<Type>::vector(const size_type size, memory_resource* resource)
+        :   m_elements(0),
+            m_size(size),
+            m_array(nullptr),
+            m_resource(resource)
     {
+        m_array = allocate(size);
+    }
+
+    template <class Type>
+    vector<Type>::vector(const std::initializer_list<Type>&& list, memory_resource* resource)
+        :   m_elements(list.size()),
+            m_size(list.size() << 2),
+            m_array(nullptr),
+            m_resource(resource)
+    {
+        m_array = allocate(m_size);
         for (typename std::initializer_list<Type>::iterator it = list.begin(); it != list.end(); ++it) {
             m_array[it - list.begin()] = *(it);
         }
     }
     
     template <class Type>
-    vector<Type>::vector(iterator const begin, iterator const end)
-        :   m_elements(0), 
-            m_size(0)
+    vector<Type>::vector(iterator const begin, iterator const end, memory_resource* resource)
+        :   m_elements(0),
+            m_size(0),
+            m_array(nullptr),
+            m_resource(resource)
     {
         for (iterator it = begin; it != end; ++it) {
             m_elements++;
         }
         
         m_size = m_elements << 2;
-        m_array = new Type[m_size];
+        m_array = allocate(m_size);
         for (size_type i = 0; i < m_elements; ++i) {
             m_array[i] = *(begin + i);
         }
     }
 
+    // Like std::pmr containers, a copy doesn't inherit the resource: it
+    // uses the default unless it's given one.
     template <class Type>
     vector<Type>::vector(const vector<Type>& v2)
-        : m_elements(v2.m_elements), m_size(v2.m_size), m_array(new Type[m_size])
+        : vector(v2, brisk::get_default_resource())
+    {}
+
+    template <class Type>
+    vector<Type>::vector(const vector<Type>& v2, memory_resource* resource)
+        : m_elements(v2.m_elements), m_size(v2.m_size), m_array(nullptr), m_resource(resource)
     {
-        for (size_type i = 0; i < v2.m_size; i++) {
-            m_array[i] = v2.m_array[i];
-        }
+        m_array = allocate(m_size);
+        brisk::copy(v2.m_array, v2.m_array + v2.m_elements, m_array);
     }
 
     template <class Type>
     vector<Type>::vector(vector<Type>&& v2)
-        : m_elements(brisk::move(v2.m_elements)), m_size(brisk::move(v2.m_size)), m_array(v2.m_array)
-    {       
+        : m_elements(brisk::move(v2.m_elements)), m_size(brisk::move(v2.m_size)), m_array(v2.m_array), m_resource(v2.m_resource)
+    {
         v2.m_elements = 0;
         v2.m_size = 0;
         v2.m_array = nullptr;
@@ -202,39 +284,70 @@ namespace brisk
 
     template <class Type>
     vector<Type>::~vector() {
-        delete[] m_array;
+        deallocate(m_array, m_size);
     }
 
     // Equals operators
     // ---------------------------------------------------------
     // vector<Type>& operator=(const vector<Type>& v2);
-    // vector<Type>& operator=(vector&& v2) noexcept;
+    // vector<Type>& operator=(vector&& v2);
     // bool operator==(const vector<Type>& rhs) const noexcept;
     // bool operator!=(const vector<Type>& rhs) const noexcept;
+    // void swap(vector<Type>& v2) noexcept;
     // ---------------------------------------------------------
+    // Assignment keeps this vector's resource.
     template <class Type>
     vector<Type>& vector<Type>::operator=(const vector<Type>& v2)
     {
+        if (this == &v2) {
+            return *this;
+        }
+
+        Type* buffer = allocate(v2.m_size);
+        brisk::copy(v2.m_array, v2.m_array + v2.m_elements, buffer);
+
+        deallocate(m_array, m_size);
         m_elements = v2.m_elements;
         m_size = v2.m_size;
-        m_array = new Type[m_size];
-        
-        for (size_type i = 0; i < v2.m_size; i++) {
-            m_array[i] = v2.m_array[i];
-        }
+        m_array = buffer;
 
         return *this;
     }
 
+    // The array can only be stolen when both vectors allocate from the
+    // same resource; otherwise the elements are moved across one by one
+    // into a new array, which can throw bad_alloc, as it can for a
+    // std::pmr::vector. Either way v2 is left empty. Use swap() to hand
+    // over the array and the resource together without allocating.
     template <class Type>
-    vector<Type>& vector<Type>::operator=(vector<Type>&& v2) noexcept
+    vector<Type>& vector<Type>::operator=(vector<Type>&& v2)
     {
-        m_elements = brisk::move(v2.m_elements);
-        m_size = brisk::move(v2.m_size);
-        m_array = v2.m_array;
-        v2.m_elements = 0;
-        v2.m_size = 0;
-        v2.m_array = nullptr;
+        if (this == &v2) {
+            return *this;
+        }
+
+        if (m_resource->is_equal(*v2.m_resource)) {
+            deallocate(m_array, m_size);
+            m_elements = brisk::move(v2.m_elements);
+            m_size = brisk::move(v2.m_size);
+            m_array = v2.m_array;
+            v2.m_elements = 0;
+            v2.m_size = 0;
+            v2.m_array = nullptr;
+        } else {
+            Type* buffer = allocate(v2.m_size);
+            brisk::move(v2.m_array, v2.m_array + v2.m_elements, buffer);
+
+            deallocate(m_array, m_size);
+            m_elements = v2.m_elements;
+            m_size = v2.m_size;
+            m_array = buffer;
+
+            v2.deallocate(v2.m_array, v2.m_size);
+            v2.m_elements = 0;
+            v2.m_size = 0;
+            v2.m_array = nullptr;
+        }
 
         return *this;
     }
@@ -245,32 +358,24 @@ namespace brisk
         if (m_elements != rhs.m_elements) {
             return false;
         }
-        
-        for (size_type i = 0; i < m_elements; ++i)
-        {
-            if (m_array[i] != rhs.m_array[i]) {
-                return false;
-            }
-        }
-        
-        return true;
+
+        return detail::equalElements(m_array, rhs.m_array, m_elements);
     }
 
     template <class Type>
     bool vector<Type>::operator!=(const vector<Type>& rhs) const noexcept
     {
-        if (m_elements != rhs.m_elements) {
-            return true;
-        }
-        
-        for (size_type i = 0; i < m_elements; ++i)
-        {
-            if (m_array[i] != rhs.m_array[i]) {
-                return true;
-            }
-        }
-        
-        return false;
+        return !(*this == rhs);
+    }
+
+    // Exchanges the arrays along with the resources that own them.
+    template <class Type>
+    void vector<Type>::swap(vector<Type>& v2) noexcept
+    {
+        brisk::swap(m_elements, v2.m_elements);
+        brisk::swap(m_size, v2.m_size);
+        brisk::swap(m_array, v2.m_array);
+        brisk::swap(m_resource, v2.m_resource);
     }
 
     // Array operators
@@ -306,25 +411,18 @@ namespace brisk
             throw std::overflow_error("[brisk::vector][Exception]: Iterator out of range");
         }
         
+        // pos doesn't survive a reallocation, its index does
+        const size_type index = pos - m_array;
+        Type value(brisk::forward<Args>(args)...);
         if (m_size <= m_elements+1) {
             realloc(m_size << 2);
         }
-        
-        // Start from the end, move backwards while moving each element over 1 until
-        // we're at the end. If statement catches when the pos is == to v.begin(),
-        // otherwise memmove would corrupt memory by going out of bounds
-        iterator it = this->end();
-        for (; it > pos; it--) {
-            if (it - 1 < m_array) {
-                break;
-            }
-            // it initializes to one past the last element, so start there in that empty space (it)
-            // and move the previous element (it - 1) over sizeof(*it) bytes or the size of one element
-            memmove(it, it-1, sizeof(*it));
-            //     dest, src, bytes to copy
-        }
 
-        *it = brisk::move(brisk::forward<Args>(args)...);
+        // shift the tail up one slot in a single pass, a memmove for
+        // trivially copyable types
+        iterator it = m_array + index;
+        brisk::move_backward(it, m_array + m_elements, m_array + m_elements + 1);
+        *it = brisk::move(value);
         m_elements++;
         return it;
     }
@@ -381,8 +479,9 @@ namespace brisk
     void vector<Type>::pop_back() 
     {
         if (m_elements != 0) {
-            m_array[m_elements].~Type();
             --m_elements;
+            m_array[m_elements].~Type();
+            ::new (static_cast<void*>(m_array + m_elements)) Type;
         }
     }
 
@@ -393,9 +492,7 @@ namespace brisk
             realloc(count << 2);
         }
 
-        for (size_type i = 0; i < count; ++i) {
-            m_array[i] = value;
-        }
+        brisk::fill(m_array, m_array + count, value);
 
         m_elements += count - m_elements;
     }
@@ -455,40 +552,46 @@ namespace brisk
 
     template <class Type>
     void vector<Type>::fill(const value_type& value) noexcept {
-        for (size_type i = 0; i < m_elements; ++i) {
-            m_array[i] = value;
-        }
+        brisk::fill(m_array, m_array + m_elements, value);
     }
     
     template <class Type>
     void vector<Type>::clear() noexcept
     {
-        for (int i = 0; i < m_elements; ++i) {
+        // slots past size() stay constructed, so put a fresh object back
+        // in each one rather than leaving it destroyed
+        for (size_type i = 0; i < m_elements; ++i) {
             m_array[i].~Type();
+            ::new (static_cast<void*>(m_array + i)) Type;
         }
         
         m_elements = 0;
-        m_size = 0;
-        erase(begin(), end());
     }
 
     template <class Type>
     vector<Type>::iterator vector<Type>::erase(const_iterator pos)
     {
-        iterator iit = &m_array[pos - m_array];
-        (*iit).~Type();
-        memmove(iit, iit + 1, (m_elements - (pos - m_array) - 1) * sizeof(Type));
-        --m_elements;
-        return iit;
+        return erase(pos, pos + 1);
     }
 
+    // The tail moves down over the erased range in one pass, then the
+    // vacated slots at the end get fresh objects, as pop_back leaves them.
     template <class Type>
-    vector<Type>::iterator vector<Type>::erase(const_iterator first, const_iterator last) {
-        iterator it = const_cast<iterator>(last-1);
-        for (; it >= first; --it) {
-            erase(it);
+    vector<Type>::iterator vector<Type>::erase(const_iterator first, const_iterator last)
+    {
+        iterator it = m_array + (first - m_array);
+        const size_type count = last - first;
+        if (count == 0) {
+            return it;
+        }
+
+        brisk::move(it + count, m_array + m_elements, it);
+        for (size_type i = m_elements - count; i < m_elements; ++i) {
+            m_array[i].~Type();
+            ::new (static_cast<void*>(m_array + i)) Type;
         }
 
+        m_elements -= count;
         return it;
     }
 
@@ -504,6 +607,8 @@ namespace brisk
     // const_pointer data() const noexcept;
     // iterator begin() noexcept;
     // iterator end() noexcept;
+    // const_iterator begin() const noexcept;
+    // const_iterator end() const noexcept;
     // const_iterator cbegin() const noexcept;
     // const_iterator cend() const noexcept;
     // reverse_iterator rbegin() noexcept;
@@ -570,6 +675,16 @@ namespace brisk
     vector<Type>::iterator vector<Type>::end() noexcept {
         return &m_array[m_elements];
     }
+
+    template <class Type>
+    vector<Type>::const_iterator vector<Type>::begin() const noexcept {
+        return &m_array[0];
+    }
+
+    template <class Type>
+    vector<Type>::const_iterator vector<Type>::end() const noexcept {
+        return &m_array[m_elements];
+    }
     
     template <class Type>
     vector<Type>::const_iterator vector<Type>::cbegin() const noexcept {
@@ -600,4 +715,13 @@ namespace brisk
     vector<Type>::const_reverse_iterator vector<Type>::crend() const noexcept {
         return reverse_iterator(&m_array[0]);
     }
+
+    // Memory resource
+    // ---------------------------------------------------
+    // memory_resource* resource() const noexcept;
+    // ---------------------------------------------------
+    template <class Type>
+    memory_resource* vector<Type>::resource() const noexcept {
+        return m_resource;
+    }
 }
@@ -0,0 +1,109 @@
+#include "brisk/logger.hpp"
+#include "brisk/compress.hpp"
+#include "brisk/memory.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdio>
+#include <cstring>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// Builds a corpus that looks like a request log: mostly fixed text with
+// timestamps, ids, paths and latencies that vary from line to line.
+static void generateLogCorpus(brisk::vector<char>& corpus, size_t bytes)
+{
+    static const char* levels[] = { "INFO", "INFO", "INFO", "WARN", "DEBUG" };
+    static const char* paths[] = { "/api/v1/items", "/api/v1/users", "/api/v1/orders/search", "/healthz", "/static/app.js" };
+    std::mt19937 generator(42);
+    char line[256];
+    long long timestamp = 1700000000000LL;
+    auto next = [&generator]() { return static_cast<unsigned>(generator()); };
+
+    corpus.reserve(bytes + sizeof(line));
+    while (corpus.size() < bytes) {
+        timestamp += next() % 7;
+        int n = std::snprintf(line, sizeof(line), "%lld %s [worker-%u] req id=%u path=%s status=%d latency_us=%u bytes=%u\n",
+            timestamp, levels[next() % 5], next() % 8, next() % 1000000, paths[next() % 5],
+            (next() % 50 == 0) ? 500 : 200, next() % 20000, next() % 65536);
+        for (int i = 0; i < n; i++) {
+            corpus.push_back(line[i]);
+        }
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("compress_benchmark.log");
+
+    int megabytes = 256;
+    if (argc >= 2) {
+        megabytes = convertStrToInt(argv[1]);
+    }
+
+    brisk::vector<char> corpus;
+    generateLogCorpus(corpus, static_cast<size_t>(megabytes) << 20);
+    const size_t total = corpus.size();
+    const float totalMB = static_cast<float>(total) / (1 << 20);
+
+    cout << "Corpus: " << totalMB << "MB of generated log lines" << brisk::newl;
+
+    const size_t blockSizes[] = { size_t(16) << 10, size_t(64) << 10, size_t(256) << 10 };
+    for (size_t blockSize : blockSizes) {
+        const size_t blocks = (total + blockSize - 1) / blockSize;
+        // written before they're read, so skip zeroing them
+        brisk::unique_ptr<char[]> compressed = brisk::make_unique_for_overwrite<char[]>(blocks * brisk::lz::compress_bound(blockSize));
+        brisk::unique_ptr<size_t[]> sizes = brisk::make_unique_for_overwrite<size_t[]>(blocks);
+        brisk::unique_ptr<char[]> restored = brisk::make_unique_for_overwrite<char[]>(total);
+
+        using namespace std::chrono;
+        time_point<steady_clock> start = steady_clock::now();
+        size_t compressedBytes = 0;
+        for (size_t b = 0; b < blocks; b++) {
+            size_t n = (b == blocks - 1) ? total - b * blockSize : blockSize;
+            sizes[b] = brisk::lz::compress(corpus.data() + b * blockSize, n,
+                compressed.get() + b * brisk::lz::compress_bound(blockSize), brisk::lz::compress_bound(blockSize));
+            compressedBytes += sizes[b];
+        }
+        duration<float> compressTime = steady_clock::now() - start;
+
+        start = steady_clock::now();
+        bool ok = true;
+        for (size_t b = 0; b < blocks; b++) {
+            size_t n = (b == blocks - 1) ? total - b * blockSize : blockSize;
+            ok = ok && brisk::lz::decompress(compressed.get() + b * brisk::lz::compress_bound(blockSize), sizes[b],
+                restored.get() + b * blockSize, n) == n;
+        }
+        duration<float> decompressTime = steady_clock::now() - start;
+        ok = ok && memcmp(restored.get(), corpus.data(), total) == 0;
+
+        cout << "Block " << (blockSize >> 10) << "KB: ratio " << static_cast<float>(total) / compressedBytes
+        << ", compress " << totalMB / compressTime.count() << "MB/s"
+        << ", decompress " << totalMB / decompressTime.count() << "MB/s"
+        << (ok ? "" : " [ROUND TRIP FAILED]") << brisk::newl;
+    }
+
+    // framed file: stream it out, then read one block from the middle
+    brisk::compressed_writer writer;
+    writer.open("compress_benchmark.lz");
+    writer.write(corpus.data(), total);
+    writer.close();
+
+    brisk::compressed_reader reader;
+    bool framedOk = reader.open("compress_benchmark.lz");
+    if (framedOk) {
+        size_t middle = reader.blocks() / 2;
+        brisk::unique_ptr<char[]> block = brisk::make_unique_for_overwrite<char[]>(reader.block_size());
+        size_t n = reader.read_block(middle, block.get(), reader.block_size());
+        framedOk = (n != static_cast<size_t>(-1)) && memcmp(block.get(), corpus.data() + middle * reader.block_size(), n) == 0;
+    }
+    std::remove("compress_benchmark.lz");
+
+    cout << "Framed file random access: " << (framedOk ? "ok" : "FAILED") << brisk::newl;
+}
@@ -0,0 +1,149 @@
+#include "brisk/algorithm.hpp"
+#include "brisk/execution.hpp"
+#include "brisk/external_sort.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+template <class Function>
+static float time(Function f)
+{
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    f();
+    duration<float, std::milli> elapsed = steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Reads the file back a buffer at a time and checks it's in order.
+static bool sortedFile(const std::filesystem::path& path, size_t expected)
+{
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    brisk::vector<std::uint64_t> buffer(1 << 20);
+    for (size_t i = 0; i < buffer.capacity(); i++) {
+        buffer.push_back(0);
+    }
+
+    std::uint64_t previous = 0;
+    size_t total = 0;
+    bool sorted = true;
+    for (size_t count; (count = std::fread(buffer.data(), sizeof(std::uint64_t), buffer.size(), file)) != 0; ) {
+        for (size_t i = 0; i < count; i++) {
+            sorted = sorted && previous <= buffer[i];
+            previous = buffer[i];
+        }
+        total += count;
+    }
+
+    std::fclose(file);
+    return sorted && total == expected;
+}
+
+static void row(brisk::logger& cout, const char* name, float ms, double megabytes, bool correct)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-36s %10.0f %9.1f%s\n", name, ms, megabytes / (ms / 1000.0), correct ? "" : "  WRONG");
+    cout << line;
+}
+
+// Sorts a file of random 64-bit keys bigger than the memory it's given,
+// once on one thread and once forming runs with the parallel stable_sort,
+// after timing the in-memory pieces on one run's worth of keys.
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("external_sort_benchmark.log");
+
+    int megabytes = 1024;
+    int memory = 256;
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    if (argc >= 2) {
+        megabytes = convertStrToInt(argv[1]);
+    }
+    if (argc >= 3) {
+        memory = convertStrToInt(argv[2]);
+    }
+    if (argc >= 4) {
+        directory = argv[3];
+    }
+
+    const size_t n = static_cast<size_t>(megabytes) * (1 << 20) / sizeof(std::uint64_t);
+    const std::filesystem::path input = directory / "brisk_external_sort_input.bin";
+    const std::filesystem::path output = directory / "brisk_external_sort_output.bin";
+    {
+        std::FILE* file = std::fopen(input.string().c_str(), "wb");
+        if (file == nullptr) {
+            cout << "can't write to " << directory.string().c_str() << brisk::newl;
+            return 1;
+        }
+
+        std::mt19937_64 rng(47);
+        brisk::vector<std::uint64_t> block(1 << 20);
+        for (size_t written = 0; written < n; written += block.size()) {
+            block.clear();
+            for (size_t i = 0; i < block.capacity() && written + i < n; i++) {
+                block.push_back(rng());
+            }
+            std::fwrite(block.data(), sizeof(std::uint64_t), block.size(), file);
+        }
+        std::fclose(file);
+    }
+
+    char line[128];
+    std::snprintf(line, sizeof(line), "%d MB of uint64, %d MB of memory, %zu threads\n%-36s %10s %9s\n",
+        megabytes, memory, brisk::default_thread_pool().size(), "", "ms", "MB/s");
+    cout << line;
+
+    // in memory, on one run's worth
+    {
+        const size_t runKeys = static_cast<size_t>(memory) * (1 << 20) / sizeof(std::uint64_t);
+        brisk::vector<std::uint64_t> keys(runKeys);
+        std::mt19937_64 rng(48);
+        for (size_t i = 0; i < runKeys; i++) {
+            keys.push_back(rng());
+        }
+
+        brisk::vector<std::uint64_t> work(keys);
+        float ms = time([&]() { brisk::stable_sort(work.begin(), work.end()); });
+        row(cout, "stable_sort, one run", ms, memory, brisk::is_sorted(work.begin(), work.end()));
+        work = keys;
+        ms = time([&]() { brisk::stable_sort(brisk::execution::par, work.begin(), work.end()); });
+        row(cout, "stable_sort(par), one run", ms, memory, brisk::is_sorted(work.begin(), work.end()));
+
+        // two sorted halves into a third vector
+        const size_t half = runKeys / 2;
+        brisk::sort(keys.begin(), keys.begin() + half);
+        brisk::sort(keys.begin() + half, keys.end());
+        ms = time([&]() { brisk::merge(keys.begin(), keys.begin() + half, keys.begin() + half, keys.end(), work.begin()); });
+        row(cout, "merge, one run", ms, memory, brisk::is_sorted(work.begin(), work.end()));
+        ms = time([&]() { brisk::merge(brisk::execution::par, keys.begin(), keys.begin() + half, keys.begin() + half, keys.end(), work.begin()); });
+        row(cout, "merge(par), one run", ms, memory, brisk::is_sorted(work.begin(), work.end()));
+    }
+
+    brisk::external_sort_options options;
+    options.memory_bytes = static_cast<size_t>(memory) << 20;
+    options.temp_directory = directory;
+
+    float ms = time([&]() { brisk::external_sort<std::uint64_t>(input, output, brisk::less<>(), options); });
+    row(cout, "external_sort", ms, megabytes, sortedFile(output, n));
+    ms = time([&]() { brisk::external_sort<std::uint64_t>(brisk::execution::par, input, output, brisk::less<>(), options); });
+    row(cout, "external_sort(par)", ms, megabytes, sortedFile(output, n));
+
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+}
@@ -0,0 +1,139 @@
+#include "brisk/algorithm.hpp"
+#include "brisk/execution.hpp"
+#include "brisk/hash_algorithm.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+template <class Function>
+static float best(Function f)
+{
+    using namespace std::chrono;
+    float fastest = 0;
+    for (int run = 0; run < 3; run++) {
+        time_point<steady_clock> start = steady_clock::now();
+        f();
+        duration<float, std::milli> elapsed = steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < fastest) {
+            fastest = elapsed.count();
+        }
+    }
+    return fastest;
+}
+
+// Times f, which returns what it found so the work can't be skipped.
+template <class Function>
+static size_t row(brisk::logger& cout, const char* name, size_t n, Function f)
+{
+    size_t result = 0;
+    float ms = best([&]() { result = f(); });
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-40s %9.1f %9.1f %12zu\n", name, ms, n / (ms / 1000.0) / 1e6, result);
+    cout << line;
+    return result;
+}
+
+struct sale
+{
+    std::uint32_t customer;
+    std::uint32_t amount;
+};
+
+// Dedup, group-by, distinct counts and a join over rows of random keys,
+// the hash algorithms against the standard containers doing the same.
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("hash_benchmark.log");
+
+    int millions = 20;
+    if (argc >= 2) {
+        millions = convertStrToInt(argv[1]);
+    }
+
+    const size_t n = static_cast<size_t>(millions) * 1000000;
+    const std::uint32_t distinct = static_cast<std::uint32_t>(n / 10);
+    std::mt19937 rng(49);
+    brisk::vector<std::uint32_t> keys(n);
+    brisk::vector<sale> sales(n);
+    for (size_t i = 0; i < n; i++) {
+        keys.push_back(rng() % distinct);
+        sales.push_back(sale{static_cast<std::uint32_t>(rng() % distinct), static_cast<std::uint32_t>(rng() % 1000)});
+    }
+
+    // a dimension table of distinct / 4 customers for the join
+    brisk::vector<std::uint32_t> customers(distinct / 4);
+    for (std::uint32_t c = 0; c < distinct; c += 4) {
+        customers.push_back(c);
+    }
+
+    char line[128];
+    std::snprintf(line, sizeof(line), "%d M rows, %u keys, %zu threads, best of 3\n%-40s %9s %9s %12s\n",
+        millions, distinct, brisk::default_thread_pool().size(), "", "ms", "M rows/s", "result");
+    cout << line;
+
+    row(cout, "sort + unique", n, [&]() {
+        brisk::vector<std::uint32_t> work(keys);
+        std::sort(work.begin(), work.end());
+        return static_cast<size_t>(std::unique(work.begin(), work.end()) - work.begin());
+    });
+    row(cout, "std::unordered_set", n, [&]() {
+        std::unordered_set<std::uint32_t> seen;
+        for (size_t i = 0; i < n; i++) {
+            seen.insert(keys[i]);
+        }
+        return seen.size();
+    });
+    row(cout, "brisk::unique_hashed", n, [&]() { return brisk::unique_hashed(keys).size(); });
+    row(cout, "brisk::unique_hashed(par)", n, [&]() { return brisk::unique_hashed(brisk::execution::par, keys).size(); });
+
+    auto customer = [](const sale& s) { return s.customer; };
+    auto total = [](std::uint64_t sum, const sale& s) { return sum + s.amount; };
+    row(cout, "group by, std::unordered_map", n, [&]() {
+        std::unordered_map<std::uint32_t, std::uint64_t> groups;
+        for (size_t i = 0; i < n; i++) {
+            groups[sales[i].customer] += sales[i].amount;
+        }
+        return groups.size();
+    });
+    row(cout, "brisk::group_by", n, [&]() { return brisk::group_by(sales, customer, total, std::uint64_t(0)).size(); });
+    row(cout, "brisk::group_by(par)", n, [&]() { return brisk::group_by(brisk::execution::par, sales, customer, total, std::uint64_t(0)).size(); });
+
+    size_t exact = row(cout, "brisk::count_distinct", n, [&]() { return brisk::count_distinct(keys); });
+    row(cout, "brisk::count_distinct(par)", n, [&]() { return brisk::count_distinct(brisk::execution::par, keys); });
+    size_t approx = row(cout, "brisk::approx_count_distinct", n, [&]() { return brisk::approx_count_distinct(keys); });
+    std::snprintf(line, sizeof(line), "  error %.2f%% in 16 KB\n", 100.0 * (static_cast<double>(approx) - exact) / exact);
+    cout << line;
+    row(cout, "brisk::approx_count_distinct(par)", n, [&]() { return brisk::approx_count_distinct(brisk::execution::par, keys); });
+
+    row(cout, "join, std::unordered_multimap", n, [&]() {
+        std::unordered_multimap<std::uint32_t, size_t> table;
+        for (size_t j = 0; j < customers.size(); j++) {
+            table.emplace(customers[j], j);
+        }
+        brisk::vector<brisk::pair<size_t, size_t>> matches;
+        for (size_t i = 0; i < n; i++) {
+            auto range = table.equal_range(sales[i].customer);
+            for (auto it = range.first; it != range.second; ++it) {
+                matches.push_back(brisk::pair<size_t, size_t>(i, it->second));
+            }
+        }
+        return matches.size();
+    });
+    auto id = [](std::uint32_t c) { return c; };
+    row(cout, "brisk::hash_join", n, [&]() { return brisk::hash_join(sales, customers, customer, id).size(); });
+    row(cout, "brisk::hash_join(par)", n, [&]() { return brisk::hash_join(brisk::execution::par, sales, customers, customer, id).size(); });
+}
@@ -0,0 +1,95 @@
+#include "brisk/heap_profiler.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/memory.hpp"
+#include "brisk/string.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// Three call sites with different allocation patterns, so the profile has
+// something to tell apart: vector growth, string appends and make_unique.
+[[gnu::noinline]] long buildRows(int n)
+{
+    brisk::vector<long> row;
+    for (int i = 0; i < n; i++) {
+        row.push_back(i);
+    }
+    return row.back();
+}
+
+[[gnu::noinline]] long buildKey(int n)
+{
+    brisk::string key("session:");
+    for (int i = 0; i < n; i++) {
+        key.append(static_cast<char>('a' + i % 26));
+    }
+    return static_cast<long>(key.size());
+}
+
+[[gnu::noinline]] long makeBuffer(int n)
+{
+    brisk::unique_ptr<char[]> buffer = brisk::make_unique_for_overwrite<char[]>(static_cast<brisk::size_t>(n) * 64);
+    buffer[0] = static_cast<char>(n);
+    return buffer[0];
+}
+
+static float workload(int rounds, long& checksum)
+{
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        checksum += buildRows(256 + r % 64);
+        checksum += buildKey(32 + r % 16);
+        checksum += makeBuffer(16 + r % 32);
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("heap_profiler_benchmark.log");
+
+    int rounds = 500000;
+    int sampleBytes = 2 * 1024 * 1024;
+    if (argc >= 3) {
+        rounds = convertStrToInt(argv[1]);
+        sampleBytes = convertStrToInt(argv[2]);
+    }
+
+    // alternate off and on in short slices, so drift in clock speed and
+    // cache state lands on both sides equally
+    long checksum = 0;
+    float off = 0;
+    float on = 0;
+    const int slices = 50;
+    for (int slice = 0; slice < slices; slice++) {
+        brisk::heap_profiler_stop();
+        off += workload(rounds / slices, checksum);
+
+        brisk::heap_profiler_start(sampleBytes);
+        on += workload(rounds / slices, checksum);
+    }
+    brisk::heap_profiler_stop();
+
+    brisk::heap_profile_stats stats = brisk::heap_profiler_stats();
+    cout << rounds << " rounds (checksum " << checksum << "), sampling every " << sampleBytes / 1024 << "KB" << brisk::newl
+    << "    profiler off: " << off << "secs" << brisk::newl
+    << "    profiler on:  " << on << "secs (" << (on / off - 1) * 100 << "% overhead)" << brisk::newl
+    << "    " << stats.samples << " samples from " << stats.stacks << " stacks, " << stats.dropped << " dropped" << brisk::newl;
+
+    brisk::logger folded("heap_profiler_benchmark.folded");
+    folded.disablePrinting();
+    brisk::heap_profiler_write_folded(folded);
+
+    brisk::logger pprof("heap_profiler_benchmark.heap");
+    pprof.disablePrinting();
+    brisk::heap_profiler_write_pprof(pprof);
+}
@@ -0,0 +1,122 @@
+#include "brisk/logger.hpp"
+#include "brisk/memory.hpp"
+#include "brisk/vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+struct std_node
+{
+    long value;
+    std::shared_ptr<std_node> next;
+
+    explicit std_node(long v) : value(v) {}
+};
+
+template <class Policy>
+struct brisk_node : brisk::ref_counted<brisk_node<Policy>, Policy>
+{
+    long value;
+    brisk::intrusive_ptr<brisk_node> next;
+
+    explicit brisk_node(long v) : value(v) {}
+};
+
+// Builds a list whose links jump around the heap in random order, so every
+// hop is a cache miss and the refcount's location is what gets measured.
+template <class Pointer, class Make>
+static Pointer build(Make make, size_t nodes, std::mt19937& rng)
+{
+    brisk::vector<Pointer> all(nodes);
+    for (size_t i = 0; i < nodes; i++) {
+        all.push_back(make(static_cast<long>(i)));
+    }
+    std::shuffle(all.begin(), all.end(), rng);
+    for (size_t i = 0; i + 1 < nodes; i++) {
+        all[i]->next = all[i + 1];
+    }
+    return all[0];
+}
+
+// Unlinks one node at a time so destroying a long list doesn't recurse.
+template <class Pointer>
+static void destroy(Pointer& head)
+{
+    while (head) {
+        Pointer next = std::move(head->next);
+        head = std::move(next);
+    }
+}
+
+// Walks the list holding a reference to the current node, the way code that
+// may drop the rest of the list mid-walk has to.
+template <class Pointer>
+static float walk(const Pointer& head, int passes, long& checksum)
+{
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        for (Pointer node = head; node; node = node->next) {
+            checksum += node->value;
+        }
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("intrusive_ptr_benchmark.log");
+
+    int nodes = 1000000;
+    int passes = 10;
+    if (argc >= 3) {
+        nodes = convertStrToInt(argv[1]);
+        passes = convertStrToInt(argv[2]);
+    }
+
+    using atomic_node = brisk_node<brisk::atomic_ref_count>;
+    using local_node = brisk_node<brisk::local_ref_count>;
+
+    const size_t count = static_cast<size_t>(nodes);
+    const float hops = static_cast<float>(count) * passes;
+    std::mt19937 rng(42);
+    long checksum = 0;
+
+    std::shared_ptr<std_node> stdMade = build<std::shared_ptr<std_node>>(
+        [](long v) { return std::make_shared<std_node>(v); }, count, rng);
+    float madeTime = walk(stdMade, passes, checksum);
+    destroy(stdMade);
+
+    std::shared_ptr<std_node> stdNew = build<std::shared_ptr<std_node>>(
+        [](long v) { return std::shared_ptr<std_node>(new std_node(v)); }, count, rng);
+    float newTime = walk(stdNew, passes, checksum);
+    destroy(stdNew);
+
+    brisk::intrusive_ptr<atomic_node> atomicList = build<brisk::intrusive_ptr<atomic_node>>(
+        [](long v) { return brisk::make_intrusive<atomic_node>(v); }, count, rng);
+    float atomicTime = walk(atomicList, passes, checksum);
+    destroy(atomicList);
+
+    brisk::intrusive_ptr<local_node> localList = build<brisk::intrusive_ptr<local_node>>(
+        [](long v) { return brisk::make_intrusive<local_node>(v); }, count, rng);
+    float localTime = walk(localList, passes, checksum);
+    destroy(localList);
+
+    cout << "Pointer chasing, " << nodes << " shuffled nodes x " << passes << " passes (checksum " << checksum << ")" << brisk::newl
+    << "    std::make_shared:             " << madeTime << "secs (" << hops / madeTime / 1e6f << "M hops/s)" << brisk::newl
+    << "    std::shared_ptr(new):         " << newTime << "secs (" << hops / newTime / 1e6f << "M hops/s)" << brisk::newl
+    << "    intrusive_ptr, atomic count:  " << atomicTime << "secs (" << hops / atomicTime / 1e6f << "M hops/s)" << brisk::newl
+    << "    intrusive_ptr, local count:   " << localTime << "secs (" << hops / localTime / 1e6f << "M hops/s)" << brisk::newl
+    << "    sizeof: std::shared_ptr " << sizeof(std::shared_ptr<std_node>)
+    << ", brisk::intrusive_ptr " << sizeof(brisk::intrusive_ptr<atomic_node>) << brisk::newl;
+}
@@ -0,0 +1,125 @@
+#include "brisk/logger.hpp"
+#include "brisk/logfile.hpp"
+#include "brisk/eventlog.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <cstring>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("logger_benchmark.log");
+
+    int megabytes = 2048;
+    int numberOfThreads = 8;
+    if (argc >= 3) {
+        megabytes = convertStrToInt(argv[1]);
+        numberOfThreads = convertStrToInt(argv[2]);
+    }
+
+    // a typical request line, 128 bytes
+    char line[128];
+    memset(line, 'x', sizeof(line));
+    memcpy(line, "2024-01-01T00:00:00.000Z INFO req id=4242 path=/api/v1/items latency_us=", 73);
+    line[sizeof(line) - 1] = '\n';
+
+    const size_t totalBytes = static_cast<size_t>(megabytes) << 20;
+    const size_t linesPerThread = totalBytes / sizeof(line) / numberOfThreads;
+
+    brisk::rotation_policy policy;
+    policy.segmentSize = size_t(64) << 20;
+    policy.retention = 4;
+
+    using namespace std::chrono;
+    duration<float> elapsed;
+    brisk::shared_ptr<brisk::log_counters> counters = brisk::make_shared<brisk::log_counters>();
+    {
+        brisk::rotating_logfile segments("rotating_benchmark.log", policy, counters);
+
+        auto workerFunc = [&segments, &line, linesPerThread]() {
+            for (size_t i = 0; i < linesPerThread; i++) {
+                segments.write(line, sizeof(line));
+            }
+        };
+
+        time_point<steady_clock> start = steady_clock::now();
+        brisk::vector<std::future<void>> threads(numberOfThreads);
+        for (int i = 0; i < numberOfThreads; i++) {
+            threads[i] = std::async(std::launch::async, workerFunc);
+        }
+        for (int i = 0; i < numberOfThreads; i++) {
+            threads[i].wait();
+        }
+        elapsed = steady_clock::now() - start;
+    }
+
+    const float written = static_cast<float>(linesPerThread * numberOfThreads * sizeof(line)) / (1 << 20);
+    cout << "Rotating segments: " << written << "MB from " << numberOfThreads << " threads in "
+    << elapsed.count() << "secs (" << written / elapsed.count() << "MB/s)" << brisk::newl
+    << "Rotating segment metrics: " << brisk::log_metrics::read(*counters) << brisk::newl;
+
+    // in-memory history: every line is kept until dumpLog writes it out
+    {
+        const size_t historyLines = ((totalBytes < (size_t(256) << 20)) ? totalBytes : (size_t(256) << 20)) / sizeof(line);
+        std::string text(line, sizeof(line));
+        brisk::logger history("history_benchmark.log");
+        history.disablePrinting();
+
+        time_point<steady_clock> start = steady_clock::now();
+        for (size_t i = 0; i < historyLines; i++) {
+            history.fmt("{}", text.c_str());
+        }
+        duration<float> logged = steady_clock::now() - start;
+
+        start = steady_clock::now();
+        history.dumpLog();
+        duration<float> dumped = steady_clock::now() - start;
+
+        const float mb = static_cast<float>(historyLines * sizeof(line)) / (1 << 20);
+        cout << "In-memory history: " << historyLines << " lines in " << logged.count() << "secs ("
+        << historyLines / logged.count() / 1e6f << "M lines/s), dumpLog " << mb / dumped.count() << "MB/s" << brisk::newl;
+    }
+
+    // structured events: write one record per request, then scan them back
+    const size_t events = totalBytes / 64;
+    brisk::logger structured("events_benchmark.log");
+    structured.events("events_benchmark.events");
+    time_point<steady_clock> start = steady_clock::now();
+    for (size_t i = 0; i < events; i++) {
+        structured.event("req", "id", i, "latency_us", static_cast<int>(i % 20000), "path", "/api/v1/items", "ok", (i % 50) != 0);
+    }
+    structured.dumpLog();
+    elapsed = steady_clock::now() - start;
+    cout << "Structured events: " << static_cast<float>(events) / elapsed.count() / 1e6f << "M events/s" << brisk::newl;
+
+#ifdef BRISK_HAS_EVENT_READER
+    brisk::event_reader reader;
+    if (reader.open("events_benchmark.events")) {
+        start = steady_clock::now();
+        double sum = 0;
+        size_t n = 0;
+        int latency = brisk::event_reader::unknown;
+        for (brisk::event_record record : reader) {
+            brisk::event_field field;
+            latency = (latency == brisk::event_reader::unknown) ? reader.id("latency_us") : latency;
+            if (record.find(static_cast<std::uint16_t>(latency), field)) {
+                sum += field.as_double();
+                n++;
+            }
+        }
+        elapsed = steady_clock::now() - start;
+        const float mb = static_cast<float>(reader.bytes()) / (1 << 20);
+        cout << "Event reader: " << n << " records (avg latency " << sum / n << "us), "
+        << mb / elapsed.count() << "MB/s" << brisk::newl;
+    }
+#endif
+}
@@ -0,0 +1,201 @@
+#include "brisk/eventlog.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+
+// logquery FILE [-e EVENT] [-w KEY OP VALUE]... [-g KEY] [-a KEY] [-p]
+//
+// Filters the records of a brisk structured log and counts them, optionally
+// aggregating a numeric field (count/sum/min/max/avg) per value of a group
+// key. OP is one of = != < <= > >=; numeric fields compare as numbers,
+// string fields compare as text.
+
+struct condition
+{
+    std::string key;
+    std::string op;
+    std::string text;
+    double number;
+    int id;
+};
+
+struct aggregate
+{
+    size_t count = 0;
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+};
+
+static bool compare(int order, const std::string& op)
+{
+    if (op == "=") return order == 0;
+    if (op == "!=") return order != 0;
+    if (op == "<") return order < 0;
+    if (op == "<=") return order <= 0;
+    if (op == ">") return order > 0;
+    if (op == ">=") return order >= 0;
+    return false;
+}
+
+static bool matches(const brisk::event_record& record, const condition& c)
+{
+    brisk::event_field field;
+    if (c.id == brisk::event_reader::unknown || !record.find(static_cast<std::uint16_t>(c.id), field)) {
+        return false;
+    }
+
+    if (field.is_string()) {
+        int order = field.as_string().compare(c.text);
+        return compare((order < 0) ? -1 : (order > 0), c.op);
+    }
+
+    double value = field.as_double();
+    return compare((value < c.number) ? -1 : (value > c.number), c.op);
+}
+
+static void printRecord(const brisk::event_record& record)
+{
+    std::fwrite(record.name().data(), 1, record.name().size(), stdout);
+    for (brisk::event_field field : record) {
+        std::printf(" %.*s=", static_cast<int>(field.key().size()), field.key().data());
+        switch (field.type()) {
+            case brisk::eventlog::string: std::printf("%.*s", static_cast<int>(field.as_string().size()), field.as_string().data()); break;
+            case brisk::eventlog::float64: std::printf("%g", field.as_double()); break;
+            case brisk::eventlog::uint64: std::printf("%llu", static_cast<unsigned long long>(field.as_int())); break;
+            default: std::printf("%lld", static_cast<long long>(field.as_int())); break;
+        }
+    }
+    std::printf("\n");
+}
+
+static int usage()
+{
+    std::fprintf(stderr, "usage: logquery FILE [-e EVENT] [-w KEY OP VALUE]... [-g KEY] [-a KEY] [-p]\n");
+    return 2;
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc < 2) {
+        return usage();
+    }
+
+    std::string eventName, groupKey, aggregateKey;
+    brisk::vector<condition> conditions;
+    bool print = false;
+
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            eventName = argv[++i];
+        } else if (std::strcmp(argv[i], "-w") == 0 && i + 3 < argc) {
+            condition c;
+            c.key = argv[i + 1];
+            c.op = argv[i + 2];
+            c.text = argv[i + 3];
+            c.number = std::strtod(argv[i + 3], nullptr);
+            c.id = brisk::event_reader::unknown;
+            conditions.push_back(c);
+            i += 3;
+        } else if (std::strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            groupKey = argv[++i];
+        } else if (std::strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            aggregateKey = argv[++i];
+        } else if (std::strcmp(argv[i], "-p") == 0) {
+            print = true;
+        } else {
+            return usage();
+        }
+    }
+
+    brisk::event_reader reader;
+    if (!reader.open(argv[1])) {
+        std::fprintf(stderr, "logquery: can't open %s as a brisk event log\n", argv[1]);
+        return 1;
+    }
+
+    // ids are only known once the dictionary record for a name has been
+    // read, so re-resolve whenever new names show up
+    size_t generation = static_cast<size_t>(-1);
+    int eventId = brisk::event_reader::unknown, groupId = brisk::event_reader::unknown, aggregateId = brisk::event_reader::unknown;
+    std::map<std::string, aggregate> groups;
+    size_t scanned = 0;
+
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    for (brisk::event_record record : reader) {
+        ++scanned;
+        if (generation != reader.generation()) {
+            generation = reader.generation();
+            eventId = eventName.empty() ? eventId : reader.id(eventName);
+            groupId = groupKey.empty() ? groupId : reader.id(groupKey);
+            aggregateId = aggregateKey.empty() ? aggregateId : reader.id(aggregateKey);
+            for (condition& c : conditions) {
+                c.id = reader.id(c.key);
+            }
+        }
+
+        if (!eventName.empty() && record.name_id() != eventId) {
+            continue;
+        }
+
+        bool keep = true;
+        for (const condition& c : conditions) {
+            if (!matches(record, c)) {
+                keep = false;
+                break;
+            }
+        }
+        if (!keep) {
+            continue;
+        }
+
+        if (print) {
+            printRecord(record);
+        }
+
+        std::string group;
+        brisk::event_field field;
+        if (!groupKey.empty()) {
+            if (groupId == brisk::event_reader::unknown || !record.find(static_cast<std::uint16_t>(groupId), field)) {
+                continue;
+            }
+            group = field.is_string() ? std::string(field.as_string()) : std::to_string(field.as_int());
+        }
+
+        double value = 0;
+        if (!aggregateKey.empty()) {
+            if (aggregateId == brisk::event_reader::unknown || !record.find(static_cast<std::uint16_t>(aggregateId), field)) {
+                continue;
+            }
+            value = field.as_double();
+        }
+
+        aggregate& a = groups[group];
+        a.min = (a.count == 0 || value < a.min) ? value : a.min;
+        a.max = (a.count == 0 || value > a.max) ? value : a.max;
+        a.sum += value;
+        a.count++;
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+
+    for (const auto& [group, a] : groups) {
+        if (!groupKey.empty()) {
+            std::printf("%s=%s ", groupKey.c_str(), group.c_str());
+        }
+        std::printf("count=%zu", a.count);
+        if (!aggregateKey.empty()) {
+            std::printf(" sum=%g min=%g max=%g avg=%g", a.sum, a.min, a.max, a.sum / a.count);
+        }
+        std::printf("\n");
+    }
+
+    std::fprintf(stderr, "scanned %zu records (%.1fMB) in %.3fsecs, %.1fMB/s\n", scanned,
+        reader.bytes() / 1048576.0, elapsed.count(), reader.bytes() / 1048576.0 / elapsed.count());
+}
@@ -0,0 +1,81 @@
+#include "brisk/logger.hpp"
+#include "brisk/memory_resource.hpp"
+#include "brisk/string.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// What one request handler does: a few thousand short-lived vectors and
+// strings, all dropped when the request finishes.
+static long handleRequest(brisk::memory_resource* resource, int temporaries)
+{
+    long checksum = 0;
+    brisk::vector<brisk::vector<int>> rows(resource);
+    for (int i = 0; i < temporaries; i++) {
+        brisk::vector<int> row(resource);
+        for (int j = 0; j < 16; j++) {
+            row.push_back(i + j);
+        }
+
+        brisk::string key("user:", resource);
+        key.append("session-");
+        key.append(static_cast<char>('a' + i % 26));
+        checksum += row.back() + static_cast<long>(key.size());
+
+        if (i % 64 == 0) {
+            rows.push_back(row);
+        }
+    }
+
+    return checksum + static_cast<long>(rows.size());
+}
+
+template <class Reset>
+static float run(brisk::memory_resource* resource, Reset reset, int requests, int temporaries, long& checksum)
+{
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    for (int r = 0; r < requests; r++) {
+        checksum += handleRequest(resource, temporaries);
+        reset();
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("memory_resource_benchmark.log");
+
+    int requests = 2000;
+    int temporaries = 2000;
+    if (argc >= 3) {
+        requests = convertStrToInt(argv[1]);
+        temporaries = convertStrToInt(argv[2]);
+    }
+
+    long checksum = 0;
+    float heap = run(brisk::new_delete_resource(), []() {}, requests, temporaries, checksum);
+
+    brisk::monotonic_buffer_resource arena;
+    float monotonic = run(&arena, [&arena]() { arena.reset(); }, requests, temporaries, checksum);
+
+    brisk::unsynchronized_pool_resource pool;
+    float pooled = run(&pool, []() {}, requests, temporaries, checksum);
+
+    brisk::synchronized_pool_resource sharedPool;
+    float synchronized = run(&sharedPool, []() {}, requests, temporaries, checksum);
+
+    cout << requests << " requests x " << temporaries << " temporaries (checksum " << checksum << ")" << brisk::newl
+    << "    new/delete:                  " << heap << "secs" << brisk::newl
+    << "    monotonic arena, reset/req:  " << monotonic << "secs (" << heap / monotonic << "x)" << brisk::newl
+    << "    unsynchronized pool:         " << pooled << "secs (" << heap / pooled << "x)" << brisk::newl
+    << "    synchronized pool:           " << synchronized << "secs (" << heap / synchronized << "x)" << brisk::newl;
+}
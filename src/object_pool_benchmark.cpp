@@ -0,0 +1,158 @@
+#include "brisk/logger.hpp"
+#include "brisk/memory_resource.hpp"
+#include "brisk/object_pool.hpp"
+#include "brisk/string.hpp"
+#include "brisk/vector.hpp"
+
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <future>
+#include <string>
+
+// Installed as the default resource, so every vector and string allocation
+// in the program is counted.
+class counting_resource : public brisk::memory_resource
+{
+public:
+    std::atomic<long> allocations{0};
+
+private:
+    void* do_allocate(brisk::size_t bytes, brisk::size_t alignment) override
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return brisk::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, brisk::size_t bytes, brisk::size_t alignment) override
+    {
+        brisk::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const brisk::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+static counting_resource counter;
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// A message buffer of the kind a request handler fills and throws away.
+struct message
+{
+    brisk::vector<int> samples;
+    brisk::vector<double> weights;
+    brisk::string name;
+
+    void reset()
+    {
+        samples.clear();
+        weights.clear();
+        name.clear();
+    }
+};
+
+static long fill(message& m, long seed)
+{
+    for (int i = 0; i < 512; i++) {
+        m.samples.push_back(static_cast<int>(seed + i));
+        m.weights.push_back(i * 0.5);
+    }
+    m.name.append("request-");
+    m.name.append(static_cast<char>('a' + seed % 26));
+    return m.samples.back() + static_cast<long>(m.name.size());
+}
+
+struct phase
+{
+    float seconds;
+    long allocations;
+    long warmupAllocations;
+};
+
+// Each thread calls prepare() and makes warmup calls to work, then
+// perThread timed and counted ones once every thread is warm; marked() is
+// called in between. Both parts run on the same threads, so the timed
+// calls find whatever the warmup left in their own object_pool shard.
+template <class Prepare, class Work, class Mark>
+static phase measure(int numberOfThreads, size_t warmup, size_t perThread, Prepare prepare, Work work, Mark marked)
+{
+    using namespace std::chrono;
+    long initial = counter.allocations.load();
+    long before = 0;
+    time_point<steady_clock> start;
+    std::barrier warm(numberOfThreads, [&]() noexcept {
+        marked();
+        before = counter.allocations.load();
+        start = steady_clock::now();
+    });
+
+    auto workerFunc = [&prepare, &work, &warm, warmup, perThread](int id) -> long {
+        prepare();
+        long sum = 0;
+        for (size_t i = 0; i < warmup; i++) {
+            sum += work(static_cast<long>(id * warmup + i));
+        }
+        warm.arrive_and_wait();
+        for (size_t i = 0; i < perThread; i++) {
+            sum += work(static_cast<long>(id * perThread + i));
+        }
+        return sum;
+    };
+
+    brisk::vector<std::future<long>> threads(numberOfThreads);
+    for (int i = 0; i < numberOfThreads; i++) {
+        threads[i] = std::async(std::launch::async, workerFunc, i);
+    }
+    for (int i = 0; i < numberOfThreads; i++) {
+        threads[i].get();
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    return phase{elapsed.count(), counter.allocations.load() - before, before - initial};
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("object_pool_benchmark.log");
+    brisk::set_default_resource(&counter);
+
+    int thousands = 200;
+    int numberOfThreads = 4;
+    if (argc >= 3) {
+        thousands = convertStrToInt(argv[1]);
+        numberOfThreads = convertStrToInt(argv[2]);
+    }
+
+    const size_t perThread = static_cast<size_t>(thousands) * 1000 / numberOfThreads;
+    const float total = static_cast<float>(perThread) * numberOfThreads;
+
+    phase fresh = measure(numberOfThreads, 0, perThread, []() {}, [](long seed) {
+        message m;
+        return fill(m, seed);
+    }, []() {});
+
+    brisk::object_pool<message> pool(64);
+    auto pooled = [&pool](long seed) {
+        brisk::object_pool<message>::handle m = pool.acquire();
+        return fill(*m, seed);
+    };
+    // each thread puts an object in its own shard, so it never has to take
+    // one from another thread's, and the warmup grows its storage to the
+    // working size
+    size_t warmupCreated = 0;
+    phase steady = measure(numberOfThreads, perThread / 4, perThread, [&pool]() { pool.reserve(1); }, pooled, [&pool, &warmupCreated]() {
+        warmupCreated = pool.created();
+    });
+
+    cout << numberOfThreads << " threads, " << total / 1000 << "K messages of 512 samples" << brisk::newl
+    << "    construct/destroy:   " << fresh.seconds << "secs, " << fresh.allocations / total << " allocations/message" << brisk::newl
+    << "    object_pool warmup:  " << steady.warmupAllocations << " allocations, " << warmupCreated << " objects created" << brisk::newl
+    << "    object_pool steady:  " << steady.seconds << "secs (" << fresh.seconds / steady.seconds << "x), "
+    << steady.allocations << " allocations, " << pool.created() - warmupCreated << " objects created" << brisk::newl;
+}
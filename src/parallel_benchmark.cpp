@@ -0,0 +1,100 @@
+#include "brisk/execution.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// Best of a few runs, in milliseconds.
+template <class Function>
+static float best(Function f)
+{
+    using namespace std::chrono;
+    float fastest = 0;
+    for (int run = 0; run < 5; run++) {
+        time_point<steady_clock> start = steady_clock::now();
+        f();
+        duration<float, std::milli> elapsed = steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < fastest) {
+            fastest = elapsed.count();
+        }
+    }
+    return fastest;
+}
+
+// One row of timings for a policy: a cheap per-element update, a
+// transcendental map, plain and fused reductions, memory-bound fill and
+// copy, and two predicates, the search finding its match at the very end.
+template <class Policy>
+static void row(brisk::logger& cout, const char* name, const Policy& policy, brisk::vector<double>& a, brisk::vector<double>& b, double& sink)
+{
+    float forEach = best([&]() { brisk::for_each(policy, a.begin(), a.end(), [](double& x) { x = x * 0.999 + 1.0; }); });
+    float transform = best([&]() { brisk::transform(policy, a.begin(), a.end(), b.begin(), [](double x) { return std::sqrt(x) * std::log(x + 2.0); }); });
+    float reduce = best([&]() { sink += brisk::reduce(policy, a.begin(), a.end(), 0.0); });
+    float dot = best([&]() { sink += brisk::transform_reduce(policy, a.begin(), a.end(), b.begin(), 0.0); });
+    float fill = best([&]() { brisk::fill(policy, b.begin(), b.end(), 1.5); });
+    float copy = best([&]() { brisk::copy(policy, a.begin(), a.end(), b.begin()); });
+    float countIf = best([&]() { sink += static_cast<double>(brisk::count_if(policy, a.begin(), a.end(), [](double x) { return x > 500.0; })); });
+    float findIf = best([&]() { sink += *brisk::find_if(policy, a.begin(), a.end(), [](double x) { return x < 0.0; }); });
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-12s %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+        name, forEach, transform, reduce, dot, fill, copy, countIf, findIf);
+    cout << line;
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("parallel_benchmark.log");
+
+    int millions = 16;
+    int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (argc >= 3) {
+        millions = convertStrToInt(argv[1]);
+        maxThreads = convertStrToInt(argv[2]);
+    }
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    const size_t n = static_cast<size_t>(millions) * 1000000;
+    brisk::vector<double> a(n);
+    brisk::vector<double> b(n);
+    for (size_t i = 0; i < n; i++) {
+        a.push_back(static_cast<double>(i % 1000));
+        b.push_back(0.0);
+    }
+    a.back() = -1.0;
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%d M doubles, best of 5 in ms\n%-12s %9s %9s %9s %9s %9s %9s %9s %9s\n", millions,
+        "", "for_each", "transform", "reduce", "dot", "fill", "copy", "count_if", "find_if");
+    cout << line;
+
+    double sink = 0;
+    row(cout, "seq", brisk::execution::seq, a, b, sink);
+    row(cout, "unseq", brisk::execution::unseq, a, b, sink);
+    // 1, 2, 3, 4, then doubling, always ending on maxThreads
+    for (int threads = 1; ; threads = std::min((threads < 4) ? threads + 1 : threads * 2, maxThreads)) {
+        brisk::thread_pool pool(static_cast<size_t>(threads));
+        std::string name = "par x" + std::to_string(threads);
+        row(cout, name.c_str(), brisk::execution::par.on(pool), a, b, sink);
+        name = "par_unseq x" + std::to_string(threads);
+        row(cout, name.c_str(), brisk::execution::par_unseq.on(pool), a, b, sink);
+
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+    cout << "(checksum " << sink << ")" << brisk::newl;
+}
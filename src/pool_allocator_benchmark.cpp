@@ -0,0 +1,140 @@
+#include "brisk/logger.hpp"
+#include "brisk/memory.hpp"
+#include "brisk/pool_allocator.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// a binary tree node, the kind of thing we build out of unique_ptrs
+struct node
+{
+    long key;
+    void* left;
+    void* right;
+    void* parent;
+};
+
+// the same with a value and a balance factor: 48 bytes, a block size that
+// isn't a power of two
+struct wide_node
+{
+    long key;
+    void* left;
+    void* right;
+    void* parent;
+    void* value;
+    long balance;
+};
+
+// Each thread keeps a window of live blocks and replaces the oldest one on
+// every step, so allocations and frees interleave like a working structure
+// rather than strictly LIFO.
+template <class Allocate, class Free>
+static float pairs(size_t total, int numberOfThreads, Allocate allocate, Free release)
+{
+    auto workerFunc = [total, numberOfThreads, &allocate, &release]() {
+        const size_t window = 256;
+        void* live[window] = {};
+        for (size_t i = 0; i < total / numberOfThreads; i++) {
+            void*& slot = live[i % window];
+            if (slot != nullptr) {
+                release(slot);
+            }
+            slot = allocate();
+            // both node types start with the key
+            *static_cast<long*>(slot) = static_cast<long>(i);
+        }
+        for (void* p : live) {
+            if (p != nullptr) {
+                release(p);
+            }
+        }
+    };
+
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    brisk::vector<std::future<void>> threads(numberOfThreads);
+    for (int i = 0; i < numberOfThreads; i++) {
+        threads[i] = std::async(std::launch::async, workerFunc);
+    }
+    // get() rather than wait(), so an allocation that throws isn't lost
+    for (int i = 0; i < numberOfThreads; i++) {
+        threads[i].get();
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    return elapsed.count();
+}
+
+template <class Make>
+static float nodes(size_t count, Make make)
+{
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    long sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        auto p = make(static_cast<long>(i));
+        sum += p->key;
+        asm volatile("" : : "r"(sum) : "memory");
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("pool_allocator_benchmark.log");
+
+    int millions = 100;
+    int numberOfThreads = 8;
+    if (argc >= 3) {
+        millions = convertStrToInt(argv[1]);
+        numberOfThreads = convertStrToInt(argv[2]);
+    }
+
+    const size_t total = static_cast<size_t>(millions) * 1000000;
+
+    float mallocTime = pairs(total, numberOfThreads,
+        []() { return std::malloc(sizeof(node)); },
+        [](void* p) { std::free(p); });
+
+    float cachedTime = pairs(total, numberOfThreads,
+        []() { return static_cast<void*>(brisk::pool_allocator<node>().allocate(1)); },
+        [](void* p) { brisk::pool_allocator<node>().deallocate(static_cast<node*>(p), 1); });
+
+    float wideTime = pairs(total, numberOfThreads,
+        []() { return static_cast<void*>(brisk::pool_allocator<wide_node>().allocate(1)); },
+        [](void* p) { brisk::pool_allocator<wide_node>().deallocate(static_cast<wide_node*>(p), 1); });
+
+    // the uncached pool serialises every call on one lock, so give it a
+    // tenth of the work and scale
+    float uncachedTime = pairs(total / 10, numberOfThreads,
+        []() { return static_cast<void*>(brisk::pool_allocator<node, brisk::pool_uncached>().allocate(1)); },
+        [](void* p) { brisk::pool_allocator<node, brisk::pool_uncached>().deallocate(static_cast<node*>(p), 1); }) * 10;
+
+    cout << millions << "M alloc/free pairs of " << static_cast<int>(sizeof(node)) << " bytes across " << numberOfThreads << " threads" << brisk::newl
+    << "    malloc/free:                 " << mallocTime << "secs (" << total / mallocTime / 1e6f << "M pairs/s)" << brisk::newl
+    << "    pool_allocator, cached:      " << cachedTime << "secs (" << total / cachedTime / 1e6f << "M pairs/s)" << brisk::newl
+    << "    pool_allocator, uncached:    " << uncachedTime << "secs (" << total / uncachedTime / 1e6f << "M pairs/s, extrapolated)" << brisk::newl
+    << "    pool_allocator, " << static_cast<int>(sizeof(wide_node)) << " bytes:    " << wideTime << "secs (" << total / wideTime / 1e6f << "M pairs/s)" << brisk::newl;
+
+    const size_t count = total / 10;
+    float plainUnique = nodes(count, [](long k) { return brisk::make_unique<node>(node{k, nullptr, nullptr, nullptr}); });
+    float pooledUnique = nodes(count, [](long k) { return brisk::make_pooled_unique<node>(node{k, nullptr, nullptr, nullptr}); });
+    float plainShared = nodes(count, [](long k) { return brisk::make_shared<node>(node{k, nullptr, nullptr, nullptr}); });
+    float pooledShared = nodes(count, [](long k) { return brisk::make_pooled_shared<node>(node{k, nullptr, nullptr, nullptr}); });
+    cout << "Single thread, " << count / 1000000 << "M nodes" << brisk::newl
+    << "    make_unique:        " << plainUnique << "secs" << brisk::newl
+    << "    make_pooled_unique: " << pooledUnique << "secs" << brisk::newl
+    << "    make_shared:        " << plainShared << "secs" << brisk::newl
+    << "    make_pooled_shared: " << pooledShared << "secs" << brisk::newl
+    << "    sizeof(pooled_unique_ptr<node>): " << static_cast<int>(sizeof(brisk::pooled_unique_ptr<node>)) << brisk::newl;
+}
@@ -0,0 +1,197 @@
+#include "brisk/logger.hpp"
+#include "brisk/ranges.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// Best of a few runs, in milliseconds.
+template <class Function>
+static float best(Function f)
+{
+    using namespace std::chrono;
+    float fastest = 0;
+    for (int run = 0; run < 5; run++) {
+        time_point<steady_clock> start = steady_clock::now();
+        f();
+        duration<float, std::milli> elapsed = steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < fastest) {
+            fastest = elapsed.count();
+        }
+    }
+    return fastest;
+}
+
+static void row(brisk::logger& cout, const char* name, float loop, float views)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-34s %9.2f %9.2f %8.2fx\n", name, loop, views, views / loop);
+    cout << line;
+}
+
+// Each pipeline against the loop someone would write by hand for it. The
+// results go into sink so neither side can be optimized away.
+int main(int argc, const char* argv[])
+{
+    namespace views = brisk::views;
+    brisk::logger cout("ranges_benchmark.log");
+
+    int millions = 10;
+    if (argc >= 2) {
+        millions = convertStrToInt(argv[1]);
+    }
+
+    const size_t n = static_cast<size_t>(millions) * 1000000;
+    brisk::vector<int> a(n);
+    brisk::vector<double> b(n);
+    for (size_t i = 0; i < n; i++) {
+        a.push_back(static_cast<int>((i * 2654435761u) % 1000));
+        b.push_back(static_cast<double>(i % 7) * 0.5);
+    }
+
+    long long sink = 0;
+    double dsink = 0;
+    char line[128];
+    std::snprintf(line, sizeof(line), "%d M elements, best of 5 in ms\n%-34s %9s %9s %9s\n", millions, "", "loop", "views", "ratio");
+    cout << line;
+
+    {
+        float loop = best([&]() {
+            long long sum = 0;
+            for (size_t i = 0; i < a.size(); i++) {
+                if (a[i] % 3 == 0) {
+                    sum += static_cast<long long>(a[i]) * a[i];
+                }
+            }
+            sink += sum;
+        });
+        float view = best([&]() {
+            auto squares = a | views::filter([](int x) { return x % 3 == 0; })
+                             | views::transform([](int x) { return static_cast<long long>(x) * x; });
+            sink += brisk::accumulate(squares, 0ll);
+        });
+        row(cout, "filter | transform | accumulate", loop, view);
+    }
+
+    {
+        float loop = best([&]() {
+            double sum = 0;
+            for (size_t i = 0; i < a.size(); i++) {
+                sum += a[i] * b[i];
+            }
+            dsink += sum;
+        });
+        float view = best([&]() {
+            dsink += brisk::accumulate(views::zip(a, b), 0.0, [](double sum, auto pair) { return sum + std::get<0>(pair) * std::get<1>(pair); });
+        });
+        row(cout, "zip | accumulate (dot product)", loop, view);
+    }
+
+    {
+        float loop = best([&]() {
+            long long sum = 0;
+            for (size_t i = 0; i < a.size(); i += 4) {
+                sum += a[i];
+            }
+            sink += sum;
+        });
+        float view = best([&]() { sink += brisk::accumulate(a | views::stride(4), 0ll); });
+        row(cout, "stride(4) | accumulate", loop, view);
+    }
+
+    {
+        float loop = best([&]() {
+            long long sum = 0;
+            for (size_t i = n / 4; i < n / 2; i++) {
+                sum += a[i];
+            }
+            sink += sum;
+        });
+        float view = best([&]() { sink += brisk::accumulate(a | views::drop(n / 4) | views::take(n / 4), 0ll); });
+        row(cout, "drop | take | accumulate", loop, view);
+    }
+
+    {
+        float loop = best([&]() {
+            long long sum = 0;
+            for (size_t i = 0; i < a.size(); i++) {
+                if (i % 5 == 0) {
+                    sum += a[i];
+                }
+            }
+            sink += sum;
+        });
+        float view = best([&]() {
+            long long sum = 0;
+            brisk::for_each(a | views::enumerate | views::filter([](auto pair) { return std::get<0>(pair) % 5 == 0; }),
+                [&sum](auto pair) { sum += std::get<1>(pair); });
+            sink += sum;
+        });
+        row(cout, "enumerate | filter | for_each", loop, view);
+    }
+
+    {
+        float loop = best([&]() {
+            long long sum = 0;
+            for (size_t i = 0; i < a.size(); i += 8) {
+                int largest = a[i];
+                for (size_t j = i + 1; j < i + 8 && j < a.size(); j++) {
+                    largest = (a[j] > largest) ? a[j] : largest;
+                }
+                sum += largest;
+            }
+            sink += sum;
+        });
+        float view = best([&]() {
+            long long sum = 0;
+            for (auto chunk : a | views::chunk(8)) {
+                int largest = *chunk.begin();
+                for (int x : chunk) {
+                    largest = (x > largest) ? x : largest;
+                }
+                sum += largest;
+            }
+            sink += sum;
+        });
+        row(cout, "chunk(8), max of each", loop, view);
+    }
+
+    {
+        float loop = best([&]() {
+            long long sum = 0;
+            for (long long i = 0; i < static_cast<long long>(n); i++) {
+                sum += i * i % 7;
+            }
+            sink += sum;
+        });
+        float view = best([&]() {
+            sink += brisk::accumulate(views::iota(0ll, static_cast<long long>(n)) | views::transform([](long long i) { return i * i % 7; }), 0ll);
+        });
+        row(cout, "iota | transform | accumulate", loop, view);
+    }
+
+    {
+        float loop = best([&]() {
+            brisk::vector<double> out;
+            out.reserve(a.size());
+            for (size_t i = 0; i < a.size(); i++) {
+                out.push_back(a[i] * 0.5);
+            }
+            dsink += out[out.size() / 2];
+        });
+        float view = best([&]() {
+            brisk::vector<double> out = a | views::transform([](int x) { return x * 0.5; }) | brisk::to<brisk::vector>();
+            dsink += out[out.size() / 2];
+        });
+        row(cout, "transform | to<vector>", loop, view);
+    }
+
+    cout << "(checksum " << sink << " " << dsink << ")" << brisk::newl;
+}
@@ -0,0 +1,141 @@
+#include "brisk/logger.hpp"
+#include "brisk/reclaim.hpp"
+#include "brisk/vector.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// a config snapshot that readers look at and a writer swaps out
+struct config
+{
+    long version;
+    long limits[7];
+
+    explicit config(long v) : version(v), limits() {}
+};
+
+// Readers do `reads` lookups each while one writer keeps publishing new
+// versions, so the read side pays for whatever the writer makes it share.
+template <class Read, class Write>
+static float run(int numberOfReaders, size_t reads, Read read, Write write)
+{
+    std::atomic<bool> done(false);
+    auto readerFunc = [&read, reads]() -> long {
+        long sum = 0;
+        for (size_t i = 0; i < reads; i++) {
+            sum += read();
+        }
+        return sum;
+    };
+    auto writerFunc = [&write, &done]() {
+        for (long v = 1; !done.load(std::memory_order_relaxed); v++) {
+            write(v);
+            std::this_thread::yield();
+        }
+    };
+
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    std::future<void> writer = std::async(std::launch::async, writerFunc);
+    brisk::vector<std::future<long>> readers(numberOfReaders);
+    for (int i = 0; i < numberOfReaders; i++) {
+        readers[i] = std::async(std::launch::async, readerFunc);
+    }
+    for (int i = 0; i < numberOfReaders; i++) {
+        readers[i].get();
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    done.store(true);
+    writer.wait();
+    return elapsed.count();
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("reclaim_benchmark.log");
+
+    int millions = 20;
+    int numberOfReaders = 4;
+    if (argc >= 3) {
+        millions = convertStrToInt(argv[1]);
+        numberOfReaders = convertStrToInt(argv[2]);
+    }
+
+    const size_t reads = static_cast<size_t>(millions) * 1000000 / numberOfReaders;
+    const float total = static_cast<float>(reads) * numberOfReaders;
+
+    // No reclamation at all: old versions are kept until the end. The floor
+    // the others are measured against.
+    std::atomic<config*> current(new config(0));
+    brisk::vector<config*> leaked;
+    float rawTime = run(numberOfReaders, reads,
+        [&current]() { return current.load(std::memory_order_acquire)->version; },
+        [&current, &leaked](long v) { leaked.push_back(current.exchange(new config(v))); });
+    for (size_t i = 0; i < leaked.size(); i++) {
+        delete leaked[i];
+    }
+
+    brisk::epoch_domain epochs;
+    float epochTime = run(numberOfReaders, reads,
+        [&current, &epochs]() {
+            brisk::epoch_guard guard(epochs);
+            return current.load(std::memory_order_acquire)->version;
+        },
+        [&current, &epochs](long v) { epochs.retire(current.exchange(new config(v))); });
+
+    brisk::hazard_domain hazards;
+    float hazardTime = run(numberOfReaders, reads,
+        [&current, &hazards]() {
+            static thread_local brisk::hazard_pointer hazard(hazards);
+            long version = hazard.protect(current)->version;
+            hazard.reset_protection();
+            return version;
+        },
+        [&current, &hazards](long v) { hazards.retire(current.exchange(new config(v))); });
+
+    std::shared_mutex sharedMutex;
+    config* locked = current.load();
+    float sharedTime = run(numberOfReaders, reads,
+        [&sharedMutex, &locked]() {
+            std::shared_lock<std::shared_mutex> lock(sharedMutex);
+            return locked->version;
+        },
+        [&sharedMutex, &locked](long v) {
+            config* fresh = new config(v);
+            std::unique_lock<std::shared_mutex> lock(sharedMutex);
+            delete locked;
+            locked = fresh;
+        });
+
+    std::mutex mutex;
+    float mutexTime = run(numberOfReaders, reads,
+        [&mutex, &locked]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return locked->version;
+        },
+        [&mutex, &locked](long v) {
+            config* fresh = new config(v);
+            std::lock_guard<std::mutex> lock(mutex);
+            delete locked;
+            locked = fresh;
+        });
+    delete locked;
+
+    cout << "Read side, " << numberOfReaders << " readers, " << millions << "M reads, one writer publishing" << brisk::newl
+    << "    raw load, never freed:  " << rawTime << "secs (" << total / rawTime / 1e6f << "M/s)" << brisk::newl
+    << "    epoch_guard:            " << epochTime << "secs (" << total / epochTime / 1e6f << "M/s)" << brisk::newl
+    << "    hazard_pointer:         " << hazardTime << "secs (" << total / hazardTime / 1e6f << "M/s)" << brisk::newl
+    << "    std::shared_mutex:      " << sharedTime << "secs (" << total / sharedTime / 1e6f << "M/s)" << brisk::newl
+    << "    std::mutex:             " << mutexTime << "secs (" << total / mutexTime / 1e6f << "M/s)" << brisk::newl;
+}
@@ -0,0 +1,182 @@
+#include "brisk/logger.hpp"
+#include "brisk/reclaim.hpp"
+#include "brisk/vector.hpp"
+
+#include <atomic>
+#include <future>
+#include <optional>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+static std::atomic<long> liveNodes(0);
+
+// check is value scrambled, and the destructor poisons it, so a reader that
+// gets hold of a freed node notices even without a sanitizer.
+struct node
+{
+    static constexpr unsigned long magic = 0x9e3779b97f4a7c15ul;
+
+    unsigned long value;
+    unsigned long check;
+    node* next;
+
+    explicit node(unsigned long v) : value(v), check(v ^ magic), next(nullptr)
+    {
+        liveNodes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~node()
+    {
+        check = 0;
+        liveNodes.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    bool intact() const
+    {
+        return (value ^ magic) == check;
+    }
+};
+
+// The two read sides behind one interface: enter/leave bracket a critical
+// section, load() returns a pointer that is safe to use until leave().
+struct epoch_reader
+{
+    brisk::epoch_domain& domain;
+    std::optional<brisk::epoch_guard> guard;
+
+    explicit epoch_reader(brisk::epoch_domain& d) : domain(d) {}
+    void enter() { guard.emplace(domain); }
+    node* load(const std::atomic<node*>& src) { return src.load(std::memory_order_acquire); }
+    void leave() { guard.reset(); }
+};
+
+struct hazard_reader
+{
+    brisk::hazard_pointer hazard;
+
+    explicit hazard_reader(brisk::hazard_domain& d) : hazard(d) {}
+    void enter() {}
+    node* load(const std::atomic<node*>& src) { return hazard.protect(src); }
+    void leave() { hazard.reset_protection(); }
+};
+
+constexpr int slotCount = 16;
+
+// Readers check whatever the slots hold while writers keep replacing them,
+// and every thread pushes and pops a shared Treiber stack, whose pop has to
+// read head->next of a node another thread may be popping.
+template <class Domain, class Reader>
+static long stress(int numberOfThreads, int iterations)
+{
+    Domain domain;
+    std::atomic<node*> slots[slotCount];
+    for (int i = 0; i < slotCount; i++) {
+        slots[i].store(new node(i), std::memory_order_relaxed);
+    }
+    std::atomic<node*> stack(nullptr);
+
+    auto workerFunc = [&domain, &slots, &stack, iterations](int id) -> long {
+        Reader reader(domain);
+        long errors = 0;
+        unsigned long seed = static_cast<unsigned long>(id) * 7919 + 1;
+        for (int i = 0; i < iterations; i++) {
+            seed = seed * 6364136223846793005ul + 1442695040888963407ul;
+            std::atomic<node*>& slot = slots[(seed >> 33) % slotCount];
+
+            switch ((seed >> 60) & 3) {
+            case 0: {
+                node* fresh = new node(seed);
+                node* old = slot.exchange(fresh, std::memory_order_acq_rel);
+                domain.retire(old);
+                break;
+            }
+            case 1: {
+                node* pushed = new node(seed);
+                pushed->next = stack.load(std::memory_order_relaxed);
+                while (!stack.compare_exchange_weak(pushed->next, pushed, std::memory_order_release, std::memory_order_relaxed)) {
+
+                }
+                break;
+            }
+            case 2: {
+                node* popped = nullptr;
+                reader.enter();
+                for (;;) {
+                    node* head = reader.load(stack);
+                    if (head == nullptr) {
+                        break;
+                    }
+                    errors += !head->intact();
+                    if (stack.compare_exchange_strong(head, head->next, std::memory_order_acquire, std::memory_order_relaxed)) {
+                        popped = head;
+                        break;
+                    }
+                }
+                reader.leave();
+                if (popped != nullptr) {
+                    domain.retire(popped);
+                }
+                break;
+            }
+            default: {
+                reader.enter();
+                node* n = reader.load(slot);
+                errors += !n->intact();
+                reader.leave();
+                break;
+            }
+            }
+        }
+        return errors;
+    };
+
+    brisk::vector<std::future<long>> threads(numberOfThreads);
+    for (int i = 0; i < numberOfThreads; i++) {
+        threads[i] = std::async(std::launch::async, workerFunc, i);
+    }
+    long errors = 0;
+    for (int i = 0; i < numberOfThreads; i++) {
+        errors += threads[i].get();
+    }
+
+    for (int i = 0; i < slotCount; i++) {
+        domain.retire(slots[i].load(std::memory_order_relaxed));
+    }
+    for (node* n = stack.load(std::memory_order_relaxed); n != nullptr;) {
+        node* next = n->next;
+        domain.retire(n);
+        n = next;
+    }
+    return errors;
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("reclaim_stress.log");
+
+    int numberOfThreads = 8;
+    int iterations = 200000;
+    if (argc >= 3) {
+        numberOfThreads = convertStrToInt(argv[1]);
+        iterations = convertStrToInt(argv[2]);
+    }
+
+    // each domain frees what's left when it goes out of scope in stress(),
+    // so every node should be gone afterwards
+    long epochErrors = stress<brisk::epoch_domain, epoch_reader>(numberOfThreads, iterations);
+    long epochLeaked = liveNodes.load();
+    long hazardErrors = stress<brisk::hazard_domain, hazard_reader>(numberOfThreads, iterations);
+    long hazardLeaked = liveNodes.load();
+
+    bool ok = epochErrors == 0 && epochLeaked == 0 && hazardErrors == 0 && hazardLeaked == 0;
+    cout << numberOfThreads << " threads x " << iterations << " operations" << brisk::newl
+    << "    epoch_domain:  " << epochErrors << " bad reads, " << epochLeaked << " nodes left" << brisk::newl
+    << "    hazard_domain: " << hazardErrors << " bad reads, " << hazardLeaked << " nodes left" << brisk::newl
+    << (ok ? "ok" : "FAILED") << brisk::newl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+#include "brisk/algorithm.hpp"
+#include "brisk/execution.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// Best of a few runs, in milliseconds.
+template <class Function>
+static float best(Function f)
+{
+    using namespace std::chrono;
+    float fastest = 0;
+    for (int run = 0; run < 5; run++) {
+        time_point<steady_clock> start = steady_clock::now();
+        f();
+        duration<float, std::milli> elapsed = steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < fastest) {
+            fastest = elapsed.count();
+        }
+    }
+    return fastest;
+}
+
+// bytes is what the operation has to read and write at the least.
+static void row(brisk::logger& cout, const char* name, float ms, double bytes)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-36s %9.2f %9.2f\n", name, ms, bytes / (ms / 1000.0) / 1e9);
+    cout << line;
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("scan_benchmark.log");
+
+    int millions = 100;
+    if (argc >= 2) {
+        millions = convertStrToInt(argv[1]);
+    }
+
+    const size_t n = static_cast<size_t>(millions) * 1000000;
+    brisk::vector<std::uint32_t> sizes(n);
+    brisk::vector<std::uint32_t> out(n);
+    std::mt19937 rng(48);
+    for (size_t i = 0; i < n; i++) {
+        sizes.push_back(rng() % 64);
+        out.push_back(0);
+    }
+
+    const double stream = 2.0 * n * sizeof(std::uint32_t);
+    std::uint64_t sink = 0;
+    char line[128];
+    std::snprintf(line, sizeof(line), "%d M uint32, %zu threads, best of 5\n%-36s %9s %9s\n",
+        millions, brisk::default_thread_pool().size(), "", "ms", "GB/s");
+    cout << line;
+
+    // what reading and writing the array once costs
+    row(cout, "memcpy", best([&]() { std::memcpy(out.data(), sizes.data(), n * sizeof(std::uint32_t)); }), stream);
+    row(cout, "loop", best([&]() {
+        std::uint32_t sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += sizes[i];
+            out[i] = sum;
+        }
+    }), stream);
+    row(cout, "std::inclusive_scan", best([&]() { std::inclusive_scan(sizes.begin(), sizes.end(), out.begin()); }), stream);
+    row(cout, "brisk::inclusive_scan", best([&]() { brisk::inclusive_scan(sizes.begin(), sizes.end(), out.begin()); }), stream);
+    sink += out[n - 1];
+    row(cout, "brisk::exclusive_scan", best([&]() { brisk::exclusive_scan(sizes.begin(), sizes.end(), out.begin(), std::uint32_t(0)); }), stream);
+    row(cout, "brisk::inclusive_scan(par)", best([&]() { brisk::inclusive_scan(brisk::execution::par, sizes.begin(), sizes.end(), out.begin()); }), stream);
+    sink += out[n - 1];
+    row(cout, "brisk::transform_inclusive_scan", best([&]() {
+        brisk::transform_inclusive_scan(sizes.begin(), sizes.end(), out.begin(), std::plus<>(), [](std::uint32_t x) { return x * 2; });
+    }), stream);
+
+    // a skewed key: seven in eight are the same bucket
+    brisk::vector<std::uint32_t> keys(n);
+    for (size_t i = 0; i < n; i++) {
+        std::uint32_t r = rng();
+        keys.push_back(((r & 7) == 0) ? (r >> 8) & 0xff : 3);
+    }
+
+    const double read = static_cast<double>(n) * sizeof(std::uint32_t);
+    brisk::vector<std::uint64_t> counts(65537);
+    for (size_t i = 0; i < 65537; i++) {
+        counts.push_back(0);
+    }
+
+    row(cout, "histogram 256, loop", best([&]() {
+        std::fill(counts.begin(), counts.begin() + 256, 0);
+        for (size_t i = 0; i < n; i++) {
+            ++counts[keys[i]];
+        }
+    }), read);
+    sink += counts[0];
+    row(cout, "brisk::histogram 256", best([&]() { brisk::histogram(keys.begin(), keys.end(), counts.begin(), 256); }), read);
+    row(cout, "brisk::histogram 256 (par)", best([&]() { brisk::histogram(brisk::execution::par, keys.begin(), keys.end(), counts.begin(), 256); }), read);
+    sink += counts[0];
+
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = rng() & 0xffff;
+    }
+    row(cout, "histogram 65536, loop", best([&]() {
+        std::fill(counts.begin(), counts.begin() + 65536, 0);
+        for (size_t i = 0; i < n; i++) {
+            ++counts[keys[i]];
+        }
+    }), read);
+    row(cout, "brisk::histogram 65536", best([&]() { brisk::histogram(keys.begin(), keys.end(), counts.begin(), 65536); }), read);
+    row(cout, "brisk::bucket_offsets 65536", best([&]() { brisk::bucket_offsets(keys.begin(), keys.end(), counts.begin(), 65536); }), read);
+    sink += counts[65536];
+
+    cout << "(checksum " << sink << ")" << brisk::newl;
+}
@@ -0,0 +1,78 @@
+#include "brisk/algorithm.hpp"
+#include "brisk/eytzinger.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// Runs every query through search and returns nanoseconds per query. The
+// results are summed so the searches can't be dropped.
+template <class Search>
+static float measure(const brisk::vector<int>& queries, long long& sink, Search search)
+{
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    for (size_t i = 0; i < queries.size(); i++) {
+        sink += search(queries[i]);
+    }
+    duration<float, std::nano> elapsed = steady_clock::now() - start;
+    return elapsed.count() / static_cast<float>(queries.size());
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("search_benchmark.log");
+
+    // 4KB of keys fits in L1, the default top of 64MB is well past any cache
+    int maxElements = 16 * 1024 * 1024;
+    if (argc >= 2) {
+        maxElements = convertStrToInt(argv[1]);
+    }
+
+    std::mt19937 rng(2024);
+    const size_t queryCount = 1000000;
+    brisk::vector<int> keys;
+    brisk::vector<int> queries(queryCount);
+    long long sink = 0;
+    char line[256];
+
+    std::snprintf(line, sizeof(line), "lower_bound over sorted ints, ns per query\n%10s %10s %12s %12s %12s %12s\n",
+        "elements", "KB", "std", "brisk", "eytzinger", "blocked");
+    cout << line;
+    for (size_t n = 1024; n <= static_cast<size_t>(maxElements); n *= 4) {
+        // every third integer, so about two thirds of the queries miss
+        keys.clear();
+        for (size_t i = 0; i < n; i++) {
+            keys.push_back(static_cast<int>(i * 3));
+        }
+        queries.clear();
+        for (size_t i = 0; i < queryCount; i++) {
+            queries.push_back(static_cast<int>(rng() % (n * 3 - 2)));
+        }
+
+        const int* first = keys.data();
+        const int* last = keys.data() + keys.size();
+        brisk::eytzinger_index<int> eytzinger(first, last);
+        brisk::blocked_eytzinger_index<int> blocked(first, last);
+
+        float stdSearch = measure(queries, sink, [first, last](int x) { return *std::lower_bound(first, last, x); });
+        float briskSearch = measure(queries, sink, [first, last](int x) { return *brisk::lower_bound(first, last, x); });
+        float eytzingerSearch = measure(queries, sink, [&eytzinger](int x) { return *eytzinger.lower_bound(x); });
+        float blockedSearch = measure(queries, sink, [&blocked](int x) { return *blocked.lower_bound(x); });
+
+        std::snprintf(line, sizeof(line), "%10zu %10zu %12.1f %12.1f %12.1f %12.1f\n",
+            n, n * sizeof(int) / 1024, stdSearch, briskSearch, eytzingerSearch, blockedSearch);
+        cout << line;
+    }
+    cout << "(checksum " << sink << ")" << brisk::newl;
+}
@@ -0,0 +1,153 @@
+#include "brisk/algorithm.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/top_k.hpp"
+#include "brisk/vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+struct percentiles
+{
+    unsigned int p50;
+    unsigned int p99;
+    unsigned int p999;
+};
+
+// Times one way of getting the percentiles, on a fresh copy of the
+// latencies, and checks it against the answer from a full sort.
+template <class Method>
+static void row(brisk::logger& cout, const char* name, const brisk::vector<unsigned int>& input, brisk::vector<unsigned int>& work, const percentiles& expected, Method method)
+{
+    using namespace std::chrono;
+    work = input;
+    time_point<steady_clock> start = steady_clock::now();
+    percentiles result = method(work.data(), work.data() + work.size());
+    duration<float, std::milli> elapsed = steady_clock::now() - start;
+
+    bool correct = result.p50 == expected.p50 && result.p99 == expected.p99 && result.p999 == expected.p999;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-36s %10.1f %8u %8u %8u%s\n", name, elapsed.count(), result.p50, result.p99, result.p999, correct ? "" : "  WRONG");
+    cout << line;
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("select_benchmark.log");
+
+    int millions = 100;
+    unsigned int threads = std::thread::hardware_concurrency();
+    if (argc >= 2) {
+        millions = convertStrToInt(argv[1]);
+    }
+    if (argc >= 3) {
+        threads = static_cast<unsigned int>(convertStrToInt(argv[2]));
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    // latencies in microseconds, log-normal around a millisecond with a
+    // long tail
+    const size_t n = static_cast<size_t>(millions) * 1000000;
+    brisk::vector<unsigned int> input(n);
+    std::mt19937_64 rng(2024);
+    std::lognormal_distribution<double> latency(7.0, 0.8);
+    for (size_t i = 0; i < n; i++) {
+        input.push_back(static_cast<unsigned int>(latency(rng)));
+    }
+
+    const size_t i50 = (n - 1) / 2;
+    const size_t i99 = (n - 1) * 99 / 100;
+    const size_t i999 = (n - 1) * 999 / 1000;
+    brisk::vector<unsigned int> work(n);
+    percentiles expected = { 0, 0, 0 };
+    {
+        work = input;
+        brisk::sort(work.begin(), work.end());
+        expected = { work[i50], work[i99], work[i999] };
+    }
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%d M latencies, %u threads\n%-36s %10s %8s %8s %8s\n", millions, threads, "", "ms", "p50", "p99", "p999");
+    cout << line;
+
+    row(cout, "std::sort", input, work, expected, [=](unsigned int* first, unsigned int* last) {
+        std::sort(first, last);
+        return percentiles{ first[i50], first[i99], first[i999] };
+    });
+    row(cout, "brisk::sort", input, work, expected, [=](unsigned int* first, unsigned int* last) {
+        brisk::sort(first, last);
+        return percentiles{ first[i50], first[i99], first[i999] };
+    });
+    // each selection only has to look above the one before it
+    row(cout, "std::nth_element x3", input, work, expected, [=](unsigned int* first, unsigned int* last) {
+        std::nth_element(first, first + i50, last);
+        std::nth_element(first + i50 + 1, first + i99, last);
+        std::nth_element(first + i99 + 1, first + i999, last);
+        return percentiles{ first[i50], first[i99], first[i999] };
+    });
+    row(cout, "brisk::nth_element x3", input, work, expected, [=](unsigned int* first, unsigned int* last) {
+        brisk::nth_element(first, first + i50, last);
+        brisk::nth_element(first + i50 + 1, first + i99, last);
+        brisk::nth_element(first + i99 + 1, first + i999, last);
+        return percentiles{ first[i50], first[i99], first[i999] };
+    });
+    // the tail only: the p99 and p999 come out of one sorted top 1%
+    row(cout, "std::partial_sort top 1%", input, work, expected, [=](unsigned int* first, unsigned int* last) {
+        std::partial_sort(first, first + (n - i99), last, std::greater<>());
+        brisk::nth_element(first + (n - i99), first + (n - 1 - i50), last, std::greater<>());
+        return percentiles{ first[n - 1 - i50], first[n - 1 - i99], first[n - 1 - i999] };
+    });
+    row(cout, "brisk::partial_sort top 1%", input, work, expected, [=](unsigned int* first, unsigned int* last) {
+        brisk::partial_sort(first, first + (n - i99), last, brisk::greater<>());
+        brisk::nth_element(first + (n - i99), first + (n - 1 - i50), last, brisk::greater<>());
+        return percentiles{ first[n - 1 - i50], first[n - 1 - i99], first[n - 1 - i999] };
+    });
+    // streaming: p99 and p999 from the largest 1% without touching the
+    // input's order, p50 still by selection
+    row(cout, "brisk::top_k 1% + nth_element", input, work, expected, [=](unsigned int* first, unsigned int* last) {
+        brisk::top_k<unsigned int> top(n - i99);
+        top.push(first, last);
+        brisk::vector<unsigned int> tail = top.sorted();
+        brisk::nth_element(first, first + i50, last);
+        return percentiles{ first[i50], tail[n - 1 - i99], tail[n - 1 - i999] };
+    });
+    std::string name = "brisk::top_k 1% x" + std::to_string(threads) + " merged";
+    row(cout, name.c_str(), input, work, expected, [=](unsigned int* first, unsigned int* last) {
+        brisk::vector<brisk::top_k<unsigned int>*> partial;
+        brisk::vector<std::thread> workers;
+        const size_t slice = n / threads;
+        for (unsigned int t = 0; t < threads; t++) {
+            partial.push_back(new brisk::top_k<unsigned int>(n - i99));
+        }
+        for (unsigned int t = 0; t < threads; t++) {
+            unsigned int* begin = first + t * slice;
+            unsigned int* end = (t + 1 == threads) ? last : begin + slice;
+            workers.emplace_back([begin, end, top = partial[t]]() { top->push(begin, end); });
+        }
+        for (size_t t = 0; t < workers.size(); t++) {
+            workers[t].join();
+        }
+        for (size_t t = 1; t < partial.size(); t++) {
+            partial[0]->merge(*partial[t]);
+        }
+
+        brisk::vector<unsigned int> tail = partial[0]->sorted();
+        for (size_t t = 0; t < partial.size(); t++) {
+            delete partial[t];
+        }
+        brisk::nth_element(first, first + i50, last);
+        return percentiles{ first[i50], tail[n - 1 - i99], tail[n - 1 - i999] };
+    });
+}
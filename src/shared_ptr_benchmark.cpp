@@ -0,0 +1,133 @@
+#include "brisk/logger.hpp"
+#include "brisk/memory.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+struct payload
+{
+    long value;
+    char bytes[56];
+
+    explicit payload(long v) : value(v), bytes() {}
+};
+
+// Every thread copies and destroys the same pointer, so all of them fight
+// over one reference count.
+template <class Pointer>
+static float contended(const Pointer& shared, size_t copies, int numberOfThreads)
+{
+    auto workerFunc = [&shared, copies]() -> long {
+        long sum = 0;
+        for (size_t i = 0; i < copies; i++) {
+            Pointer copy = shared;
+            sum += copy->value;
+        }
+        return sum;
+    };
+
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    brisk::vector<std::future<long>> threads(numberOfThreads);
+    for (int i = 0; i < numberOfThreads; i++) {
+        threads[i] = std::async(std::launch::async, workerFunc);
+    }
+    for (int i = 0; i < numberOfThreads; i++) {
+        threads[i].get();
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    return elapsed.count();
+}
+
+template <class Pointer>
+static float uncontended(const Pointer& shared, size_t copies)
+{
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    long sum = 0;
+    for (size_t i = 0; i < copies; i++) {
+        Pointer copy = shared;
+        sum += copy->value;
+        asm volatile("" : : "r"(sum) : "memory");
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    return elapsed.count();
+}
+
+template <class Make>
+static float creation(Make make, size_t count)
+{
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    long sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        auto p = make(static_cast<long>(i));
+        sum += p->value;
+        asm volatile("" : : "r"(sum) : "memory");
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("shared_ptr_benchmark.log");
+
+    int millions = 20;
+    int numberOfThreads = 8;
+    if (argc >= 3) {
+        millions = convertStrToInt(argv[1]);
+        numberOfThreads = convertStrToInt(argv[2]);
+    }
+
+    const size_t copies = static_cast<size_t>(millions) * 1000000;
+    const size_t copiesPerThread = copies / numberOfThreads;
+
+    std::shared_ptr<payload> stdShared = std::make_shared<payload>(1);
+    brisk::shared_ptr<payload> briskShared = brisk::make_shared<payload>(1);
+    brisk::local_shared_ptr<payload> briskLocal = brisk::make_local_shared<payload>(1);
+
+    float stdTime = contended(stdShared, copiesPerThread, numberOfThreads);
+    float briskTime = contended(briskShared, copiesPerThread, numberOfThreads);
+    cout << "Contended copy/destroy, " << numberOfThreads << " threads, " << millions << "M copies" << brisk::newl
+    << "    std::shared_ptr:   " << stdTime << "secs (" << copies / stdTime / 1e6f << "M/s)" << brisk::newl
+    << "    brisk::shared_ptr: " << briskTime << "secs (" << copies / briskTime / 1e6f << "M/s)" << brisk::newl;
+
+    stdTime = uncontended(stdShared, copies);
+    briskTime = uncontended(briskShared, copies);
+    float localTime = uncontended(briskLocal, copies);
+    cout << "Single thread copy/destroy, " << millions << "M copies" << brisk::newl
+    << "    std::shared_ptr:         " << stdTime << "secs (" << copies / stdTime / 1e6f << "M/s)" << brisk::newl
+    << "    brisk::shared_ptr:       " << briskTime << "secs (" << copies / briskTime / 1e6f << "M/s)" << brisk::newl
+    << "    brisk::local_shared_ptr: " << localTime << "secs (" << copies / localTime / 1e6f << "M/s)" << brisk::newl;
+
+    const size_t created = copies / 10;
+    stdTime = creation([](long v) { return std::make_shared<payload>(v); }, created);
+    briskTime = creation([](long v) { return brisk::make_shared<payload>(v); }, created);
+    localTime = creation([](long v) { return brisk::make_local_shared<payload>(v); }, created);
+    float separateTime = creation([](long v) { return brisk::shared_ptr<payload>(new payload(v)); }, created);
+    cout << "Create/destroy, " << created / 1000000.0f << "M objects" << brisk::newl
+    << "    std::make_shared:         " << stdTime << "secs" << brisk::newl
+    << "    brisk::make_shared:       " << briskTime << "secs" << brisk::newl
+    << "    brisk::make_local_shared: " << localTime << "secs" << brisk::newl
+    << "    brisk::shared_ptr(new):   " << separateTime << "secs" << brisk::newl;
+
+    // weak references: lock() has to race the last owner
+    brisk::weak_ptr<payload> weak = briskShared;
+    long alive = 0;
+    for (size_t i = 0; i < created; i++) {
+        brisk::shared_ptr<payload> locked = weak.lock();
+        alive += locked ? locked->value : 0;
+    }
+    briskShared.reset();
+    cout << "weak_ptr locked " << alive << " times, expired after reset: " << weak.expired() << brisk::newl;
+}
@@ -0,0 +1,135 @@
+#include "brisk/algorithm.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/simd.hpp"
+#include "brisk/vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// Best of a few runs of f repeated reps times, in milliseconds.
+template <class Function>
+static float best(int reps, Function f)
+{
+    using namespace std::chrono;
+    float fastest = 0;
+    for (int run = 0; run < 5; run++) {
+        time_point<steady_clock> start = steady_clock::now();
+        for (int rep = 0; rep < reps; rep++) {
+            f();
+        }
+        duration<float, std::milli> elapsed = steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < fastest) {
+            fastest = elapsed.count();
+        }
+    }
+    return fastest;
+}
+
+static const brisk::simd_isa isas[] = {brisk::simd_isa::scalar, brisk::simd_isa::sse2, brisk::simd_isa::avx2, brisk::simd_isa::avx512};
+
+// The std version, then the brisk one forced onto each instruction set the
+// CPU has, in GB/s of what the operation reads or writes.
+template <class Std, class Brisk>
+static void row(brisk::logger& cout, const char* name, double bytes, int reps, Std stdVersion, Brisk briskVersion)
+{
+    const double total = bytes * reps;
+    char line[160];
+    int at = std::snprintf(line, sizeof(line), "%-26s %9.2f", name, total / (best(reps, stdVersion) / 1000.0) / 1e9);
+    for (brisk::simd_isa isa : isas) {
+        if (isa > brisk::simd_supported_isa()) {
+            at += std::snprintf(line + at, sizeof(line) - at, " %9s", "-");
+            continue;
+        }
+
+        brisk::set_simd_isa(isa);
+        at += std::snprintf(line + at, sizeof(line) - at, " %9.2f", total / (best(reps, briskVersion) / 1000.0) / 1e9);
+    }
+    brisk::set_simd_isa(brisk::simd_supported_isa());
+    std::snprintf(line + at, sizeof(line) - at, "\n");
+    cout << line;
+}
+
+template <class T>
+static brisk::vector<T> randomArray(size_t n, std::mt19937& rng)
+{
+    brisk::vector<T> a(n);
+    for (size_t i = 0; i < n; i++) {
+        a.push_back(static_cast<T>(rng() % 1000));
+    }
+    return a;
+}
+
+// The algorithms simd.hpp backs, on arrays small enough to stay in L2 so the
+// instruction set rather than memory sets the pace.
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("simd_benchmark.log");
+
+    int kilobytes = 256;
+    if (argc >= 2) {
+        kilobytes = convertStrToInt(argv[1]);
+    }
+
+    const double bytes = kilobytes * 1024.0;
+    const int reps = static_cast<int>((size_t(1) << 30) / (kilobytes * size_t(1024)));
+    std::mt19937 rng(50);
+    auto u8 = randomArray<std::uint8_t>(kilobytes * 1024, rng);
+    auto i16 = randomArray<std::int16_t>(kilobytes * 512, rng);
+    auto i32 = randomArray<std::int32_t>(kilobytes * 256, rng);
+    auto i32copy = i32;
+    auto i64 = randomArray<std::int64_t>(kilobytes * 128, rng);
+    auto f32 = randomArray<float>(kilobytes * 256, rng);
+    auto f64 = randomArray<double>(kilobytes * 128, rng);
+    auto f64copy = f64;
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%d KB arrays, 1 GB per run, best of 5, detected %s\n%-26s %9s %9s %9s %9s %9s\n", kilobytes,
+        brisk::simd_isa_name(brisk::simd_supported_isa()), "GB/s", "std", "scalar", "sse2", "avx2", "avx512");
+    cout << line;
+
+    volatile std::int64_t sink = 0;
+    volatile double dsink = 0;
+    row(cout, "accumulate uint8", bytes, reps, [&]() { sink = sink + std::accumulate(u8.begin(), u8.end(), std::uint8_t(0)); },
+        [&]() { sink = sink + brisk::accumulate(u8.begin(), u8.end(), std::uint8_t(0)); });
+    row(cout, "accumulate int32", bytes, reps, [&]() { sink = sink + std::accumulate(i32.begin(), i32.end(), 0); },
+        [&]() { sink = sink + brisk::accumulate(i32.begin(), i32.end(), 0); });
+    row(cout, "accumulate int64", bytes, reps, [&]() { sink = sink + std::accumulate(i64.begin(), i64.end(), std::int64_t(0)); },
+        [&]() { sink = sink + brisk::accumulate(i64.begin(), i64.end(), std::int64_t(0)); });
+    row(cout, "reduce float", bytes, reps, [&]() { dsink = dsink + std::reduce(f32.begin(), f32.end(), 0.0f); },
+        [&]() { dsink = dsink + brisk::reduce(f32.begin(), f32.end(), 0.0f); });
+    row(cout, "reduce double", bytes, reps, [&]() { dsink = dsink + std::reduce(f64.begin(), f64.end(), 0.0); },
+        [&]() { dsink = dsink + brisk::reduce(f64.begin(), f64.end(), 0.0); });
+
+    // values that aren't all zero bytes, so not a memset
+    row(cout, "fill int32", bytes, reps, [&]() { std::fill(i32copy.begin(), i32copy.end(), 7); },
+        [&]() { brisk::fill(i32copy.begin(), i32copy.end(), 7); });
+    row(cout, "fill double", bytes, reps, [&]() { std::fill(f64copy.begin(), f64copy.end(), 1.5); },
+        [&]() { brisk::fill(f64copy.begin(), f64copy.end(), 1.5); });
+    f64copy = f64;
+    i32copy = i32;
+
+    row(cout, "min_element int16", bytes, reps, [&]() { sink = sink + *std::min_element(i16.begin(), i16.end()); },
+        [&]() { sink = sink + *brisk::min_element(i16.begin(), i16.end()); });
+    row(cout, "min_element int32", bytes, reps, [&]() { sink = sink + *std::min_element(i32.begin(), i32.end()); },
+        [&]() { sink = sink + *brisk::min_element(i32.begin(), i32.end()); });
+    row(cout, "max_element int64", bytes, reps, [&]() { sink = sink + *std::max_element(i64.begin(), i64.end()); },
+        [&]() { sink = sink + *brisk::max_element(i64.begin(), i64.end()); });
+
+    // equal vectors, so the whole of both is compared
+    row(cout, "vector == int32", 2 * bytes, reps, [&]() { sink = sink + std::equal(i32.begin(), i32.end(), i32copy.begin()); },
+        [&]() { sink = sink + (i32 == i32copy); });
+    row(cout, "vector == double", 2 * bytes, reps, [&]() { sink = sink + std::equal(f64.begin(), f64.end(), f64copy.begin()); },
+        [&]() { sink = sink + (f64 == f64copy); });
+}
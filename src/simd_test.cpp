@@ -0,0 +1,245 @@
+#include "brisk/algorithm.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/simd.hpp"
+#include "brisk/vector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <typeinfo>
+
+// Checks every lane operation and every algorithm simd.hpp backs on each
+// instruction set the CPU has, against plain scalar code. The Makefile also
+// builds it at -O0, where nothing is inlined into the dispatched kernels.
+//
+// A dispatched kernel inlines everything it calls, so check() only notes
+// what failed and the logging happens outside.
+static long failures = 0;
+static const char* failed = nullptr;
+
+static void check(bool ok, const char* what)
+{
+    if (!ok) {
+        failures++;
+        failed = what;
+    }
+}
+
+static void report(brisk::logger& cout, long before, const char* type, brisk::simd_isa isa)
+{
+    if (failures != before) {
+        char line[160];
+        std::snprintf(line, sizeof(line), "FAILED %s, %s on %s\n", failed, type, brisk::simd_isa_name(isa));
+        cout << line;
+    }
+}
+
+template <class T>
+static bool same(T a, T b)
+{
+    if constexpr (std::is_floating_point_v<T>) {
+        return (std::isnan(a) && std::isnan(b)) || std::memcmp(&a, &b, sizeof(T)) == 0;
+    } else {
+        return a == b;
+    }
+}
+
+// Lane i of an operation's result against f(i).
+template <class T, class Abi, class Function>
+static bool lanesAre(const brisk::basic_simd<T, Abi>& v, Function f)
+{
+    T lanes[64];
+    v.store(lanes);
+    for (size_t i = 0; i < v.size(); i++) {
+        if (!same(lanes[i], static_cast<T>(f(i)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class T, class Abi, class Predicate>
+static bool bitsAre(const brisk::basic_simd_mask<T, Abi>& m, Predicate p)
+{
+    std::uint64_t bits = 0;
+    for (size_t i = 0; i < m.size(); i++) {
+        bits |= std::uint64_t(p(i)) << i;
+    }
+    return m.to_bits() == bits;
+}
+
+struct lane_ops
+{
+    template <class Abi, class T>
+    static int run(const T* x, const T* y, const std::int32_t* index)
+    {
+        using namespace brisk::detail;
+        using V = brisk::basic_simd<T, Abi>;
+        const size_t lanes = V::size();
+        const V a = V::load(x);
+        const V b = V::load(y);
+
+        check(lanesAre(a + b, [&](size_t i) { return wrapAdd(x[i], y[i]); }), "+");
+        check(lanesAre(a - b, [&](size_t i) { return wrapSub(x[i], y[i]); }), "-");
+        check(lanesAre(a * b, [&](size_t i) { return wrapMul(x[i], y[i]); }), "*");
+        check(lanesAre(-a, [&](size_t i) { return wrapSub(T(0), x[i]); }), "unary -");
+        if constexpr (std::is_floating_point_v<T>) {
+            check(lanesAre(a / b, [&](size_t i) { return x[i] / y[i]; }), "/");
+        } else {
+            check(lanesAre(a & b, [&](size_t i) { return x[i] & y[i]; }), "&");
+            check(lanesAre(a | b, [&](size_t i) { return x[i] | y[i]; }), "|");
+            check(lanesAre(a ^ b, [&](size_t i) { return x[i] ^ y[i]; }), "^");
+        }
+
+        V sum = a;
+        sum += b;
+        check(lanesAre(sum, [&](size_t i) { return wrapAdd(x[i], y[i]); }), "+=");
+
+        check(bitsAre(a == b, [&](size_t i) { return x[i] == y[i]; }), "==");
+        check(bitsAre(a != b, [&](size_t i) { return x[i] != y[i]; }), "!=");
+        check(bitsAre(a < b, [&](size_t i) { return x[i] < y[i]; }), "<");
+        check(bitsAre(a <= b, [&](size_t i) { return x[i] <= y[i]; }), "<=");
+        check(bitsAre(a > b, [&](size_t i) { return x[i] > y[i]; }), ">");
+        check(bitsAre(a >= b, [&](size_t i) { return x[i] >= y[i]; }), ">=");
+
+        const auto less = a < b;
+        const auto equal = a == b;
+        check(bitsAre(!less, [&](size_t i) { return !(x[i] < y[i]); }), "mask !");
+        check(bitsAre(less | equal, [&](size_t i) { return x[i] < y[i] || x[i] == y[i]; }), "mask |");
+        check(bitsAre(less & equal, [](size_t) { return false; }), "mask &");
+        bool anyLess = false;
+        for (size_t i = 0; i < lanes; i++) {
+            anyLess = anyLess || x[i] < y[i];
+        }
+        check(brisk::any_of(less) == anyLess && brisk::none_of(less) == !anyLess, "any_of");
+
+        check(lanesAre(brisk::select(less, a, b), [&](size_t i) { return (x[i] < y[i]) ? x[i] : y[i]; }), "select");
+        check(lanesAre(brisk::min(a, b), [&](size_t i) { return brisk::min(x[i], y[i]); }), "min");
+        check(lanesAre(brisk::max(a, b), [&](size_t i) { return brisk::max(x[i], y[i]); }), "max");
+        check(lanesAre(V::gather(y, index), [&](size_t i) { return y[index[i]]; }), "gather");
+        check(lanesAre(brisk::permute(a, index), [&](size_t i) { return x[index[i]]; }), "permute");
+        check(lanesAre(brisk::reverse(a), [&](size_t i) { return x[lanes - 1 - i]; }), "reverse");
+        check(lanesAre(V(x[0]), [&](size_t) { return x[0]; }), "broadcast");
+        check(lanesAre(V(), [](size_t) { return 0; }), "zero");
+        check(same(a[lanes - 1], x[lanes - 1]), "[]");
+
+        if constexpr (std::is_integral_v<T>) {
+            T total = x[0];
+            for (size_t i = 1; i < lanes; i++) {
+                total = wrapAdd(total, x[i]);
+            }
+            check(brisk::reduce_add(a) == total, "reduce_add");
+            check(brisk::reduce_min(a) == *std::min_element(x, x + lanes), "reduce_min");
+            check(brisk::reduce_max(a) == *std::max_element(x, x + lanes), "reduce_max");
+        }
+        return static_cast<int>(lanes);
+    }
+};
+
+template <class T>
+static void testLanes(brisk::logger& cout, std::mt19937_64& rng, brisk::simd_isa isa)
+{
+    long before = failures;
+    for (int round = 0; round < 50; round++) {
+        T x[64];
+        T y[64];
+        for (int i = 0; i < 64; i++) {
+            if constexpr (std::is_floating_point_v<T>) {
+                x[i] = (rng() % 8 == 0) ? std::numeric_limits<T>::quiet_NaN() : T(int(rng() % 200) - 100) / T(8);
+                y[i] = (rng() % 3 == 0) ? x[i] : T(int(rng() % 200) - 100) / T(8);
+            } else {
+                x[i] = (rng() % 8 == 0) ? std::numeric_limits<T>::min() : static_cast<T>(rng());
+                y[i] = (rng() % 3 == 0) ? x[i] : static_cast<T>(rng());
+            }
+        }
+
+        std::int32_t index[64];
+        const size_t lanes = (isa == brisk::simd_isa::scalar) ? 1 : (size_t(8) << static_cast<int>(isa)) / sizeof(T);
+        for (size_t i = 0; i < 64; i++) {
+            index[i] = static_cast<std::int32_t>(rng() % lanes);
+        }
+
+        const T* cx = x;
+        const T* cy = y;
+        const std::int32_t* cindex = index;
+        int ran = brisk::simd_dispatch<lane_ops>(cx, cy, cindex);
+        check(static_cast<size_t>(ran) == lanes, "size()");
+    }
+    report(cout, before, typeid(T).name(), isa);
+}
+
+template <class T>
+static void testAlgorithms(brisk::logger& cout, std::mt19937_64& rng, brisk::simd_isa isa)
+{
+    long before = failures;
+    for (size_t n : {0, 1, 3, 17, 64, 65, 1000, 4097, 9000}) {
+        // off by one element, so the kernels start unaligned
+        brisk::vector<T> a(n + 1);
+        brisk::vector<T> b(n + 1);
+        for (size_t i = 0; i <= n; i++) {
+            T value = std::is_floating_point_v<T> ? T(int(rng() % 2000) - 1000) / T(16) : static_cast<T>(rng());
+            a.push_back(value);
+            b.push_back(value);
+        }
+        T* p = &a[1];
+
+        // exact in binary for floats, so any order sums the same
+        T total = T(1);
+        for (size_t i = 0; i < n; i++) {
+            total = brisk::detail::wrapAdd(total, p[i]);
+        }
+        check(brisk::accumulate(p, p + n, T(1)) == total, "accumulate");
+        check(brisk::reduce(p, p + n, T(1)) == total, "reduce");
+
+        if constexpr (std::is_integral_v<T>) {
+            check(brisk::min_element(p, p + n) == std::min_element(p, p + n), "min_element");
+            check(brisk::max_element(p, p + n) == std::max_element(p, p + n), "max_element");
+        }
+
+        check(a == b && !(a != b), "vector ==");
+        if (n > 0) {
+            b[n] = static_cast<T>(b[n] + 1);
+            check(a != b, "vector !=");
+        }
+
+        brisk::fill(p, p + n, T(3));
+        check(std::all_of(p, p + n, [](T v) { return v == T(3); }), "fill");
+    }
+    report(cout, before, typeid(T).name(), isa);
+}
+
+int main()
+{
+    brisk::logger cout("simd_test.log");
+
+    std::mt19937_64 rng(50);
+    for (int i = 0; i <= static_cast<int>(brisk::simd_supported_isa()); i++) {
+        brisk::simd_isa isa = brisk::set_simd_isa(static_cast<brisk::simd_isa>(i));
+        testLanes<std::int8_t>(cout, rng, isa);
+        testLanes<std::uint8_t>(cout, rng, isa);
+        testLanes<std::int16_t>(cout, rng, isa);
+        testLanes<std::uint16_t>(cout, rng, isa);
+        testLanes<std::int32_t>(cout, rng, isa);
+        testLanes<std::uint32_t>(cout, rng, isa);
+        testLanes<std::int64_t>(cout, rng, isa);
+        testLanes<std::uint64_t>(cout, rng, isa);
+        testLanes<float>(cout, rng, isa);
+        testLanes<double>(cout, rng, isa);
+
+        testAlgorithms<std::uint8_t>(cout, rng, isa);
+        testAlgorithms<std::int16_t>(cout, rng, isa);
+        testAlgorithms<std::int32_t>(cout, rng, isa);
+        testAlgorithms<std::uint64_t>(cout, rng, isa);
+        testAlgorithms<float>(cout, rng, isa);
+        testAlgorithms<double>(cout, rng, isa);
+    }
+
+    bool ok = failures == 0;
+    cout << "simd up to " << brisk::simd_isa_name(brisk::simd_supported_isa()) << ": " << failures << " failures" << brisk::newl
+    << (ok ? "ok" : "FAILED") << brisk::newl;
+    return ok ? 0 : 1;
+}
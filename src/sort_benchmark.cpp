@@ -0,0 +1,95 @@
+#include "brisk/algorithm.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+template <class Type>
+static void makeInput(brisk::vector<Type>& v, size_t n, int distribution, std::mt19937_64& rng)
+{
+    v.clear();
+    for (size_t i = 0; i < n; i++) {
+        switch (distribution) {
+        case 0: v.push_back(static_cast<Type>(static_cast<long long>(rng() >> 1) - (1ll << 62))); break;
+        case 1: v.push_back(static_cast<Type>(i)); break;
+        case 2: v.push_back(static_cast<Type>(n - i)); break;
+        default: v.push_back(static_cast<Type>(rng() % 16)); break;
+        }
+    }
+}
+
+// Sorts fresh copies of input until about 5M elements have gone through,
+// and returns millions of elements sorted per second. Only the sorts are
+// timed, not the copies.
+template <class Type, class Sort>
+static float measure(const brisk::vector<Type>& input, brisk::vector<Type>& work, Sort sort)
+{
+    using namespace std::chrono;
+    const size_t n = input.size();
+    const size_t rounds = (n >= 5000000) ? 1 : 5000000 / n;
+    duration<float> elapsed(0);
+    for (size_t r = 0; r < rounds; r++) {
+        work = input;
+        time_point<steady_clock> start = steady_clock::now();
+        sort(work.begin(), work.end());
+        elapsed += steady_clock::now() - start;
+    }
+
+    if (!std::is_sorted(work.begin(), work.end())) {
+        return -1;
+    }
+
+    return static_cast<float>(n) * rounds / elapsed.count() / 1e6f;
+}
+
+template <class Type>
+static void table(brisk::logger& cout, const char* type, size_t maxElements, std::mt19937_64& rng)
+{
+    const char* distributions[] = { "random", "sorted", "reversed", "few unique" };
+    brisk::vector<Type> input;
+    brisk::vector<Type> work;
+    char line[256];
+
+    std::snprintf(line, sizeof(line), "%s, M elements/s\n%-11s %10s %10s %10s %12s %12s %11s\n", type,
+        "", "elements", "std::sort", "brisk::sort", "std::stable", "brisk::stable", "brisk::radix");
+    cout << line;
+    for (int distribution = 0; distribution < 4; distribution++) {
+        for (size_t n = 1000; n <= maxElements; n *= 10) {
+            makeInput(input, n, distribution, rng);
+            float stdSort = measure(input, work, [](Type* first, Type* last) { std::sort(first, last); });
+            float briskSort = measure(input, work, [](Type* first, Type* last) { brisk::sort(first, last); });
+            float stdStable = measure(input, work, [](Type* first, Type* last) { std::stable_sort(first, last); });
+            float briskStable = measure(input, work, [](Type* first, Type* last) { brisk::stable_sort(first, last); });
+            float briskRadix = measure(input, work, [](Type* first, Type* last) { brisk::radix_sort(first, last); });
+
+            std::snprintf(line, sizeof(line), "%-11s %10zu %10.1f %11.1f %11.1f %13.1f %12.1f\n",
+                distributions[distribution], n, stdSort, briskSort, stdStable, briskStable, briskRadix);
+            cout << line;
+        }
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("sort_benchmark.log");
+
+    int maxElements = 10000000;
+    if (argc >= 2) {
+        maxElements = convertStrToInt(argv[1]);
+    }
+
+    std::mt19937_64 rng(2024);
+    table<int>(cout, "int", static_cast<size_t>(maxElements), rng);
+    cout << brisk::newl;
+    table<double>(cout, "double", static_cast<size_t>(maxElements), rng);
+}
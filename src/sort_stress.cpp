@@ -0,0 +1,81 @@
+#include "brisk/execution.hpp"
+#include "brisk/logger.hpp"
+#include "brisk/vector.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// Strings long enough to live on the heap, so a value moved out from under a
+// comparison is empty rather than left behind in the small buffer.
+static std::vector<std::string> randomStrings(int n, std::mt19937& rng)
+{
+    std::vector<std::string> strings;
+    strings.reserve(n);
+    for (int i = 0; i < n; i++) {
+        strings.push_back("key-" + std::to_string(rng() % 5000) + "-payload-" + std::to_string(i));
+    }
+    return strings;
+}
+
+// The parallel stable_sort against std::stable_sort, comparing only the key
+// so that equal keys check stability too. Returns the number of positions
+// that differ.
+static long stress(const std::vector<std::string>& input, int numberOfThreads, int grain)
+{
+    auto key = [](const std::string& a, const std::string& b) {
+        return a.compare(0, a.find('-', 4), b, 0, b.find('-', 4)) < 0;
+    };
+
+    std::vector<std::string> expected = input;
+    std::stable_sort(expected.begin(), expected.end(), key);
+
+    brisk::vector<std::string> sorted(input.size());
+    for (const std::string& s : input) {
+        sorted.push_back(s);
+    }
+
+    brisk::thread_pool pool(static_cast<size_t>(numberOfThreads));
+    brisk::stable_sort(brisk::execution::par.on(pool).with_grain(static_cast<size_t>(grain)), sorted.begin(), sorted.end(), key);
+
+    long errors = 0;
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (sorted[i] != expected[i]) {
+            errors++;
+        }
+    }
+    return errors;
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("sort_stress.log");
+
+    int numberOfThreads = 8;
+    int size = 200000;
+    int grain = 500;
+    if (argc >= 4) {
+        numberOfThreads = convertStrToInt(argv[1]);
+        size = convertStrToInt(argv[2]);
+        grain = convertStrToInt(argv[3]);
+    }
+
+    std::mt19937 rng(47);
+    long errors = 0;
+    for (int run = 0; run < 4; run++) {
+        errors += stress(randomStrings(size, rng), numberOfThreads, grain);
+    }
+
+    bool ok = errors == 0;
+    cout << numberOfThreads << " threads, " << size << " strings, grain " << grain << brisk::newl
+    << "    stable_sort: " << errors << " misplaced" << brisk::newl
+    << (ok ? "ok" : "FAILED") << brisk::newl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+#include "brisk/logger.hpp"
+#include "brisk/memory_resource.hpp"
+#include "brisk/thread_caching_resource.hpp"
+#include "brisk/string.hpp"
+#include "brisk/vector.hpp"
+
+#include <chrono>
+#include <future>
+#include <string>
+
+static int convertStrToInt(const char* str)
+{
+    std::string a = str;
+    return std::stoi(a, nullptr);
+}
+
+// A mix of what our workers allocate: growing vectors of every size from a
+// few bytes to a few hundred KB, strings built up piecewise, and vectors
+// of strings that outlive the iteration that made them.
+static long workload(int iterations, unsigned seed)
+{
+    long checksum = 0;
+    brisk::vector<brisk::vector<brisk::string>> keep;
+    for (int i = 0; i < iterations; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const int elements = 1 << ((seed >> 16) % 15);
+
+        brisk::vector<int> numbers;
+        for (int j = 0; j < elements; j++) {
+            numbers.push_back(j);
+        }
+        checksum += numbers.back();
+
+        brisk::vector<brisk::string> words;
+        for (int j = 0; j < 16; j++) {
+            brisk::string word("worker-");
+            word.append(static_cast<char>('a' + (seed + j) % 26));
+            word.append("-request-line");
+            words.push_back(word);
+        }
+        checksum += static_cast<long>(words.back().size());
+
+        if (i % 8 == 0) {
+            keep.push_back(brisk::move(words));
+        }
+        if (keep.size() > 64) {
+            keep.clear();
+        }
+    }
+    return checksum;
+}
+
+static float run(int iterations, int numberOfThreads, long& checksum)
+{
+    using namespace std::chrono;
+    time_point<steady_clock> start = steady_clock::now();
+    brisk::vector<std::future<long>> threads(numberOfThreads);
+    for (int i = 0; i < numberOfThreads; i++) {
+        threads[i] = std::async(std::launch::async, workload, iterations, static_cast<unsigned>(i + 1));
+    }
+    for (int i = 0; i < numberOfThreads; i++) {
+        checksum += threads[i].get();
+    }
+    duration<float> elapsed = steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, const char* argv[])
+{
+    brisk::logger cout("thread_caching_benchmark.log");
+
+    int iterations = 20000;
+    int numberOfThreads = 8;
+    if (argc >= 3) {
+        iterations = convertStrToInt(argv[1]);
+        numberOfThreads = convertStrToInt(argv[2]);
+    }
+
+#ifdef BRISK_HAS_THREAD_CACHING_RESOURCE
+    long checksum = 0;
+    brisk::set_default_resource(brisk::new_delete_resource());
+    float heap = run(iterations, numberOfThreads, checksum);
+
+    brisk::set_default_resource(brisk::thread_caching_resource());
+    float cached = run(iterations, numberOfThreads, checksum);
+    brisk::set_default_resource(nullptr);
+
+    brisk::thread_caching_stats before = brisk::thread_caching_resource_stats();
+    brisk::size_t released = brisk::thread_caching_release_free_memory();
+    brisk::thread_caching_stats after = brisk::thread_caching_resource_stats();
+
+    cout << numberOfThreads << " threads x " << iterations << " iterations (checksum " << checksum << ")" << brisk::newl
+    << "    new/delete (malloc):     " << heap << "secs" << brisk::newl
+    << "    thread_caching_resource: " << cached << "secs (" << heap / cached << "x)" << brisk::newl
+    << "    mapped " << static_cast<float>(before.mappedBytes) / (1 << 20) << "MB, free "
+    << static_cast<float>(before.freeBytes) / (1 << 20) << "MB, already released "
+    << static_cast<float>(before.releasedBytes) / (1 << 20) << "MB" << brisk::newl
+    << "    release_free_memory() gave back " << static_cast<float>(released) / (1 << 20) << "MB, "
+    << static_cast<float>(after.releasedBytes) / (1 << 20) << "MB released in total" << brisk::newl;
+#else
+    cout << "thread_caching_resource needs mmap/madvise" << brisk::newl;
+#endif
+}
@@ -133,13 +133,48 @@ int main(int argc, const char* argv[])
         stlElapsedSeconds += end - start;
     }
     
-    cout << "\n\nStatistics:" << brisk::newl << 
-    "Tests (for each container): "<< testRuns << brisk::newl <<
-    "Operations (for each container, 8 operations each): " << operations << brisk::newl <<
-    "Total operations performed (on each container): " << testRuns * (operations * 12) << brisk::newl <<
-    "std::vector Time: " << stlElapsedSeconds.count() << "secs, brisk::vector Time: " << briskElapsedSeconds.count() << "secs" << brisk::newl <<
-    "Total time elapsed: " << stlElapsedSeconds.count() + briskElapsedSeconds.count() << "secs" << brisk::newl <<
-    "Press ENTER to quit..." << brisk::newl;
+    // Render the statistics block below both ways into loggers that neither
+    // print nor keep growing a file, to compare the << chain against fmt
+    const int formatRuns = 20000;
+    brisk::logger chained("chained.log"), formatted("formatted.log");
+    chained.disablePrinting();
+    chained.disableLogging();
+    formatted.disablePrinting();
+    formatted.disableLogging();
+
+    start = system_clock::now();
+    for (int i = 0; i < formatRuns; i++) {
+        chained << "\n\nStatistics:" << brisk::newl << 
+        "Tests (for each container): "<< testRuns << brisk::newl <<
+        "Operations (for each container, 8 operations each): " << operations << brisk::newl <<
+        "Total operations performed (on each container): " << testRuns * (operations * 12) << brisk::newl <<
+        "std::vector Time: " << stlElapsedSeconds.count() << "secs, brisk::vector Time: " << briskElapsedSeconds.count() << "secs" << brisk::newl <<
+        "Total time elapsed: " << stlElapsedSeconds.count() + briskElapsedSeconds.count() << "secs" << brisk::newl;
+    }
+    duration<float> chainedElapsedSeconds = system_clock::now() - start;
+
+    start = system_clock::now();
+    for (int i = 0; i < formatRuns; i++) {
+        formatted.fmt("\n\nStatistics:\nTests (for each container): {}\n"
+            "Operations (for each container, 8 operations each): {}\n"
+            "Total operations performed (on each container): {}\n"
+            "std::vector Time: {}secs, brisk::vector Time: {}secs\n"
+            "Total time elapsed: {}secs\n",
+            testRuns, operations, testRuns * (operations * 12), stlElapsedSeconds.count(), briskElapsedSeconds.count(),
+            stlElapsedSeconds.count() + briskElapsedSeconds.count());
+    }
+    duration<float> formattedElapsedSeconds = system_clock::now() - start;
+
+    cout.fmt("\n\nStatistics:\nTests (for each container): {}\n"
+        "Operations (for each container, 8 operations each): {}\n"
+        "Total operations performed (on each container): {}\n"
+        "std::vector Time: {}secs, brisk::vector Time: {}secs\n"
+        "Total time elapsed: {}secs\n",
+        testRuns, operations, testRuns * (operations * 12), stlElapsedSeconds.count(), briskElapsedSeconds.count(),
+        stlElapsedSeconds.count() + briskElapsedSeconds.count());
+    cout.fmt("Statistics output x{}: << chain {}secs ({} history entries), fmt {}secs ({} history entries)\n",
+        formatRuns, chainedElapsedSeconds.count(), chained.buffer().size(), formattedElapsedSeconds.count(), formatted.buffer().size());
+    cout << "Press ENTER to quit..." << brisk::newl;
     
     std::cin.get();
 }
\ No newline at end of file